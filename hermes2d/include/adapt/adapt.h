@@ -172,6 +172,18 @@ namespace Hermes
       bool adapt(RefinementSelectors::Selector<Scalar>* refinement_selector, double thr, int strat = 0,
         int regularize = -1, double to_be_processed = 0.0);
 
+      /// Set the number of threads used to calculate errors and to select refinements (the default 1 means serial adaptivity).
+      /** Requires OpenMP (WITH_OPENMP).
+      *  - The errors of elements (calc_err_est(), calc_err_exact()) are then evaluated concurrently, each thread uses its own copies
+      *    of the solutions. The methods eval_error() and eval_error_norm() must not modify any shared data. The errors are summed up
+      *    in the order of the elements, so they are identical to the serial ones. Errors with respect to solutions which do not come
+      *    from a computation (e.g. exact solutions) are still calculated serially.
+      *  - Refinements of the elements with the largest errors are selected concurrently by adapt(),
+      *    each thread uses its own copy of the selectors (see RefinementSelectors::Selector::clone()) and of the reference solutions.
+      *    The stopping strategies are applied serially afterwards, so the resulting refinements are identical to the serial ones.
+      *    Selectors that cannot be copied (e.g. selectors with a user shapeset) still select refinements serially. */
+      void set_num_threads(int num_threads);
+
       /// Unrefines the elements with the smallest error.
       /** \note This method is provided just for backward compatibility reasons. Currently, it is not used by the library.
       *  \param[in] thr A stop condition relative error threshold. */
@@ -211,6 +223,19 @@ namespace Hermes
       Hermes::vector<ElementReference> regular_queue; ///< A queue of elements which should be processes. The queue had to be filled by the method fill_regular_queue().
       std::vector<ElementToRefine> last_refinements; ///< A vector of refinements generated during the last finished execution of the method adapt().
 
+      /// Selects refinements of the elements at the beginning of the regular queue concurrently.
+      /** The elements are the elements of the regular queue which the method adapt() examines if all examined elements are refined,
+      *  i.e., the stopping strategy is evaluated as in adapt(). Refinements of the remaining elements are selected serially by adapt().
+      *  \param[in] refinement_selectors Selectors of the components.
+      *  \param[in] meshes Meshes of the components.
+      *  \param[in] thr A threshold, see adapt().
+      *  \param[in] strat A strategy, see adapt().
+      *  \param[in] to_be_processed Error which has to be processed in the strategy number 3.
+      *  \param[out] suggestions Selected refinements. The index is an index of an element in the regular queue.
+      *  \param[out] suggested Results of the selections: 1 if a refinement was proposed, 0 if not, -1 if the refinement was not selected yet. The index is an index of an element in the regular queue. */
+      void select_refinements_threaded(Hermes::vector<RefinementSelectors::Selector<Scalar>*>& refinement_selectors, Mesh** meshes,
+        double thr, int strat, double to_be_processed, std::vector<ElementToRefine>& suggestions, std::vector<int>& suggested);
+
       /// Returns true if a given element should be ignored and not processed through refinement selection.
       /** Overload this method to omit some elements from processing.
       *  \param[in] inx_element An index of an element in the regular queue. -1 if the element cames from the priority queue.
@@ -252,6 +277,7 @@ namespace Hermes
       bool have_errors;                     ///< True if errors of elements were calculated.
       bool have_coarse_solutions;           ///< True if the coarse solutions were set.
       bool have_reference_solutions;        ///< True if the reference solutions were set.
+      int num_threads;                      ///< Number of threads used to select refinements, see set_num_threads().
 
       double* errors[H2D_MAX_COMPONENTS];   ///< Errors of elements. Meaning of the error depeds on flags used when the
       ///< method calc_errors_internal() was calls. Initialized in the method calc_errors_internal().
@@ -273,6 +299,19 @@ namespace Hermes
         Hermes::vector<double>* component_errors, bool solutions_for_adapt,
         unsigned int error_flags);
 
+      /// Evaluates the errors and norms of all states of the traversal of the meshes concurrently.
+      /** Used by calc_err_internal() if more threads are set. Updates the errors of elements (if solutions_for_adapt), the norms
+      *  and errors of components and the totals exactly as the serial loop of calc_err_internal() does.
+      *  \param[in] meshes Meshes of the (coarse) solutions followed by the meshes of the reference solutions.
+      *  \param[in] tr The (coarse) solutions followed by the reference solutions, used by the traversal.
+      *  \param[in,out] norms Squared norms of components.
+      *  \param[in,out] errors_components Squared errors of components.
+      *  \param[in,out] total_norm Squared norm of all components.
+      *  \param[in,out] total_error Squared error of all components.
+      *  \param[in] solutions_for_adapt True if the errors of elements are stored. */
+      void calc_err_threaded(Mesh** meshes, Transformable** tr, double* norms, double* errors_components,
+        double& total_norm, double& total_error, bool solutions_for_adapt);
+
       /// One Space version.
       virtual double calc_err_internal(Solution<Scalar>* sln, Solution<Scalar>* rsln,
         Hermes::vector<double>* component_errors, bool solutions_for_adapt,
@@ -31,6 +31,7 @@ namespace Hermes
   namespace Hermes2D
   {
     class PrecalcShapeset;
+    class Traverse;
 
     /// Multimesh neighbors traversal class.
     class NeighborNode
@@ -84,6 +85,13 @@ namespace Hermes
       void assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = NULL,
         bool force_diagonal_blocks = false, bool add_dir_lift = true, Table* block_weights = NULL);
 
+      /// Batched assembling of several right-hand sides (load cases) in one traversal.
+      /// The vector forms with Form::load_case == k are added to rhs[k], the forms of load cases
+      /// without a vector in rhs are not evaluated. The matrix is optional (mat may be NULL),
+      /// the other parameters are the same as in the previous function.
+      void assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Hermes::vector<Vector<Scalar>*> rhs,
+        bool force_diagonal_blocks = false, bool add_dir_lift = true, Table* block_weights = NULL);
+
       /// Assembling.
       /// Without the matrix.
       void assemble(Scalar* coeff_vec, Vector<Scalar>* rhs = NULL,
@@ -100,6 +108,15 @@ namespace Hermes
       void assemble(Vector<Scalar>* rhs = NULL, bool force_diagonal_blocks = false,
         Table* block_weights = NULL);
 
+      /// Matrix-free application of the matrix (the Jacobian at coeff_vec): y = A x.
+      /// The element matrices are evaluated on the fly and multiplied with x, no SparseMatrix
+      /// is built, so the memory use does not grow with the number of nonzeros. The parameters
+      /// are the same as in assemble(), y has to hold get_num_dofs() values.
+      void apply(Scalar* coeff_vec, const Scalar* x, Scalar* y, bool add_dir_lift = true, Table* block_weights = NULL);
+
+      /// Light version passing NULL for the coefficient vector.
+      void apply(const Scalar* x, Scalar* y, Table* block_weights = NULL);
+
       void invalidate_matrix();
 
       /// Set this problem to Finite Volume.
@@ -109,10 +126,43 @@ namespace Hermes
 
       void set_spaces(const Space<Scalar>* space);
 
+      /// Set the number of threads used in assembling (the default 1 means serial assembling).
+      /// Requires OpenMP (WITH_OPENMP). Elements are then assembled concurrently, so the forms
+      /// must not modify any shared data in value() and ord(). The assembled matrix and vector
+      /// are identical to the serial ones. Stages with DG forms, or with external functions
+      /// that are not Solutions coming from a computation, are still assembled serially.
+      void set_num_threads(int num_threads);
+
+      /// Use the element coloring in the threaded assembling. The active elements are divided
+      /// into groups (colors) so that no two elements of one group share a DOF, the groups are
+      /// then assembled one after another, the elements of a group concurrently and directly into
+      /// the matrix and vector (no recording). The coloring is cached until the spaces or meshes change.
+      /// Used only if the matrix and vector support concurrent add (e.g. UMFPackMatrix) and all
+      /// functions of the stage are defined on one mesh, otherwise the default threaded assembling is used.
+      /// The contributions are summed in a different order than in the serial assembling, so the
+      /// results may differ in round-off.
+      void set_element_coloring(bool element_coloring);
+
+      /// Record the traversal of the union of the meshes of each stage in the first assembling and
+      /// reuse it in the following ones, as long as the meshes do not change (on by default).
+      /// Not used for stages with DG forms or with external functions that are not Solutions.
+      /// Without it, the serial assembling traverses the meshes directly, the threaded one records
+      /// the traversal in every assembling.
+      void set_reuse_traversal(bool reuse_traversal);
+
+      /// Peak use (in bytes) of the memory arenas the values of the temporary Func, Geom and ExtData
+      /// instances of the form evaluations are allocated from (the maximum over the threads).
+      size_t get_arena_peak_size() const;
+
     protected:
       /// Get the number of unknowns.
       int get_num_dofs();
 
+      /// Assembling into a matrix and vector whose structure has been created
+      /// (the common part of assemble() and apply()).
+      void assemble_system(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
+        bool force_diagonal_blocks, bool add_dir_lift, Table* block_weights);
+
       /// Get info about presence of a matrix.
       bool is_matrix_free();
 
@@ -136,6 +186,8 @@ namespace Hermes
       /// forms do not exist. This is useful if the matrix is later to be merged with
       /// a matrix that has nonzeros in these blocks. The Table serves for optional
       /// weighting of matrix blocks in systems.
+      /// If all spaces are on the same mesh, there are no DG forms and the spaces assign DOFs incrementally
+      /// (see Space::set_incremental_dofs()), only the part of the structure belonging to the touched DOFs is updated.
       void create_sparse_structure(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = NULL,
         bool force_diagonal_blocks = false, Table* block_weights = NULL);
 
@@ -231,6 +283,79 @@ namespace Hermes
         int marker, Hermes::vector<AsmList<Scalar>*>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat,
         int isurf, Element** e, Element* trav_base, Element* rep_element);
 
+      /// Class holding one recorded assembling state for the threaded assembling.
+      class AssemblingState;
+
+      /// Class holding the data of one assembling thread.
+      class AssemblingThread;
+
+      /// Returns true if the stage can be assembled from the recorded traversal of its meshes
+      /// (the functions of the stage can be set to the recorded states).
+      bool is_traverse_plan_possible(Stage<Scalar>& stage);
+
+      /// Returns the recorded traversal of the meshes of the stage, records it again if the meshes have changed.
+      TraversePlan* get_traverse_plan(Stage<Scalar>& stage);
+
+      /// Deletes the recorded traversals of the mesh sets that are not used by the stages, if some of the stages
+      /// has no recorded traversal yet (e.g. new reference meshes in every adaptivity step).
+      void evict_traverse_plans(Hermes::vector<Stage<Scalar> >& stages);
+
+      /// Returns true if the stage can be assembled by multiple threads.
+      bool is_threaded_assembling_possible(Stage<Scalar>& stage);
+
+      /// Assemble one stage using multiple threads.
+      /// The states of the plan are assembled concurrently in rounds.
+      void assemble_one_stage_threaded(Stage<Scalar>& stage,
+        SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs, bool force_diagonal_blocks, Table* block_weights,
+        Hermes::vector<Solution<Scalar>*>& u_ext, TraversePlan* plan);
+
+      /// Assemble the recorded states [0, num_states) concurrently and add their contributions
+      /// to mat and rhs in the order of the states.
+      void assemble_states_threaded(Stage<Scalar>& stage,
+        SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs, bool force_diagonal_blocks, Table* block_weights,
+        Hermes::vector<Solution<Scalar>*>& u_ext, int num_states);
+
+      /// Sets the active elements and transformations of the functions fns according to a recorded state.
+      void set_assembling_state(Hermes::vector<Transformable*>& fns, AssemblingState* state);
+
+      /// Sets the active elements e and their transformations sub_idx to the functions fns.
+      void set_state_transforms(Hermes::vector<Transformable*>& fns, Element** e, uint64_t* sub_idx);
+
+      /// Makes dp add the vector forms of the load cases to the records of the state (batched threaded assembling).
+      void record_load_cases(DiscreteProblem<Scalar>* dp, AssemblingState* state);
+
+      /// Returns the vector the form is added to: rhs for the load case 0, otherwise the vector
+      /// of the form's load case in the batched assembling (NULL if the load case is not assembled).
+      Vector<Scalar>* get_load_case_rhs(Vector<Scalar>* rhs, Form<Scalar>* form);
+
+      /// Prepares the assembling threads for the stage (spaces, copies of external functions).
+      void init_assembling_threads(Stage<Scalar>& stage, Hermes::vector<Solution<Scalar>*>& u_ext);
+
+      /// Deletes the copies of external functions made for the stage.
+      void finish_assembling_threads();
+
+      /// Deletes the assembling threads.
+      void free_assembling_threads();
+
+      /// Class holding the element coloring of a mesh.
+      class ElementColoring;
+
+      /// Returns true if the stage can be assembled using the element coloring.
+      bool is_element_coloring_possible(Stage<Scalar>& stage, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs);
+
+      /// Colors the active elements of the mesh according to the DOFs of all spaces on it.
+      /// Does nothing if the cached coloring is up to date.
+      void update_element_coloring(const Mesh* mesh);
+
+      /// Assemble one stage using multiple threads and the element coloring.
+      void assemble_one_stage_colored(Stage<Scalar>& stage,
+        SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs, bool force_diagonal_blocks, Table* block_weights,
+        Hermes::vector<Solution<Scalar>*>& u_ext, TraversePlan* plan);
+
+      /// Returns the copy of the external function used by this instance (threaded assembling),
+      /// or the function itself.
+      MeshFunction<Scalar>* get_ext_fn(MeshFunction<Scalar>* fn);
+
       /// Init function. Common code for the constructors.
       void init();
 
@@ -401,6 +526,17 @@ namespace Hermes
       /// Matrix structure as well as spaces and weak formulation is up-to-date.
       bool is_up_to_date();
 
+      /// Updates ndof and spaces_first_dofs after the spaces have changed.
+      void update_num_dofs();
+
+      /// Creates the matrix sparse structure for spaces on a common mesh assigning DOFs incrementally.
+      /// The stored structure is reused for the columns of the DOFs not touched since the last call.
+      void create_sparse_structure_incremental(SparseMatrix<Scalar>* mat, bool force_diagonal_blocks);
+
+      /// The matrix sparse structure (rows of all columns) created by create_sparse_structure_incremental().
+      std::vector<int> sp_structure_start, sp_structure_rows;
+      bool sp_structure_force_diagonal_blocks;
+
       /// Minimum identifier of the meshes used in DG assembling in one stage.
       unsigned int min_dg_mesh_seq;
 
@@ -459,6 +595,39 @@ namespace Hermes
       /// Number of spaces in the original problem in a Runge-Kutta method.
       int RK_original_spaces_count;
 
+      /// Number of threads used in assembling.
+      int num_threads;
+
+      /// Maximum number of states assembled by one thread in one round of the threaded assembling.
+      static const int H2D_STATES_PER_THREAD = 16;
+
+      /// Assembling threads (each with its own DiscreteProblem, slave pss's, refmaps).
+      Hermes::vector<AssemblingThread*> assembling_threads;
+
+      /// Recorded states for one round of the threaded assembling.
+      Hermes::vector<AssemblingState*> assembling_states;
+
+      /// Use the element coloring in the threaded assembling.
+      bool element_coloring;
+
+      /// Cached element coloring.
+      ElementColoring* coloring;
+
+      /// Reuse the recorded traversals of the meshes of the stages.
+      bool reuse_traversal;
+
+      /// Recorded traversals of the meshes of the stages, reused while the meshes do not change.
+      Hermes::vector<TraversePlan*> traverse_plans;
+
+      /// Copies of the external functions (if this instance is used by an assembling thread).
+      std::map<MeshFunction<Scalar>*, MeshFunction<Scalar>*> ext_fn_copies;
+
+      /// Arena of the temporaries of one assembling state, reset after each state.
+      MemoryArena arena;
+
+      /// Right-hand sides of the load cases in the batched assembling (empty otherwise).
+      Hermes::vector<Vector<Scalar>*> load_case_rhs;
+
       /// Class handling various caches used in assembling.
       class AssemblingCaches
       {
@@ -482,25 +651,17 @@ namespace Hermes
 #endif
           int shapeset_type;
           double inv_ref_map[2][2];
+          KeyConst() {};
 #ifdef _MSC_VER
           KeyConst(int index, int order, UINT64 sub_idx, int shapeset_type, double2x2* inv_ref_map);
 #else
           KeyConst(int index, int order, unsigned int sub_idx, int shapeset_type, double2x2* inv_ref_map);
 #endif
+          /// Hash value of the key.
+          unsigned int hash() const;
+          bool operator==(const KeyConst& other) const;
         };
 
-        /// Functor that compares two above keys (needed e.g. to create a std::map indexed by these keys);
-        struct CompareConst
-        {
-          bool operator()(KeyConst a, KeyConst b) const;
-        };
-
-        /// PrecalcShapeset stored values for Elements with constant jacobian of the reference mapping for triangles.
-        std::map<KeyConst, Func<double>* , CompareConst> const_cache_fn_triangles;
-
-        /// PrecalcShapeset stored values for Elements with constant jacobian of the reference mapping for quads.
-        std::map<KeyConst, Func<double>* , CompareConst> const_cache_fn_quads;
-
         /// The same setup for elements with non-constant jacobians.
         /// This cache is deleted with every change of the state in assembling.
         struct KeyNonConst
@@ -513,35 +674,192 @@ namespace Hermes
           unsigned int sub_idx;
 #endif
           int shapeset_type;
+          KeyNonConst() {};
 #ifdef _MSC_VER
           KeyNonConst(int index, int order, UINT64 sub_idx, int shapeset_type);
 #else
           KeyNonConst(int index, int order, unsigned int sub_idx, int shapeset_type);
 #endif
+          /// Hash value of the key.
+          unsigned int hash() const;
+          bool operator==(const KeyNonConst& other) const;
         };
 
-        /// Functor that compares two above keys (needed e.g. to create a std::map indexed by these keys);
-        struct CompareNonConst
+        /// Hash table of precalculated values (open addressing, linear probing). The keys and
+        /// the pointers to the values are stored in flat arrays, so a lookup is a hash computation
+        /// and (mostly) one probe into contiguous memory. The table owns the stored values.
+        template<typename Key>
+        class FnCache
         {
-          bool operator()(KeyNonConst a, KeyNonConst b) const;
+        public:
+          FnCache();
+          ~FnCache();
+
+          /// Returns the values stored for the key, NULL if there are none.
+          Func<double>* get(const Key& key) const;
+
+          /// Stores the values for the key (which must not be present yet).
+          void add(const Key& key, Func<double>* fn);
+
+          /// Deletes all stored values. Takes time proportional to their number, not to the table capacity.
+          void clear();
+
+          /// Number of stored values.
+          unsigned int get_size() const;
+
+        protected:
+          /// Rebuilds the table with the new capacity (a power of two).
+          void rehash(unsigned int new_capacity);
+
+          /// Slot of the key, or the empty slot where it would be stored.
+          unsigned int find_slot(const Key& key) const;
+
+          /// Keys and values, fns[i] == NULL for an empty slot i.
+          Hermes::vector<Key> keys;
+          Hermes::vector<Func<double>*> fns;
+
+          /// Occupied slots (in the order of adding).
+          Hermes::vector<unsigned int> used_slots;
+
+          /// Capacity - 1.
+          unsigned int mask;
         };
 
+        /// PrecalcShapeset stored values for Elements with constant jacobian of the reference mapping for triangles.
+        FnCache<KeyConst> const_cache_fn_triangles;
+
+        /// PrecalcShapeset stored values for Elements with constant jacobian of the reference mapping for quads.
+        FnCache<KeyConst> const_cache_fn_quads;
+
         /// PrecalcShapeset stored values for Elements with non-constant jacobian of the reference mapping for triangles.
-        std::map<KeyNonConst, Func<double>* , CompareNonConst> cache_fn_triangles;
+        FnCache<KeyNonConst> cache_fn_triangles;
 
         /// PrecalcShapeset stored values for Elements with non-constant jacobian of the reference mapping for quads.
-        std::map<KeyNonConst, Func<double>* , CompareNonConst> cache_fn_quads;
+        FnCache<KeyNonConst> cache_fn_quads;
 
         LightArray<Func<Hermes::Ord>*> cache_fn_ord;
+
+        /// Key of the memo of the integration orders of the forms: the form and the polynomial
+        /// orders of the arguments of its ord() method.
+        struct KeyOrder
+        {
+          /// Maximum number of orders in a key, the order of a form with more arguments is not memoized.
+          static const int H2D_MAX_ORDERS = 24;
+
+          const void* form;
+          int marker;        ///< Marker of the neighbor element for DG forms, -1 otherwise.
+          int num_orders;
+          unsigned char orders[H2D_MAX_ORDERS];
+
+          KeyOrder(const void* form = NULL, int marker = -1);
+
+          /// Appends the order of the function (the central and neighbor orders of a DiscontinuousFunc,
+          /// -1 for a missing one). Returns false if the order can not be stored in the key.
+          bool add(Func<Hermes::Ord>* fn);
+
+          /// Appends an order, returns false if it can not be stored in the key.
+          bool add(int order, bool discontinuous = false);
+
+          /// Hash value of the key.
+          unsigned int hash() const;
+          bool operator==(const KeyOrder& other) const;
+        };
+
+        /// Memo of the integration orders of the forms (open addressing, linear probing).
+        class OrderMemo
+        {
+        public:
+          OrderMemo();
+
+          /// Looks up the order stored for the key, returns false if there is none.
+          bool get(const KeyOrder& key, int& order) const;
+
+          /// Stores the order for the key.
+          void add(const KeyOrder& key, int order);
+
+          /// Forgets all orders (the forms may have changed).
+          void clear();
+
+          /// Number of stored orders.
+          unsigned int get_size() const;
+
+        protected:
+          /// Rebuilds the table with the new capacity (a power of two).
+          void rehash(unsigned int new_capacity);
+
+          /// Slot of the key, or the empty slot where it would be stored.
+          unsigned int find_slot(const KeyOrder& key) const;
+
+          /// Keys and orders, used[i] is false for an empty slot i.
+          Hermes::vector<KeyOrder> keys;
+          Hermes::vector<int> orders;
+          Hermes::vector<bool> used;
+
+          /// Number of stored orders.
+          unsigned int size;
+
+          /// Capacity - 1.
+          unsigned int mask;
+        };
+
+        /// Integration orders of the forms (see Form::set_order_memoization()).
+        OrderMemo order_memo;
       };
 
       /// An AssemblingCaches instance for this instance of DiscreteProblem.
       AssemblingCaches assembling_caches;
 
+      /// Initializes the key of the memo of the integration orders from the arguments of the ord() method of the form
+      /// (ou is NULL for vector forms, marker is the neighbor element marker for DG forms).
+      /// Returns false if the order of the form is not to be memoized.
+      bool init_order_key(typename AssemblingCaches::KeyOrder& key, Form<Scalar>* form,
+        Func<Hermes::Ord>** oi, int num_oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov, ExtData<Hermes::Ord>* ext, int marker = -1);
+
+      /// Returns the total order of the form for the orders of the arguments of its ord() method, memoized in
+      /// assembling_caches if the form allows it. The arguments are the same as in init_order_key().
+      template<typename FormType>
+      int calc_form_order(FormType* form, Func<Hermes::Ord>** oi, int num_oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext, int marker = -1);
+
+      /// Evaluates the ord() method of a matrix form.
+      template<typename FormType>
+      static int eval_form_order(FormType* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext);
+
+      /// Evaluate the ord() method of the vector forms (ou is not used).
+      static int eval_form_order(VectorFormVol<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext);
+      static int eval_form_order(MultiComponentVectorFormVol<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext);
+      static int eval_form_order(VectorFormSurf<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext);
+      static int eval_form_order(MultiComponentVectorFormSurf<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov,
+        Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext);
+
       template<typename T> friend class KellyTypeAdapt;
       template<typename T> friend class NewtonSolver;
       template<typename T> friend class PicardSolver;
       template<typename T> friend class RungeKutta;
+      template<typename T> friend class DiscreteProblemOperator;
+    };
+
+    /// The matrix (the Jacobian at coeff_vec) of a DiscreteProblem as an operator of the
+    /// matrix-free KrylovSolver, the products are computed by DiscreteProblem::apply().
+    template<typename Scalar>
+    class HERMES_API DiscreteProblemOperator : public Hermes::Solvers::KrylovOperator<Scalar>
+    {
+    public:
+      /// Constructor, the coefficient vector and the block weights are used as in DiscreteProblem::apply().
+      DiscreteProblemOperator(DiscreteProblem<Scalar>* dp, Scalar* coeff_vec = NULL, Table* block_weights = NULL);
+
+      virtual unsigned int get_size();
+
+      virtual void apply(const Scalar* x, Scalar* y);
+
+    protected:
+      DiscreteProblem<Scalar>* dp;
+      Scalar* coeff_vec;
+      Table* block_weights;
     };
   }
 }
@@ -53,6 +53,9 @@ namespace Hermes
       Mesh*   get_mesh() const;
       RefMap* get_refmap();
 
+      /// Sets the shapesets of the reference map, see RefMap::set_shapes().
+      void set_refmap_shapes(RefMapShapes* shapes);
+
       virtual int get_edge_fn_order(int edge);
 
       virtual Scalar get_pt_value(double x, double y, int item = H2D_FN_VAL_0) = 0;
@@ -113,6 +113,11 @@ namespace Hermes
       HERMES_INVALID_SPACE = -9999
     };
 
+    enum DofOrdering {
+      HERMES_DOF_ORDERING_NATURAL = 0,  ///< In the order of the nodes and elements.
+      HERMES_DOF_ORDERING_RCM = 1       ///< Reverse Cuthill-McKee (reduces the bandwidth of the matrix).
+    };
+
     /// How many bits the order number takes.
     const int H2D_ORDER_BITS = 5;
     const int H2D_ORDER_MASK = (1 << H2D_ORDER_BITS) - 1;
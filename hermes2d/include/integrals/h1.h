@@ -19,11 +19,159 @@
 #include "../quadrature/limit_order.h"
 #include "../forms.h"
 #include "../function/function.h"
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//// vectorized kernels ////////////////////////////////////////////////////////////////////////////
+
+// The sums over the integration points of the integrals of real (double) functions are vectorized
+// with the widest instruction set the compiler targets (AVX-512, AVX/AVX2, SSE2), in the portable
+// fallback H2D_SIMD_WIDTH is 1. Build with WITH_NATIVE_SIMD to target the instruction set of the
+// build machine. The values, derivatives and weights are already stored as separate arrays
+// (structure of arrays) in Func, Geom and the quadrature, they are loaded unaligned.
+#if defined(__AVX512F__)
+#define H2D_SIMD_WIDTH 8
+typedef __m512d h2d_simd_t;
+#define h2d_simd_zero() _mm512_setzero_pd()
+#define h2d_simd_load(p) _mm512_loadu_pd(p)
+#define h2d_simd_store(p, a) _mm512_storeu_pd(p, a)
+#define h2d_simd_mul(a, b) _mm512_mul_pd(a, b)
+#define h2d_simd_add(a, b) _mm512_add_pd(a, b)
+#elif defined(__AVX__)
+#define H2D_SIMD_WIDTH 4
+typedef __m256d h2d_simd_t;
+#define h2d_simd_zero() _mm256_setzero_pd()
+#define h2d_simd_load(p) _mm256_loadu_pd(p)
+#define h2d_simd_store(p, a) _mm256_storeu_pd(p, a)
+#define h2d_simd_mul(a, b) _mm256_mul_pd(a, b)
+#define h2d_simd_add(a, b) _mm256_add_pd(a, b)
+#elif defined(__SSE2__)
+#define H2D_SIMD_WIDTH 2
+typedef __m128d h2d_simd_t;
+#define h2d_simd_zero() _mm_setzero_pd()
+#define h2d_simd_load(p) _mm_loadu_pd(p)
+#define h2d_simd_store(p, a) _mm_storeu_pd(p, a)
+#define h2d_simd_mul(a, b) _mm_mul_pd(a, b)
+#define h2d_simd_add(a, b) _mm_add_pd(a, b)
+#else
+#define H2D_SIMD_WIDTH 1
+#endif
 
 namespace Hermes
 {
   namespace Hermes2D
   {
+#if H2D_SIMD_WIDTH > 1
+    /// Sum of the components of a vector register.
+    inline double h2d_simd_sum(h2d_simd_t a)
+    {
+      double components[H2D_SIMD_WIDTH];
+      h2d_simd_store(components, a);
+      double result = 0.0;
+      for (int i = 0; i < H2D_SIMD_WIDTH; i++)
+        result += components[i];
+      return result;
+    }
+#endif
+
+    /// Returns the sum of wt[i] * c[i] * a[i] * b[i] over the n points, c may be NULL (c[i] = 1).
+    inline double integrate_product(int n, const double* wt, const double* a, const double* b, const double* c = NULL)
+    {
+      int i = 0;
+      double result = 0.0;
+#if H2D_SIMD_WIDTH > 1
+      h2d_simd_t sum = h2d_simd_zero();
+      if (c == NULL)
+        for (; i + H2D_SIMD_WIDTH <= n; i += H2D_SIMD_WIDTH)
+          sum = h2d_simd_add(sum, h2d_simd_mul(h2d_simd_mul(h2d_simd_load(wt + i), h2d_simd_load(a + i)), h2d_simd_load(b + i)));
+      else
+        for (; i + H2D_SIMD_WIDTH <= n; i += H2D_SIMD_WIDTH)
+          sum = h2d_simd_add(sum, h2d_simd_mul(h2d_simd_mul(h2d_simd_mul(h2d_simd_load(wt + i), h2d_simd_load(c + i)),
+            h2d_simd_load(a + i)), h2d_simd_load(b + i)));
+      result = h2d_simd_sum(sum);
+#endif
+      for (; i < n; i++)
+        result += (c == NULL ? wt[i] : wt[i] * c[i]) * a[i] * b[i];
+      return result;
+    }
+
+    /// Returns the sum of wt[i] * c[i] * (ax[i] * bx[i] + ay[i] * by[i]) over the n points, c may be NULL (c[i] = 1).
+    inline double integrate_grad_product(int n, const double* wt, const double* ax, const double* ay,
+      const double* bx, const double* by, const double* c = NULL)
+    {
+      int i = 0;
+      double result = 0.0;
+#if H2D_SIMD_WIDTH > 1
+      h2d_simd_t sum = h2d_simd_zero();
+      for (; i + H2D_SIMD_WIDTH <= n; i += H2D_SIMD_WIDTH)
+      {
+        h2d_simd_t w = h2d_simd_load(wt + i);
+        if (c != NULL)
+          w = h2d_simd_mul(w, h2d_simd_load(c + i));
+        h2d_simd_t grad = h2d_simd_add(h2d_simd_mul(h2d_simd_load(ax + i), h2d_simd_load(bx + i)),
+          h2d_simd_mul(h2d_simd_load(ay + i), h2d_simd_load(by + i)));
+        sum = h2d_simd_add(sum, h2d_simd_mul(w, grad));
+      }
+      result = h2d_simd_sum(sum);
+#endif
+      for (; i < n; i++)
+        result += (c == NULL ? wt[i] : wt[i] * c[i]) * (ax[i] * bx[i] + ay[i] * by[i]);
+      return result;
+    }
+
+    /// Complex version of integrate_product(), a is complex (the real and imaginary parts are summed together).
+    inline std::complex<double> integrate_product(int n, const double* wt, const std::complex<double>* a,
+      const double* b, const double* c = NULL)
+    {
+      int i = 0;
+      std::complex<double> result = 0.0;
+#if H2D_SIMD_WIDTH > 1
+      // One complex number per 128-bit register, the real weights are broadcast.
+      const double* a_parts = reinterpret_cast<const double*>(a);
+      __m128d sum = _mm_setzero_pd();
+      for (; i < n; i++)
+        sum = _mm_add_pd(sum, _mm_mul_pd(_mm_loadu_pd(a_parts + 2 * i),
+          _mm_set1_pd((c == NULL ? wt[i] : wt[i] * c[i]) * b[i])));
+      double parts[2];
+      _mm_storeu_pd(parts, sum);
+      result = std::complex<double>(parts[0], parts[1]);
+#endif
+      for (; i < n; i++)
+        result += ((c == NULL ? wt[i] : wt[i] * c[i]) * b[i]) * a[i];
+      return result;
+    }
+
+    /// Complex version of integrate_grad_product(), ax and ay are complex.
+    inline std::complex<double> integrate_grad_product(int n, const double* wt, const std::complex<double>* ax,
+      const std::complex<double>* ay, const double* bx, const double* by, const double* c = NULL)
+    {
+      int i = 0;
+      std::complex<double> result = 0.0;
+#if H2D_SIMD_WIDTH > 1
+      const double* ax_parts = reinterpret_cast<const double*>(ax);
+      const double* ay_parts = reinterpret_cast<const double*>(ay);
+      __m128d sum = _mm_setzero_pd();
+      for (; i < n; i++)
+      {
+        double w = (c == NULL ? wt[i] : wt[i] * c[i]);
+        sum = _mm_add_pd(sum, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(ax_parts + 2 * i), _mm_set1_pd(w * bx[i])),
+          _mm_mul_pd(_mm_loadu_pd(ay_parts + 2 * i), _mm_set1_pd(w * by[i]))));
+      }
+      double parts[2];
+      _mm_storeu_pd(parts, sum);
+      result = std::complex<double>(parts[0], parts[1]);
+#endif
+      for (; i < n; i++)
+      {
+        double w = (c == NULL ? wt[i] : wt[i] * c[i]);
+        result += (w * bx[i]) * ax[i] + (w * by[i]) * ay[i];
+      }
+      return result;
+    }
+
     template<typename Real>
     Real int_v(int n, double *wt, Func<Real> *v)
     {
@@ -294,6 +442,151 @@ namespace Hermes
       return result;
     }
 
+    // The integrals of double-valued functions use the vectorized kernels.
+    template<>
+    inline double int_u_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v)
+    {
+      return integrate_product(n, wt, u->val, v->val);
+    }
+
+    template<>
+    inline std::complex<double> int_u_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v)
+    {
+      return std::complex<double>(integrate_product(n, wt, u->val, v->val));
+    }
+
+    template<>
+    inline double int_x_u_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u->val, v->val, e->x);
+    }
+
+    template<>
+    inline std::complex<double> int_x_u_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return std::complex<double>(integrate_product(n, wt, u->val, v->val, e->x));
+    }
+
+    template<>
+    inline double int_y_u_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u->val, v->val, e->y);
+    }
+
+    template<>
+    inline std::complex<double> int_y_u_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return std::complex<double>(integrate_product(n, wt, u->val, v->val, e->y));
+    }
+
+    template<>
+    inline double int_u_ext_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val);
+    }
+
+    template<>
+    inline std::complex<double> int_u_ext_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val);
+    }
+
+    template<>
+    inline double int_x_u_ext_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val, e->x);
+    }
+
+    template<>
+    inline std::complex<double> int_x_u_ext_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val, e->x);
+    }
+
+    template<>
+    inline double int_y_u_ext_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val, e->y);
+    }
+
+    template<>
+    inline std::complex<double> int_y_u_ext_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_product(n, wt, u_ext->val, v->val, e->y);
+    }
+
+    template<>
+    inline double int_grad_u_grad_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v)
+    {
+      return integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy);
+    }
+
+    template<>
+    inline std::complex<double> int_grad_u_grad_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v)
+    {
+      return std::complex<double>(integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy));
+    }
+
+    template<>
+    inline double int_x_grad_u_grad_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy, e->x);
+    }
+
+    template<>
+    inline std::complex<double> int_x_grad_u_grad_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return std::complex<double>(integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy, e->x));
+    }
+
+    template<>
+    inline double int_y_grad_u_grad_v<double, double>(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy, e->y);
+    }
+
+    template<>
+    inline std::complex<double> int_y_grad_u_grad_v<double, std::complex<double> >(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e)
+    {
+      return std::complex<double>(integrate_grad_product(n, wt, u->dx, u->dy, v->dx, v->dy, e->y));
+    }
+
+    template<>
+    inline double int_grad_u_ext_grad_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy);
+    }
+
+    template<>
+    inline std::complex<double> int_grad_u_ext_grad_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy);
+    }
+
+    template<>
+    inline double int_x_grad_u_ext_grad_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy, e->x);
+    }
+
+    template<>
+    inline std::complex<double> int_x_grad_u_ext_grad_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy, e->x);
+    }
+
+    template<>
+    inline double int_y_grad_u_ext_grad_v<double, double>(int n, double *wt, Func<double> *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy, e->y);
+    }
+
+    template<>
+    inline std::complex<double> int_y_grad_u_ext_grad_v<double, std::complex<double> >(int n, double *wt, Func<std::complex<double> > *u_ext, Func<double> *v, Geom<double> *e)
+    {
+      return integrate_grad_product(n, wt, u_ext->dx, u_ext->dy, v->dx, v->dy, e->y);
+    }
+
     //// error & norm integrals  ////////////////////////////////////////////////////////////////////////
 
     // the inner integration loops for both constant and non-constant jacobian elements
@@ -37,6 +37,8 @@ namespace Hermes
     ///
     /// HashTable is a base class for Mesh. It serves as a container for all nodes
     /// of a mesh. Moreover, it has node searching functions based on hash tables.
+    /// The hash tables use open addressing with linear probing, and they are doubled
+    /// whenever they get more than half full.
     ///
     class HERMES_API HashTable
     {
@@ -70,12 +72,24 @@ namespace Hermes
       /// created first.
       Node* get_edge_node(int p1, int p2);
 
-      static const int H2D_DEFAULT_HASH_SIZE = 0x8000; // 32K entries
+      /// Creates a vertex node with parent id's p1 and p2, which must not exist yet.
+      /// Used instead of get_vertex_node() when the caller knows the node is new.
+      Node* add_vertex_node(int p1, int p2);
+
+      /// Creates an edge node with parent id's p1 and p2, which must not exist yet.
+      /// Used instead of get_edge_node() when the caller knows the node is new.
+      Node* add_edge_node(int p1, int p2);
+
+      /// Enlarges the hash tables in advance for the given numbers of new vertex and edge nodes,
+      /// so that they are not doubled repeatedly while the nodes are added.
+      void reserve(int num_new_vertex_nodes, int num_new_edge_nodes);
+
+      static const int H2D_DEFAULT_HASH_SIZE = 0x1000; // 4K entries (initially)
 
       Array<Node> nodes; ///< Array storing all nodes
 
       /// Initializes the hash table.
-      /// \param size [in] Hash table size; must be a power of two.
+      /// \param size [in] Initial hash table size; must be a power of two.
       void init(int size = H2D_DEFAULT_HASH_SIZE);
 
       /// Copies another hash table contents
@@ -87,7 +101,8 @@ namespace Hermes
       /// Frees all memory used by the instance.
       void free();
 
-      /// Prints hash table statistics for debugging purposes.
+      /// Prints hash table statistics (the load factors and the average number
+      /// of probes per query) for debugging purposes.
       void dump_hash_stat();
 
       /// Removes a vertex node with parent id's p1 and p2.
@@ -100,20 +115,46 @@ namespace Hermes
       // Internal members
     private:
 
-      Node** v_table; ///< Vertex node hash table
-      Node** e_table; ///< Edge node hash table
+      /// Entry of a hash table: the parent id's of a node and its id (-1 if the entry is empty).
+      struct HashEntry
+      {
+        int p1, p2, id;
+      };
 
-      int mask;
+      HashEntry* v_table; ///< Vertex node hash table
+      HashEntry* e_table; ///< Edge node hash table
+
+      int v_mask, e_mask;   ///< Sizes of the hash tables minus one
+      int v_count, e_count; ///< Numbers of nodes in the hash tables
       int nqueries, ncollisions;
 
-      int hash(int p1, int p2) { return (984120265*p1 + 125965121*p2) & mask; }
+      int hash(int p1, int p2, int mask) const
+      {
+        unsigned int h = 984120265u * p1 + 125965121u * p2;
+        return (h ^ (h >> 16)) & mask;
+      }
+
+      /// Returns the position of the node with parent id's p1 and p2 in the table,
+      /// or the position of the empty entry where the node belongs.
+      int search_table(HashEntry* table, int mask, int p1, int p2);
+
+      /// Inserts the node at the position pos (found by search_table()) and doubles the table if it gets more than half full.
+      void insert_node(HashEntry*& table, int& mask, int& count, int pos, Node* node);
+
+      /// Removes the node from the table, shifts back the following entries of its cluster.
+      void remove_node(HashEntry* table, int mask, int& count, Node* node);
+
+      /// Allocates an empty table of the given size.
+      static HashEntry* alloc_table(int size);
+
+      /// Moves the entries of the table to a new table of the given size (a power of two).
+      void resize_table(HashEntry*& table, int& mask, int size);
 
-      /// Searches a list of hash synonyms given the first list item.
-      /// Returns the node matching the parent ids p1 and p2.
-      Node* search_list(Node* node, int p1, int p2);
+      /// Initializes a new vertex node and inserts it at the position pos (found by search_table()).
+      Node* create_vertex_node(int p1, int p2, int pos);
 
-      /// Creates a copy of a hash synonym list.
-      void copy_list(Node** ptr, Node* node);
+      /// Initializes a new edge node and inserts it at the position pos (found by search_table()).
+      Node* create_edge_node(int p1, int p2, int pos);
 
       friend struct Node;
       friend class MeshReaderH2D;
@@ -79,7 +79,6 @@ namespace Hermes
       };
 
       int p1, p2; ///< parent id numbers
-      Node* next_hash; ///< next node in hash synonym list
 
       /// Returns true if the (vertex) node is constrained.
       bool is_constrained_vertex() const;
@@ -263,6 +262,11 @@ namespace Hermes
       void refine_element_id(int id, int refinement = 0);
 
       /// Refines all elements.
+      /// A conforming mesh without curved elements is refined uniformly (refinement 0) in bulk:
+      /// the neighbors of the elements are found first (in parallel), the new nodes and elements
+      /// are then created without searching the hash tables, in space allocated in advance.
+      /// The resulting mesh (including the id numbers of the nodes and elements) is identical
+      /// to the one obtained by refining the elements one by one.
       /// \param refinement [in] Same meaning as in refine_element_id().
       void refine_all_elements(int refinement = 0, bool mark_as_initial = false);
 
@@ -321,6 +325,17 @@ namespace Hermes
       /// Note: this function creates a base mesh.
       void convert_triangles_to_quads();
 
+      /// Renumbers the elements along the Hilbert curve through their centroids, so that
+      /// the elements close to each other are stored (and visited by for_all_active_elements
+      /// and Traverse) close to each other, which improves the reuse of cached nodes and
+      /// coefficients. The base elements, the initial refinements and the other elements are
+      /// renumbered separately, the ids used stay the same. Meshes traversed together must be
+      /// reordered the same way (the base elements of meshes with the same base get the same ids).
+      /// Spaces and solutions on the mesh have to be created again. The reordering is recorded in the
+      /// refinements together with the number of the initial elements, so that a saved mesh is loaded
+      /// with the same ids also if mark_as_initial was used.
+      void reorder_elements();
+
       /// For 1D problems.
       /// Returns the left boundary coordinate.
       double get_a();
@@ -331,6 +346,10 @@ namespace Hermes
       /// For internal use.
       int get_edge_sons(Element* e, int edge, int& son1, int& son2);
 
+      /// Reorders the elements as reorder_elements(), the elements below num_initial (and not below nbase)
+      /// are the initial refinements. Used to replay the recorded reordering.
+      void reorder_elements(int num_initial);
+
       /// Refines all quad elements to triangles.
       /// It refines a quadrilateral element into two triangles.
       /// Note: this function creates a base mesh.
@@ -627,6 +646,19 @@ namespace Hermes
       void refine_quad(Element* e, int refinement, Element** sons_out = NULL);
       void refine_triangle_to_triangles(Element* e, Element** sons = NULL);
 
+      /// Refines all active elements uniformly in bulk (see refine_all_elements()). Returns false,
+      /// leaving the mesh unchanged, if the refinement is not 0, or if the mesh has hanging nodes
+      /// or curved elements.
+      bool refine_all_elements_bulk(int refinement);
+
+      /// Refines the element e into four sons in the bulk refinement. nb[i] is the neighbor
+      /// across the edge i of e (NULL on the boundary) and nb_edge[i] the number of the edge
+      /// of the neighbor. The nodes created by neighbors refined before are reused.
+      void refine_element_bulk(Element* e, Element** nb, int* nb_edge);
+
+      /// Creates a son element in the bulk refinement. The edge nodes en[i] which are NULL are created.
+      Element* create_element_bulk(int marker, int nvert, Node** vn, Node** en);
+
       /// Computing vector length.
       static double vector_length(double a_1, double a_2);
 
@@ -18,6 +18,7 @@
 
 #include "../hermes2d_common_defs.h"
 #include "../shapeset/precalc.h"
+#include "../shapeset/shapeset_h1_all.h"
 #include "../quadrature/quad_all.h"
 
 namespace Hermes
@@ -31,6 +32,18 @@ namespace Hermes
       class Vectorizer;
     };
 
+    /// \brief Shapeset and PrecalcShapeset used for the evaluation of reference mappings.
+    ///
+    /// Their mode and precalculated tables change with every element, so reference maps used
+    /// by concurrent threads must not share an instance (see RefMap::set_shapes()).
+    class HERMES_API RefMapShapes
+    {
+    public:
+      RefMapShapes() : pss(&shapeset) {}
+      H1Shapeset shapeset;
+      PrecalcShapeset pss;
+    };
+
     /// \brief Represents the reference mapping.
     ///
     /// RefMap represents the mapping from the reference to the physical element.
@@ -95,8 +108,18 @@ namespace Hermes
       
       /// Returns the increase in the integration order due to the reference map.
       int get_inv_ref_order() const;
-      
+
+      /// Sets the shapesets used for the evaluation, NULL for the instance shared by all reference
+      /// maps. Reference maps evaluated by concurrent threads need their own instances, these are
+      /// not deleted by the reference map.
+      void set_shapes(RefMapShapes* shapes);
+
     private:
+      /// The shapesets used for the evaluation (see set_shapes()).
+      RefMapShapes* get_shapes();
+
+      RefMapShapes* shapes;
+
       /// If the reference map is constant, this is the fast way to obtain
       /// its inverse matrix.
       double2x2* get_const_inv_ref_map();
@@ -91,6 +91,7 @@ namespace Hermes
       uint64_t init_idx(Rect* cr, Rect* er);
 
       Mesh* unimesh;
+      friend class TraversePlan;
       template<typename T> friend class Adapt;
       template<typename T> friend class KellyTypeAdapt;
       template<typename T> friend class DiscreteProblem;
@@ -101,6 +102,69 @@ namespace Hermes
       friend class Views::Vectorizer;
       friend class Views::Linearizer;
     };
+
+    /// \brief A recorded traversal of the union of meshes.
+    ///
+    /// TraversePlan stores the states returned by Traverse::get_next_state() as a flat array:
+    /// the elements on all meshes, their sub-element transformations (as returned by
+    /// Transformable::get_transform()), the boundary flags and positions and the base element.
+    /// The plan is recorded once and reused as long as the meshes are the same and have not
+    /// changed (have the same seq numbers), so that repeated assemblings on the same meshes
+    /// do not construct the union mesh again. The functions on the meshes are set to a state
+    /// by set_active_element() and set_transform(), therefore the states can be processed in
+    /// any order and split among threads.
+    ///
+    class HERMES_API TraversePlan
+    {
+    public:
+      TraversePlan();
+
+      /// Records the traversal of the meshes, unless the plan is valid for them already.
+      /// \return True if the traversal was recorded.
+      bool update(int n, Mesh** meshes);
+
+      /// Returns true if the plan was recorded for the same meshes with the same seq numbers.
+      bool is_valid(int n, Mesh** meshes) const;
+
+      /// Returns true if the plan was recorded for the same meshes (which may have changed since).
+      bool is_recorded_for(int n, Mesh** meshes) const;
+
+      /// Deletes the recorded states.
+      void free();
+
+      /// Returns the number of states.
+      int get_num_states() const { return (int) bases.size(); }
+
+      /// Returns the elements of the state on all meshes (NULL where a mesh has no element).
+      Element** get_elements(int state) { return &elements[state * num]; }
+
+      /// Returns the sub-element transformations of the elements of the state.
+      uint64_t* get_sub_idx(int state) { return &sub_idx[state * num]; }
+
+      /// Returns the base element of the state (as Traverse::get_base()).
+      Element* get_base(int state) const { return bases[state]; }
+
+      /// Fills in the boundary flags and positions of the edges of the state (as Traverse::get_next_state()).
+      void get_boundary_info(int state, bool* bnd, SurfPos* surf_pos) const;
+
+    private:
+      /// Returns the element of the mesh with the id (NULL if there is no such element).
+      Element* get_element(int mesh, int id) const;
+
+      int num;                              ///< Number of meshes.
+      std::vector<Mesh*> meshes;            ///< The meshes of the recorded traversal.
+      std::vector<unsigned> seqs;           ///< Their seq numbers.
+
+      std::vector<Element*> elements;       ///< Elements of the states (num per state).
+      std::vector<int> element_ids;         ///< Their ids (-1 for NULL).
+      std::vector<uint64_t> sub_idx;        ///< Transformations of the elements (num per state).
+      std::vector<Element*> bases;          ///< Base elements of the states.
+      std::vector<int> base_meshes;         ///< Index of the mesh of the base element of each state.
+      std::vector<int> base_ids;            ///< Ids of the base elements.
+      std::vector<unsigned char> bnd_flags; ///< Boundary flags of the edges of the states (bit i for the edge i).
+      std::vector<int> bnd_pos;             ///< Index of the first boundary position of the state in lo_hi (-1 if none).
+      std::vector<double> lo_hi;            ///< Positions (lo, hi) of the boundary edges of the states.
+    };
   }
 }
 #endif
@@ -64,6 +64,10 @@ namespace Hermes
       /// Call NonlinearSolver::set_preconditioner() and set the method to the linear solver (if applicable).
       virtual void set_preconditioner(const char* preconditioner_name);
 
+      /// Sets the preconditioner of the native Krylov solver (SOLVER_KRYLOV), e.g. PMultigridPrecond.
+      /// It is not deleted by the solver.
+      void set_preconditioner(Precond<Scalar>* pc);
+
       /// Get times accumulated by this instance of NewtonSolver.
       double get_setup_time() const { return setup_time; }
       double get_assemble_time() const { return assemble_time; }
@@ -77,6 +81,15 @@ namespace Hermes
 
       /// Sets the dumping coefficient.
       void set_damping_coeff(double damping_coeff);
+
+      /// Assemble the residual and the jacobian in one traversal of the meshes where the jacobian
+      /// is needed for sure, i.e. in the first iteration (on by default).
+      void set_fused_assembling(bool fused_assembling);
+
+      /// Assemble the jacobian together with the residual in every iteration, before the residual norm
+      /// is known (off by default). Saves a traversal of the meshes in every iteration, the jacobian
+      /// assembled in the last iteration is not used.
+      void set_speculative_jacobian(bool speculative_jacobian);
     protected:
       void init_linear_solver();
 
@@ -105,6 +118,12 @@ namespace Hermes
       /// Damping coefficient.
       double damping_coeff;
 
+      /// Assemble the residual and the jacobian in one traversal in the first iteration.
+      bool fused_assembling;
+
+      /// Assemble the residual and the jacobian in one traversal in every iteration.
+      bool speculative_jacobian;
+
       /// Pointer to an external timer to which this instance of NewtonSolver accumulates time spent in it.
       TimePeriod *timer;
     };
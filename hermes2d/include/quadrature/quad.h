@@ -64,6 +64,8 @@ namespace Hermes
     class HERMES_API Quad2D
     {
     public:
+      Quad2D() : tensor_np_1d(NULL) {}
+
       void set_mode(int mode) { this->mode = mode; }
       int  get_mode() const { return mode; }
 
@@ -89,6 +91,16 @@ namespace Hermes
 
       inline double2* get_ref_vertex(int n, int mode_) { return &ref_vert[mode_][n]; }
 
+      /// Returns n if the points of the given (volumetric) order on quads are the tensor product
+      /// of n one-dimensional points, the point i * n + j then has the x-coordinate of the point
+      /// i * n and the y-coordinate of the point j. Returns 0 otherwise.
+      inline int get_tensor_num_points(int order) const
+      {
+        if (mode != HERMES_MODE_QUAD || tensor_np_1d == NULL || order > max_order[mode])
+          return 0;
+        return tensor_np_1d[order];
+      }
+
     protected:
 
       int mode;
@@ -101,6 +113,10 @@ namespace Hermes
       int max_edge_order;
 
       double2 ref_vert[2][4];
+
+      /// Numbers of the one-dimensional points of the tensor-product rules on quads (NULL if the
+      /// rules are not tensor products).
+      int* tensor_np_1d;
     };
   }
 }
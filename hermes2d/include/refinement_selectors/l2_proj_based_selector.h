@@ -37,7 +37,15 @@ namespace Hermes
         *  \param[in] max_order A maximum order which considered. If ::H2DRS_DEFAULT_ORDER, a maximum order supported by the selector is used, see HcurlProjBasedSelector::H2DRS_MAX_L2_ORDER.
         *  \param[in] user_shapeset A shapeset. If NULL, it will use internal instance of the class L2Shapeset. */
         L2ProjBasedSelector(CandList cand_list = H2D_HP_ANISO, double conv_exp = 1.0, int max_order = H2DRS_DEFAULT_ORDER, L2Shapeset* user_shapeset = NULL);
+
+        /// Destructor.
+        virtual ~L2ProjBasedSelector();
       protected: //overloads
+        /// Returns a new selector with the same settings.
+        /** A clone uses its own instance of the class L2Shapeset. Therefore, NULL is returned if a user shapeset is used.
+        *  Overriden function. For details, see Selector::clone(). */
+        virtual Selector<Scalar>* clone();
+
         /// A function expansion of a function f used by this selector.
         enum LocalFuncExpansion {
           H2D_L2FE_VALUE = 0, ///< A function expansion: f.
@@ -83,6 +91,7 @@ namespace Hermes
         virtual double evaluate_error_squared_subdomain(Element* sub_elem, const typename ProjBasedSelector<Scalar>::ElemGIP& sub_gip, const typename ProjBasedSelector<Scalar>::ElemSubTrf& sub_trf, const typename ProjBasedSelector<Scalar>::ElemProj& elem_proj);
 
         static L2Shapeset default_shapeset; ///< A default shapeset.
+        L2Shapeset* own_shapeset; ///< A shapeset owned by this selector (a clone). NULL if the selector uses the default shapeset or a user shapeset.
       };
     }
   }
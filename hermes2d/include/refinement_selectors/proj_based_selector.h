@@ -216,14 +216,22 @@ namespace Hermes
         /** Defines a cache of projection matrices for all possible permutations of orders. */
         typedef double** ProjMatrixCache[H2DRS_MAX_ORDER + 2][H2DRS_MAX_ORDER + 2];
 
-        /// An array of projection matrices.
+        /// A cache of the pivoting of the LU decompositions of the projection matrices.
+        typedef int* ProjPivotCache[H2DRS_MAX_ORDER + 2][H2DRS_MAX_ORDER + 2];
+
+        /// An array of LU decompositions of projection matrices.
         /** The first index is the mode (see the enum ElementMode2D). The second and the third index
         *  is the horizontal and the vertical order respectively.
         *
         *  All matrices are square dense matrices and they have to be created through the function new_matrix().
+        *  A projection matrix depends only on the mode and the orders, it is decomposed by ludcmp() when it
+        *  is built and the decomposition is used for all elements.
         *  If record is NULL, the corresponding matrix has to be calculated. */
         ProjMatrixCache proj_matrix_cache[H2D_NUM_MODES];
 
+        /// An array of the permutation vectors (the output of ludcmp()) of the decompositions in proj_matrix_cache.
+        ProjPivotCache proj_pivot_cache[H2D_NUM_MODES];
+
         /// An array of cached right-hand side values.
         /** The first index is an index of the shape function.
         *
@@ -237,6 +245,11 @@ namespace Hermes
         double error_weight_p; ///< A coefficient that multiplies error of P-candidate. The default value is ::H2DRS_DEFAULT_ERR_WEIGHT_P.
         double error_weight_aniso; ///< A coefficient that multiplies error of ANISO-candidate. The default value is ::H2DRS_DEFAULT_ERR_WEIGHT_ANISO.
 
+        /// Copies the options and the error weights of this selector to its clone.
+        /** Used by implementations of Selector::clone(). Caches are not copied, a clone fills its own caches.
+        *  \param[in] clone A clone of this selector. */
+        void copy_settings(ProjBasedSelector<Scalar>* clone) const;
+
         /// Calculates error of candidates.
         /** Overriden function. For details, see OptimumSelector::evaluate_cands_error(). */
         virtual void evaluate_cands_error(Element* e, Solution<Scalar>* rsln, double* avg_error, double* dev_error);
@@ -16,6 +16,8 @@
 #ifndef __H2D_REFINEMENT_SELECTOR_H
 #define __H2D_REFINEMENT_SELECTOR_H
 
+#include <vector>
+
 #ifndef _MSC_VER
 #include "../mesh/refinement_type.h"
 
@@ -80,6 +82,25 @@ namespace Hermes
         /** \param[in] max_order A maximum order used by this selector. If it is ::H2DRS_DEFAULT_ORDER, a maximum supported order is used. */
         Selector(int max_order = H2DRS_DEFAULT_ORDER) : max_order(max_order) {};
 
+      public:
+        /// Destructor.
+        virtual ~Selector();
+
+      protected:
+        /// Returns a new selector with the same settings.
+        /** Used by Adapt::adapt() to select refinements of several elements concurrently, each thread uses its own copy of the selector.
+        *  \return A copy of the selector. NULL if the selector cannot be copied, refinements are then selected by this instance serially. */
+        virtual Selector<Scalar>* clone() { return NULL; };
+
+        /// Returns a copy of the selector used by a thread.
+        /** The copy is created by clone() on the first request and it is kept until the selector is destroyed,
+        *  so that the copy reuses its caches in subsequent adaptivity steps. Not thread-safe, it has to be called before the threads start.
+        *  \param[in] thread An index of the thread. The thread 0 uses this instance.
+        *  \return A copy of the selector. NULL if the selector cannot be copied. */
+        Selector<Scalar>* get_thread_copy(int thread);
+
+        std::vector<Selector<Scalar>*> thread_copies; ///< Copies of the selector used by threads, see get_thread_copy(). The first item is NULL.
+
         /// Selects a refinement.
         /** This methods has to be implemented.
         *  \param[in] element An element which is being refined.
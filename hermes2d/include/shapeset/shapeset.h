@@ -78,10 +78,13 @@ namespace Hermes
     class HERMES_API Shapeset
     {
     public:
-      ~Shapeset();
+      virtual ~Shapeset();
       
       /// Shape-function function type. Internal.
       typedef double (*shape_fn_t)(double, double);
+
+      /// One-dimensional factor of a tensor-product shape function on quads. Internal.
+      typedef double (*shape_fn_1d_t)(double);
       
       /// Returns the polynomial degree of the specified shape function.
       /// If on quads, it returns encoded orders. The orders has to be decoded through macros
@@ -90,6 +93,8 @@ namespace Hermes
       int get_order(int index, int mode_) const;
 
     protected:
+      Shapeset();
+
       /// Selects HERMES_MODE_TRIANGLE or HERMES_MODE_QUAD.
       virtual void set_mode(int mode);
 
@@ -134,6 +139,16 @@ namespace Hermes
       double get_dyy_value(int index, double x, double y, int component);
       double get_dxy_value(int index, double x, double y, int component);
 
+      /// Returns true if the shape function is a product of one-dimensional functions of x and y,
+      /// i.e. if get_tensor_values() can be used for it (only on quads, for some shapesets).
+      bool is_tensor_fn(int index) const;
+
+      /// Obtains the values of the given tensor-product shape function at the points (x[i], y[j])
+      /// of a tensor grid, stored in values[i * ny + j]. The one-dimensional factors are evaluated
+      /// only at the nx + ny coordinates (sum factorization), the values are exactly the same as
+      /// those returned by get_value().
+      void get_tensor_values(int n, int index, int nx, const double* x, int ny, const double* y, double* values);
+
       /// Returns the coordinates of the reference domain vertices.
       double2* get_ref_vertex(int vertex);
 
@@ -164,6 +179,15 @@ namespace Hermes
 
       double** comb_table;
       int table_size;
+
+      /// Tensor-product form of the quad shape functions (NULL if the shapeset does not have one).
+      /// The derivative of the shape function index that is dx-times in x and dy-times in y equals
+      /// tensor_coef[index] * tensor_fn_table[dx][tensor_x[index]](x) * tensor_fn_table[dy][tensor_y[index]](y),
+      /// tensor_coef is NULL if all coefficients are 1.
+      shape_fn_1d_t** tensor_fn_table;
+      int* tensor_x;
+      int* tensor_y;
+      double* tensor_coef;
       /**    numbering of edge intervals: (the variable 'part')
       -+-        -+-         -+-
       |          |        13 |
@@ -24,6 +24,11 @@ extern Shapeset::shape_fn_t* simple_quad_shape_fn_table_dxx[1];
 extern Shapeset::shape_fn_t* simple_quad_shape_fn_table_dxy[1];
 extern Shapeset::shape_fn_t* simple_quad_shape_fn_table_dyy[1];
 
+extern Shapeset::shape_fn_1d_t* simple_quad_tensor_fn_table[3];
+extern int simple_quad_tensor_x[];
+extern int simple_quad_tensor_y[];
+extern double simple_quad_tensor_coef[];
+
 extern int simple_quad_vertex_indices[4];
 extern int* simple_quad_edge_indices[4];
 extern int* simple_quad_bubble_indices[];
@@ -32,6 +32,7 @@ namespace Hermes
   {
     template<typename Scalar> class Adapt;
     template<typename Scalar> class DiscreteProblem;
+    template<typename Scalar> class RefinedSpaceBuilder;
     namespace Views
     {
       template<typename Scalar> class BaseView;
@@ -138,6 +139,12 @@ namespace Hermes
       /// recursively. This is useful for reference solution spaces.
       void copy_orders(const Space<Scalar>* space, int inc = 0);
 
+      /// Updates element orders of a space created by copy_orders() after the orders of another space
+      /// on the same (coarse) mesh changed. Only subtrees of elements whose order changed are updated and marked
+      /// as changed in the last adaptation. Does not call assign_dofs().
+      /// \return True if an order changed.
+      bool update_copied_orders(const Space<Scalar>* space, int inc = 0);
+
       /// \brief Returns the number of basis functions contained in the space.
       int get_num_dofs() const;
 
@@ -189,6 +196,58 @@ namespace Hermes
       /// \brief Assings the degrees of freedom to all Spaces in the Hermes::vector.
       static int assign_dofs(Hermes::vector<Space<Scalar>*> spaces);
 
+      /// \brief Sets the ordering of the DOFs applied by assign_dofs().
+      /// \details HERMES_DOF_ORDERING_NATURAL (default) numbers the DOFs in the order of the nodes and elements.
+      /// HERMES_DOF_ORDERING_RCM renumbers them by the reverse Cuthill-McKee algorithm on the graph of the nodes
+      /// and elements (coupled by the elements), which reduces the bandwidth of the matrix and the fill-in
+      /// of the factorizations which do not reorder the matrix. The DOFs of a node or an element stay consecutive,
+      /// so the ordering is seen through the assembly lists by everything else. When the DOFs are assigned to
+      /// several spaces, each of them is ordered within its range. If the space has DOFs already, they are reassigned.
+      /// The couplings through the constraints of the hanging nodes are not in the graph (see order_dofs_rcm()).
+      /// The copies made by dup() (and so the reference spaces) have the ordering of the original space.
+      void set_dof_ordering(DofOrdering ordering);
+
+      /// Returns the ordering of the DOFs, see set_dof_ordering().
+      DofOrdering get_dof_ordering() const;
+
+      /// Returns the permutation applied by the ordering of the DOFs: the i-th DOF (from the first DOF of the space)
+      /// in the natural order got the index get_dof_permutation()[i]. Empty for the natural ordering, and if the
+      /// incremental assignment of DOFs kept the previous numbers.
+      const std::vector<int>& get_dof_permutation() const;
+
+      /// \brief Returns blocks of DOFs of the spaces, e.g. for the block Jacobi preconditioner (BlockJacobiPrecond).
+      /// \details With element_blocks, every DOF goes to the block of the first active element whose assembly list
+      /// contains it. Otherwise the DOFs of a space are grouped by their support (the elements whose assembly lists
+      /// contain them), which gives the DOFs of the vertex and edge nodes and the bubble DOFs of the elements (the DOFs
+      /// of the boundary nodes of a single element are grouped with its bubble DOFs).
+      static void get_dof_blocks(Hermes::vector<Space<Scalar>*> spaces, std::vector<std::vector<int> >& blocks, bool element_blocks = false);
+
+      /// \brief Returns the levels of the p-multigrid (PMultigridPrecond) of the spaces.
+      /// \details The orders of the elements are lowered by one from level to level down to the order 1. With
+      /// a hierarchical shapeset every basis function of a coarser level is a basis function of the finer level,
+      /// levels[l][i] is the DOF of the finer level of the i-th DOF of the level l + 1 (the level 0 are the spaces).
+      /// Only H1 spaces are supported. The spaces of the coarser levels are created only temporarily.
+      static void get_order_hierarchy(Hermes::vector<Space<Scalar>*> spaces, std::vector<std::vector<int> >& levels);
+
+      /// \brief Turns on (off) the incremental assignment of DOFs.
+      /// \details If turned on, assign_dofs() keeps the numbers of the DOFs of the nodes and elements which
+      /// did not change since the previous assignment. The numbers of the removed DOFs are reused by the new ones,
+      /// the rest of the new DOFs is appended at the end (if there are fewer DOFs than before, the DOFs behind
+      /// the first unused number are shifted). The DOFs whose basis functions changed are recorded, see
+      /// get_touched_dofs(), and DiscreteProblem then updates only the affected part of the matrix sparse structure.
+      /// If the space has DOFs already, they are reassigned to be recorded.
+      void set_incremental_dofs(bool incremental = true);
+
+      /// Returns the (sorted) DOFs whose basis functions changed or were added since the space changed last time
+      /// (all DOFs if there was no previous assignment). Available if the incremental assignment of DOFs is turned on.
+      const Hermes::vector<int>& get_touched_dofs() const;
+
+      /// \brief Maps a coefficient vector of the previous assignment of DOFs to the current one.
+      /// \details The coefficients of the basis functions kept by the incremental assign_dofs() are copied (also
+      /// if their numbers changed), the coefficients of the new basis functions are set to zero. This gives
+      /// e.g. an initial guess for the Newton's method without a projection. Both vectors are indexed by DOF numbers.
+      void transfer_coefficients(const Scalar* prev_coeff_vec, Scalar* coeff_vec) const;
+
       /// Creates a copy of the space, increases order of all elements by
       /// "order_increase".
       virtual Space<Scalar>* dup(Mesh* mesh, int order_increase = 0) const = 0;
@@ -297,6 +356,58 @@ namespace Hermes
 
       void copy_orders_recurrent(Element* e, int order);
 
+      /// Returns the order 'o' of the element 'e' of another space increased by 'inc', limited by the shapeset. Used by copy_orders().
+      int get_copied_order(Element* e, int o, int inc) const;
+
+      /// \brief DOFs of a node or an element, used by the incremental assignment of DOFs.
+      struct AssignedDofs
+      {
+        int key[3];        ///< Identification of the node (type and parent ids) or element (number and ids of the first vertices).
+        int dof, n;        ///< The first DOF (the index from first_dof) and the number of DOFs.
+        unsigned int hash; ///< Hash of the assembly list of the element.
+      };
+
+      /// Incremental assignment of DOFs, see set_incremental_dofs().
+      bool incremental_dofs;
+
+      /// DOFs of the nodes and elements (by id) from the last assignment.
+      std::vector<AssignedDofs> assigned_node_dofs, assigned_elem_dofs;
+      int assigned_first_dof, assigned_stride, assigned_ndof;
+
+      /// The number of each DOF in the previous assignment, -1 for the new DOFs (see transfer_coefficients()).
+      std::vector<int> prev_dofs;
+
+      /// See get_touched_dofs().
+      Hermes::vector<int> touched_dofs;
+
+      /// The seq of the space at the last assignment of DOFs and the seq the touched DOFs are related to
+      /// (-1 if all DOFs are touched). Used by DiscreteProblem.
+      int assignment_seq, prev_assignment_seq;
+
+      /// \brief Renumbers the DOFs assigned by assign_vertex_dofs(), assign_edge_dofs() and assign_bubble_dofs() so that
+      /// the DOFs of the unchanged nodes and elements keep their numbers.
+      /// \param node_dofs, elem_dofs [out] The DOFs of the nodes and elements.
+      /// \param step_map [out] The previous index of every DOF (-1 for the new ones).
+      /// \return False if there is no previous assignment to be matched.
+      bool renumber_dofs_incrementally(std::vector<AssignedDofs>& node_dofs, std::vector<AssignedDofs>& elem_dofs, std::vector<int>& step_map);
+
+      /// Finds the touched DOFs by comparing the assembly lists of the elements with the previous assignment, and stores the assignment.
+      void update_touched_dofs(bool incremental, std::vector<AssignedDofs>& node_dofs, std::vector<AssignedDofs>& elem_dofs, const std::vector<int>& step_map);
+
+      /// See set_dof_ordering().
+      DofOrdering dof_ordering;
+
+      /// See get_dof_permutation().
+      std::vector<int> dof_permutation;
+
+      /// Renumbers the DOFs assigned by assign_vertex_dofs(), assign_edge_dofs() and assign_bubble_dofs()
+      /// by the reverse Cuthill-McKee algorithm, and stores the permutation.
+      /// The graph couples the nodes and bubbles of each element and the bubbles of its neighbors. It runs before
+      /// update_constraints(), so the DOFs of the constraining nodes that a hanging node adds to the assembly
+      /// lists of the small elements are not coupled to them. The ordering stays valid, only the bandwidth of
+      /// meshes with hanging nodes may be larger than the optimum.
+      void order_dofs_rcm();
+
       virtual void reset_dof_assignment(); ///< Resets assignment of DOF to an unassigned state.
       virtual void assign_vertex_dofs() = 0;
       virtual void assign_edge_dofs() = 0;
@@ -349,6 +460,7 @@ namespace Hermes
       friend class Adapt<Scalar>;
       friend class DiscreteProblem<Scalar>;
       template<typename T> friend class CalculationContinuity;
+      template<typename T> friend class RefinedSpaceBuilder;
 
       /// Saves this space into a file.
       bool save(const char *filename) const;
@@ -370,6 +482,45 @@ namespace Hermes
       friend class Views::OrderView;
       template<typename T> friend class Views::VectorBaseView;
     };
+
+    /// \brief Constructs reference spaces in an adaptivity loop.
+    ///
+    /// Unlike Space::construct_refined_space(), the reference mesh and space are kept between
+    /// the adaptivity steps and updated in place. If the coarse mesh did not change since the previous
+    /// step (only orders were changed), the reference mesh is reused and only orders of the elements
+    /// under the coarse elements whose order changed are updated. Otherwise, the reference mesh is rebuilt
+    /// from the coarse mesh (the IDs of coarse elements have to be preserved in the reference mesh,
+    /// refinement selectors rely on that). In both cases, the DOFs are assigned just once.
+    ///
+    /// The reference space and its mesh are owned by the builder. They are changed by the next call
+    /// of get_refined_space(), so solutions on the reference space of the previous step cannot be used
+    /// after that.
+    template<typename Scalar>
+    class HERMES_API RefinedSpaceBuilder
+    {
+    public:
+      /// Constructor.
+      /// \param coarse [in] The coarse space.
+      /// \param order_increase [in] The increase of orders of the reference space, see Space::construct_refined_space().
+      /// \param refinement_type [in] The refinement of the reference mesh, see Mesh::refine_all_elements().
+      RefinedSpaceBuilder(Space<Scalar>* coarse, int order_increase = 1, int refinement_type = 0);
+
+      ~RefinedSpaceBuilder();
+
+      /// Returns the reference space of the current coarse space.
+      Space<Scalar>* get_refined_space();
+
+    protected:
+      Space<Scalar>* coarse;
+      int order_increase;
+      int refinement_type;
+
+      Mesh* ref_mesh;
+      Space<Scalar>* ref_space;
+
+      /// The seq of the coarse mesh the reference mesh was built from.
+      unsigned coarse_mesh_seq;
+    };
   }
 }
 #endif
@@ -200,6 +200,13 @@ namespace Hermes
 
       double get_current_stage_time() const;
 
+      /// Memoize the integration order returned by ord() (on by default): in assembling, ord() is then
+      /// called only once for every combination of the polynomial orders of its arguments.
+      /// Switch it off for forms whose order depends on anything else, e.g. on the geometry of the element.
+      void set_order_memoization(bool order_memoization);
+
+      bool get_order_memoization() const;
+
       Hermes::vector<std::string> areas;
 
       Hermes::vector<MeshFunction<Scalar>*> ext;
@@ -213,9 +220,15 @@ namespace Hermes
       /// external coefficient vector.
       int u_ext_offset;
 
+      /// Load case of a vector form (0 by default). DiscreteProblem::assemble() with a list
+      /// of right-hand sides adds the form to the vector with this index, the other assembling
+      /// functions only assemble the vector forms of the load case 0.
+      unsigned int load_case;
+
     protected:
       WeakForm<Scalar>* wf;
       double stage_time;
+      bool order_memoization;
     };
 
     template<typename Scalar>
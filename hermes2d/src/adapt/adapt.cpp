@@ -26,6 +26,9 @@
 #include "refinement_selectors/selector.h"
 #include "matrix.h"
 #include "common_time_period.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Hermes
 {
@@ -38,7 +41,8 @@ namespace Hermes
       num_act_elems(-1),
       have_errors(false),
       have_coarse_solutions(false),
-      have_reference_solutions(false)
+      have_reference_solutions(false),
+      num_threads(1)
     {
       _F_
       // sanity check
@@ -100,7 +104,8 @@ namespace Hermes
       num_act_elems(-1),
       have_errors(false),
       have_coarse_solutions(false),
-      have_reference_solutions(false)
+      have_reference_solutions(false),
+      num_threads(1)
     {
       _F_
       if (space == NULL) throw Exceptions::NullException(1);
@@ -155,6 +160,143 @@ namespace Hermes
           }
     }
 
+    template<typename Scalar>
+    void Adapt<Scalar>::set_num_threads(int num_threads)
+    {
+      _F_
+      if(num_threads < 1)
+        error("The number of threads has to be positive.");
+#ifndef _OPENMP
+      if(num_threads > 1)
+      {
+        warn("Hermes2D was built without OpenMP, refinements will be selected serially.");
+        num_threads = 1;
+      }
+#endif
+      this->num_threads = num_threads;
+    }
+
+    template<typename Scalar>
+    void Adapt<Scalar>::select_refinements_threaded(Hermes::vector<RefinementSelectors::Selector<Scalar>*>& refinement_selectors, Mesh** meshes,
+      double thr, int strat, double to_be_processed, std::vector<ElementToRefine>& suggestions, std::vector<int>& suggested)
+    {
+      _F_
+      // find the elements which adapt() examines if all of them are refined
+      std::vector<int> queue_inxs;
+      double err0_squared = 1000.0;
+      double processed_error_squared = 0.0;
+      double error_squared_threshod = -1;
+      int mode = -1;
+      bool same_mode = true;
+      for (int inx_element = 0; inx_element < num_act_elems; inx_element++)
+      {
+        int id = regular_queue[inx_element].id;
+        int comp = regular_queue[inx_element].comp;
+        double err_squared = errors[comp][id];
+        Element* e = meshes[comp]->get_element(id);
+        if (should_ignore_element(inx_element, meshes[comp], e))
+          continue;
+
+        if (error_squared_threshod < 0)
+          error_squared_threshod = thr * err_squared;
+        if ((strat == 0) && (processed_error_squared > sqrt(thr) * errors_squared_sum)
+          && fabs((err_squared - err0_squared)/err0_squared) > 1e-3) break;
+        if ((strat == 1) && (err_squared < error_squared_threshod)) break;
+        if ((strat == 2) && (err_squared < thr)) break;
+        if ((strat == 3) &&
+          ( (err_squared < error_squared_threshod) ||
+          ( processed_error_squared > 1.5 * to_be_processed )) ) break;
+
+        queue_inxs.push_back(inx_element);
+        err0_squared = err_squared;
+        processed_error_squared += err_squared;
+        if (mode >= 0 && e->get_mode() != mode)
+          same_mode = false;
+        mode = e->get_mode();
+      }
+
+      suggestions.clear();
+      suggested.clear();
+      int num_threads = std::min(this->num_threads, (int)queue_inxs.size());
+      // the selectors set the mode of the global quadrature g_quad_2d_std
+      if (num_threads < 2 || !same_mode)
+        return;
+
+      // copies of the selectors (kept by the selectors) and of the reference solutions, the thread 0 uses the originals
+      RefinementSelectors::Selector<Scalar>*** thread_selectors = new RefinementSelectors::Selector<Scalar>**[num_threads];
+      Solution<Scalar>*** thread_rslns = new Solution<Scalar>**[num_threads];
+      // the copies of the reference solutions of a thread share its refmap shapesets
+      RefMapShapes* thread_refmap_shapes = new RefMapShapes[num_threads];
+      bool can_copy[H2D_MAX_COMPONENTS];
+      for (int j = 0; j < this->num; j++)
+        can_copy[j] = (rsln[j] == NULL || rsln[j]->get_type() == HERMES_SLN);
+      for (int t = 0; t < num_threads; t++)
+      {
+        thread_selectors[t] = new RefinementSelectors::Selector<Scalar>*[this->num];
+        thread_rslns[t] = new Solution<Scalar>*[this->num];
+        for (int j = 0; j < this->num; j++)
+        {
+          thread_selectors[t][j] = NULL;
+          thread_rslns[t][j] = NULL;
+          if (t == 0)
+          {
+            thread_selectors[t][j] = refinement_selectors[j];
+            thread_rslns[t][j] = rsln[j];
+          }
+          else if (can_copy[j])
+          {
+            thread_selectors[t][j] = refinement_selectors[j]->get_thread_copy(t);
+            if (thread_selectors[t][j] == NULL)
+              can_copy[j] = false;
+            else if (rsln[j] != NULL)
+            {
+              thread_rslns[t][j] = new Solution<Scalar>();
+              thread_rslns[t][j]->copy(rsln[j]);
+              thread_rslns[t][j]->set_quad_2d(&g_quad_2d_std);
+              thread_rslns[t][j]->set_refmap_shapes(&thread_refmap_shapes[t]);
+              thread_rslns[t][j]->enable_transform(false);
+            }
+          }
+        }
+      }
+
+      suggestions.resize(queue_inxs.back() + 1);
+      suggested.resize(queue_inxs.back() + 1, -1);
+      int num_elements = (int)queue_inxs.size();
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+      for (int i = 0; i < num_elements; i++)
+      {
+        int inx_element = queue_inxs[i];
+        int id = regular_queue[inx_element].id;
+        int comp = regular_queue[inx_element].comp;
+        if (!can_copy[comp])
+          continue;
+#ifdef _OPENMP
+        int t = omp_get_thread_num();
+#else
+        int t = 0;
+#endif
+        ElementToRefine elem_ref(id, comp);
+        int current = this->spaces[comp]->get_element_order(id);
+        bool refined = thread_selectors[t][comp]->select_refinement(meshes[comp]->get_element(id), current, thread_rslns[t][comp], elem_ref);
+        suggestions[inx_element] = elem_ref;
+        suggested[inx_element] = refined ? 1 : 0;
+      }
+
+      for (int t = 0; t < num_threads; t++)
+      {
+        if (t > 0)
+          for (int j = 0; j < this->num; j++)
+            delete thread_rslns[t][j];
+        delete [] thread_selectors[t];
+        delete [] thread_rslns[t];
+      }
+      delete [] thread_selectors;
+      delete [] thread_rslns;
+      delete [] thread_refmap_shapes;
+      verbose("Refinements of %d elements selected by %d threads.", num_elements, num_threads);
+    }
+
     template<typename Scalar>
     bool Adapt<Scalar>::adapt(Hermes::vector<RefinementSelectors::Selector<Scalar> *> refinement_selectors, double thr, int strat,
       int regularize, double to_be_processed)
@@ -211,6 +353,12 @@ namespace Hermes
       int num_not_changed = 0; //a number of element that were not changed
       int num_priority_elem = 0; //a number of elements that were processed using priority queue
 
+      //refinements selected concurrently
+      std::vector<ElementToRefine> suggestions;
+      std::vector<int> suggested;
+      if (num_threads > 1)
+        select_refinements_threaded(refinement_selectors, meshes, thr, strat, to_be_processed, suggestions, suggested);
+
       bool first_regular_element = true; //true if first regular element was not processed yet
       int inx_regular_element = 0;
       while (inx_regular_element < num_act_elems || !priority_queue.empty())
@@ -273,7 +421,14 @@ namespace Hermes
           ElementToRefine elem_ref(id, comp);
           int current = this->spaces[comp]->get_element_order(id);
           // rsln[comp] may be unset if refinement_selectors[comp] == HOnlySelector or POnlySelector
-          bool refined = refinement_selectors[comp]->select_refinement(e, current, rsln[comp], elem_ref);
+          bool refined;
+          if (inx_element >= 0 && inx_element < (int)suggested.size() && suggested[inx_element] >= 0)
+          {
+            elem_ref = suggestions[inx_element];
+            refined = (suggested[inx_element] == 1);
+          }
+          else
+            refined = refinement_selectors[comp]->select_refinement(e, current, rsln[comp], elem_ref);
 
           //add to a list of elements that are going to be refined
           if (can_refine_element(mesh, e, refined, elem_ref) )
@@ -1048,31 +1203,40 @@ namespace Hermes
       double total_error = 0.0;
 
       // Calculate error.
-      Element **ee;
-      trav.begin(2 * num, meshes, tr);
-      while ((ee = trav.get_next_state(NULL, NULL)) != NULL)
+      bool threaded = (num_threads > 1);
+      for (i = 0; i < num; i++)
+        if (sln[i]->get_type() != HERMES_SLN || rsln[i]->get_type() != HERMES_SLN)
+          threaded = false;
+      if (threaded)
+        calc_err_threaded(meshes, tr, norms, errors_components, total_norm, total_error, solutions_for_adapt);
+      else
       {
-        for (i = 0; i < num; i++)
+        Element **ee;
+        trav.begin(2 * num, meshes, tr);
+        while ((ee = trav.get_next_state(NULL, NULL)) != NULL)
         {
-          for (j = 0; j < num; j++)
+          for (i = 0; i < num; i++)
           {
-            if (error_form[i][j] != NULL)
+            for (j = 0; j < num; j++)
             {
-              double err, nrm;
-              err = eval_error(error_form[i][j], sln[i], sln[j], rsln[i], rsln[j]);
-              nrm = eval_error_norm(norm_form[i][j], rsln[i], rsln[j]);
-
-              norms[i] += nrm;
-              total_norm  += nrm;
-              total_error += err;
-              errors_components[i] += err;
-              if(solutions_for_adapt)
-                this->errors[i][ee[i]->id] += err;
+              if (error_form[i][j] != NULL)
+              {
+                double err, nrm;
+                err = eval_error(error_form[i][j], sln[i], sln[j], rsln[i], rsln[j]);
+                nrm = eval_error_norm(norm_form[i][j], rsln[i], rsln[j]);
+
+                norms[i] += nrm;
+                total_norm  += nrm;
+                total_error += err;
+                errors_components[i] += err;
+                if(solutions_for_adapt)
+                  this->errors[i][ee[i]->id] += err;
+              }
             }
           }
         }
+        trav.finish();
       }
-      trav.finish();
 
       // Store the calculation for each solution component separately.
       if(component_errors != NULL)
@@ -1150,6 +1314,115 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void Adapt<Scalar>::calc_err_threaded(Mesh** meshes, Transformable** tr, double* norms, double* errors_components,
+      double& total_norm, double& total_error, bool solutions_for_adapt)
+    {
+      _F_;
+      int num_fns = 2 * num;
+
+      // Record the states of the traversal.
+      std::vector<Element*> state_elems;
+      std::vector<uint64_t> state_sub_idx;
+      Traverse trav;
+      Element **ee;
+      trav.begin(num_fns, meshes, tr);
+      while ((ee = trav.get_next_state(NULL, NULL)) != NULL)
+        for (int k = 0; k < num_fns; k++)
+        {
+          state_elems.push_back(ee[k]);
+          state_sub_idx.push_back(tr[k]->get_transform());
+        }
+      trav.finish();
+      int num_states = (int)state_elems.size() / num_fns;
+
+      // Copies of the solutions used by the threads.
+      Solution<Scalar>*** fns = new Solution<Scalar>**[num_threads];
+      RefMapShapes* refmap_shapes = new RefMapShapes[num_threads];
+      for (int t = 0; t < num_threads; t++)
+      {
+        fns[t] = new Solution<Scalar>*[num_fns];
+        for (int k = 0; k < num_fns; k++)
+        {
+          fns[t][k] = new Solution<Scalar>();
+          fns[t][k]->copy(k < num ? sln[k] : rsln[k - num]);
+          fns[t][k]->set_quad_2d(&g_quad_2d_std);
+          fns[t][k]->set_refmap_shapes(&refmap_shapes[t]);
+        }
+      }
+
+      // Errors and norms of the states, the index is (state * num + i) * num + j.
+      int num_forms = num * num;
+      double* state_errors = new double[num_states * num_forms];
+      double* state_norms = new double[num_states * num_forms];
+
+      // Runs of states with the same element mode are evaluated concurrently.
+      // The quadrature g_quad_2d_std is shared by all threads, so the mode must not change within a run.
+      int first = 0;
+      while (first < num_states)
+      {
+        int mode = state_elems[first * num_fns]->get_mode();
+        int last = first + 1;
+        while (last < num_states && state_elems[last * num_fns]->get_mode() == mode)
+          last++;
+
+#pragma omp parallel for schedule(dynamic, 16) num_threads(num_threads)
+        for (int s = first; s < last; s++)
+        {
+#ifdef _OPENMP
+          Solution<Scalar>** thread_fns = fns[omp_get_thread_num()];
+#else
+          Solution<Scalar>** thread_fns = fns[0];
+#endif
+          for (int k = 0; k < num_fns; k++)
+          {
+            Element* e = state_elems[s * num_fns + k];
+            uint64_t sub_idx = state_sub_idx[s * num_fns + k];
+            // set_transform() does not refresh the precalculated values for the identity transformation.
+            if (thread_fns[k]->get_active_element() != e || sub_idx == 0)
+              thread_fns[k]->set_active_element(e);
+            thread_fns[k]->set_transform(sub_idx);
+          }
+          for (int i = 0; i < num; i++)
+            for (int j = 0; j < num; j++)
+              if (error_form[i][j] != NULL)
+              {
+                state_errors[s * num_forms + i * num + j] = eval_error(error_form[i][j], thread_fns[i], thread_fns[j], thread_fns[num + i], thread_fns[num + j]);
+                state_norms[s * num_forms + i * num + j] = eval_error_norm(norm_form[i][j], thread_fns[num + i], thread_fns[num + j]);
+              }
+        }
+        first = last;
+      }
+
+      // Sum up in the order of the states, i.e. exactly as in the serial calculation.
+      for (int s = 0; s < num_states; s++)
+        for (int i = 0; i < num; i++)
+          for (int j = 0; j < num; j++)
+            if (error_form[i][j] != NULL)
+            {
+              double err = state_errors[s * num_forms + i * num + j];
+              double nrm = state_norms[s * num_forms + i * num + j];
+
+              norms[i] += nrm;
+              total_norm  += nrm;
+              total_error += err;
+              errors_components[i] += err;
+              if(solutions_for_adapt)
+                this->errors[i][state_elems[s * num_fns + i]->id] += err;
+            }
+
+      for (int t = 0; t < num_threads; t++)
+      {
+        for (int k = 0; k < num_fns; k++)
+          delete fns[t][k];
+        delete [] fns[t];
+      }
+      delete [] fns;
+      delete [] refmap_shapes;
+      delete [] state_errors;
+      delete [] state_norms;
+    }
+
     template<typename Scalar>
     double Adapt<Scalar>::calc_err_internal(Solution<Scalar>* sln, Solution<Scalar>* rsln,
       Hermes::vector<double>* component_errors, bool solutions_for_adapt,
@@ -23,6 +23,10 @@
 #include "mesh/refmap.h"
 #include "function/solution.h"
 #include "neighbor.h"
+#include <typeinfo>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace Hermes::Algebra::DenseMatrixOperations;
 
@@ -30,6 +34,362 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    /// Sparse matrix that only records the values added to it. Used in the threaded assembling,
+    /// the recorded values are added to the real matrix in the order of the assembling states.
+    template<typename Scalar>
+    class AssemblingRecordMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      AssemblingRecordMatrix() : buffer(NULL), buffer_dim(0) {}
+
+      virtual ~AssemblingRecordMatrix()
+      {
+        if(buffer != NULL)
+          delete [] buffer;
+      }
+
+      virtual void alloc() {}
+
+      virtual void free()
+      {
+        indices.clear();
+        values.clear();
+      }
+
+      virtual Scalar get(unsigned int m, unsigned int n)
+      {
+        error("AssemblingRecordMatrix<Scalar>::get() is not available.");
+        return 0.0;
+      }
+
+      virtual void zero()
+      {
+        free();
+      }
+
+      virtual void add_to_diagonal(Scalar v)
+      {
+        error("AssemblingRecordMatrix<Scalar>::add_to_diagonal() is not available.");
+      }
+
+      /// A single value is recorded as (-1, m, n).
+      virtual void add(unsigned int m, unsigned int n, Scalar v)
+      {
+        indices.push_back(-1);
+        indices.push_back(m);
+        indices.push_back(n);
+        values.push_back(v);
+      }
+
+      /// A block is recorded as (m, n, rows, cols).
+      virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+      {
+        indices.push_back(m);
+        indices.push_back(n);
+        for (unsigned int i = 0; i < m; i++)
+          indices.push_back(rows[i]);
+        for (unsigned int j = 0; j < n; j++)
+          indices.push_back(cols[j]);
+        for (unsigned int i = 0; i < m; i++)
+          for (unsigned int j = 0; j < n; j++)
+            values.push_back(mat[i][j]);
+      }
+
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE)
+      {
+        return false;
+      }
+
+      virtual unsigned int get_matrix_size() const
+      {
+        return 0;
+      }
+
+      virtual double get_fill_in() const
+      {
+        return 0.0;
+      }
+
+      /// Adds the recorded values to mat (in the recorded order) and forgets them.
+      void flush(SparseMatrix<Scalar>* mat)
+      {
+        unsigned int i_pos = 0, v_pos = 0;
+        while (i_pos < indices.size())
+        {
+          if (indices[i_pos] < 0)
+          {
+            mat->add(indices[i_pos + 1], indices[i_pos + 2], values[v_pos]);
+            i_pos += 3;
+            v_pos++;
+          }
+          else
+          {
+            int m = indices[i_pos];
+            int n = indices[i_pos + 1];
+            int* rows = &indices.front() + i_pos + 2;
+            int* cols = rows + m;
+            if (std::max(m, n) > buffer_dim)
+            {
+              if (buffer != NULL)
+                delete [] buffer;
+              buffer_dim = std::max(m, n);
+              buffer = new_matrix<Scalar>(buffer_dim, buffer_dim);
+            }
+            for (int i = 0; i < m; i++)
+              for (int j = 0; j < n; j++)
+                buffer[i][j] = values[v_pos++];
+            mat->add(m, n, buffer, rows, cols);
+            i_pos += 2 + m + n;
+          }
+        }
+        free();
+      }
+
+    protected:
+      /// Recorded indices.
+      Hermes::vector<int> indices;
+
+      /// Recorded values.
+      Hermes::vector<Scalar> values;
+
+      /// Buffer for the blocks added in flush().
+      Scalar** buffer;
+
+      int buffer_dim;
+    };
+
+    /// Vector that only records the values added to it, see AssemblingRecordMatrix.
+    template<typename Scalar>
+    class AssemblingRecordVector : public Vector<Scalar>
+    {
+    public:
+      AssemblingRecordVector()
+      {
+        this->size = 0;
+      }
+
+      virtual void alloc(unsigned int ndofs) {}
+
+      virtual void free()
+      {
+        indices.clear();
+        values.clear();
+      }
+
+      virtual Scalar get(unsigned int idx)
+      {
+        error("AssemblingRecordVector<Scalar>::get() is not available.");
+        return 0.0;
+      }
+
+      virtual void extract(Scalar *v) const
+      {
+        error("AssemblingRecordVector<Scalar>::extract() is not available.");
+      }
+
+      virtual void zero()
+      {
+        free();
+      }
+
+      virtual void change_sign()
+      {
+        error("AssemblingRecordVector<Scalar>::change_sign() is not available.");
+      }
+
+      virtual void set(unsigned int idx, Scalar y)
+      {
+        error("AssemblingRecordVector<Scalar>::set() is not available.");
+      }
+
+      virtual void add(unsigned int idx, Scalar y)
+      {
+        indices.push_back(idx);
+        values.push_back(y);
+      }
+
+      virtual void add_vector(Vector<Scalar>* vec)
+      {
+        error("AssemblingRecordVector<Scalar>::add_vector() is not available.");
+      }
+
+      virtual void add_vector(Scalar* vec)
+      {
+        error("AssemblingRecordVector<Scalar>::add_vector() is not available.");
+      }
+
+      virtual void add(unsigned int n, unsigned int *idx, Scalar *y)
+      {
+        for (unsigned int i = 0; i < n; i++)
+          add(idx[i], y[i]);
+      }
+
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE)
+      {
+        return false;
+      }
+
+      /// Adds the recorded values to vec (in the recorded order) and forgets them.
+      void flush(Vector<Scalar>* vec)
+      {
+        for (unsigned int i = 0; i < indices.size(); i++)
+          vec->add(indices[i], values[i]);
+        free();
+      }
+
+    protected:
+      /// Recorded indices.
+      Hermes::vector<unsigned int> indices;
+
+      /// Recorded values.
+      Hermes::vector<Scalar> values;
+    };
+
+    /// Matrix that is never stored: the blocks added to it are multiplied with the vector x
+    /// and added to y (matrix-free DiscreteProblem::apply()). Blocks with disjoint rows can
+    /// be added concurrently.
+    template<typename Scalar>
+    class AssemblingApplyMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      AssemblingApplyMatrix(unsigned int size, const Scalar* x, Scalar* y) : x(x), y(y)
+      {
+        this->size = size;
+      }
+
+      virtual void alloc() {}
+
+      virtual void free() {}
+
+      virtual Scalar get(unsigned int m, unsigned int n)
+      {
+        error("AssemblingApplyMatrix<Scalar>::get() is not available.");
+        return 0.0;
+      }
+
+      virtual void zero() {}
+
+      virtual void add_to_diagonal(Scalar v)
+      {
+        for (unsigned int i = 0; i < this->size; i++)
+          y[i] += v * x[i];
+      }
+
+      virtual void add(unsigned int m, unsigned int n, Scalar v)
+      {
+        y[m] += v * x[n];
+      }
+
+      /// Negative (Dirichlet) rows and columns are skipped, as in the stored matrices.
+      virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+      {
+        for (unsigned int i = 0; i < m; i++)
+        {
+          if (rows[i] < 0)
+            continue;
+          Scalar sum = 0.0;
+          for (unsigned int j = 0; j < n; j++)
+            if (cols[j] >= 0)
+              sum += mat[i][j] * x[cols[j]];
+          y[rows[i]] += sum;
+        }
+      }
+
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE)
+      {
+        return false;
+      }
+
+      virtual unsigned int get_matrix_size() const
+      {
+        return 0;
+      }
+
+      virtual double get_fill_in() const
+      {
+        return 0.0;
+      }
+
+      virtual bool is_concurrent_add_supported() const
+      {
+        return true;
+      }
+
+    protected:
+      const Scalar* x;
+      Scalar* y;
+    };
+
+    /// One assembling state recorded by the traversal for the threaded assembling.
+    template<typename Scalar>
+    class DiscreteProblem<Scalar>::AssemblingState
+    {
+    public:
+      /// Elements of the state, one for each function of the stage.
+      Hermes::vector<Element*> e;
+
+      /// Sub-element transformations of the functions of the stage.
+      Hermes::vector<uint64_t> sub_idx;
+
+      /// Boundary flags and info about the boundary edges.
+      bool bnd[4];
+      SurfPos surf_pos[4];
+
+      /// Base element of the traversal.
+      Element* trav_base;
+
+      /// Contributions of this state.
+      AssemblingRecordMatrix<Scalar> mat;
+      AssemblingRecordVector<Scalar> rhs;
+
+      /// Contributions to the right-hand sides of the load cases 1, 2, ... in the batched
+      /// assembling (indexed by the load case, the load case 0 is recorded in rhs).
+      Hermes::vector<AssemblingRecordVector<Scalar> > load_case_rhs;
+    };
+
+    /// Data of one assembling thread.
+    template<typename Scalar>
+    class DiscreteProblem<Scalar>::AssemblingThread
+    {
+    public:
+      /// Instance with own (master) PrecalcShapesets and caches, the copies of the
+      /// external functions are stored in its ext_fn_copies.
+      DiscreteProblem<Scalar>* dp;
+
+      /// Slave pss's, refmaps.
+      Hermes::vector<PrecalcShapeset *> spss;
+      Hermes::vector<RefMap *> refmap;
+
+      /// Shapesets of the refmaps of this thread (its refmaps and the refmaps of the copies
+      /// of the external functions).
+      RefMapShapes refmap_shapes;
+
+      /// Copies of the solutions from the previous iteration.
+      Hermes::vector<Solution<Scalar>*> u_ext;
+
+      /// Functions of the current stage (in the order of Stage::fns).
+      Hermes::vector<Transformable*> fns;
+    };
+
+    /// Element coloring of a mesh: no two elements of the same color share a DOF.
+    template<typename Scalar>
+    class DiscreteProblem<Scalar>::ElementColoring
+    {
+    public:
+      /// The colored mesh and its seq.
+      const Mesh* mesh;
+      unsigned int mesh_seq;
+
+      /// Seqs of the spaces at the time of coloring.
+      Hermes::vector<int> space_seqs;
+
+      /// Colors of the elements (by element id, -1 for inactive elements).
+      Hermes::vector<int> colors;
+
+      /// Number of colors.
+      int num_colors;
+    };
+
     template<typename Scalar>
     DiscreteProblem<Scalar>::DiscreteProblem(const WeakForm<Scalar>* wf, Hermes::vector<const Space<Scalar> *> spaces) : wf(wf), wf_seq(-1), geom_ord(Geom<Hermes::Ord>(1))
     {
@@ -68,6 +428,10 @@ namespace Hermes
       matrix_buffer = NULL;
       matrix_buffer_dim = 0;
       have_matrix = false;
+      num_threads = 1;
+      element_coloring = false;
+      coloring = NULL;
+      reuse_traversal = true;
     }
 
     template<typename Scalar>
@@ -79,6 +443,12 @@ namespace Hermes
       RungeKutta = false;
       RK_original_spaces_count = 0;
 
+      // Serial assembling by default.
+      num_threads = 1;
+      element_coloring = false;
+      coloring = NULL;
+      reuse_traversal = true;
+
       ndof = Space<Scalar>::get_num_dofs(spaces);
 
       // Sanity checks.
@@ -93,6 +463,7 @@ namespace Hermes
       // Internal variables settings.
       sp_seq = new int[wf->get_neq()];
       memset(sp_seq, -1, sizeof(int) * wf->get_neq());
+      sp_structure_force_diagonal_blocks = false;
 
       // Matrix<Scalar> related settings.
       matrix_buffer = NULL;
@@ -127,6 +498,13 @@ namespace Hermes
     {
       _F_;
       free();
+      free_assembling_threads();
+      for(unsigned int i = 0; i < assembling_states.size(); i++)
+        delete assembling_states[i];
+      if (coloring != NULL)
+        delete coloring;
+      for(unsigned int i = 0; i < traverse_plans.size(); i++)
+        delete traverse_plans[i];
       if (sp_seq != NULL) delete [] sp_seq;
       if (pss != NULL)
       {
@@ -221,6 +599,20 @@ namespace Hermes
       return up_to_date;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::update_num_dofs()
+    {
+      _F_;
+      ndof = Space<Scalar>::get_num_dofs(spaces);
+      spaces_first_dofs.clear();
+      unsigned int first_dof_running = 0;
+      for(unsigned int i = 0; i < spaces.size(); i++)
+      {
+        spaces_first_dofs.push_back(first_dof_running);
+        first_dof_running += spaces[i]->get_num_dofs();
+      }
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::invalidate_matrix()
     {
@@ -233,12 +625,63 @@ namespace Hermes
       this->is_fvm = true;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_num_threads(int num_threads)
+    {
+      _F_;
+      if(num_threads < 1)
+        error("The number of assembling threads has to be positive.");
+#ifndef _OPENMP
+      if(num_threads > 1)
+      {
+        warn("Hermes2D was built without OpenMP, the assembling will be serial.");
+        num_threads = 1;
+      }
+#endif
+      if(num_threads != this->num_threads)
+        free_assembling_threads();
+      this->num_threads = num_threads;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_element_coloring(bool element_coloring)
+    {
+      _F_;
+      this->element_coloring = element_coloring;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_reuse_traversal(bool reuse_traversal)
+    {
+      _F_;
+      this->reuse_traversal = reuse_traversal;
+    }
+
+    template<typename Scalar>
+    size_t DiscreteProblem<Scalar>::get_arena_peak_size() const
+    {
+      size_t peak_size = arena.get_peak_size();
+      for (unsigned int i = 0; i < assembling_threads.size(); i++)
+        peak_size = std::max(peak_size, assembling_threads[i]->dp->get_arena_peak_size());
+      return peak_size;
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::create_sparse_structure(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
       bool force_diagonal_blocks, Table* block_weights)
     {
       _F_;
 
+      // The seq numbers of the spaces become a part of the structure fingerprint of the matrix
+      // (SparseMatrix::get_structure_fingerprint()).
+      if (mat != NULL)
+      {
+        unsigned int structure_seq = 0;
+        for (unsigned int i = 0; i < wf->get_neq(); i++)
+          structure_seq = 31 * structure_seq + spaces[i]->get_seq();
+        mat->set_structure_seq(structure_seq);
+      }
+
       if (is_up_to_date())
       {
         if (mat != NULL)
@@ -258,6 +701,9 @@ namespace Hermes
         return;
       }
 
+      // The spaces may have changed in place.
+      update_num_dofs();
+
       // For DG, the sparse structure is different as we have to
       // account for over-edge calculations.
       bool is_DG = false;
@@ -294,10 +740,20 @@ namespace Hermes
         }
       }
 
-      if (mat != NULL)
+      // The structure of spaces on a common mesh assigning DOFs incrementally can be updated.
+      bool incremental = !is_DG;
+      for (unsigned int i = 0; i < wf->get_neq(); i++)
+        if (!spaces[i]->incremental_dofs || spaces[i]->get_mesh() != spaces[0]->get_mesh())
+          incremental = false;
+
+      if (mat != NULL && incremental)
+        create_sparse_structure_incremental(mat, force_diagonal_blocks);
+      else if (mat != NULL)
       {
         // Spaces have changed: create the matrix from scratch.
         have_matrix = true;
+        sp_structure_start.clear();
+        sp_structure_rows.clear();
         mat->free();
         mat->prealloc(ndof);
 
@@ -454,6 +910,94 @@ namespace Hermes
       wf_seq = wf->get_seq();
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::create_sparse_structure_incremental(SparseMatrix<Scalar>* mat, bool force_diagonal_blocks)
+    {
+      _F_;
+      // The stored structure can be updated if the spaces changed just once since it was created.
+      bool update = have_matrix && !sp_structure_start.empty() && sp_structure_force_diagonal_blocks == force_diagonal_blocks
+        && wf->get_seq() == wf_seq;
+      for (unsigned int i = 0; i < wf->get_neq(); i++)
+        if (spaces[i]->prev_assignment_seq == -1 || spaces[i]->prev_assignment_seq != sp_seq[i]
+          || spaces[i]->assignment_seq != spaces[i]->get_seq())
+          update = false;
+
+      // Columns of the touched DOFs are created from the elements, the other ones did not change.
+      std::vector<bool> touched(ndof, !update);
+      int num_touched = ndof;
+      if (update)
+      {
+        int prev_ndof = sp_structure_start.size() - 1;
+        for (int i = prev_ndof; i < ndof; i++)
+          touched[i] = true;
+        for (unsigned int i = 0; i < wf->get_neq(); i++)
+        {
+          const Hermes::vector<int>& touched_dofs = spaces[i]->get_touched_dofs();
+          for (unsigned int j = 0; j < touched_dofs.size(); j++)
+            touched[touched_dofs[j] + spaces_first_dofs[i]] = true;
+        }
+        num_touched = std::count(touched.begin(), touched.end(), true);
+      }
+
+      std::vector<std::vector<int> > touched_rows(ndof);
+      AsmList<Scalar>* al = new AsmList<Scalar>[wf->get_neq()];
+      bool **blocks = wf->get_blocks(force_diagonal_blocks);
+      Element* e;
+      for_all_active_elements(e, spaces[0]->get_mesh())
+      {
+        bool has_touched = !update;
+        for (unsigned int i = 0; i < wf->get_neq(); i++)
+        {
+          spaces[i]->get_element_assembly_list(e, &(al[i]), spaces_first_dofs[i]);
+          for (unsigned int j = 0; j < al[i].cnt && !has_touched; j++)
+            if (al[i].dof[j] >= 0 && touched[al[i].dof[j]])
+              has_touched = true;
+        }
+        if (!has_touched)
+          continue;
+
+        for (unsigned int m = 0; m < wf->get_neq(); m++)
+          for (unsigned int n = 0; n < wf->get_neq(); n++)
+            if (blocks[m][n])
+              for (unsigned int j = 0; j < al[n].cnt; j++)
+                if (al[n].dof[j] >= 0 && touched[al[n].dof[j]])
+                  for (unsigned int i = 0; i < al[m].cnt; i++)
+                    if (al[m].dof[i] >= 0)
+                      touched_rows[al[n].dof[j]].push_back(al[m].dof[i]);
+      }
+      delete [] al;
+      delete [] blocks;
+
+      std::vector<int> start(ndof + 1), rows;
+      rows.reserve(sp_structure_rows.size());
+      for (int col = 0; col < ndof; col++)
+      {
+        start[col] = rows.size();
+        if (touched[col])
+        {
+          std::vector<int>& col_rows = touched_rows[col];
+          std::sort(col_rows.begin(), col_rows.end());
+          rows.insert(rows.end(), col_rows.begin(), std::unique(col_rows.begin(), col_rows.end()));
+        }
+        else
+          rows.insert(rows.end(), sp_structure_rows.begin() + sp_structure_start[col], sp_structure_rows.begin() + sp_structure_start[col + 1]);
+      }
+      start[ndof] = rows.size();
+      sp_structure_start.swap(start);
+      sp_structure_rows.swap(rows);
+      sp_structure_force_diagonal_blocks = force_diagonal_blocks;
+      if (update)
+        verbose("Updating matrix sparse structure (%d of %d columns).", num_touched, ndof);
+
+      have_matrix = true;
+      mat->free();
+      mat->prealloc(ndof);
+      for (int col = 0; col < ndof; col++)
+        for (int i = sp_structure_start[col]; i < sp_structure_start[col + 1]; i++)
+          mat->pre_add_ij(sp_structure_rows[i], col);
+      mat->alloc();
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble(SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
       bool force_diagonal_blocks, Table* block_weights)
@@ -487,7 +1031,7 @@ namespace Hermes
         }
 
       this->spaces = spaces;
-      this->ndof = Space<Scalar>::get_num_dofs(spaces);
+      this->update_num_dofs();
       
       this->invalidate_matrix();
     }
@@ -550,6 +1094,67 @@ namespace Hermes
       // Creating matrix sparse structure.
       create_sparse_structure(mat, rhs, force_diagonal_blocks, block_weights);
 
+      // Right-hand sides of the other load cases in the batched assembling.
+      for (unsigned int i = 1; i < load_case_rhs.size(); i++)
+      {
+        if(load_case_rhs[i]->length() == (unsigned int) ndof)
+          load_case_rhs[i]->zero();
+        else
+          load_case_rhs[i]->alloc(ndof);
+      }
+
+      assemble_system(coeff_vec, mat, rhs, force_diagonal_blocks, add_dir_lift, block_weights);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::apply(Scalar* coeff_vec, const Scalar* x, Scalar* y,
+      bool add_dir_lift, Table* block_weights)
+    {
+      _F_;
+      assemble_sanity_checks(block_weights);
+      // Check that the block scaling table have proper dimension.
+      if (block_weights != NULL)
+        if (block_weights->get_size() != wf->get_neq())
+          throw Exceptions::LengthException(5, block_weights->get_size(), wf->get_neq());
+
+      // The spaces may have changed since the last assembling.
+      update_num_dofs();
+      memset(y, 0, ndof * sizeof(Scalar));
+      AssemblingApplyMatrix<Scalar> op(ndof, x, y);
+      assemble_system(coeff_vec, &op, NULL, false, add_dir_lift, block_weights);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::apply(const Scalar* x, Scalar* y, Table* block_weights)
+    {
+      _F_;
+      apply(NULL, x, y, true, block_weights);
+    }
+
+    template<typename Scalar>
+    DiscreteProblemOperator<Scalar>::DiscreteProblemOperator(DiscreteProblem<Scalar>* dp, Scalar* coeff_vec, Table* block_weights)
+      : dp(dp), coeff_vec(coeff_vec), block_weights(block_weights)
+    {
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblemOperator<Scalar>::get_size()
+    {
+      return dp->get_num_dofs();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemOperator<Scalar>::apply(const Scalar* x, Scalar* y)
+    {
+      _F_;
+      dp->apply(coeff_vec, x, y, true, block_weights);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::assemble_system(Scalar* coeff_vec, SparseMatrix<Scalar>* mat,
+      Vector<Scalar>* rhs, bool force_diagonal_blocks, bool add_dir_lift, Table* block_weights)
+    {
+      _F_;
       // Convert the coefficient vector into vector of external solutions.
       Hermes::vector<Solution<Scalar>*> u_ext;
       int first_dof = 0;
@@ -564,6 +1169,9 @@ namespace Hermes
       // Reset the warnings about insufficiently high integration order.
       reset_warn_order();
 
+      // The forms may have changed since the last assembling.
+      assembling_caches.order_memo.clear();
+
       // Create slave pss's, refmaps.
       Hermes::vector<PrecalcShapeset *> spss;
       Hermes::vector<RefMap *> refmap;
@@ -583,6 +1191,7 @@ namespace Hermes
       bool want_matrix = (mat != NULL);
       bool want_vector = (rhs != NULL);
       wf->get_stages(spaces, u_ext, stages, want_matrix, want_vector);
+      evict_traverse_plans(stages);
 
       // Loop through all assembling stages -- the purpose of this is increased performance
       // in multi-mesh calculations, where, e.g., only the right hand side uses two meshes.
@@ -617,6 +1226,37 @@ namespace Hermes
         delete *it;
     }
 
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat,
+      Hermes::vector<Vector<Scalar>*> rhs,
+      bool force_diagonal_blocks, bool add_dir_lift,
+      Table* block_weights)
+    {
+      _F_;
+      if (rhs.empty())
+      {
+        assemble(coeff_vec, mat, (Vector<Scalar>*) NULL, force_diagonal_blocks, add_dir_lift, block_weights);
+        return;
+      }
+      for (unsigned int i = 0; i < rhs.size(); i++)
+        if (rhs[i] == NULL)
+          error("NULL right-hand side of the load case %d in DiscreteProblem<Scalar>::assemble().", i);
+
+      // The vector of the load case 0 takes the place of the single right-hand side,
+      // the vector forms of the other load cases are routed by get_load_case_rhs().
+      load_case_rhs = rhs;
+      try
+      {
+        assemble(coeff_vec, mat, rhs[0], force_diagonal_blocks, add_dir_lift, block_weights);
+      }
+      catch(...)
+      {
+        load_case_rhs.clear();
+        throw;
+      }
+      load_case_rhs.clear();
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble(Scalar* coeff_vec, Vector<Scalar>* rhs,
       bool force_diagonal_blocks, bool add_dir_lift,
@@ -642,77 +1282,659 @@ namespace Hermes
       // Info about the boundary edge.
       SurfPos surf_pos[4];
 
-      // Create the assembling states.
-      Traverse trav;
-      for (unsigned i = 0; i < stage.idx.size(); i++)
-        stage.fns[i] = pss[stage.idx[i]];
-      for (unsigned i = 0; i < stage.ext.size(); i++)
-        stage.ext[i]->set_quad_2d(&g_quad_2d_std);
-      trav.begin(stage.meshes.size(), &(stage.meshes.front()), &(stage.fns.front()));
+      for (unsigned i = 0; i < stage.idx.size(); i++)
+        stage.fns[i] = pss[stage.idx[i]];
+      for (unsigned i = 0; i < stage.ext.size(); i++)
+        stage.ext[i]->set_quad_2d(&g_quad_2d_std);
+
+      // Check that there is a DG form, so that the DG assembling procedure needs to be performed.
+      DG_matrix_forms_present = false;
+      DG_vector_forms_present = false;
+      for(unsigned int i = 0; i < stage.mfsurf.size() && DG_matrix_forms_present == false; i++)
+      {
+        if (stage.mfsurf[i]->areas[0] == H2D_DG_INNER_EDGE)
+        {
+          DG_matrix_forms_present = true;
+          break;
+        }
+      }
+      for(unsigned int i = 0; i < stage.vfsurf.size() && DG_vector_forms_present == false; i++)
+      {
+        if (stage.vfsurf[i]->areas[0] == H2D_DG_INNER_EDGE)
+        {
+          DG_vector_forms_present = true;
+          break;
+        }
+      }
+      for(unsigned int i = 0; i < stage.mfsurf_mc.size() && DG_matrix_forms_present == false; i++)
+      {
+        if (stage.mfsurf_mc[i]->areas[0] == H2D_DG_INNER_EDGE)
+        {
+          DG_matrix_forms_present = true;
+          break;
+        }
+      }
+      for(unsigned int i = 0; i < stage.vfsurf_mc.size() && DG_vector_forms_present == false; i++)
+      {
+        if (stage.vfsurf_mc[i]->areas[0] == H2D_DG_INNER_EDGE)
+        {
+          DG_vector_forms_present = true;
+          break;
+        }
+      }
+
+      // Loop through all assembling states.
+      // Assemble each one.
+      if (is_threaded_assembling_possible(stage) || (reuse_traversal && is_traverse_plan_possible(stage)))
+      {
+        // The states of the union mesh are recorded by the first assembling on the meshes.
+        TraversePlan* plan = get_traverse_plan(stage);
+        if (is_threaded_assembling_possible(stage))
+        {
+          if (is_element_coloring_possible(stage, mat, rhs))
+            assemble_one_stage_colored(stage, mat, rhs, force_diagonal_blocks,
+            block_weights, u_ext, plan);
+          else
+            assemble_one_stage_threaded(stage, mat, rhs, force_diagonal_blocks,
+            block_weights, u_ext, plan);
+        }
+        else
+        {
+          for (int i = 0; i < plan->get_num_states(); i++)
+          {
+            Element** e = plan->get_elements(i);
+            set_state_transforms(stage.fns, e, plan->get_sub_idx(i));
+            plan->get_boundary_info(i, bnd, surf_pos);
+            assemble_one_state(stage, mat, rhs, force_diagonal_blocks,
+              block_weights, spss, refmap,
+              u_ext, e, bnd, surf_pos, plan->get_base(i));
+          }
+        }
+      }
+      else
+      {
+        Traverse trav;
+        trav.begin(stage.meshes.size(), &(stage.meshes.front()), &(stage.fns.front()));
+        Element** e;
+        while ((e = trav.get_next_state(bnd, surf_pos)) != NULL)
+          // One state is a collection of (virtual) elements sharing
+          // the same physical location on (possibly) different meshes.
+          // This is then the same element of the virtual union mesh.
+          // The proper sub-element mappings to all the functions of
+          // this stage is supplied by the function Traverse::get_next_state()
+          // called in the while loop.
+          assemble_one_state(stage, mat, rhs, force_diagonal_blocks,
+          block_weights, spss, refmap,
+          u_ext, e, bnd, surf_pos, trav.get_base());
+        trav.finish();
+      }
+
+      if (mat != NULL)
+        mat->finish();
+      if (rhs != NULL)
+        rhs->finish();
+      for (unsigned int i = 1; i < load_case_rhs.size(); i++)
+        load_case_rhs[i]->finish();
+
+      if(DG_matrix_forms_present || DG_vector_forms_present)
+      {
+        Element* element_to_set_nonvisited;
+        for(unsigned int mesh_i = 0; mesh_i < stage.meshes.size(); mesh_i++)
+          for_all_elements(element_to_set_nonvisited, stage.meshes[mesh_i])
+          element_to_set_nonvisited->visited = false;
+      }
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::is_traverse_plan_possible(Stage<Scalar>& stage)
+    {
+      _F_;
+      // DG forms mark the visited elements during the assembling.
+      if (DG_matrix_forms_present || DG_vector_forms_present)
+        return false;
+
+      // Filters do not propagate set_transform() to their functions, only Solutions are set to the recorded states.
+      for (unsigned int i = 0; i < stage.ext.size(); i++)
+        if (typeid(*stage.ext[i]) != typeid(Solution<Scalar>))
+          return false;
+      return true;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::evict_traverse_plans(Hermes::vector<Stage<Scalar> >& stages)
+    {
+      _F_;
+      // Only the mesh pointers are compared, the meshes of the evicted plans may not exist any more.
+      std::vector<bool> used(traverse_plans.size(), false);
+      bool all_recorded = true;
+      for (unsigned int ss = 0; ss < stages.size(); ss++)
+      {
+        bool recorded = false;
+        for (unsigned int i = 0; i < traverse_plans.size(); i++)
+          if (traverse_plans[i]->is_recorded_for(stages[ss].meshes.size(), &stages[ss].meshes.front()))
+            used[i] = recorded = true;
+        if (!recorded)
+          all_recorded = false;
+      }
+      if (all_recorded)
+        return;
+
+      unsigned int num_kept = 0;
+      for (unsigned int i = 0; i < traverse_plans.size(); i++)
+      {
+        if (used[i])
+          traverse_plans[num_kept++] = traverse_plans[i];
+        else
+          delete traverse_plans[i];
+      }
+      traverse_plans.resize(num_kept);
+    }
+
+    template<typename Scalar>
+    TraversePlan* DiscreteProblem<Scalar>::get_traverse_plan(Stage<Scalar>& stage)
+    {
+      _F_;
+      int n = stage.meshes.size();
+      Mesh** meshes = &stage.meshes.front();
+      TraversePlan* plan = NULL;
+      for (unsigned int i = 0; i < traverse_plans.size() && plan == NULL; i++)
+        if (traverse_plans[i]->is_recorded_for(n, meshes))
+          plan = traverse_plans[i];
+      if (plan == NULL)
+      {
+        plan = new TraversePlan;
+        traverse_plans.push_back(plan);
+      }
+      if (!reuse_traversal)
+        plan->free();
+      if (plan->update(n, meshes))
+        verbose("Traversal of %d mesh(es) recorded: %d states.", n, plan->get_num_states());
+      return plan;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::is_threaded_assembling_possible(Stage<Scalar>& stage)
+    {
+      _F_;
+      if (num_threads < 2 || !is_traverse_plan_possible(stage))
+        return false;
+
+      // Every thread needs its own copy of the external functions, these can be made only of Solutions.
+      for (unsigned int i = 0; i < stage.ext.size(); i++)
+      {
+        Solution<Scalar>* sln = static_cast<Solution<Scalar>*>(stage.ext[i]);
+        if (sln->get_type() != HERMES_SLN || sln->get_sln_vector() == NULL)
+          return false;
+      }
+      return true;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::init_assembling_threads(Stage<Scalar>& stage, Hermes::vector<Solution<Scalar>*>& u_ext)
+    {
+      _F_;
+      finish_assembling_threads();
+
+      while (assembling_threads.size() < (unsigned int) num_threads)
+      {
+        AssemblingThread* thread = new AssemblingThread;
+        thread->dp = new DiscreteProblem<Scalar>(wf, spaces);
+        thread->dp->initialize_psss(thread->spss);
+        thread->dp->initialize_refmaps(thread->refmap);
+        for (unsigned int j = 0; j < thread->refmap.size(); j++)
+          thread->refmap[j]->set_shapes(&thread->refmap_shapes);
+        assembling_threads.push_back(thread);
+      }
+
+      for (unsigned int i = 0; i < assembling_threads.size(); i++)
+      {
+        AssemblingThread* thread = assembling_threads[i];
+        DiscreteProblem<Scalar>* dp = thread->dp;
+        dp->spaces = spaces;
+        dp->spaces_first_dofs = spaces_first_dofs;
+        dp->ndof = ndof;
+        dp->is_fvm = is_fvm;
+        dp->RungeKutta = RungeKutta;
+        dp->RK_original_spaces_count = RK_original_spaces_count;
+        dp->DG_matrix_forms_present = false;
+        dp->DG_vector_forms_present = false;
+        dp->assembling_caches.order_memo.clear();
+        dp->load_case_rhs = load_case_rhs;
+
+        // The threads can not share the precalculated values of the external functions.
+        for (unsigned int j = 0; j < stage.ext.size(); j++)
+        {
+          Solution<Scalar>* ext_copy = new Solution<Scalar>();
+          ext_copy->copy(static_cast<Solution<Scalar>*>(stage.ext[j]));
+          ext_copy->set_quad_2d(&g_quad_2d_std);
+          ext_copy->set_refmap_shapes(&thread->refmap_shapes);
+          dp->ext_fn_copies[stage.ext[j]] = ext_copy;
+        }
+
+        thread->u_ext.clear();
+        for (unsigned int j = 0; j < u_ext.size(); j++)
+          thread->u_ext.push_back(u_ext[j] == NULL ? NULL : static_cast<Solution<Scalar>*>(dp->get_ext_fn(u_ext[j])));
+
+        thread->fns.clear();
+        for (unsigned int j = 0; j < stage.idx.size(); j++)
+          thread->fns.push_back(dp->pss[stage.idx[j]]);
+        for (unsigned int j = 0; j < stage.ext.size(); j++)
+          thread->fns.push_back(dp->get_ext_fn(stage.ext[j]));
+      }
+
+      while (assembling_states.size() < (unsigned int) (num_threads * H2D_STATES_PER_THREAD))
+        assembling_states.push_back(new AssemblingState);
+      for (unsigned int i = 0; i < assembling_states.size(); i++)
+      {
+        assembling_states[i]->e.resize(stage.fns.size());
+        assembling_states[i]->sub_idx.resize(stage.fns.size());
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::finish_assembling_threads()
+    {
+      _F_;
+      for (unsigned int i = 0; i < assembling_threads.size(); i++)
+      {
+        DiscreteProblem<Scalar>* dp = assembling_threads[i]->dp;
+        for (typename std::map<MeshFunction<Scalar>*, MeshFunction<Scalar>*>::iterator it = dp->ext_fn_copies.begin();
+          it != dp->ext_fn_copies.end(); it++)
+          delete it->second;
+        dp->ext_fn_copies.clear();
+        assembling_threads[i]->u_ext.clear();
+        assembling_threads[i]->fns.clear();
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::free_assembling_threads()
+    {
+      _F_;
+      finish_assembling_threads();
+      for (unsigned int i = 0; i < assembling_threads.size(); i++)
+      {
+        AssemblingThread* thread = assembling_threads[i];
+        for(Hermes::vector<PrecalcShapeset *>::iterator it = thread->spss.begin(); it != thread->spss.end(); it++)
+          delete *it;
+        for(Hermes::vector<RefMap *>::iterator it = thread->refmap.begin(); it != thread->refmap.end(); it++)
+          delete *it;
+        if (thread->dp->matrix_buffer != NULL)
+          delete [] thread->dp->matrix_buffer;
+        delete thread->dp;
+        delete thread;
+      }
+      assembling_threads.clear();
+    }
+
+    template<typename Scalar>
+    MeshFunction<Scalar>* DiscreteProblem<Scalar>::get_ext_fn(MeshFunction<Scalar>* fn)
+    {
+      if (ext_fn_copies.empty())
+        return fn;
+      typename std::map<MeshFunction<Scalar>*, MeshFunction<Scalar>*>::iterator it = ext_fn_copies.find(fn);
+      if (it == ext_fn_copies.end())
+        return fn;
+      return it->second;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_assembling_state(Hermes::vector<Transformable*>& fns, AssemblingState* state)
+    {
+      _F_;
+      set_state_transforms(fns, &state->e.front(), &state->sub_idx.front());
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_state_transforms(Hermes::vector<Transformable*>& fns, Element** e, uint64_t* sub_idx)
+    {
+      _F_;
+      for (unsigned int i = 0; i < fns.size(); i++)
+      {
+        if (e[i] == NULL)
+          continue;
+        // set_transform() does not refresh the precalculated values for the identity transformation.
+        if (fns[i]->get_active_element() != e[i] || sub_idx[i] == 0)
+          fns[i]->set_active_element(e[i]);
+        fns[i]->set_transform(sub_idx[i]);
+      }
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::record_load_cases(DiscreteProblem<Scalar>* dp, AssemblingState* state)
+    {
+      if (load_case_rhs.empty())
+        return;
+      state->load_case_rhs.resize(load_case_rhs.size());
+      for (unsigned int i = 1; i < load_case_rhs.size(); i++)
+        dp->load_case_rhs[i] = &state->load_case_rhs[i];
+    }
+
+    template<typename Scalar>
+    Vector<Scalar>* DiscreteProblem<Scalar>::get_load_case_rhs(Vector<Scalar>* rhs, Form<Scalar>* form)
+    {
+      if (form->load_case == 0)
+        return rhs;
+      if (form->load_case < load_case_rhs.size())
+        return load_case_rhs[form->load_case];
+      return NULL;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::assemble_one_stage_threaded(Stage<Scalar>& stage,
+      SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
+      bool force_diagonal_blocks, Table* block_weights,
+      Hermes::vector<Solution<Scalar>*>& u_ext, TraversePlan* plan)
+    {
+      _F_;
+      init_assembling_threads(stage, u_ext);
+
+      int max_states = num_threads * H2D_STATES_PER_THREAD;
+      int num_states = 0;
+
+      // Element mode of the states of the current round. Shapesets and quadratures are shared
+      // by all threads, so the mode must not change within a round.
+      int round_mode = -1;
+
+      for (int s = 0; s < plan->get_num_states(); s++)
+      {
+        Element** e = plan->get_elements(s);
+        int mode = -1;
+        for (unsigned int i = 0; i < stage.idx.size(); i++)
+          if (e[i] != NULL)
+          {
+            mode = e[i]->get_mode();
+            break;
+          }
+
+        if (num_states == max_states || (mode != -1 && round_mode != -1 && mode != round_mode))
+        {
+          assemble_states_threaded(stage, mat, rhs, force_diagonal_blocks, block_weights, u_ext, num_states);
+          num_states = 0;
+          round_mode = -1;
+        }
+
+        AssemblingState* state = assembling_states[num_states++];
+        for (unsigned int i = 0; i < stage.fns.size(); i++)
+        {
+          state->e[i] = e[i];
+          state->sub_idx[i] = plan->get_sub_idx(s)[i];
+        }
+        plan->get_boundary_info(s, state->bnd, state->surf_pos);
+        state->trav_base = plan->get_base(s);
+        if (mode != -1)
+          round_mode = mode;
+      }
+
+      if (num_states > 0)
+        assemble_states_threaded(stage, mat, rhs, force_diagonal_blocks, block_weights, u_ext, num_states);
+
+      finish_assembling_threads();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::assemble_states_threaded(Stage<Scalar>& stage,
+      SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
+      bool force_diagonal_blocks, Table* block_weights,
+      Hermes::vector<Solution<Scalar>*>& u_ext, int num_states)
+    {
+      _F_;
+      // The first state whose assembling failed.
+      int failed_state = num_states;
+
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+      for (int i = 0; i < num_states; i++)
+      {
+#ifdef _OPENMP
+        AssemblingThread* thread = assembling_threads[omp_get_thread_num()];
+#else
+        AssemblingThread* thread = assembling_threads[0];
+#endif
+        AssemblingState* state = assembling_states[i];
+        try
+        {
+          thread->dp->set_assembling_state(thread->fns, state);
+          record_load_cases(thread->dp, state);
+          thread->dp->assemble_one_state(stage, mat == NULL ? NULL : &state->mat, rhs == NULL ? NULL : &state->rhs,
+            force_diagonal_blocks, block_weights, thread->spss, thread->refmap, thread->u_ext,
+            &state->e.front(), state->bnd, state->surf_pos, state->trav_base);
+        }
+        catch(...)
+        {
+#pragma omp critical (assemble_states_threaded)
+          if (i < failed_state)
+            failed_state = i;
+        }
+      }
+
+      // Add the contributions in the order of the states, i.e. exactly as in the serial assembling.
+      for (int i = 0; i < failed_state; i++)
+      {
+        if (mat != NULL)
+          assembling_states[i]->mat.flush(mat);
+        if (rhs != NULL)
+          assembling_states[i]->rhs.flush(rhs);
+        for (unsigned int j = 1; j < load_case_rhs.size(); j++)
+          assembling_states[i]->load_case_rhs[j].flush(load_case_rhs[j]);
+      }
+
+      if (failed_state < num_states)
+      {
+        for (int i = failed_state; i < num_states; i++)
+        {
+          assembling_states[i]->mat.free();
+          assembling_states[i]->rhs.free();
+          for (unsigned int j = 0; j < assembling_states[i]->load_case_rhs.size(); j++)
+            assembling_states[i]->load_case_rhs[j].free();
+        }
+
+        // Exceptions can not leave the parallel region: assemble the rest serially with new
+        // threads' data (the old ones may be inconsistent), this rethrows the exception.
+        free_assembling_threads();
+        init_assembling_threads(stage, u_ext);
+        AssemblingThread* thread = assembling_threads[0];
+        for (int i = failed_state; i < num_states; i++)
+        {
+          AssemblingState* state = assembling_states[i];
+          thread->dp->set_assembling_state(thread->fns, state);
+          thread->dp->assemble_one_state(stage, mat, rhs, force_diagonal_blocks, block_weights,
+            thread->spss, thread->refmap, thread->u_ext, &state->e.front(), state->bnd, state->surf_pos, state->trav_base);
+        }
+      }
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::is_element_coloring_possible(Stage<Scalar>& stage, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs)
+    {
+      _F_;
+      if (!element_coloring)
+        return false;
+      if (mat != NULL && !mat->is_concurrent_add_supported())
+        return false;
+      if (rhs != NULL && !rhs->is_concurrent_add_supported())
+        return false;
+      for (unsigned int i = 1; i < load_case_rhs.size(); i++)
+        if (!load_case_rhs[i]->is_concurrent_add_supported())
+          return false;
+
+      // The states of the traversal have to be the elements of one mesh (copies of a mesh keep its seq).
+      for (unsigned int i = 1; i < stage.meshes.size(); i++)
+        if (stage.meshes[i]->get_seq() != stage.meshes[0]->get_seq())
+          return false;
+      return true;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::update_element_coloring(const Mesh* mesh)
+    {
+      _F_;
+      if (coloring != NULL && coloring->mesh == mesh && coloring->mesh_seq == mesh->get_seq())
+      {
+        bool up_to_date = true;
+        for (unsigned int i = 0; i < spaces.size(); i++)
+          if (coloring->space_seqs[i] != spaces[i]->get_seq())
+            up_to_date = false;
+        if (up_to_date)
+          return;
+      }
 
-      // Check that there is a DG form, so that the DG assembling procedure needs to be performed.
-      DG_matrix_forms_present = false;
-      DG_vector_forms_present = false;
-      for(unsigned int i = 0; i < stage.mfsurf.size() && DG_matrix_forms_present == false; i++)
+      if (coloring == NULL)
+        coloring = new ElementColoring;
+      coloring->mesh = mesh;
+      coloring->mesh_seq = mesh->get_seq();
+      coloring->space_seqs.clear();
+      for (unsigned int i = 0; i < spaces.size(); i++)
+        coloring->space_seqs.push_back(spaces[i]->get_seq());
+
+      // DOFs of the elements (of all spaces on the mesh) and elements of the DOFs.
+      int max_id = mesh->get_max_element_id();
+      Hermes::vector<int> element_dofs_start;
+      element_dofs_start.resize(max_id + 1);
+      Hermes::vector<int> element_dofs;
+      Hermes::vector<Hermes::vector<int> > dof_elements;
+      dof_elements.resize(Space<Scalar>::get_num_dofs(spaces));
+      AsmList<Scalar> al;
+      Element* e;
+      for (int id = 0; id < max_id; id++)
       {
-        if (stage.mfsurf[i]->areas[0] == H2D_DG_INNER_EDGE)
+        element_dofs_start[id] = element_dofs.size();
+        e = mesh->get_element_fast(id);
+        if (!e->used || !e->active)
+          continue;
+        for (unsigned int i = 0; i < spaces.size(); i++)
         {
-          DG_matrix_forms_present = true;
-          break;
+          if (spaces[i]->get_mesh()->get_seq() != mesh->get_seq())
+            continue;
+          spaces[i]->get_element_assembly_list(e, &al, spaces_first_dofs[i]);
+          for (unsigned int j = 0; j < al.cnt; j++)
+          {
+            if (al.dof[j] < 0)
+              continue;
+            element_dofs.push_back(al.dof[j]);
+            dof_elements[al.dof[j]].push_back(id);
+          }
         }
       }
-      for(unsigned int i = 0; i < stage.vfsurf.size() && DG_vector_forms_present == false; i++)
+      element_dofs_start[max_id] = element_dofs.size();
+
+      // Greedy coloring: each element gets the lowest color not used by its neighbors.
+      coloring->colors.assign(max_id, -1);
+      coloring->num_colors = 0;
+      Hermes::vector<int> forbidden;
+      for_all_active_elements(e, mesh)
       {
-        if (stage.vfsurf[i]->areas[0] == H2D_DG_INNER_EDGE)
+        for (int j = element_dofs_start[e->id]; j < element_dofs_start[e->id + 1]; j++)
         {
-          DG_vector_forms_present = true;
-          break;
+          Hermes::vector<int>& neighbors = dof_elements[element_dofs[j]];
+          for (unsigned int k = 0; k < neighbors.size(); k++)
+            if (coloring->colors[neighbors[k]] >= 0)
+              forbidden[coloring->colors[neighbors[k]]] = e->id;
         }
-      }
-      for(unsigned int i = 0; i < stage.mfsurf_mc.size() && DG_matrix_forms_present == false; i++)
-      {
-        if (stage.mfsurf_mc[i]->areas[0] == H2D_DG_INNER_EDGE)
+        int color = 0;
+        while (color < coloring->num_colors && forbidden[color] == e->id)
+          color++;
+        if (color == coloring->num_colors)
         {
-          DG_matrix_forms_present = true;
-          break;
+          coloring->num_colors++;
+          forbidden.push_back(-1);
         }
+        coloring->colors[e->id] = color;
       }
-      for(unsigned int i = 0; i < stage.vfsurf_mc.size() && DG_vector_forms_present == false; i++)
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::assemble_one_stage_colored(Stage<Scalar>& stage,
+      SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs,
+      bool force_diagonal_blocks, Table* block_weights,
+      Hermes::vector<Solution<Scalar>*>& u_ext, TraversePlan* plan)
+    {
+      _F_;
+      update_element_coloring(stage.meshes[0]);
+      init_assembling_threads(stage, u_ext);
+
+      // Record all states, the states of one group have the same color and element mode
+      // (shapesets and quadratures are shared by all threads).
+      Hermes::vector<Hermes::vector<int> > groups;
+      groups.resize(2 * coloring->num_colors);
+      int num_states = plan->get_num_states();
+      for (int s = 0; s < num_states; s++)
       {
-        if (stage.vfsurf_mc[i]->areas[0] == H2D_DG_INNER_EDGE)
+        if ((unsigned int) s == assembling_states.size())
         {
-          DG_vector_forms_present = true;
-          break;
+          assembling_states.push_back(new AssemblingState);
+          assembling_states.back()->e.resize(stage.fns.size());
+          assembling_states.back()->sub_idx.resize(stage.fns.size());
+        }
+        AssemblingState* state = assembling_states[s];
+        Element** e = plan->get_elements(s);
+        Element* e0 = NULL;
+        for (unsigned int i = 0; i < stage.fns.size(); i++)
+        {
+          state->e[i] = e[i];
+          state->sub_idx[i] = plan->get_sub_idx(s)[i];
+          if (e0 == NULL && i < stage.idx.size())
+            e0 = e[i];
         }
+        plan->get_boundary_info(s, state->bnd, state->surf_pos);
+        state->trav_base = plan->get_base(s);
+        if (e0 != NULL)
+          groups[2 * coloring->colors[e0->id] + e0->get_mode()].push_back(s);
       }
 
-      // Loop through all assembling states.
-      // Assemble each one.
-      Element** e;
-      while ((e = trav.get_next_state(bnd, surf_pos)) != NULL)
-        // One state is a collection of (virtual) elements sharing
-        // the same physical location on (possibly) different meshes.
-        // This is then the same element of the virtual union mesh.
-        // The proper sub-element mappings to all the functions of
-        // this stage is supplied by the function Traverse::get_next_state()
-        // called in the while loop.
-        assemble_one_state(stage, mat, rhs, force_diagonal_blocks,
-        block_weights, spss, refmap,
-        u_ext, e, bnd, surf_pos, trav.get_base());
+      for (unsigned int group_i = 0; group_i < groups.size(); group_i++)
+      {
+        Hermes::vector<int>& group = groups[group_i];
+        int group_size = group.size();
 
-      if (mat != NULL)
-        mat->finish();
-      if (rhs != NULL)
-        rhs->finish();
-      trav.finish();
+        // The first state of the group whose assembling failed.
+        int failed_state = num_states;
 
-      if(DG_matrix_forms_present || DG_vector_forms_present)
-      {
-        Element* element_to_set_nonvisited;
-        for(unsigned int mesh_i = 0; mesh_i < stage.meshes.size(); mesh_i++)
-          for_all_elements(element_to_set_nonvisited, stage.meshes[mesh_i])
-          element_to_set_nonvisited->visited = false;
+        // No two elements of the group share a DOF, so they can add to the matrix and vector concurrently.
+#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+        for (int i = 0; i < group_size; i++)
+        {
+#ifdef _OPENMP
+          AssemblingThread* thread = assembling_threads[omp_get_thread_num()];
+#else
+          AssemblingThread* thread = assembling_threads[0];
+#endif
+          AssemblingState* state = assembling_states[group[i]];
+          try
+          {
+            thread->dp->set_assembling_state(thread->fns, state);
+            thread->dp->assemble_one_state(stage, mat, rhs, force_diagonal_blocks, block_weights,
+              thread->spss, thread->refmap, thread->u_ext, &state->e.front(), state->bnd, state->surf_pos, state->trav_base);
+          }
+          catch(...)
+          {
+#pragma omp critical (assemble_one_stage_colored)
+            if (group[i] < failed_state)
+              failed_state = group[i];
+          }
+        }
+
+        if (failed_state < num_states)
+        {
+          // Exceptions can not leave the parallel region: assemble the failed state again
+          // serially with new threads' data to rethrow the exception.
+          free_assembling_threads();
+          init_assembling_threads(stage, u_ext);
+          AssemblingThread* thread = assembling_threads[0];
+          AssemblingState* state = assembling_states[failed_state];
+          thread->dp->set_assembling_state(thread->fns, state);
+          record_load_cases(thread->dp, state);
+          thread->dp->assemble_one_state(stage, mat == NULL ? NULL : &state->mat, rhs == NULL ? NULL : &state->rhs,
+            force_diagonal_blocks, block_weights, thread->spss, thread->refmap, thread->u_ext,
+            &state->e.front(), state->bnd, state->surf_pos, state->trav_base);
+          state->mat.free();
+          state->rhs.free();
+          for (unsigned int j = 0; j < state->load_case_rhs.size(); j++)
+            state->load_case_rhs[j].free();
+          error("Assembling of an element failed in DiscreteProblem<Scalar>::assemble_one_stage_colored().");
+        }
       }
+
+      finish_assembling_threads();
     }
 
     template<typename Scalar>
@@ -791,6 +2013,10 @@ namespace Hermes
       if(rep_element == NULL)
         return;
 
+      // The temporaries of the form evaluations come from the arena of this instance,
+      // the arena is reset when the state is done.
+      MemoryArenaScope arena_scope(&arena, true);
+
       init_cache();
 
       // Assemble volume matrix forms.
@@ -821,7 +2047,6 @@ namespace Hermes
         delete al[i];
 
       delete_cache();
-
     }
 
     template<typename Scalar>
@@ -973,6 +2198,8 @@ namespace Hermes
         int m = vfv->i;
         if (isempty[vfv->i]) continue;
         if (fabs(vfv->scaling_factor) < 1e-12) continue;
+        Vector<Scalar>* form_rhs = get_load_case_rhs(rhs, vfv);
+        if (form_rhs == NULL) continue;
 
         // Assemble this form only if one of its areas is HERMES_ANY
         // of if the element marker coincides with one of the form's areas.
@@ -1010,7 +2237,7 @@ namespace Hermes
           // Numerical integration performed only if the coefficient
           // multiplying the form is nonzero.
           if (std::abs(al[m]->coef[i]) > 1e-12)
-            rhs->add(al[m]->dof[i], eval_form(vfv, u_ext, spss[m], refmap[m]) * al[m]->coef[i]);
+            form_rhs->add(al[m]->dof[i], eval_form(vfv, u_ext, spss[m], refmap[m]) * al[m]->coef[i]);
         }
       }
     }
@@ -1158,7 +2385,7 @@ namespace Hermes
                     cache_e[i]->free();
                     delete cache_e[i];
                     cache_e[i] = NULL;
-                    delete [] cache_jwt[i];
+                    MemoryArena::delete_array(cache_jwt[i]);
                   }
 
                   assemble_DG_one_neighbor(processed, neighbor_i, stage, mat, rhs,
@@ -1755,6 +2982,9 @@ namespace Hermes
           continue;
         if (vfs->areas[0] == H2D_DG_INNER_EDGE)
           continue;
+        Vector<Scalar>* form_rhs = get_load_case_rhs(rhs, vfs);
+        if (form_rhs == NULL)
+          continue;
 
         // Assemble this form only if one of its areas is HERMES_ANY or H2D_DG_BOUNDARY_EDGE,
         // or if the element marker coincides with one of the form's areas.
@@ -1796,7 +3026,7 @@ namespace Hermes
 
           // Numerical integration performed only if the coefficient multiplying the form is nonzero.
           if (std::abs(al[m]->coef[i]) > 1e-12)
-            rhs->add(al[m]->dof[i], eval_form(vfs, u_ext, spss[m], refmap[m], &surf_pos) * al[m]->coef[i]);
+            form_rhs->add(al[m]->dof[i], eval_form(vfs, u_ext, spss[m], refmap[m], &surf_pos) * al[m]->coef[i]);
         }
       }
     }
@@ -1922,6 +3152,9 @@ namespace Hermes
           continue;
         if (fabs(vfs->scaling_factor) < 1e-12)
           continue;
+        Vector<Scalar>* form_rhs = get_load_case_rhs(rhs, vfs);
+        if (form_rhs == NULL)
+          continue;
 
         // Here we use the standard pss, possibly just transformed by NeighborSearch.
         for (unsigned int i = 0; i < al[m]->cnt; i++)
@@ -1929,7 +3162,7 @@ namespace Hermes
           if (al[m]->dof[i] < 0)
             continue;
           spss[m]->set_active_shape(al[m]->idx[i]);
-          rhs->add(al[m]->dof[i], eval_dg_form(vfs, u_ext, spss[m], refmap[m], &surf_pos, neighbor_searches, stage.meshes[m]->get_seq() - min_dg_mesh_seq) * al[m]->coef[i]);
+          form_rhs->add(al[m]->dof[i], eval_dg_form(vfs, u_ext, spss[m], refmap[m], &surf_pos, neighbor_searches, stage.meshes[m]->get_seq() - min_dg_mesh_seq) * al[m]->coef[i]);
         }
       }
     }
@@ -1942,9 +3175,9 @@ namespace Hermes
 
       // External functions.
       fake_ext->nf = ext.size();
-      Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[fake_ext->nf];
+      Func<Hermes::Ord>** fake_ext_fn = MemoryArena::new_array<Func<Hermes::Ord>*>(fake_ext->nf);
       for (int i = 0; i < fake_ext->nf; i++)
-        fake_ext_fn[i] = get_fn_ord(ext[i]->get_fn_order());
+        fake_ext_fn[i] = get_fn_ord(get_ext_fn(ext[i])->get_fn_order());
       fake_ext->fn = fake_ext_fn;
 
       return fake_ext;
@@ -1958,10 +3191,10 @@ namespace Hermes
       ExtData<Scalar>* ext_data = new ExtData<Scalar>;
 
       // Copy external functions.
-      Func<Scalar>** ext_fn = new Func<Scalar>*[ext.size()];
+      Func<Scalar>** ext_fn = MemoryArena::new_array<Func<Scalar>*>(ext.size());
       for (unsigned i = 0; i < ext.size(); i++)
       {
-        if (ext[i] != NULL) ext_fn[i] = init_fn(ext[i], order);
+        if (ext[i] != NULL) ext_fn[i] = init_fn(get_ext_fn(ext[i]), order);
         else ext_fn[i] = NULL;
       }
       ext_data->nf = ext.size();
@@ -1979,9 +3212,9 @@ namespace Hermes
 
       // External functions.
       fake_ext->nf = ext.size();
-      Func<Hermes::Ord>** fake_ext_fn = new Func<Hermes::Ord>*[fake_ext->nf];
+      Func<Hermes::Ord>** fake_ext_fn = MemoryArena::new_array<Func<Hermes::Ord>*>(fake_ext->nf);
       for (int i = 0; i < fake_ext->nf; i++)
-        fake_ext_fn[i] = get_fn_ord(ext[i]->get_edge_fn_order(edge));
+        fake_ext_fn[i] = get_fn_ord(get_ext_fn(ext[i])->get_edge_fn_order(edge));
       fake_ext->fn = fake_ext_fn;
 
       return fake_ext;
@@ -1992,7 +3225,7 @@ namespace Hermes
       LightArray<NeighborSearch<Scalar>*>& neighbor_searches, int order)
     {
       _F_;
-      Func<Scalar>** ext_fns = new Func<Scalar>*[ext.size()];
+      Func<Scalar>** ext_fns = MemoryArena::new_array<Func<Scalar>*>(ext.size());
       for(unsigned int j = 0; j < ext.size(); j++)
       {
         neighbor_searches.get(ext[j]->get_mesh()->get_seq() - min_dg_mesh_seq)->set_quad_order(order);
@@ -2011,7 +3244,7 @@ namespace Hermes
       LightArray<NeighborSearch<Scalar>*>& neighbor_searches)
     {
       _F_;
-      Func<Hermes::Ord>** fake_ext_fns = new Func<Hermes::Ord>*[ext.size()];
+      Func<Hermes::Ord>** fake_ext_fns = MemoryArena::new_array<Func<Hermes::Ord>*>(ext.size());
       for (unsigned int j = 0; j < ext.size(); j++)
         fake_ext_fns[j] = init_ext_fn_ord(neighbor_searches.get(ext[j]->get_mesh()->get_seq() - min_dg_mesh_seq), ext[j]);
 
@@ -2029,35 +3262,33 @@ namespace Hermes
       if(rm->is_jacobian_const())
       {
         typename AssemblingCaches::KeyConst key(256 - fu->get_active_shape(), order, fu->get_transform(), fu->get_shapeset()->get_id(), rm->get_const_inv_ref_map());
-        if(rm->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE)
+        typename AssemblingCaches::template FnCache<typename AssemblingCaches::KeyConst>& cache =
+          (rm->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE) ? assembling_caches.const_cache_fn_triangles : assembling_caches.const_cache_fn_quads;
+        Func<double>* fn = cache.get(key);
+        if(fn == NULL)
         {
-          if(assembling_caches.const_cache_fn_triangles.find(key) == assembling_caches.const_cache_fn_triangles.end())
-            assembling_caches.const_cache_fn_triangles[key] = init_fn(fu, rm, order);
-          return assembling_caches.const_cache_fn_triangles[key];
-        }
-        else
-        {
-          if(assembling_caches.const_cache_fn_quads.find(key) == assembling_caches.const_cache_fn_quads.end())
-            assembling_caches.const_cache_fn_quads[key] = init_fn(fu, rm, order);
-          return assembling_caches.const_cache_fn_quads[key];
+          // The values are kept for the whole assembling, not only for the current state.
+          {
+            MemoryArenaScope arena_scope(NULL);
+            fn = init_fn(fu, rm, order);
+          }
+          cache.add(key, fn);
         }
+        return fn;
       }
       else
       {
         typename AssemblingCaches::KeyNonConst key(256 - fu->get_active_shape(), order,
           fu->get_transform(), fu->get_shapeset()->get_id());
-        if(rm->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE)
-        {
-          if(assembling_caches.cache_fn_triangles.find(key) == assembling_caches.cache_fn_triangles.end())
-            assembling_caches.cache_fn_triangles[key] = init_fn(fu, rm, order);
-          return assembling_caches.cache_fn_triangles[key];
-        }
-        else
+        typename AssemblingCaches::template FnCache<typename AssemblingCaches::KeyNonConst>& cache =
+          (rm->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE) ? assembling_caches.cache_fn_triangles : assembling_caches.cache_fn_quads;
+        Func<double>* fn = cache.get(key);
+        if(fn == NULL)
         {
-          if(assembling_caches.cache_fn_quads.find(key) == assembling_caches.cache_fn_quads.end())
-            assembling_caches.cache_fn_quads[key] = init_fn(fu, rm, order);
-          return assembling_caches.cache_fn_quads[key];
+          fn = init_fn(fu, rm, order);
+          cache.add(key, fn);
         }
+        return fn;
       }
     }
 
@@ -2068,10 +3299,34 @@ namespace Hermes
       assert(order >= 0);
       unsigned int cached_order = (unsigned int) order;
       if(!assembling_caches.cache_fn_ord.present(cached_order))
+      {
+        MemoryArenaScope arena_scope(NULL);
         assembling_caches.cache_fn_ord.add(init_fn_ord(cached_order), cached_order);
+      }
       return assembling_caches.cache_fn_ord.get(cached_order);
     }
 
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::init_order_key(typename AssemblingCaches::KeyOrder& key, Form<Scalar>* form,
+      Func<Hermes::Ord>** oi, int num_oi, Func<Hermes::Ord>* ou, Func<Hermes::Ord>* ov, ExtData<Hermes::Ord>* ext, int marker)
+    {
+      if (!form->get_order_memoization())
+        return false;
+      key = typename AssemblingCaches::KeyOrder(form, marker);
+      for (int i = 0; i < num_oi; i++)
+        if (!key.add(oi[i]))
+          return false;
+      if (ou != NULL && !key.add(ou))
+        return false;
+      if (!key.add(ov))
+        return false;
+      if (ext != NULL)
+        for (int i = 0; i < ext->nf; i++)
+          if (!key.add(ext->fn[i]))
+            return false;
+      return true;
+    }
+
     template<typename Scalar>
     void DiscreteProblem<Scalar>::init_cache()
     {
@@ -2091,7 +3346,7 @@ namespace Hermes
         cache_e[order]->free();
         delete cache_e[order];
         cache_e[order] = NULL;
-        delete [] cache_jwt[order];
+        MemoryArena::delete_array(cache_jwt[order]);
       }
     }
 
@@ -2104,23 +3359,11 @@ namespace Hermes
         if (cache_e[i] != NULL)
         {
           cache_e[i]->free(); delete cache_e[i];
-          delete [] cache_jwt[i];
+          MemoryArena::delete_array(cache_jwt[i]);
         }
       }
 
-      for (typename std::map<typename AssemblingCaches::KeyNonConst, Func<double>*, typename AssemblingCaches::CompareNonConst>::const_iterator it = assembling_caches.cache_fn_quads.begin();
-        it != assembling_caches.cache_fn_quads.end(); it++)
-      {
-        (it->second)->free_fn(); delete (it->second);
-      }
       assembling_caches.cache_fn_quads.clear();
-
-      for (typename std::map<typename AssemblingCaches::KeyNonConst, Func<double>*, typename AssemblingCaches::CompareNonConst>::const_iterator it = assembling_caches.cache_fn_triangles.begin();
-        it != assembling_caches.cache_fn_triangles.end(); it++)
-      {
-        (it->second)->free_fn();
-        delete (it->second);
-      }
       assembling_caches.cache_fn_triangles.clear();
     }
 
@@ -2151,6 +3394,64 @@ namespace Hermes
       return result;
     }
     
+    template<typename Scalar>
+    template<typename FormType>
+    int DiscreteProblem<Scalar>::calc_form_order(FormType* form, Func<Hermes::Ord>** oi, int num_oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext, int marker)
+    {
+      typename AssemblingCaches::KeyOrder key;
+      bool memoize = init_order_key(key, form, oi, num_oi, ou, ov, ext, marker);
+      int form_order;
+      if (!memoize || !assembling_caches.order_memo.get(key, form_order))
+      {
+        form_order = eval_form_order(form, oi, ou, ov, e, ext);
+        if (memoize)
+          assembling_caches.order_memo.add(key, form_order);
+      }
+      return form_order;
+    }
+
+    template<typename Scalar>
+    template<typename FormType>
+    int DiscreteProblem<Scalar>::eval_form_order(FormType* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext)
+    {
+      double fake_wt = 1.0;
+      return form->ord(1, &fake_wt, oi, ou, ov, e, ext).get_order();
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::eval_form_order(VectorFormVol<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext)
+    {
+      double fake_wt = 1.0;
+      return form->ord(1, &fake_wt, oi, ov, e, ext).get_order();
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::eval_form_order(MultiComponentVectorFormVol<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext)
+    {
+      double fake_wt = 1.0;
+      return form->ord(1, &fake_wt, oi, ov, e, ext).get_order();
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::eval_form_order(VectorFormSurf<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext)
+    {
+      double fake_wt = 1.0;
+      return form->ord(1, &fake_wt, oi, ov, e, ext).get_order();
+    }
+
+    template<typename Scalar>
+    int DiscreteProblem<Scalar>::eval_form_order(MultiComponentVectorFormSurf<Scalar>* form, Func<Hermes::Ord>** oi, Func<Hermes::Ord>* ou,
+      Func<Hermes::Ord>* ov, Geom<Hermes::Ord>* e, ExtData<Hermes::Ord>* ext)
+    {
+      double fake_wt = 1.0;
+      return form->ord(1, &fake_wt, oi, ov, e, ext).get_order();
+    }
+
     template<typename Scalar>
     int DiscreteProblem<Scalar>::calc_order_matrix_form_vol(MatrixFormVol<Scalar> *mfv, Hermes::vector<Solution<Scalar>*> u_ext,
       PrecalcShapeset *fu, PrecalcShapeset *fv, RefMap *ru, RefMap *rv)
@@ -2171,7 +3472,7 @@ namespace Hermes
         int inc = (fu->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2189,19 +3490,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(mfv->ext);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = mfv->ord(1, &fake_wt, oi, ou, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(mfv, oi, u_ext_length - u_ext_offset, ou, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = ru->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, ru->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -2230,7 +3528,7 @@ namespace Hermes
         double* jac = NULL;
         if(!ru->is_jacobian_const())
           jac = ru->get_jacobian(order);
-        cache_jwt[order] = new double[np];
+        cache_jwt[order] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
         {
           if(ru->is_jacobian_const())
@@ -2249,7 +3547,7 @@ namespace Hermes
       if(RungeKutta)
         prev_size = RK_original_spaces_count;
 
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + mfv->u_ext_offset] != NULL)
@@ -2280,7 +3578,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-        delete [] prev;
+        MemoryArena::delete_array(prev);
 
         if (ext != NULL)
         {
@@ -2328,7 +3626,7 @@ namespace Hermes
         double* jac = NULL;
         if(!rv->is_jacobian_const())
           jac = rv->get_jacobian(order);
-        cache_jwt[order] = new double[np];
+        cache_jwt[order] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
         {
           if(rv->is_jacobian_const())
@@ -2342,7 +3640,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - vfv->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + vfv->u_ext_offset] != NULL)
@@ -2369,7 +3667,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-      delete [] prev;
+      MemoryArena::delete_array(prev);
 
       if (ext != NULL)
       {
@@ -2399,7 +3697,7 @@ namespace Hermes
         int inc = (fv->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2416,20 +3714,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(vfv->ext);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of
-        // a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = vfv->ord(1, &fake_wt, oi, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(vfv, oi, u_ext_length - u_ext_offset, NULL, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = rv->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, rv->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -2461,7 +3755,7 @@ namespace Hermes
         int inc = (fv->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2478,20 +3772,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(vfv->ext);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of
-        // a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = vfv->ord(1, &fake_wt, oi, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(vfv, oi, u_ext_length - u_ext_offset, NULL, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = rv->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, rv->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -2522,7 +3812,7 @@ namespace Hermes
         double* jac = NULL;
         if(!rv->is_jacobian_const())
           jac = rv->get_jacobian(order);
-        cache_jwt[order] = new double[np];
+        cache_jwt[order] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
         {
           if(rv->is_jacobian_const())
@@ -2541,7 +3831,7 @@ namespace Hermes
       if(RungeKutta)
         prev_size = RK_original_spaces_count;
 
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + vfv->u_ext_offset] != NULL)
@@ -2570,7 +3860,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-      delete [] prev;
+      MemoryArena::delete_array(prev);
 
       if (ext != NULL)
       {
@@ -2617,7 +3907,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(ru, surf_pos, eo);
         double3* tan = ru->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -2626,7 +3916,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - mfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + mfs->u_ext_offset] != NULL)
@@ -2654,7 +3944,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-      delete [] prev;
+      MemoryArena::delete_array(prev);
 
       if (ext != NULL)
       {
@@ -2683,7 +3973,7 @@ namespace Hermes
         int inc = (fu->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2701,19 +3991,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(mfs->ext, surf_pos->surf_num);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = mfs->ord(1, &fake_wt, oi, ou, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(mfs, oi, u_ext_length - u_ext_offset, ou, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = ru->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, ru->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -2744,7 +4031,7 @@ namespace Hermes
         int inc = (fu->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2762,19 +4049,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(mfs->ext, surf_pos->surf_num);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = mfs->ord(1, &fake_wt, oi, ou, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(mfs, oi, u_ext_length - u_ext_offset, ou, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = ru->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, ru->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -2804,7 +4088,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(ru, surf_pos, eo);
         double3* tan = ru->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -2813,7 +4097,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - mfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       // In case of Runge-Kutta, this is time-saving, as it is known how many functions are there for the user.
       if(RungeKutta)
         prev_size = RK_original_spaces_count;
@@ -2847,7 +4131,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-        delete [] prev;
+        MemoryArena::delete_array(prev);
 
         if (ext != NULL)
         {
@@ -2896,7 +4180,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(rv, surf_pos, eo);
         double3* tan = rv->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -2905,7 +4189,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - vfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + vfs->u_ext_offset] != NULL)
@@ -2931,7 +4215,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-        delete [] prev;
+        MemoryArena::delete_array(prev);
 
         if (ext != NULL)
         {
@@ -2960,7 +4244,7 @@ namespace Hermes
         int inc = (fv->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -2977,19 +4261,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(vfs->ext);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = vfs->ord(1, &fake_wt, oi, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(vfs, oi, u_ext_length - u_ext_offset, NULL, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = rv->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, rv->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -3020,7 +4301,7 @@ namespace Hermes
         int inc = (fv->get_num_components() == 2) ? 1 : 0;
 
         // Hermes::Order of solutions from the previous Newton iteration.
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[u_ext_length - u_ext_offset];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(u_ext_length - u_ext_offset);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for(int i = 0; i < u_ext_length - u_ext_offset; i++)
             if (u_ext[i + u_ext_offset] != NULL)
@@ -3037,19 +4318,16 @@ namespace Hermes
         // Hermes::Order of additional external functions.
         ExtData<Hermes::Ord>* fake_ext = init_ext_fns_ord(vfs->ext);
 
-        // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-        double fake_wt = 1.0;
-
-        // Total order of the vector form.
-        Hermes::Ord o = vfs->ord(1, &fake_wt, oi, ov, &geom_ord, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(vfs, oi, u_ext_length - u_ext_offset, NULL, ov, &geom_ord, fake_ext);
 
         // Increase due to reference map.
         order = rv->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, rv->get_active_element()->get_mode());
 
         // Cleanup.
-        delete [] oi;
+        MemoryArena::delete_array(oi);
 
         if (fake_ext != NULL)
         {
@@ -3079,7 +4357,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(rv, surf_pos, eo);
         double3* tan = rv->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -3088,7 +4366,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - vfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       // In case of Runge-Kutta, this is time-saving, as it is known how many functions are there for the user.
       if(RungeKutta)
         prev_size = RK_original_spaces_count;
@@ -3121,7 +4399,7 @@ namespace Hermes
           prev[i]->free_fn();
           delete prev[i];
         }
-        delete [] prev;
+        MemoryArena::delete_array(prev);
 
         if (ext != NULL)
         {
@@ -3149,7 +4427,7 @@ namespace Hermes
       {
         // Hermes::Order of solutions from the previous Newton iteration.
         int prev_size = u_ext.size() - mfs->u_ext_offset;
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[prev_size];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(prev_size);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for (int i = 0; i < prev_size; i++)
             if (u_ext[i + mfs->u_ext_offset] != NULL)
@@ -3171,15 +4449,14 @@ namespace Hermes
         // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
         Geom<Hermes::Ord>* fake_e = new InterfaceGeom<Hermes::Ord>(&geom_ord, nbs_u->neighb_el->marker,
           nbs_u->neighb_el->id, Hermes::Ord(nbs_u->neighb_el->get_diameter()));
-        double fake_wt = 1.0;
 
-        // Total order of the vector form.
-        Hermes::Ord o = mfs->ord(1, &fake_wt, oi, ou, ov, fake_e, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(mfs, oi, prev_size, ou, ov, fake_e, fake_ext, fake_e->get_neighbor_marker());
 
         // Increase due to reference maps.
         order = ru->get_inv_ref_order();
 
-        order += o.get_order();
+        order += form_order;
         limit_order(order, ru->get_active_element()->get_mode());
 
         // Clean up.
@@ -3187,7 +4464,7 @@ namespace Hermes
           for (int i = 0; i < prev_size; i++)
             if (u_ext[i + mfs->u_ext_offset] != NULL)
               delete oi[i];
-        delete [] oi;
+        MemoryArena::delete_array(oi);
         delete fake_e;
         delete ou;
         delete ov;
@@ -3233,7 +4510,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(ru_central, surf_pos, eo);
         double3* tan = ru_central->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -3244,7 +4521,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - mfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + mfs->u_ext_offset] != NULL)
@@ -3279,7 +4556,7 @@ namespace Hermes
         }
       }
 
-      delete [] prev;
+      MemoryArena::delete_array(prev);
 
 
       if (ext != NULL)
@@ -3317,7 +4594,7 @@ namespace Hermes
       {
         // Hermes::Order of solutions from the previous Newton iteration.
         int prev_size = u_ext.size() - vfs->u_ext_offset;
-        Func<Hermes::Ord>** oi = new Func<Hermes::Ord>*[prev_size];
+        Func<Hermes::Ord>** oi = MemoryArena::new_array<Func<Hermes::Ord>*>(prev_size);
         if (u_ext != Hermes::vector<Solution<Scalar>*>())
           for (int i = 0; i < prev_size; i++)
             if (u_ext[i + vfs->u_ext_offset] != NULL)
@@ -3339,14 +4616,13 @@ namespace Hermes
         // Hermes::Order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
         Geom<Hermes::Ord>* fake_e = new InterfaceGeom<Hermes::Ord>(&geom_ord,
           nbs_v->neighb_el->marker, nbs_v->neighb_el->id, Hermes::Ord(nbs_v->neighb_el->get_diameter()));
-        double fake_wt = 1.0;
 
-        // Total order of the vector form.
-        Hermes::Ord o = vfs->ord(1, &fake_wt, oi, ov, fake_e, fake_ext);
+        // Total order of the form, memoized for the orders of the arguments.
+        int form_order = calc_form_order(vfs, oi, prev_size, NULL, ov, fake_e, fake_ext, fake_e->get_neighbor_marker());
 
         // Increase due to reference map.
         order = rv->get_inv_ref_order();
-        order += o.get_order();
+        order += form_order;
         limit_order(order, rv->get_active_element()->get_mode());
 
         // Clean up.
@@ -3354,7 +4630,7 @@ namespace Hermes
           for (int i = 0; i < prev_size; i++)
             if (u_ext[i + vfs->u_ext_offset] != NULL)
               delete oi[i];
-        delete [] oi;
+        MemoryArena::delete_array(oi);
         if (fake_ext != NULL)
         {
           for (int i = 0; i < fake_ext->nf; i++)
@@ -3395,7 +4671,7 @@ namespace Hermes
       {
         cache_e[eo] = init_geom_surf(rv, surf_pos, eo);
         double3* tan = rv->get_tangent(surf_pos->surf_num, eo);
-        cache_jwt[eo] = new double[np];
+        cache_jwt[eo] = MemoryArena::new_array<double>(np);
         for(int i = 0; i < np; i++)
           cache_jwt[eo][i] = pt[i][2] * tan[i][2];
       }
@@ -3406,7 +4682,7 @@ namespace Hermes
 
       // Values of the previous Newton iteration, shape functions and external functions in quadrature points.
       int prev_size = u_ext.size() - vfs->u_ext_offset;
-      Func<Scalar>** prev = new Func<Scalar>*[prev_size];
+      Func<Scalar>** prev = MemoryArena::new_array<Func<Scalar>*>(prev_size);
       if (u_ext != Hermes::vector<Solution<Scalar>*>())
         for (int i = 0; i < prev_size; i++)
           if (u_ext[i + vfs->u_ext_offset] != NULL)
@@ -3434,7 +4710,7 @@ namespace Hermes
         }
       }
 
-      delete [] prev;
+      MemoryArena::delete_array(prev);
 
       if (ext != NULL)
       {
@@ -3505,18 +4781,7 @@ namespace Hermes
     DiscreteProblem<Scalar>::AssemblingCaches::~AssemblingCaches()
     {
       _F_;
-      for (typename std::map<KeyConst, Func<double>*, CompareConst>::const_iterator it = const_cache_fn_triangles.begin();
-        it != const_cache_fn_triangles.end(); it++)
-      {
-        (it->second)->free_fn(); delete (it->second);
-      }
       const_cache_fn_triangles.clear();
-
-      for (typename std::map<KeyConst, Func<double>*, CompareConst>::const_iterator it = const_cache_fn_quads.begin();
-        it != const_cache_fn_quads.end(); it++)
-      {
-        (it->second)->free_fn(); delete (it->second);
-      }
       const_cache_fn_quads.clear();
 
       for(unsigned int i = 0; i < cache_fn_ord.get_size(); i++)
@@ -3555,32 +4820,58 @@ namespace Hermes
     }
 #endif
 
+    /// Mixes a 32-bit value into a hash value.
+    static inline unsigned int hash_combine(unsigned int hash, unsigned int value)
+    {
+      value *= 0xcc9e2d51u;
+      value = (value << 15) | (value >> 17);
+      value *= 0x1b873593u;
+      hash ^= value;
+      hash = (hash << 13) | (hash >> 19);
+      return hash * 5 + 0xe6546b64u;
+    }
+
+    /// Mixes a double into a hash value, -0.0 and 0.0 (equal keys) give the same hash.
+    static inline unsigned int hash_combine(unsigned int hash, double value)
+    {
+      value += 0.0;
+      unsigned int words[2];
+      memcpy(words, &value, sizeof(double));
+      return hash_combine(hash_combine(hash, words[0]), words[1]);
+    }
+
+    /// Final mixing of a hash value.
+    static inline unsigned int hash_finish(unsigned int hash)
+    {
+      hash ^= hash >> 16;
+      hash *= 0x85ebca6bu;
+      hash ^= hash >> 13;
+      hash *= 0xc2b2ae35u;
+      return hash ^ (hash >> 16);
+    }
+
     template<typename Scalar>
-    bool DiscreteProblem<Scalar>::AssemblingCaches::CompareConst::operator()(KeyConst a, KeyConst b) const
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::KeyConst::hash() const
     {
-      if(a.inv_ref_map[0][0] < b.inv_ref_map[0][0]) return true;
-      else if(a.inv_ref_map[0][0] > b.inv_ref_map[0][0]) return false;
-      else
-        if(a.inv_ref_map[0][1] < b.inv_ref_map[0][1]) return true;
-        else if(a.inv_ref_map[0][1] > b.inv_ref_map[0][1]) return false;
-        else
-          if(a.inv_ref_map[1][0] < b.inv_ref_map[1][0]) return true;
-          else if(a.inv_ref_map[1][0] > b.inv_ref_map[1][0]) return false;
-          else
-            if(a.inv_ref_map[1][1] < b.inv_ref_map[1][1]) return true;
-            else if(a.inv_ref_map[1][1] > b.inv_ref_map[1][1]) return false;
-            else
-              if (a.index < b.index) return true;
-              else if (a.index > b.index) return false;
-              else
-                if (a.order < b.order) return true;
-                else if (a.order > b.order) return false;
-                else
-                  if (a.sub_idx < b.sub_idx) return true;
-                  else if (a.sub_idx > b.sub_idx) return false;
-                  else
-                    if (a.shapeset_type < b.shapeset_type) return true;
-                    else return false;
+      unsigned int hash = 0;
+      hash = hash_combine(hash, (unsigned int) index);
+      hash = hash_combine(hash, (unsigned int) order);
+      hash = hash_combine(hash, (unsigned int) sub_idx);
+      hash = hash_combine(hash, (unsigned int) shapeset_type);
+      hash = hash_combine(hash, inv_ref_map[0][0]);
+      hash = hash_combine(hash, inv_ref_map[0][1]);
+      hash = hash_combine(hash, inv_ref_map[1][0]);
+      hash = hash_combine(hash, inv_ref_map[1][1]);
+      return hash_finish(hash);
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::KeyConst::operator==(const KeyConst& other) const
+    {
+      return index == other.index && order == other.order && sub_idx == other.sub_idx
+        && shapeset_type == other.shapeset_type
+        && inv_ref_map[0][0] == other.inv_ref_map[0][0] && inv_ref_map[0][1] == other.inv_ref_map[0][1]
+        && inv_ref_map[1][0] == other.inv_ref_map[1][0] && inv_ref_map[1][1] == other.inv_ref_map[1][1];
     }
 
 #ifdef _MSC_VER
@@ -3603,28 +4894,248 @@ namespace Hermes
     }
 #endif
 
-    template<typename Scalar> bool DiscreteProblem<Scalar>::AssemblingCaches::CompareNonConst::operator()(KeyNonConst a, KeyNonConst b) const
+    template<typename Scalar>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::KeyNonConst::hash() const
     {
-      if (a.index < b.index) return true;
-      else if (a.index > b.index) return false;
-      else
+      unsigned int hash = 0;
+      hash = hash_combine(hash, (unsigned int) index);
+      hash = hash_combine(hash, (unsigned int) order);
+      hash = hash_combine(hash, (unsigned int) sub_idx);
+      hash = hash_combine(hash, (unsigned int) shapeset_type);
+      return hash_finish(hash);
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::KeyNonConst::operator==(const KeyNonConst& other) const
+    {
+      return index == other.index && order == other.order && sub_idx == other.sub_idx
+        && shapeset_type == other.shapeset_type;
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::FnCache() : mask(0)
+    {
+      rehash(64);
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::~FnCache()
+    {
+      clear();
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::find_slot(const Key& key) const
+    {
+      unsigned int slot = key.hash() & mask;
+      while (fns[slot] != NULL && !(keys[slot] == key))
+        slot = (slot + 1) & mask;
+      return slot;
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    Func<double>* DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::get(const Key& key) const
+    {
+      return fns[find_slot(key)];
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    void DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::add(const Key& key, Func<double>* fn)
+    {
+      // Keep the load factor at most 1/2.
+      if (2 * (used_slots.size() + 1) > fns.size())
+        rehash(2 * fns.size());
+      unsigned int slot = find_slot(key);
+      if (fns[slot] != NULL)
+        error("Key already present in DiscreteProblem<Scalar>::AssemblingCaches::FnCache::add().");
+      keys[slot] = key;
+      fns[slot] = fn;
+      used_slots.push_back(slot);
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    void DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::clear()
+    {
+      for (unsigned int i = 0; i < used_slots.size(); i++)
       {
-        if (a.order < b.order) return true;
-        else if (a.order > b.order) return false;
-        else
-        {
-          if (a.sub_idx < b.sub_idx) return true;
-          else if (a.sub_idx > b.sub_idx) return false;
-          else
-          {
-            if (a.shapeset_type < b.shapeset_type) return true;
-            else return false;
-          }
-        }
+        fns[used_slots[i]]->free_fn();
+        delete fns[used_slots[i]];
+        fns[used_slots[i]] = NULL;
+      }
+      used_slots.clear();
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::get_size() const
+    {
+      return used_slots.size();
+    }
+
+    template<typename Scalar>
+    template<typename Key>
+    void DiscreteProblem<Scalar>::AssemblingCaches::FnCache<Key>::rehash(unsigned int new_capacity)
+    {
+      Hermes::vector<Key> old_keys;
+      Hermes::vector<Func<double>*> old_fns;
+      Hermes::vector<unsigned int> old_used_slots;
+      old_keys.swap(keys);
+      old_fns.swap(fns);
+      old_used_slots.swap(used_slots);
+
+      keys.resize(new_capacity);
+      fns.resize(new_capacity, NULL);
+      mask = new_capacity - 1;
+      for (unsigned int i = 0; i < old_used_slots.size(); i++)
+      {
+        unsigned int slot = find_slot(old_keys[old_used_slots[i]]);
+        keys[slot] = old_keys[old_used_slots[i]];
+        fns[slot] = old_fns[old_used_slots[i]];
+        used_slots.push_back(slot);
+      }
+    }
+
+    template<typename Scalar>
+    DiscreteProblem<Scalar>::AssemblingCaches::KeyOrder::KeyOrder(const void* form, int marker) : form(form), marker(marker), num_orders(0)
+    {
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::KeyOrder::add(int order, bool discontinuous)
+    {
+      // The orders (from -1) are stored in 7 bits, the 8th one marks the parts of discontinuous functions.
+      if (num_orders == H2D_MAX_ORDERS || order < -1 || order > 126)
+        return false;
+      orders[num_orders++] = (unsigned char) ((order + 1) | (discontinuous ? 128 : 0));
+      return true;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::KeyOrder::add(Func<Hermes::Ord>* fn)
+    {
+      if (fn == NULL)
+        return add(-1);
+      DiscontinuousFunc<Hermes::Ord>* dfn = dynamic_cast<DiscontinuousFunc<Hermes::Ord>*>(fn);
+      if (dfn == NULL)
+        return add(fn->val[0].get_order());
+      return add(dfn->fn_central == NULL ? -1 : dfn->fn_central->val[0].get_order(), true)
+        && add(dfn->fn_neighbor == NULL ? -1 : dfn->fn_neighbor->val[0].get_order(), true);
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::KeyOrder::hash() const
+    {
+      unsigned int hash = 0;
+      unsigned int form_words[sizeof(const void*) / sizeof(unsigned int)];
+      memcpy(form_words, &form, sizeof(const void*));
+      for (unsigned int i = 0; i < sizeof(const void*) / sizeof(unsigned int); i++)
+        hash = hash_combine(hash, form_words[i]);
+      hash = hash_combine(hash, (unsigned int) marker);
+      for (int i = 0; i < num_orders; i++)
+        hash = hash_combine(hash, (unsigned int) orders[i]);
+      return hash_finish(hash);
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::KeyOrder::operator==(const KeyOrder& other) const
+    {
+      return form == other.form && marker == other.marker && num_orders == other.num_orders
+        && memcmp(orders, other.orders, num_orders) == 0;
+    }
+
+    template<typename Scalar>
+    DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::OrderMemo() : size(0), mask(0)
+    {
+      rehash(64);
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::find_slot(const KeyOrder& key) const
+    {
+      unsigned int slot = key.hash() & mask;
+      while (used[slot] && !(keys[slot] == key))
+        slot = (slot + 1) & mask;
+      return slot;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::get(const KeyOrder& key, int& order) const
+    {
+      unsigned int slot = find_slot(key);
+      if (!used[slot])
+        return false;
+      order = orders[slot];
+      return true;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::add(const KeyOrder& key, int order)
+    {
+      // Keep the load factor at most 1/2.
+      if (2 * (size + 1) > used.size())
+        rehash(2 * used.size());
+      unsigned int slot = find_slot(key);
+      if (!used[slot])
+      {
+        keys[slot] = key;
+        used[slot] = true;
+        size++;
+      }
+      orders[slot] = order;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::clear()
+    {
+      if (size > 0)
+        used.assign(used.size(), false);
+      size = 0;
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::get_size() const
+    {
+      return size;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::AssemblingCaches::OrderMemo::rehash(unsigned int new_capacity)
+    {
+      Hermes::vector<KeyOrder> old_keys;
+      Hermes::vector<int> old_orders;
+      Hermes::vector<bool> old_used;
+      old_keys.swap(keys);
+      old_orders.swap(orders);
+      old_used.swap(used);
+
+      keys.resize(new_capacity);
+      orders.resize(new_capacity);
+      used.resize(new_capacity, false);
+      mask = new_capacity - 1;
+      for (unsigned int i = 0; i < old_used.size(); i++)
+      {
+        if (!old_used[i])
+          continue;
+        unsigned int slot = find_slot(old_keys[i]);
+        keys[slot] = old_keys[i];
+        orders[slot] = old_orders[i];
+        used[slot] = true;
       }
     }
 
     template class HERMES_API DiscreteProblem<double>;
     template class HERMES_API DiscreteProblem<std::complex<double> >;
+    template class HERMES_API DiscreteProblemOperator<double>;
+    template class HERMES_API DiscreteProblemOperator<std::complex<double> >;
+    template class HERMES_API DiscreteProblem<double>::AssemblingCaches::FnCache<DiscreteProblem<double>::AssemblingCaches::KeyConst>;
+    template class HERMES_API DiscreteProblem<double>::AssemblingCaches::FnCache<DiscreteProblem<double>::AssemblingCaches::KeyNonConst>;
+    template class HERMES_API DiscreteProblem<std::complex<double> >::AssemblingCaches::FnCache<DiscreteProblem<std::complex<double> >::AssemblingCaches::KeyConst>;
+    template class HERMES_API DiscreteProblem<std::complex<double> >::AssemblingCaches::FnCache<DiscreteProblem<std::complex<double> >::AssemblingCaches::KeyNonConst>;
   }
 }
@@ -126,18 +126,18 @@ namespace Hermes
     template<typename T>
     void Func<T>::free_fn()
     {
-      delete [] val; val = NULL;
-      delete [] dx; dx = NULL;
-      delete [] dy; dy = NULL;
+      MemoryArena::delete_array(val); val = NULL;
+      MemoryArena::delete_array(dx); dx = NULL;
+      MemoryArena::delete_array(dy); dy = NULL;
 #ifdef H2D_SECOND_DERIVATIVES_ENABLED
-      delete [] laplace; laplace = NULL;
+      MemoryArena::delete_array(laplace); laplace = NULL;
 #endif
 
-      delete [] val0; delete [] val1; val0 = val1 = NULL;
-      delete [] dx0;  delete [] dx1; dx0 = dx1 = NULL;
-      delete [] dy0;  delete [] dy1; dy0 = dy1 = NULL;
-      delete [] curl; curl = NULL;
-      delete [] div; div = NULL;
+      MemoryArena::delete_array(val0); MemoryArena::delete_array(val1); val0 = val1 = NULL;
+      MemoryArena::delete_array(dx0);  MemoryArena::delete_array(dx1); dx0 = dx1 = NULL;
+      MemoryArena::delete_array(dy0);  MemoryArena::delete_array(dy1); dy0 = dy1 = NULL;
+      MemoryArena::delete_array(curl); curl = NULL;
+      MemoryArena::delete_array(div); div = NULL;
     }
 
     template<typename T>
@@ -255,8 +255,8 @@ namespace Hermes
     template<typename T>
     void Geom<T>::free()
     {
-      delete [] tx;    delete [] ty;
-      delete [] nx;    delete [] ny;
+      MemoryArena::delete_array(tx);    MemoryArena::delete_array(ty);
+      MemoryArena::delete_array(nx);    MemoryArena::delete_array(ny);
     }
 
     template<typename T>
@@ -274,13 +274,13 @@ namespace Hermes
         fn[i]->free_fn();
         delete fn[i];
       }
-      delete [] fn;
+      MemoryArena::delete_array(fn);
     }
 
     template<typename T>
     void ExtData<T>::free_ord()
     {
-      delete [] fn;
+      MemoryArena::delete_array(fn);
     }
 
     template<typename T>
@@ -386,10 +386,10 @@ namespace Hermes
       double3 *tan;
       tan = rm->get_tangent(surf_pos->surf_num, order);
 
-      e->tx = new double [np];
-      e->ty = new double [np];
-      e->nx = new double [np];
-      e->ny = new double [np];
+      e->tx = MemoryArena::new_array<double>(np);
+      e->ty = MemoryArena::new_array<double>(np);
+      e->nx = MemoryArena::new_array<double>(np);
+      e->ny = MemoryArena::new_array<double>(np);
       for (int i = 0; i < np; i++)
       {
         e->tx[i] = tan[i][0];  e->ty[i] =   tan[i][1];
@@ -413,10 +413,10 @@ namespace Hermes
       e->y = rm->get_phys_y(order);
       tan = rm->get_tangent(surf_num, order);
 
-      e->tx = new double [np];
-      e->ty = new double [np];
-      e->nx = new double [np];
-      e->ny = new double [np];
+      e->tx = MemoryArena::new_array<double>(np);
+      e->ty = MemoryArena::new_array<double>(np);
+      e->nx = MemoryArena::new_array<double>(np);
+      e->ny = MemoryArena::new_array<double>(np);
       for (int i = 0; i < np; i++)
       {
         e->tx[i] = tan[i][0];  e->ty[i] =   tan[i][1];
@@ -462,11 +462,11 @@ namespace Hermes
       // H1 space.
       if (space_type == HERMES_H1_SPACE)
       {
-        u->val = new double [np];
-        u->dx  = new double [np];
-        u->dy  = new double [np];
+        u->val = MemoryArena::new_array<double>(np);
+        u->dx  = MemoryArena::new_array<double>(np);
+        u->dy  = MemoryArena::new_array<double>(np);
 #ifdef H2D_SECOND_DERIVATIVES_ENABLED
-        u->laplace = new double [np];
+        u->laplace = MemoryArena::new_array<double>(np);
 #endif
         double *fn = fu->get_fn_values();
         double *dx = fu->get_dx_values();
@@ -480,7 +480,7 @@ namespace Hermes
         double2x2 *m;
         if(rm->is_jacobian_const())
         {
-          m = new double2x2[np];
+          m = reinterpret_cast<double2x2*>(MemoryArena::new_array<double>(4 * np));
           double2x2 const_inv_ref_map;
 
           const_inv_ref_map[0][0] = rm->get_const_inv_ref_map()[0][0][0];
@@ -526,14 +526,14 @@ namespace Hermes
 
         m -= np;
         if(rm->is_jacobian_const())
-          delete [] m;
+          MemoryArena::delete_array(reinterpret_cast<double*>(m));
       }
       // Hcurl space.
       else if (space_type == HERMES_HCURL_SPACE)
       {
-        u->val0 = new double [np];
-        u->val1 = new double [np];
-        u->curl = new double [np];
+        u->val0 = MemoryArena::new_array<double>(np);
+        u->val1 = MemoryArena::new_array<double>(np);
+        u->curl = MemoryArena::new_array<double>(np);
 
         double *fn0 = fu->get_fn_values(0);
         double *fn1 = fu->get_fn_values(1);
@@ -542,7 +542,7 @@ namespace Hermes
         double2x2 *m;
         if(rm->is_jacobian_const())
         {
-          m = new double2x2[np];
+          m = reinterpret_cast<double2x2*>(MemoryArena::new_array<double>(4 * np));
           double2x2 const_inv_ref_map;
 
           const_inv_ref_map[0][0] = rm->get_const_inv_ref_map()[0][0][0];
@@ -569,13 +569,13 @@ namespace Hermes
 
         m -= np;
         if(rm->is_jacobian_const())
-          delete [] m;
+          MemoryArena::delete_array(reinterpret_cast<double*>(m));
       }
       // Hdiv space.
       else if (space_type == HERMES_HDIV_SPACE)
       {
-        u->val0 = new double [np];
-        u->val1 = new double [np];
+        u->val0 = MemoryArena::new_array<double>(np);
+        u->val1 = MemoryArena::new_array<double>(np);
 
         double *fn0 = fu->get_fn_values(0);
         double *fn1 = fu->get_fn_values(1);
@@ -584,7 +584,7 @@ namespace Hermes
         double2x2 *m;
         if(rm->is_jacobian_const())
         {
-          m = new double2x2[np];
+          m = reinterpret_cast<double2x2*>(MemoryArena::new_array<double>(4 * np));
           double2x2 const_inv_ref_map;
 
           const_inv_ref_map[0][0] = rm->get_const_inv_ref_map()[0][0][0];
@@ -610,16 +610,16 @@ namespace Hermes
         }
         m -= np;
         if(rm->is_jacobian_const())
-          delete [] m;
+          MemoryArena::delete_array(reinterpret_cast<double*>(m));
       }
       // L2 Space.
       else if (space_type == HERMES_L2_SPACE)
       {
         // Same as for H1, except that we currently do not have
         // second derivatives of L2 shape functions for triangles.
-        u->val = new double [np];
-        u->dx  = new double [np];
-        u->dy  = new double [np];
+        u->val = MemoryArena::new_array<double>(np);
+        u->dx  = MemoryArena::new_array<double>(np);
+        u->dy  = MemoryArena::new_array<double>(np);
 
         double *fn = fu->get_fn_values();
         double *dx = fu->get_dx_values();
@@ -628,7 +628,7 @@ namespace Hermes
         double2x2 *m;
         if(rm->is_jacobian_const())
         {
-          m = new double2x2[np];
+          m = reinterpret_cast<double2x2*>(MemoryArena::new_array<double>(4 * np));
           double2x2 const_inv_ref_map;
 
           const_inv_ref_map[0][0] = rm->get_const_inv_ref_map()[0][0][0];
@@ -656,7 +656,7 @@ namespace Hermes
 
         m -= np;
         if(rm->is_jacobian_const())
-          delete [] m;
+          MemoryArena::delete_array(reinterpret_cast<double*>(m));
       }
       else
         error("Wrong space type - space has to be either H1, Hcurl, Hdiv or L2");
@@ -680,19 +680,19 @@ namespace Hermes
 
       if (u->nc == 1)
       {
-        u->val = new Scalar [np];
-        u->dx  = new Scalar [np];
-        u->dy  = new Scalar [np];
+        u->val = MemoryArena::new_array<Scalar>(np);
+        u->dx  = MemoryArena::new_array<Scalar>(np);
+        u->dy  = MemoryArena::new_array<Scalar>(np);
         memcpy(u->val, fu->get_fn_values(), np * sizeof(Scalar));
         memcpy(u->dx, fu->get_dx_values(), np * sizeof(Scalar));
         memcpy(u->dy, fu->get_dy_values(), np * sizeof(Scalar));
       }
       else if (u->nc == 2)
       {
-        u->val0 = new Scalar [np];
-        u->val1 = new Scalar [np];
-        u->curl = new Scalar [np];
-        u->div = new Scalar [np];
+        u->val0 = MemoryArena::new_array<Scalar>(np);
+        u->val1 = MemoryArena::new_array<Scalar>(np);
+        u->curl = MemoryArena::new_array<Scalar>(np);
+        u->div = MemoryArena::new_array<Scalar>(np);
 
         memcpy(u->val0, fu->get_fn_values(0), np * sizeof(Scalar));
         memcpy(u->val1, fu->get_fn_values(1), np * sizeof(Scalar));
@@ -733,12 +733,12 @@ namespace Hermes
 
       if (u->nc == 1)
       {
-        u->val = new Scalar [np];
-        u->dx  = new Scalar [np];
-        u->dy  = new Scalar [np];
+        u->val = MemoryArena::new_array<Scalar>(np);
+        u->dx  = MemoryArena::new_array<Scalar>(np);
+        u->dy  = MemoryArena::new_array<Scalar>(np);
 #ifdef H2D_SECOND_DERIVATIVES_ENABLED
         if (space_type == HERMES_H1_SPACE && sln_type != HERMES_EXACT)
-          u->laplace = new Scalar [np];
+          u->laplace = MemoryArena::new_array<Scalar>(np);
 #endif
         memcpy(u->val, fu->get_fn_values(), np * sizeof(Scalar));
         memcpy(u->dx, fu->get_dx_values(), np * sizeof(Scalar));
@@ -758,10 +758,10 @@ namespace Hermes
       }
       else if (u->nc == 2)
       {
-        u->val0 = new Scalar [np];
-        u->val1 = new Scalar [np];
-        u->curl = new Scalar [np];
-        u->div = new Scalar [np];
+        u->val0 = MemoryArena::new_array<Scalar>(np);
+        u->val1 = MemoryArena::new_array<Scalar>(np);
+        u->curl = MemoryArena::new_array<Scalar>(np);
+        u->div = MemoryArena::new_array<Scalar>(np);
 
         memcpy(u->val0, fu->get_fn_values(0), np * sizeof(Scalar));
         memcpy(u->val1, fu->get_fn_values(1), np * sizeof(Scalar));
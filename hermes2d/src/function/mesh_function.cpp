@@ -82,6 +82,12 @@ namespace Hermes
       return refmap;
     }
 
+    template<typename Scalar>
+    void MeshFunction<Scalar>::set_refmap_shapes(RefMapShapes* shapes)
+    {
+      refmap->set_shapes(shapes);
+    }
+
     template<typename Scalar>
     void MeshFunction<Scalar>::set_quad_2d(Quad2D* quad_2d)
     {
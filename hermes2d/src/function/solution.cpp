@@ -979,8 +979,27 @@ namespace Hermes
           y[i] = pt[i][1] * this->ctm->m[1] + this->ctm->t[1];
         }
 
-        // obtain the solution values, this is the core of the whole module
+        // On quads with tensor-product points, the polynomials in x are evaluated only at the
+        // distinct x-coordinates of the points (sum factorization), tx_1d[i * np_1d + m] holds
+        // the i-th one at the m-th coordinate.
         int o = elem_orders[this->element->id];
+        int np_1d = quad->get_tensor_num_points(order);
+        Scalar* tx_1d = NULL;
+        Scalar* x_1d = NULL;
+        Scalar* y_1d = NULL;
+        if (np_1d > 0)
+        {
+          tx_1d = new Scalar[(o + 1) * np_1d];
+          x_1d = new Scalar[2 * np_1d];
+          y_1d = x_1d + np_1d;
+          for (i = 0; i < np_1d; i++)
+          {
+            x_1d[i] = x[i * np_1d];
+            y_1d[i] = y[i];
+          }
+        }
+
+        // obtain the solution values, this is the core of the whole module
         for (l = 0; l < this->num_components; l++)
         {
           for (k = 0; k < 6; k++)
@@ -993,6 +1012,26 @@ namespace Hermes
                 // copy the old table if we have it already
                 memcpy(result, this->cur_node->values[l][k], np * sizeof(Scalar));
               }
+              else if (tx_1d != NULL)
+              {
+                // Horner's scheme as below, in the same order of operations
+                Scalar* mono = dxdy_coeffs[l][k];
+                for (i = 0; i <= o; i++)
+                {
+                  Scalar* t = tx_1d + i * np_1d;
+                  set_vec_num(np_1d, t, *mono++);
+                  for (j = 1; j <= o; j++)
+                    vec_x_vec_p_num(np_1d, t, x_1d, *mono++);
+                }
+                for (int m = 0, n = 0; m < np_1d; m++)
+                  for (int p = 0; p < np_1d; p++, n++)
+                  {
+                    Scalar value = tx_1d[m];
+                    for (i = 1; i <= o; i++)
+                      value = value * y_1d[p] + tx_1d[i * np_1d + m];
+                    result[n] = value;
+                  }
+              }
               else
               {
                 // calculate the solution values using Horner's scheme
@@ -1014,6 +1053,11 @@ namespace Hermes
         delete [] x;
         delete [] y;
         delete [] tx;
+        if (tx_1d != NULL)
+        {
+          delete [] tx_1d;
+          delete [] x_1d;
+        }
 
         // transform gradient or vector solution, if required
         if (transform)
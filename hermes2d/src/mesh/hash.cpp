@@ -24,6 +24,8 @@ namespace Hermes
     HashTable::HashTable()
     {
       v_table = NULL; e_table = NULL;
+      v_mask = e_mask = -1;
+      v_count = e_count = 0;
       nqueries = ncollisions = 0;
     }
 
@@ -32,33 +34,26 @@ namespace Hermes
       free(); 
     }
 
+    HashTable::HashEntry* HashTable::alloc_table(int size)
+    {
+      HashEntry* table = new HashEntry[size];
+      for (int i = 0; i < size; i++)
+        table[i].id = -1;
+      return table;
+    }
+
     void HashTable::init(int size)
     {
       v_table = e_table = NULL;
       nqueries = ncollisions = 0;
 
-      mask = size-1;
-      if (size & mask) error("Parameter 'size' must be a power of two.");
+      if (size & (size - 1)) error("Parameter 'size' must be a power of two.");
+      v_mask = e_mask = size - 1;
+      v_count = e_count = 0;
 
       // allocate and initialize the hash tables
-      v_table = new Node*[size];
-      e_table = new Node*[size];
-
-      memset(v_table, 0, size * sizeof(Node*));
-      memset(e_table, 0, size * sizeof(Node*));
-
-      nqueries = ncollisions = 0;
-    }
-
-    void HashTable::copy_list(Node** ptr, Node* node)
-    {
-      while (node != NULL)
-      {
-        *ptr = &nodes[node->id];
-        ptr = &((*ptr)->next_hash);
-        node = node->next_hash;
-      }
-      *ptr = NULL;
+      v_table = alloc_table(size);
+      e_table = alloc_table(size);
     }
 
     Node* HashTable::get_node(int id) const 
@@ -82,44 +77,45 @@ namespace Hermes
     {
       free();
       nodes.copy(ht->nodes);
-      mask = ht->mask;
-
-      v_table = new Node*[mask + 1];
-      e_table = new Node*[mask + 1];
-      for (int i = 0; i <= mask; i++)
-      {
-        copy_list(v_table + i, ht->v_table[i]);
-        copy_list(e_table + i, ht->e_table[i]);
-      }
+      v_mask = ht->v_mask;
+      e_mask = ht->e_mask;
+      v_count = ht->v_count;
+      e_count = ht->e_count;
+
+      v_table = new HashEntry[v_mask + 1];
+      e_table = new HashEntry[e_mask + 1];
+      memcpy(v_table, ht->v_table, (v_mask + 1) * sizeof(HashEntry));
+      memcpy(e_table, ht->e_table, (e_mask + 1) * sizeof(HashEntry));
     }
 
     void HashTable::rebuild()
     {
-      memset(v_table, 0, (mask + 1) * sizeof(Node*));
-      memset(e_table, 0, (mask + 1) * sizeof(Node*));
+      for (int i = 0; i <= v_mask; i++)
+        v_table[i].id = -1;
+      for (int i = 0; i <= e_mask; i++)
+        e_table[i].id = -1;
+      v_count = e_count = 0;
 
       Node* node;
       for_all_nodes(node, this)
       {
         int p1 = node->p1, p2 = node->p2;
         if (p1 > p2) std::swap(p1, p2);
-        int idx = hash(p1, p2);
 
         if (node->type == HERMES_TYPE_VERTEX)
         {
-          node->next_hash = v_table[idx];
-          v_table[idx] = node;
+          // top-level vertex nodes have no parents
+          if (p1 < 0) continue;
+          insert_node(v_table, v_mask, v_count, search_table(v_table, v_mask, p1, p2), node);
         }
         else
-        {
-          node->next_hash = e_table[idx];
-          e_table[idx] = node;
-        }
+          insert_node(e_table, e_mask, e_count, search_table(e_table, e_mask, p1, p2), node);
       }
     }
 
     void HashTable::free()
     {
+      dump_hash_stat();
       nodes.free();
       if (v_table != NULL)
       {
@@ -131,38 +127,142 @@ namespace Hermes
         delete [] e_table;
         e_table = NULL;
       }
-      dump_hash_stat();
+      v_count = e_count = 0;
+      nqueries = ncollisions = 0;
     }
 
     void HashTable::dump_hash_stat()
     {
+      if (v_table == NULL || e_table == NULL)
+        return;
+      double v_load = v_count / (double) (v_mask + 1), e_load = e_count / (double) (e_mask + 1);
+      verbose("Hashtable: load factors %g (vertex nodes), %g (edge nodes), nqueries = %d ncollisions = %d",
+        v_load, e_load, nqueries, ncollisions);
       if (ncollisions > 2*nqueries)
       {
-        warn("Hashtable: nqueries = %d ncollisions = %d", nqueries, ncollisions);
+        warn("Hashtable: load factors %g (vertex nodes), %g (edge nodes), nqueries = %d ncollisions = %d",
+          v_load, e_load, nqueries, ncollisions);
       }
     }
 
-    inline Node* HashTable::search_list(Node* node, int p1, int p2)
+    inline int HashTable::search_table(HashEntry* table, int mask, int p1, int p2)
     {
       nqueries++;
-      while (node != NULL)
+      int pos = hash(p1, p2, mask);
+      while (table[pos].id >= 0)
       {
-        if (node->p1 == p1 && node->p2 == p2) return node;
-        node = node->next_hash;
+        if (table[pos].p1 == p1 && table[pos].p2 == p2) return pos;
+        pos = (pos + 1) & mask;
         ncollisions++;
       }
-      return NULL;
+      return pos;
+    }
+
+    void HashTable::insert_node(HashEntry*& table, int& mask, int& count, int pos, Node* node)
+    {
+      table[pos].p1 = std::min(node->p1, node->p2);
+      table[pos].p2 = std::max(node->p1, node->p2);
+      table[pos].id = node->id;
+
+      // the table is more than half full - double it
+      if (2 * ++count > mask + 1)
+        resize_table(table, mask, 2 * (mask + 1));
+    }
+
+    void HashTable::resize_table(HashEntry*& table, int& mask, int size)
+    {
+      HashEntry* old_table = table;
+      int old_size = mask + 1;
+      mask = size - 1;
+      table = alloc_table(size);
+      for (int i = 0; i < old_size; i++)
+        if (old_table[i].id >= 0)
+        {
+          int j = hash(old_table[i].p1, old_table[i].p2, mask);
+          while (table[j].id >= 0)
+            j = (j + 1) & mask;
+          table[j] = old_table[i];
+        }
+      delete [] old_table;
+    }
+
+    void HashTable::reserve(int num_new_vertex_nodes, int num_new_edge_nodes)
+    {
+      int v_size = v_mask + 1, e_size = e_mask + 1;
+      while (2 * (v_count + num_new_vertex_nodes) > v_size)
+        v_size *= 2;
+      while (2 * (e_count + num_new_edge_nodes) > e_size)
+        e_size *= 2;
+      if (v_size > v_mask + 1)
+        resize_table(v_table, v_mask, v_size);
+      if (e_size > e_mask + 1)
+        resize_table(e_table, e_mask, e_size);
+    }
+
+    void HashTable::remove_node(HashEntry* table, int mask, int& count, Node* node)
+    {
+      int i = hash(std::min(node->p1, node->p2), std::max(node->p1, node->p2), mask);
+      while (table[i].id != node->id)
+      {
+        if (table[i].id < 0) return;
+        i = (i + 1) & mask;
+      }
+      count--;
+
+      // shift back the entries of the cluster which would not be found after the hole
+      int j = i;
+      while (true)
+      {
+        j = (j + 1) & mask;
+        if (table[j].id < 0) break;
+        int k = hash(table[j].p1, table[j].p2, mask);
+        if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        table[i] = table[j];
+        i = j;
+      }
+      table[i].id = -1;
     }
 
     Node* HashTable::get_vertex_node(int p1, int p2)
     {
       // search for the node in the vertex hashtable
       if (p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(v_table[i], p1, p2);
-      if (node != NULL) return node;
+      int i = search_table(v_table, v_mask, p1, p2);
+      if (v_table[i].id >= 0) return &nodes[v_table[i].id];
+
+      // not found - create a new one
+      return create_vertex_node(p1, p2, i);
+    }
+
+    Node* HashTable::get_edge_node(int p1, int p2)
+    {
+      // search for the node in the edge hashtable
+      if (p1 > p2) std::swap(p1, p2);
+      int i = search_table(e_table, e_mask, p1, p2);
+      if (e_table[i].id >= 0) return &nodes[e_table[i].id];
 
       // not found - create a new one
+      return create_edge_node(p1, p2, i);
+    }
+
+    Node* HashTable::add_vertex_node(int p1, int p2)
+    {
+      if (p1 > p2) std::swap(p1, p2);
+      int i = search_table(v_table, v_mask, p1, p2);
+      assert(v_table[i].id < 0);
+      return create_vertex_node(p1, p2, i);
+    }
+
+    Node* HashTable::add_edge_node(int p1, int p2)
+    {
+      if (p1 > p2) std::swap(p1, p2);
+      int i = search_table(e_table, e_mask, p1, p2);
+      assert(e_table[i].id < 0);
+      return create_edge_node(p1, p2, i);
+    }
+
+    Node* HashTable::create_vertex_node(int p1, int p2, int pos)
+    {
       Node* newnode = nodes.add();
 
       // initialize the new Node
@@ -176,21 +276,13 @@ namespace Hermes
       newnode->y = (nodes[p1].y + nodes[p2].y) * 0.5;
 
       // insert into hashtable
-      newnode->next_hash = v_table[i];
-      v_table[i] = newnode;
+      insert_node(v_table, v_mask, v_count, pos, newnode);
 
       return newnode;
     }
 
-    Node* HashTable::get_edge_node(int p1, int p2)
+    Node* HashTable::create_edge_node(int p1, int p2, int pos)
     {
-      // search for the node in the edge hashtable
-      if (p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(e_table[i], p1, p2);
-      if (node != NULL) return node;
-
-      // not found - create a new one
       Node* newnode = nodes.add();
 
       // initialize the new node
@@ -203,8 +295,7 @@ namespace Hermes
       newnode->elem[0] = newnode->elem[1] = NULL;
 
       // insert into hashtable
-      newnode->next_hash = e_table[i];
-      e_table[i] = newnode;
+      insert_node(e_table, e_mask, e_count, pos, newnode);
 
       return newnode;
     }
@@ -212,31 +303,21 @@ namespace Hermes
     Node* HashTable::peek_vertex_node(int p1, int p2)
     {
       if (p1 > p2) std::swap(p1, p2);
-      return search_list(v_table[hash(p1, p2)], p1, p2);
+      int i = search_table(v_table, v_mask, p1, p2);
+      return (v_table[i].id >= 0) ? &nodes[v_table[i].id] : NULL;
     }
 
     Node* HashTable::peek_edge_node(int p1, int p2)
     {
       if (p1 > p2) std::swap(p1, p2);
-      return search_list(e_table[hash(p1, p2)], p1, p2);
+      int i = search_table(e_table, e_mask, p1, p2);
+      return (e_table[i].id >= 0) ? &nodes[e_table[i].id] : NULL;
     }
 
     void HashTable::remove_vertex_node(int id)
     {
       // remove the node from the hash table
-      int i = hash(nodes[id].p1, nodes[id].p2);
-      Node** ptr = v_table + i;
-      Node* node = *ptr;
-      while (node != NULL)
-      {
-        if (node->id == id)
-        {
-          *ptr = node->next_hash;
-          break;
-        }
-        ptr = &node->next_hash;
-        node = *ptr;
-      }
+      remove_node(v_table, v_mask, v_count, &nodes[id]);
 
       // remove node from the array
       nodes.remove(id);
@@ -245,19 +326,7 @@ namespace Hermes
     void HashTable::remove_edge_node(int id)
     {
       // remove the node from the hash table
-      int i = hash(nodes[id].p1, nodes[id].p2);
-      Node** ptr = e_table + i;
-      Node* node = *ptr;
-      while (node != NULL)
-      {
-        if (node->id == id)
-        {
-          *ptr = node->next_hash;
-          break;
-        }
-        ptr = &node->next_hash;
-        node = *ptr;
-      }
+      remove_node(e_table, e_mask, e_count, &nodes[id]);
 
       // remove node from the array
       nodes.remove(id);
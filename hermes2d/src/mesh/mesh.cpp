@@ -218,7 +218,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = NULL;
         node->x = verts[i][0];
         node->y = verts[i][1];
       }
@@ -780,13 +779,215 @@ namespace Hermes
     {
       Element* e;
       elements.set_append_only(true);
-      for_all_active_elements(e, this)
-        refine_element_id(e->id, refinement);
+      if (!refine_all_elements_bulk(refinement))
+        for_all_active_elements(e, this)
+          refine_element_id(e->id, refinement);
       elements.set_append_only(false);
       if(mark_as_initial)
         ninitial = this->get_max_element_id();
     }
 
+    bool Mesh::refine_all_elements_bulk(int refinement)
+    {
+      if (refinement != 0)
+        return false;
+
+      // the active elements, in the order in which they are refined one by one
+      std::vector<Element*> active;
+      Element* e;
+      for_all_active_elements(e, this)
+        active.push_back(e);
+      int n = (int) active.size();
+
+      // first pass: find the neighbors across the edges (before their edge nodes are released)
+      // and count the new nodes; an element creates the mid-edge vertex node and the halves
+      // of an edge if it is refined before its neighbor
+      std::vector<Element*> neighbors(4 * n, (Element*) NULL);
+      std::vector<int> neighbor_edges(4 * n, -1);
+      int conforming = 1, new_vertices = 0, new_edges = 0, released_edges = 0;
+#pragma omp parallel for reduction(&:conforming) reduction(+:new_vertices,new_edges,released_edges)
+      for (int k = 0; k < n; k++)
+      {
+        Element* e = active[k];
+        int nvert = e->get_nvert();
+        if (e->cm != NULL)
+          conforming = 0;
+
+        // the mid-element vertex node of quads, the inner edges
+        new_vertices += (nvert == 4) ? 1 : 0;
+        new_edges += nvert;
+        for (int i = 0; i < nvert; i++)
+        {
+          Node* en = e->en[i];
+          Element* nb = (en->elem[0] == e) ? en->elem[1] : en->elem[0];
+          if (nb == NULL)
+          {
+            // an edge without neighbor must lie on the boundary (not be hanging)
+            if (!en->bnd)
+              conforming = 0;
+          }
+          else
+            for (int j = 0; j < (int) nb->get_nvert(); j++)
+              if (nb->en[j] == en)
+                neighbor_edges[4 * k + i] = j;
+          neighbors[4 * k + i] = nb;
+
+          // the vertex nodes must not be released when the element is unregistered
+          if (e->vn[i]->ref < 2)
+            conforming = 0;
+
+          if (nb == NULL || nb->id > e->id)
+          {
+            new_vertices++;
+            new_edges += 2;
+          }
+          if (nb == NULL || nb->id < e->id)
+            released_edges++;
+        }
+      }
+      if (!conforming)
+        return false;
+
+      // second pass: create the nodes and elements in the order of the serial refinement
+      int unused_nodes = nodes.get_size() - nodes.get_num_items();
+      nodes.reserve(nodes.get_size() + std::max(new_vertices + new_edges - released_edges - unused_nodes, 0));
+      elements.reserve(elements.get_size() + 4 * n);
+      HashTable::reserve(new_vertices, new_edges - released_edges);
+      for (int k = 0; k < n; k++)
+        refine_element_bulk(active[k], &neighbors[4 * k], &neighbor_edges[4 * k]);
+
+      this->seq = g_mesh_seq++;
+      return true;
+    }
+
+    void Mesh::refine_element_bulk(Element* e, Element** nb, int* nb_edge)
+    {
+      this->refinements.push_back(std::pair<unsigned int, int>(e->id, 0));
+      int i, j, s1, s2;
+      int nvert = e->get_nvert();
+
+      // remember the markers of the edge nodes, take the mid-edge vertex nodes and
+      // the halves of the edges from the neighbors refined already
+      int bnd[4], mrk[4];
+      Node* x[4], *half[4][2];
+      for (i = 0; i < nvert; i++)
+      {
+        bnd[i] = e->en[i]->bnd;
+        mrk[i] = e->en[i]->marker;
+        x[i] = half[i][0] = half[i][1] = NULL;
+        if (nb[i] != NULL && nb[i]->id < e->id)
+        {
+          j = nb_edge[i];
+          get_edge_sons(nb[i], j, s1, s2);
+          x[i] = nb[i]->sons[s1]->vn[nb[i]->next_vert(j)];
+          bool same = (nb[i]->vn[j] == e->vn[i]);
+          half[i][0] = same ? nb[i]->sons[s1]->en[j] : nb[i]->sons[s2]->en[j];
+          half[i][1] = same ? nb[i]->sons[s2]->en[j] : nb[i]->sons[s1]->en[j];
+        }
+      }
+
+      Element* sons[4];
+      if (nvert == 4)
+      {
+        // the same steps as refine_quad()
+        e->active = false;
+        nactive--;
+        e->unref_all_nodes(this);
+
+        for (i = 0; i < 4; i++)
+          if (x[i] == NULL)
+            x[i] = add_vertex_node(e->vn[i]->id, e->vn[e->next_vert(i)]->id);
+        Node* mid = add_vertex_node(x[0]->id, x[2]->id);
+
+        Node* vn0[4] = { e->vn[0], x[0], mid, x[3] };
+        Node* en0[4] = { half[0][0], NULL, NULL, half[3][1] };
+        sons[0] = create_element_bulk(e->marker, 4, vn0, en0);
+        Node* vn1[4] = { x[0], e->vn[1], x[1], mid };
+        Node* en1[4] = { half[0][1], half[1][0], NULL, sons[0]->en[1] };
+        sons[1] = create_element_bulk(e->marker, 4, vn1, en1);
+        Node* vn2[4] = { mid, x[1], e->vn[2], x[2] };
+        Node* en2[4] = { sons[1]->en[2], half[1][1], half[2][0], NULL };
+        sons[2] = create_element_bulk(e->marker, 4, vn2, en2);
+        Node* vn3[4] = { x[3], mid, x[2], e->vn[3] };
+        Node* en3[4] = { sons[0]->en[2], sons[2]->en[3], half[2][1], half[3][0] };
+        sons[3] = create_element_bulk(e->marker, 4, vn3, en3);
+        this->nactive += 4;
+
+        for (i = 0; i < 4; i++)
+        {
+          j = (i > 0) ? i-1 : 3;
+          sons[i]->en[j]->bnd = bnd[j];  sons[i]->en[j]->marker = mrk[j];
+          sons[i]->en[i]->bnd = bnd[i];  sons[i]->en[i]->marker = mrk[i];
+          sons[i]->vn[j]->bnd = bnd[j];
+        }
+
+        if (e->iro_cache == 0)
+          for (i = 0; i < 4; i++)
+            sons[i]->iro_cache = 0;
+      }
+      else
+      {
+        // the same steps as refine_triangle_to_triangles()
+        for (i = 0; i < 3; i++)
+          if (x[i] == NULL)
+            x[i] = add_vertex_node(e->vn[i]->id, e->vn[e->next_vert(i)]->id);
+
+        Node* vn0[3] = { e->vn[0], x[0], x[2] };
+        Node* en0[3] = { half[0][0], NULL, half[2][1] };
+        sons[0] = create_element_bulk(e->marker, 3, vn0, en0);
+        Node* vn1[3] = { x[0], e->vn[1], x[1] };
+        Node* en1[3] = { half[0][1], half[1][0], NULL };
+        sons[1] = create_element_bulk(e->marker, 3, vn1, en1);
+        Node* vn2[3] = { x[2], x[1], e->vn[2] };
+        Node* en2[3] = { NULL, half[1][1], half[2][0] };
+        sons[2] = create_element_bulk(e->marker, 3, vn2, en2);
+        Node* vn3[3] = { x[1], x[2], x[0] };
+        Node* en3[3] = { sons[2]->en[0], sons[0]->en[1], sons[1]->en[2] };
+        sons[3] = create_element_bulk(e->marker, 3, vn3, en3);
+
+        e->active = 0;
+        this->nactive += 3;
+        e->unref_all_nodes(this);
+
+        sons[0]->en[0]->bnd = bnd[0];  sons[0]->en[0]->marker = mrk[0];
+        sons[0]->en[2]->bnd = bnd[2];  sons[0]->en[2]->marker = mrk[2];
+        sons[1]->en[0]->bnd = bnd[0];  sons[1]->en[0]->marker = mrk[0];
+        sons[1]->en[1]->bnd = bnd[1];  sons[1]->en[1]->marker = mrk[1];
+        sons[2]->en[1]->bnd = bnd[1];  sons[2]->en[1]->marker = mrk[1];
+        sons[2]->en[2]->bnd = bnd[2];  sons[2]->en[2]->marker = mrk[2];
+        sons[3]->vn[0]->bnd = bnd[1];
+        sons[3]->vn[1]->bnd = bnd[2];
+        sons[3]->vn[2]->bnd = bnd[0];
+      }
+
+      for (i = 0; i < 4; i++)
+        sons[i]->parent = e;
+      memcpy(e->sons, sons, sizeof(sons));
+    }
+
+    Element* Mesh::create_element_bulk(int marker, int nvert, Node** vn, Node** en)
+    {
+      Element* e = elements.add();
+      e->active = 1;
+      e->marker = marker;
+      e->nvert = nvert;
+      e->iro_cache = -1;
+      e->cm = NULL;
+      e->parent = NULL;
+      e->visited = false;
+
+      for (int i = 0; i < nvert; i++)
+      {
+        e->vn[i] = vn[i];
+        e->en[i] = (en[i] != NULL) ? en[i] : add_edge_node(vn[i]->id, vn[(i + 1) % nvert]->id);
+      }
+
+      // register in the nodes
+      e->ref_all_nodes();
+
+      return e;
+    }
+
     static int rtb_marker;
     static bool rtb_aniso;
     static char* rtb_vert;
@@ -1161,6 +1362,113 @@ namespace Hermes
       element_markers_conversion = mesh->element_markers_conversion;
     }
 
+    /// Index of the point (x, y) of the grid [0, n)^2 (n is a power of two) along the Hilbert curve.
+    static unsigned int hilbert_index(unsigned int n, unsigned int x, unsigned int y)
+    {
+      unsigned int d = 0;
+      for (unsigned int s = n / 2; s > 0; s /= 2)
+      {
+        unsigned int rx = (x & s) > 0;
+        unsigned int ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant.
+        if (ry == 0)
+        {
+          if (rx == 1)
+          {
+            x = n - 1 - x;
+            y = n - 1 - y;
+          }
+          std::swap(x, y);
+        }
+      }
+      return d;
+    }
+
+    void Mesh::reorder_elements()
+    {
+      _F_;
+      reorder_elements(ninitial);
+    }
+
+    void Mesh::reorder_elements(int num_initial)
+    {
+      _F_;
+      const unsigned int n = 1 << 16;
+      int max_id = get_max_element_id();
+
+      // Bounding box of the mesh.
+      double x_min = 0.0, x_max = 0.0, y_min = 0.0, y_max = 0.0;
+      bool first = true;
+      Node* node;
+      for_all_vertex_nodes(node, this)
+      {
+        x_min = first ? node->x : std::min(x_min, node->x);
+        x_max = first ? node->x : std::max(x_max, node->x);
+        y_min = first ? node->y : std::min(y_min, node->y);
+        y_max = first ? node->y : std::max(y_max, node->y);
+        first = false;
+      }
+      double scale = (n - 1) / std::max(std::max(x_max - x_min, y_max - y_min), 1e-300);
+
+      // Sort the base elements, the initial refinements and the rest by the indices of their centroids.
+      std::vector<std::pair<unsigned int, int> > keys[3];
+      std::vector<int> ids[3];
+      Element* e;
+      for_all_elements(e, this)
+      {
+        double x = 0.0, y = 0.0;
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+        {
+          x += e->vn[i]->x;
+          y += e->vn[i]->y;
+        }
+        x = (x / e->get_nvert() - x_min) * scale;
+        y = (y / e->get_nvert() - y_min) * scale;
+        int c = (e->id < nbase) ? 0 : (e->id < num_initial) ? 1 : 2;
+        keys[c].push_back(std::pair<unsigned int, int>(hilbert_index(n, (unsigned int) x, (unsigned int) y), e->id));
+        ids[c].push_back(e->id);
+      }
+      std::vector<int> new_id(max_id, -1);
+      for (int c = 0; c < 3; c++)
+      {
+        std::sort(keys[c].begin(), keys[c].end());
+        for (unsigned int i = 0; i < keys[c].size(); i++)
+          new_id[keys[c][i].second] = ids[c][i];
+      }
+
+      // Redirect the pointers to the new positions of the elements, then move the elements.
+      std::vector<Element> moved(max_id);
+      for_all_elements(e, this)
+      {
+        if (!e->active)
+          for (int i = 0; i < 4; i++)
+            if (e->sons[i] != NULL)
+              e->sons[i] = &elements[new_id[e->sons[i]->id]];
+        if (e->parent != NULL)
+          e->parent = &elements[new_id[e->parent->id]];
+        if (e->cm != NULL && !e->cm->toplevel)
+          e->cm->parent = &elements[new_id[e->cm->parent->id]];
+      }
+      for_all_edge_nodes(node, this)
+        for (int i = 0; i < 2; i++)
+          if (node->elem[i] != NULL)
+            node->elem[i] = &elements[new_id[node->elem[i]->id]];
+      for_all_elements(e, this)
+        moved[new_id[e->id]] = *e;
+      for (int id = 0; id < max_id; id++)
+        if (new_id[id] >= 0)
+        {
+          elements[new_id[id]] = moved[new_id[id]];
+          elements[new_id[id]].id = new_id[id];
+        }
+
+      // Recorded so that a saved mesh is loaded with the same ids (the number of the initial elements
+      // of the loaded mesh may differ).
+      this->refinements.push_back(std::pair<unsigned int, int>(num_initial, -2));
+      seq = g_mesh_seq++;
+    }
+
     Node* Mesh::get_base_edge_node(Element* base, int edge)
     {
       while (!base->active) // we need to go down to an active element
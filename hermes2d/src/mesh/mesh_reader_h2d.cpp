@@ -190,7 +190,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = NULL;
         node->x = m.x_vertex[i];
         node->y = m.y_vertex[i];
       }
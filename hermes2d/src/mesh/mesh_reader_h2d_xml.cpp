@@ -54,6 +54,8 @@ namespace Hermes
             int refinement_type = parsed_xml_mesh->refinements()->refinement().at(i).refinement_type();
             if(refinement_type == -1)
               mesh->unrefine_element_id(element_id);
+            else if(refinement_type == -2)
+              mesh->reorder_elements(element_id);
             else
               mesh->refine_element_id(element_id, refinement_type);
           }
@@ -92,6 +94,8 @@ namespace Hermes
             int refinement_type = parsed_xml_mesh->refinements()->refinement().at(i).refinement_type();
             if(refinement_type == -1)
               mesh->unrefine_element_id(element_id);
+            else if(refinement_type == -2)
+              mesh->reorder_elements(element_id);
             else
               mesh->refine_element_id(element_id, refinement_type);
           }
@@ -317,7 +321,6 @@ namespace Hermes
               node->type = HERMES_TYPE_VERTEX;
               node->bnd = 0;
               node->p1 = node->p2 = -1;
-              node->next_hash = NULL;
 
               // variables matching.
               std::string x = parsed_xml_domain->vertices().vertex().at(vertex_number).x();
@@ -572,6 +575,8 @@ namespace Hermes
                 int refinement_type = parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->refinement().at(i).refinement_type();
                 if(refinement_type == -1)
                   meshes[subdomains_i]->unrefine_element_id(element_id);
+                else if(refinement_type == -2)
+                  meshes[subdomains_i]->reorder_elements(element_id);
                 else
                   meshes[subdomains_i]->refine_element_id(element_id, refinement_type);
               }
@@ -781,7 +786,6 @@ namespace Hermes
           node->type = HERMES_TYPE_VERTEX;
           node->bnd = 0;
           node->p1 = node->p2 = -1;
-          node->next_hash = NULL;
 
           // variables matching.
           std::string x = parsed_xml_mesh->vertices().vertex().at(vertex_i).x();
@@ -1027,7 +1031,6 @@ namespace Hermes
           node->type = HERMES_TYPE_VERTEX;
           node->bnd = 0;
           node->p1 = node->p2 = -1;
-          node->next_hash = NULL;
 
           // variables matching.
           std::string x = parsed_xml_domain->vertices().vertex().at(vertex_i).x();
@@ -22,8 +22,8 @@ namespace Hermes
 {
   namespace Hermes2D
   {
-    H1Shapeset ref_map_shapeset;
-    PrecalcShapeset ref_map_pss(&ref_map_shapeset);
+    /// The shapesets of the reference maps without their own ones.
+    static RefMapShapes ref_map_shapes;
 
     RefMap::RefMap()
     {
@@ -31,11 +31,26 @@ namespace Hermes
       num_tables = 0;
       cur_node = NULL;
       overflow = NULL;
+      shapes = NULL;
       set_quad_2d(&g_quad_2d_std); // default quadrature
     }
 
     RefMap::~RefMap() { free(); }
 
+    void RefMap::set_shapes(RefMapShapes* shapes)
+    {
+      free();
+      element = NULL;
+      cur_node = NULL;
+      this->shapes = shapes;
+      get_shapes()->pss.set_quad_2d(quad_2d);
+    }
+
+    RefMapShapes* RefMap::get_shapes()
+    {
+      return shapes != NULL ? shapes : &ref_map_shapes;
+    }
+
     /// Sets the quadrature points in which the reference map will be evaluated.
     /// \param quad_2d [in] The quadrature points.
     void set_quad_2d(Quad2D* quad_2d);
@@ -147,6 +162,7 @@ namespace Hermes
 
     void RefMap::set_quad_2d(Quad2D* quad_2d)
     {
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       free();
       this->quad_2d = quad_2d;
       ref_map_pss.set_quad_2d(quad_2d);
@@ -154,6 +170,8 @@ namespace Hermes
 
     void RefMap::set_active_element(Element* e)
     {
+      H1Shapeset& ref_map_shapeset = get_shapes()->shapeset;
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       if (e != element) free();
 
       ref_map_pss.set_active_element(e);
@@ -228,6 +246,7 @@ namespace Hermes
 
     void RefMap::calc_inv_ref_map(int order)
     {
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       assert(quad_2d != NULL);
       int i, j, np = quad_2d->get_num_points(order);
 
@@ -276,6 +295,7 @@ namespace Hermes
 
     void RefMap::calc_second_ref_map(int order)
     {
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       assert(quad_2d != NULL);
       int i, j, np = quad_2d->get_num_points(order);
 
@@ -361,6 +381,7 @@ namespace Hermes
 
     void RefMap::calc_phys_x(int order)
     {
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       // transform all x coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order);
       double* x = cur_node->phys_x[order] = new double[np];
@@ -378,6 +399,7 @@ namespace Hermes
 
     void RefMap::calc_phys_y(int order)
     {
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       // transform all y coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order);
       double* y = cur_node->phys_y[order] = new double[np];
@@ -395,6 +417,8 @@ namespace Hermes
 
     void RefMap::calc_tangent(int edge, int eo)
     {
+      H1Shapeset& ref_map_shapeset = get_shapes()->shapeset;
+      PrecalcShapeset& ref_map_pss = get_shapes()->pss;
       int i, j;
       int np = quad_2d->get_num_points(eo);
       double3* tan = cur_node->tan[edge] = new double3[np];
@@ -503,6 +527,7 @@ namespace Hermes
 
     void RefMap::inv_ref_map_at_point(double xi1, double xi2, double& x, double& y, double2x2& m)
     {
+      H1Shapeset& ref_map_shapeset = get_shapes()->shapeset;
       double2x2 tmp;
       memset(tmp, 0, sizeof(double2x2));
       x = y = 0;
@@ -530,6 +555,7 @@ namespace Hermes
 
     void RefMap::second_ref_map_at_point(double xi1, double xi2, double& x, double& y, double3x2& mm)
     {
+      H1Shapeset& ref_map_shapeset = get_shapes()->shapeset;
       double3x2 k;
       memset(k, 0, sizeof(double3x2));
       x = y = 0;
@@ -783,5 +783,156 @@ namespace Hermes
 
       return unidata;
     }
+
+
+    //// traversal plan ////////////////////////////////////////////////////////////////////////////////
+
+    /// Transformable which only records the transformations of the traversal.
+    class PlanTransformable : public Transformable
+    {
+    public:
+      PlanTransformable() {}
+    };
+
+    TraversePlan::TraversePlan() : num(0)
+    {
+    }
+
+    bool TraversePlan::is_recorded_for(int n, Mesh** meshes) const
+    {
+      if (n != num)
+        return false;
+      for (int i = 0; i < n; i++)
+        if (meshes[i] != this->meshes[i])
+          return false;
+      return true;
+    }
+
+    bool TraversePlan::is_valid(int n, Mesh** meshes) const
+    {
+      if (!is_recorded_for(n, meshes))
+        return false;
+      for (int i = 0; i < n; i++)
+        if (meshes[i]->get_seq() != seqs[i])
+          return false;
+
+      // Mesh::copy() keeps the seq number, but the elements of a mesh copied again
+      // into the same instance may be stored elsewhere.
+      for (unsigned int k = 0; k < elements.size(); k++)
+        if (elements[k] != NULL && elements[k] != get_element(k % num, element_ids[k]))
+          return false;
+      for (unsigned int k = 0; k < bases.size(); k++)
+        if (bases[k] != get_element(base_meshes[k], base_ids[k]))
+          return false;
+      return true;
+    }
+
+    Element* TraversePlan::get_element(int mesh, int id) const
+    {
+      if (id >= meshes[mesh]->get_max_element_id())
+        return NULL;
+      return meshes[mesh]->get_element_fast(id);
+    }
+
+    void TraversePlan::free()
+    {
+      num = 0;
+      meshes.clear();
+      seqs.clear();
+      elements.clear();
+      element_ids.clear();
+      sub_idx.clear();
+      bases.clear();
+      base_meshes.clear();
+      base_ids.clear();
+      bnd_flags.clear();
+      bnd_pos.clear();
+      lo_hi.clear();
+    }
+
+    bool TraversePlan::update(int n, Mesh** meshes)
+    {
+      if (is_valid(n, meshes))
+        return false;
+
+      free();
+      num = n;
+      for (int i = 0; i < n; i++)
+      {
+        this->meshes.push_back(meshes[i]);
+        seqs.push_back(meshes[i]->get_seq());
+      }
+
+      PlanTransformable* trfs = new PlanTransformable[n];
+      Transformable** fns = new Transformable*[n];
+      for (int i = 0; i < n; i++)
+        fns[i] = trfs + i;
+
+      Traverse trav;
+      trav.begin(n, meshes, fns);
+      bool bnd[4];
+      SurfPos surf_pos[4];
+      Element** e;
+      while ((e = trav.get_next_state(bnd, surf_pos)) != NULL)
+      {
+        for (int i = 0; i < n; i++)
+        {
+          elements.push_back(e[i]);
+          element_ids.push_back((e[i] != NULL) ? e[i]->id : -1);
+          sub_idx.push_back((e[i] != NULL) ? trfs[i].get_transform() : 0);
+        }
+        Element* base = trav.get_base();
+        bases.push_back(base);
+        base_ids.push_back(base->id);
+        for (int i = n - 1; i >= 0; i--)
+          if (meshes[i]->get_element(base->id) == base)
+          {
+            base_meshes.push_back(i);
+            break;
+          }
+
+        unsigned char flags = 0;
+        int pos = -1;
+        for (unsigned int i = 0; i < base->get_num_surf(); i++)
+          if (bnd[i])
+          {
+            if (pos < 0)
+              pos = lo_hi.size();
+            flags |= 1 << i;
+            lo_hi.push_back(surf_pos[i].lo);
+            lo_hi.push_back(surf_pos[i].hi);
+          }
+        bnd_flags.push_back(flags);
+        bnd_pos.push_back(pos);
+      }
+      trav.finish();
+
+      delete [] fns;
+      delete [] trfs;
+      return true;
+    }
+
+    void TraversePlan::get_boundary_info(int state, bool* bnd, SurfPos* surf_pos) const
+    {
+      Element* e = NULL;
+      for (int i = 0; i < num; i++)
+        if ((e = elements[state * num + i]) != NULL)
+          break;
+
+      Element* base = bases[state];
+      int pos = bnd_pos[state];
+      for (unsigned int i = 0; i < base->get_num_surf(); i++)
+      {
+        if ((bnd[i] = (bnd_flags[state] >> i) & 1))
+        {
+          surf_pos[i].lo = lo_hi[pos++];
+          surf_pos[i].hi = lo_hi[pos++];
+        }
+        surf_pos[i].v1 = base->vn[i]->id;
+        surf_pos[i].v2 = base->vn[(i + 1) % base->get_num_surf()]->id;
+        surf_pos[i].marker = e->en[i]->marker;
+        surf_pos[i].surf_num = i;
+      }
+    }
   }
 }
\ No newline at end of file
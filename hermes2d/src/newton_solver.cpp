@@ -27,13 +27,15 @@ namespace Hermes
     double NewtonSolver<Scalar>::max_allowed_residual_norm = 1E9;
 
     template<typename Scalar>
-    NewtonSolver<Scalar>::NewtonSolver(DiscreteProblem<Scalar>* dp) : NonlinearSolver<Scalar>(dp), kept_jacobian(NULL), damping_coeff(1.0)
+    NewtonSolver<Scalar>::NewtonSolver(DiscreteProblem<Scalar>* dp) : NonlinearSolver<Scalar>(dp), kept_jacobian(NULL), damping_coeff(1.0),
+      fused_assembling(true), speculative_jacobian(false)
     {
       init_linear_solver();
     }
 
     template<typename Scalar>
-    NewtonSolver<Scalar>::NewtonSolver(DiscreteProblem<Scalar>* dp, Hermes::MatrixSolverType matrix_solver_type) : NonlinearSolver<Scalar>(dp, matrix_solver_type), kept_jacobian(NULL), damping_coeff(1.0)
+    NewtonSolver<Scalar>::NewtonSolver(DiscreteProblem<Scalar>* dp, Hermes::MatrixSolverType matrix_solver_type) : NonlinearSolver<Scalar>(dp, matrix_solver_type), kept_jacobian(NULL), damping_coeff(1.0),
+      fused_assembling(true), speculative_jacobian(false)
     {
       init_linear_solver();
     }
@@ -94,8 +96,14 @@ namespace Hermes
 
       while (true)
       {
-        // Assemble just the residual vector.
-        this->dp->assemble(this->sln_vector, residual);
+        // The jacobian is always needed in the first iteration (the residual norm is not tested there),
+        // assemble it in the same traversal as the residual vector.
+        bool jacobian_assembled = fused_assembling && (it == 1 || speculative_jacobian);
+        if (jacobian_assembled)
+          this->dp->assemble(this->sln_vector, jacobian, residual);
+        else
+          // Assemble just the residual vector.
+          this->dp->assemble(this->sln_vector, residual);
 
         this->timer->tick();
         assemble_time += this->timer->last();
@@ -162,9 +170,12 @@ namespace Hermes
         solve_time += this->timer->last();
 
         // Assemble just the jacobian.
-        this->dp->assemble(this->sln_vector, jacobian);
-        this->timer->tick();
-        assemble_time += this->timer->last();
+        if (!jacobian_assembled)
+        {
+          this->dp->assemble(this->sln_vector, jacobian);
+          this->timer->tick();
+          assemble_time += this->timer->last();
+        }
 
         // Multiply the residual vector with -1 since the matrix
         // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
@@ -223,8 +234,33 @@ namespace Hermes
       int it = 1;
       while (true)
       {
+        // Assemble and keep the jacobian if this has not been done before.
+        // Also declare that LU-factorization in case of a direct solver will be done only once and reused afterwards.
+        bool jacobian_needed = false, jacobian_assembled = false;
+        if(kept_jacobian == NULL) {
+          jacobian_needed = true;
+          kept_jacobian = create_matrix<Scalar>(this->matrix_solver_type);
+
+          // Give the matrix solver the correct Jacobian. NOTE: It would be cleaner if the whole decision whether to keep
+          // Jacobian or not was made in the constructor.
+          //
+          // Delete the matrix solver created in the constructor.
+          delete linear_solver;
+          // Create new matrix solver with correct matrix.
+          linear_solver = create_linear_solver<Scalar>(this->matrix_solver_type, kept_jacobian, residual);
+          linear_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
+          // The jacobian is needed in the first iteration, assemble it in the same traversal as the residual vector.
+          if (fused_assembling)
+          {
+            this->dp->assemble(this->sln_vector, kept_jacobian, residual);
+            jacobian_assembled = true;
+          }
+        }
+
         // Assemble the residual vector.
-        this->dp->assemble(this->sln_vector, residual);
+        if (!jacobian_assembled)
+          this->dp->assemble(this->sln_vector, residual);
 
         // Measure the residual norm.
         if (residual_as_function)
@@ -278,22 +314,9 @@ namespace Hermes
         if (residual_norm < newton_tol && it > 1)
           return;
 
-        // Assemble and keep the jacobian if this has not been done before.
-        // Also declare that LU-factorization in case of a direct solver will be done only once and reused afterwards.
-        if(kept_jacobian == NULL) {
-          kept_jacobian = create_matrix<Scalar>(this->matrix_solver_type);
-
-          // Give the matrix solver the correct Jacobian. NOTE: It would be cleaner if the whole decision whether to keep
-          // Jacobian or not was made in the constructor.
-          //
-          // Delete the matrix solver created in the constructor.
-          delete linear_solver;
-          // Create new matrix solver with correct matrix.
-          linear_solver = create_linear_solver<Scalar>(this->matrix_solver_type, kept_jacobian, residual);
-
+        // Assemble the kept jacobian, unless it was assembled together with the residual vector.
+        if (jacobian_needed && !jacobian_assembled)
           this->dp->assemble(this->sln_vector, kept_jacobian);
-          linear_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
-        }
 
         // Multiply the residual vector with -1 since the matrix
         // equation reads J(Y^n) \deltaY^{n + 1} = -F(Y^n).
@@ -326,6 +349,11 @@ namespace Hermes
     void NewtonSolver<Scalar>::set_iterative_method(const char* iterative_method_name)
     {
       NonlinearSolver<Scalar>::set_iterative_method(iterative_method_name);
+      if (this->matrix_solver_type == SOLVER_KRYLOV)
+      {
+        dynamic_cast<Hermes::Solvers::KrylovSolver<Scalar>*>(linear_solver)->set_solver(iterative_method_name);
+        return;
+      }
       // Set iterative method and preconditioner in case of iterative solver AztecOO.
 #ifdef HAVE_AZTECOO
       if(this->matrix_solver_type != SOLVER_AZTECOO)
@@ -344,6 +372,11 @@ namespace Hermes
     void NewtonSolver<Scalar>::set_preconditioner(const char* preconditioner_name)
     {
       NonlinearSolver<Scalar>::set_preconditioner(preconditioner_name);
+      if (this->matrix_solver_type == SOLVER_KRYLOV)
+      {
+        dynamic_cast<Hermes::Solvers::KrylovSolver<Scalar>*>(linear_solver)->set_precond(preconditioner_name);
+        return;
+      }
       // Set iterative method and preconditioner in case of iterative solver AztecOO.
 #ifdef HAVE_AZTECOO
       if(this->matrix_solver_type != SOLVER_AZTECOO)
@@ -358,12 +391,35 @@ namespace Hermes
 #endif
     }
 
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_preconditioner(Precond<Scalar>* pc)
+    {
+      if (this->matrix_solver_type != SOLVER_KRYLOV)
+      {
+        warning("Trying to set a preconditioner object for a different solver than the native Krylov solver.");
+        return;
+      }
+      dynamic_cast<Hermes::Solvers::KrylovSolver<Scalar>*>(linear_solver)->set_precond(pc);
+    }
+
     template<typename Scalar>
     void NewtonSolver<Scalar>::set_damping_coeff(double damping_coeff)
     {
       this->damping_coeff = damping_coeff;
     }
 
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_fused_assembling(bool fused_assembling)
+    {
+      this->fused_assembling = fused_assembling;
+    }
+
+    template<typename Scalar>
+    void NewtonSolver<Scalar>::set_speculative_jacobian(bool speculative_jacobian)
+    {
+      this->speculative_jacobian = speculative_jacobian;
+    }
+
     template class HERMES_API NewtonSolver<double>;
     template class HERMES_API NewtonSolver<std::complex<double> >;
   }
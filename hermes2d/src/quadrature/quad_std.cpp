@@ -2540,6 +2540,7 @@ namespace Hermes
 
       tables = std_tables_2d;
       np = std_np_2d;
+      tensor_np_1d = std_np_1d;
     }
 
 
@@ -18,7 +18,25 @@ namespace Hermes
 
       template<typename Scalar>
       H1ProjBasedSelector<Scalar>::H1ProjBasedSelector(CandList cand_list, double conv_exp, int max_order, H1Shapeset* user_shapeset)
-        : ProjBasedSelector<Scalar>(cand_list, conv_exp, max_order, user_shapeset == NULL ? &default_shapeset : user_shapeset, typename OptimumSelector<Scalar>::Range(1, 1), typename OptimumSelector<Scalar>::Range(2, H2DRS_MAX_H1_ORDER)) {}
+        : ProjBasedSelector<Scalar>(cand_list, conv_exp, max_order, user_shapeset == NULL ? &default_shapeset : user_shapeset, typename OptimumSelector<Scalar>::Range(1, 1), typename OptimumSelector<Scalar>::Range(2, H2DRS_MAX_H1_ORDER)), own_shapeset(NULL) {}
+
+      template<typename Scalar>
+      H1ProjBasedSelector<Scalar>::~H1ProjBasedSelector()
+      {
+        delete own_shapeset;
+      }
+
+      template<typename Scalar>
+      Selector<Scalar>* H1ProjBasedSelector<Scalar>::clone()
+      {
+        if (this->shapeset != &default_shapeset)
+          return NULL;
+        H1Shapeset* shapeset = new H1Shapeset;
+        H1ProjBasedSelector<Scalar>* clone = new H1ProjBasedSelector<Scalar>(this->cand_list, this->conv_exp, this->max_order, shapeset);
+        clone->own_shapeset = shapeset;
+        this->copy_settings(clone);
+        return clone;
+      }
 
       template<typename Scalar>
       void H1ProjBasedSelector<Scalar>::set_current_order_range(Element* element)
@@ -19,7 +19,25 @@ namespace Hermes
 
       template<typename Scalar>
       L2ProjBasedSelector<Scalar>::L2ProjBasedSelector(CandList cand_list, double conv_exp, int max_order, L2Shapeset* user_shapeset)
-        : ProjBasedSelector<Scalar>(cand_list, conv_exp, max_order, user_shapeset == NULL ? &default_shapeset : user_shapeset, typename OptimumSelector<Scalar>::Range(1, 1), typename OptimumSelector<Scalar>::Range(0, H2DRS_MAX_L2_ORDER)) {}
+        : ProjBasedSelector<Scalar>(cand_list, conv_exp, max_order, user_shapeset == NULL ? &default_shapeset : user_shapeset, typename OptimumSelector<Scalar>::Range(1, 1), typename OptimumSelector<Scalar>::Range(0, H2DRS_MAX_L2_ORDER)), own_shapeset(NULL) {}
+
+      template<typename Scalar>
+      L2ProjBasedSelector<Scalar>::~L2ProjBasedSelector()
+      {
+        delete own_shapeset;
+      }
+
+      template<typename Scalar>
+      Selector<Scalar>* L2ProjBasedSelector<Scalar>::clone()
+      {
+        if (this->shapeset != &default_shapeset)
+          return NULL;
+        L2Shapeset* shapeset = new L2Shapeset;
+        L2ProjBasedSelector<Scalar>* clone = new L2ProjBasedSelector<Scalar>(this->cand_list, this->conv_exp, this->max_order, shapeset);
+        clone->own_shapeset = shapeset;
+        this->copy_settings(clone);
+        return clone;
+      }
 
       template<typename Scalar>
       void L2ProjBasedSelector<Scalar>::set_current_order_range(Element* element)
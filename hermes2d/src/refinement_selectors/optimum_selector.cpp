@@ -689,6 +689,11 @@ namespace Hermes
         case H2D_APPLY_CONV_EXP_DOF: opt_apply_exp_dof = enable; break;
         default: error("Unknown option %d.", (int)option);
         }
+
+        //update copies used by threads
+        for(unsigned int i = 0; i < this->thread_copies.size(); i++)
+          if (this->thread_copies[i] != NULL)
+            static_cast<OptimumSelector<Scalar>*>(this->thread_copies[i])->set_option(option, enable);
       }
       
       template<typename Scalar>
@@ -31,7 +31,10 @@ namespace Hermes
         for(int m = 0; m < H2D_NUM_MODES; m++)
           for(int i = 0; i < H2DRS_MAX_ORDER + 1; i++)
             for(int k = 0; k < H2DRS_MAX_ORDER + 1; k++)
+            {
               proj_matrix_cache[m][i][k] = NULL;
+              proj_pivot_cache[m][i][k] = NULL;
+            }
 
         //allocate caches
         int max_inx = this->max_shape_inx[0];
@@ -51,6 +54,8 @@ namespace Hermes
             {
               if (proj_matrix_cache[m][i][k] != NULL)
                 delete[] proj_matrix_cache[m][i][k];
+              if (proj_pivot_cache[m][i][k] != NULL)
+                delete[] proj_pivot_cache[m][i][k];
             }
       }
 
@@ -60,6 +65,11 @@ namespace Hermes
         error_weight_h = weight_h;
         error_weight_p = weight_p;
         error_weight_aniso = weight_aniso;
+
+        //update copies used by threads
+        for(unsigned int i = 0; i < this->thread_copies.size(); i++)
+          if (this->thread_copies[i] != NULL)
+            static_cast<ProjBasedSelector<Scalar>*>(this->thread_copies[i])->set_error_weights(weight_h, weight_p, weight_aniso);
       }
 
       template<typename Scalar>
@@ -80,6 +90,14 @@ namespace Hermes
         return error_weight_aniso; 
       }
 
+      template<typename Scalar>
+      void ProjBasedSelector<Scalar>::copy_settings(ProjBasedSelector<Scalar>* clone) const
+      {
+        clone->opt_symmetric_mesh = this->opt_symmetric_mesh;
+        clone->opt_apply_exp_dof = this->opt_apply_exp_dof;
+        clone->set_error_weights(error_weight_h, error_weight_p, error_weight_aniso);
+      }
+
       template<typename Scalar>
       ProjBasedSelector<Scalar>::TrfShapeExp::TrfShapeExp() : num_gip(0), num_expansion(0), values(NULL) {};
 
@@ -354,10 +372,8 @@ namespace Hermes
         int max_num_shapes = this->next_order_shape[mode][this->current_max_order];
         Scalar* right_side = new Scalar[max_num_shapes];
         int* shape_inxs = new int[max_num_shapes];
-        int* indx = new int[max_num_shapes]; //solver data
-        double* d = new double[max_num_shapes]; //solver data
-        double** proj_matrix = new_matrix<double>(max_num_shapes, max_num_shapes);
         ProjMatrixCache& proj_matrices = proj_matrix_cache[mode];
+        ProjPivotCache& proj_pivots = proj_pivot_cache[mode];
         Hermes::vector<typename OptimumSelector<Scalar>::ShapeInx>& full_shape_indices = this->shape_indices[mode];
 
         //check whether ortho-svals are available
@@ -404,12 +420,13 @@ namespace Hermes
             Hermes::vector< ValueCacheItem<Scalar> >& rhs_cache = use_ortho ? ortho_rhs_cache : nonortho_rhs_cache;
             Hermes::vector<TrfShapeExp>** sub_svals = use_ortho ? sub_ortho_svals : sub_nonortho_svals;
 
-            //calculate projection matrix iff no ortho is used
-            if (!use_ortho)
+            //calculate and decompose projection matrix iff no ortho is used
+            if (!use_ortho && proj_matrices[order_h][order_v] == NULL)
             {
-              if (proj_matrices[order_h][order_v] == NULL)
-                proj_matrices[order_h][order_v] = build_projection_matrix(gip_points, num_gip_points, shape_inxs, num_shapes);
-              copy_matrix(proj_matrix, proj_matrices[order_h][order_v], num_shapes, num_shapes); //copy projection matrix because original matrix will be modified
+              double d;
+              proj_matrices[order_h][order_v] = build_projection_matrix(gip_points, num_gip_points, shape_inxs, num_shapes);
+              proj_pivots[order_h][order_v] = new int[num_shapes];
+              ludcmp(proj_matrices[order_h][order_v], num_shapes, proj_pivots[order_h][order_v], &d);
             }
 
             //build right side (fill cache values that are missing)
@@ -443,10 +460,7 @@ namespace Hermes
 
             //solve iff no ortho is used
             if (!use_ortho)
-            {
-              ludcmp(proj_matrix, num_shapes, indx, d);
-              lubksb<Scalar>(proj_matrix, num_shapes, indx, right_side);
-            }
+              lubksb<Scalar>(proj_matrices[order_h][order_v], num_shapes, proj_pivots[order_h][order_v], right_side);
 
             //calculate error
             double error_squared = 0;
@@ -464,11 +478,8 @@ namespace Hermes
         } while (order_perm.next());
 
         //clenaup
-        delete[] proj_matrix;
         delete[] right_side;
         delete[] shape_inxs;
-        delete[] indx;
-        delete[] d;
       }
 
       template class HERMES_API ProjBasedSelector<double>;
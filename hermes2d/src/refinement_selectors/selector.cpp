@@ -9,6 +9,25 @@ namespace Hermes
     namespace RefinementSelectors
     {
 
+      template<typename Scalar>
+      Selector<Scalar>::~Selector()
+      {
+        for(unsigned int i = 0; i < thread_copies.size(); i++)
+          delete thread_copies[i];
+      }
+
+      template<typename Scalar>
+      Selector<Scalar>* Selector<Scalar>::get_thread_copy(int thread)
+      {
+        if (thread == 0)
+          return this;
+        if ((int)thread_copies.size() <= thread)
+          thread_copies.resize(thread + 1, NULL);
+        if (thread_copies[thread] == NULL)
+          thread_copies[thread] = clone();
+        return thread_copies[thread];
+      }
+
       template<typename Scalar>
       bool HOnlySelector<Scalar>::select_refinement(Element* element, int quad_order, Solution<Scalar>* rsln, ElementToRefine& refinement)
       {
@@ -307,6 +307,10 @@ namespace Hermes
           // resulting tensor Jacobian.
           matrix_right->add_sparse_to_diagonal_blocks(num_stages, matrix_left);
           matrix_right->finish();
+
+          // The new jacobian has to be factorized, with the same structure the symbolic
+          // factorization is reused by the solver.
+          solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
         }
         else
           solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
@@ -133,6 +133,22 @@ namespace Hermes
       int newmask = mask | oldmask;
       Node* node = new_node(newmask, np);
 
+      // On quads, tensor-product shape functions at tensor-product points are sum-factorized:
+      // the one-dimensional factors are evaluated at the (transformed) 1D coordinates only.
+      int np_1d = quad->get_tensor_num_points(order);
+      double* x_1d = NULL;
+      double* y_1d = NULL;
+      if (np_1d > 0 && shapeset->is_tensor_fn(index))
+      {
+        x_1d = new double[2 * np_1d];
+        y_1d = x_1d + np_1d;
+        for (i = 0; i < np_1d; i++)
+        {
+          x_1d[i] = ctm->m[0] * pt[i * np_1d][0] + ctm->t[0];
+          y_1d[i] = ctm->m[1] * pt[i][1] + ctm->t[1];
+        }
+      }
+
       // precalculate all required tables
       for (j = 0; j < num_components; j++)
       {
@@ -142,6 +158,8 @@ namespace Hermes
           {
             if (oldmask & idx2mask[k][j])
               memcpy(node->values[j][k], cur_node->values[j][k], np * sizeof(double));
+            else if (x_1d != NULL)
+              shapeset->get_tensor_values(k, index, np_1d, x_1d, np_1d, y_1d, node->values[j][k]);
             else
               for (i = 0; i < np; i++)
                 node->values[j][k][i] = shapeset->get_value(k, index, ctm->m[0] * pt[i][0] + ctm->t[0],
@@ -149,6 +167,8 @@ namespace Hermes
           }
         }
       }
+      if (x_1d != NULL)
+        delete [] x_1d;
       if(nodes->present(order))
       {
         assert(nodes->get(order) == cur_node);
@@ -101,36 +101,42 @@ namespace Hermes
     double* Shapeset::get_constrained_edge_combination(int order, int part, int ori, int& nitems)
     {
       int index = 2*((max_order + 1 - ebias)*part + (order - ebias)) + ori;
+      double* comb;
 
-      // allocate/reallocate the array if necessary
-      if (comb_table == NULL)
+      // the table is shared by all threads of the threaded assembling
+#pragma omp critical (shapeset_constrained_edge_combination)
       {
-        table_size = 1024;
-        while (table_size <= index) table_size *= 2;
-        comb_table = (double**) malloc(table_size * sizeof(double*));
-        memset(comb_table, 0, table_size * sizeof(double*));
-      }
-      else if (index >= table_size)
-      {
-        // adjust table_size to accommodate the required depth
-        int old_size = table_size;
-        while (index >= table_size) table_size *= 2;
-
-        // reallocate the table
-        verbose("Shapeset::get_constrained_edge_combination(): realloc to table_size = %d", table_size);
-        comb_table = (double**) realloc(comb_table, table_size * sizeof(double*));
-        memset(comb_table + old_size, 0, (table_size - old_size) * sizeof(double*));
-      }
+        // allocate/reallocate the array if necessary
+        if (comb_table == NULL)
+        {
+          table_size = 1024;
+          while (table_size <= index) table_size *= 2;
+          comb_table = (double**) malloc(table_size * sizeof(double*));
+          memset(comb_table, 0, table_size * sizeof(double*));
+        }
+        else if (index >= table_size)
+        {
+          // adjust table_size to accommodate the required depth
+          int old_size = table_size;
+          while (index >= table_size) table_size *= 2;
+
+          // reallocate the table
+          verbose("Shapeset::get_constrained_edge_combination(): realloc to table_size = %d", table_size);
+          comb_table = (double**) realloc(comb_table, table_size * sizeof(double*));
+          memset(comb_table + old_size, 0, (table_size - old_size) * sizeof(double*));
+        }
 
-      // do we have the required linear combination yet?
-      if (comb_table[index] == NULL)
-      {
-        // no, calculate it
-        comb_table[index] = calculate_constrained_edge_combination(order, part, ori);
+        // do we have the required linear combination yet?
+        if (comb_table[index] == NULL)
+        {
+          // no, calculate it
+          comb_table[index] = calculate_constrained_edge_combination(order, part, ori);
+        }
+        comb = comb_table[index];
       }
 
       nitems = order + 1 - ebias;
-      return comb_table[index];
+      return comb;
     }
 
     void Shapeset::free_constrained_edge_combinations()
@@ -166,6 +172,10 @@ namespace Hermes
       return sum;
     }
 
+    Shapeset::Shapeset() : tensor_fn_table(NULL), tensor_x(NULL), tensor_y(NULL), tensor_coef(NULL)
+    {
+    }
+
     Shapeset::~Shapeset() { free_constrained_edge_combinations(); }
 
     /// Selects HERMES_MODE_TRIANGLE or HERMES_MODE_QUAD.
@@ -284,6 +294,34 @@ namespace Hermes
     double Shapeset::get_dyy_value(int index, double x, double y, int component)  { return get_value(4, index, x, y, component); }
     double Shapeset::get_dxy_value(int index, double x, double y, int component) { return get_value(5, index, x, y, component); }
 
+    bool Shapeset::is_tensor_fn(int index) const
+    {
+      return mode == HERMES_MODE_QUAD && tensor_fn_table != NULL && index >= 0;
+    }
+
+    void Shapeset::get_tensor_values(int n, int index, int nx, const double* x, int ny, const double* y, double* values)
+    {
+      assert(is_tensor_fn(index) && index <= max_index[mode]);
+
+      // Orders of the derivatives in x and y, in the order of FunctionExpansionIndex.
+      static const int der_x[6] = { 0, 1, 0, 2, 0, 1 };
+      static const int der_y[6] = { 0, 0, 1, 0, 2, 1 };
+      shape_fn_1d_t fx = tensor_fn_table[der_x[n]][tensor_x[index]];
+      shape_fn_1d_t fy = tensor_fn_table[der_y[n]][tensor_y[index]];
+      double coef = (tensor_coef != NULL) ? tensor_coef[index] : 1.0;
+
+      double* vy = new double[ny];
+      for (int j = 0; j < ny; j++)
+        vy[j] = fy(y[j]);
+      for (int i = 0; i < nx; i++)
+      {
+        double vx = coef * fx(x[i]);
+        for (int j = 0; j < ny; j++)
+          values[i * ny + j] = vx * vy[j];
+      }
+      delete [] vy;
+    }
+
     /// Returns the coordinates of the reference domain vertices.
     double2* Shapeset::get_ref_vertex(int vertex)
     {
@@ -4240,6 +4240,11 @@ namespace Hermes
       bubble_count = jacobi_bubble_count;
       index_to_order = jacobi_index_to_order;
 
+      tensor_fn_table = simple_quad_tensor_fn_table;
+      tensor_x = simple_quad_tensor_x;
+      tensor_y = simple_quad_tensor_y;
+      tensor_coef = simple_quad_tensor_coef;
+
       ref_vert[0][0][0] = -1.0;
       ref_vert[0][0][1] = -1.0;
       ref_vert[0][1][0] =  1.0;
@@ -17014,6 +17014,11 @@ namespace Hermes
       bubble_count = ortho2_bubble_count;
       index_to_order = ortho2_index_to_order;
 
+      tensor_fn_table = simple_quad_tensor_fn_table;
+      tensor_x = simple_quad_tensor_x;
+      tensor_y = simple_quad_tensor_y;
+      tensor_coef = simple_quad_tensor_coef;
+
       ref_vert[0][0][0] = -1.0;
       ref_vert[0][0][1] = -1.0;
       ref_vert[0][1][0] =  1.0;
@@ -4325,6 +4325,232 @@ namespace Hermes
     Shapeset::shape_fn_t* simple_quad_shape_fn_table_dxy[1] = { simple_quad_fn_dxy };
     Shapeset::shape_fn_t* simple_quad_shape_fn_table_dyy[1] = { simple_quad_fn_dyy };
 
+    //// tensor-product form of the shape functions ////////////////////////////////////////////////////
+
+    static double simple_quad_lobatto_0(double x)
+    {
+      return l0(x);
+    }
+
+    static double simple_quad_lobatto_1(double x)
+    {
+      return l1(x);
+    }
+
+    static double simple_quad_lobatto_2(double x)
+    {
+      return l2(x);
+    }
+
+    static double simple_quad_lobatto_3(double x)
+    {
+      return l3(x);
+    }
+
+    static double simple_quad_lobatto_4(double x)
+    {
+      return l4(x);
+    }
+
+    static double simple_quad_lobatto_5(double x)
+    {
+      return l5(x);
+    }
+
+    static double simple_quad_lobatto_6(double x)
+    {
+      return l6(x);
+    }
+
+    static double simple_quad_lobatto_7(double x)
+    {
+      return l7(x);
+    }
+
+    static double simple_quad_lobatto_8(double x)
+    {
+      return l8(x);
+    }
+
+    static double simple_quad_lobatto_9(double x)
+    {
+      return l9(x);
+    }
+
+    static double simple_quad_lobatto_10(double x)
+    {
+      return l10(x);
+    }
+
+    static double simple_quad_lobatto_dx_0(double x)
+    {
+      return dl0(x);
+    }
+
+    static double simple_quad_lobatto_dx_1(double x)
+    {
+      return dl1(x);
+    }
+
+    static double simple_quad_lobatto_dx_2(double x)
+    {
+      return dl2(x);
+    }
+
+    static double simple_quad_lobatto_dx_3(double x)
+    {
+      return dl3(x);
+    }
+
+    static double simple_quad_lobatto_dx_4(double x)
+    {
+      return dl4(x);
+    }
+
+    static double simple_quad_lobatto_dx_5(double x)
+    {
+      return dl5(x);
+    }
+
+    static double simple_quad_lobatto_dx_6(double x)
+    {
+      return dl6(x);
+    }
+
+    static double simple_quad_lobatto_dx_7(double x)
+    {
+      return dl7(x);
+    }
+
+    static double simple_quad_lobatto_dx_8(double x)
+    {
+      return dl8(x);
+    }
+
+    static double simple_quad_lobatto_dx_9(double x)
+    {
+      return dl9(x);
+    }
+
+    static double simple_quad_lobatto_dx_10(double x)
+    {
+      return dl10(x);
+    }
+
+    static double simple_quad_lobatto_dxx_0(double x)
+    {
+      return d2l0(x);
+    }
+
+    static double simple_quad_lobatto_dxx_1(double x)
+    {
+      return d2l1(x);
+    }
+
+    static double simple_quad_lobatto_dxx_2(double x)
+    {
+      return d2l2(x);
+    }
+
+    static double simple_quad_lobatto_dxx_3(double x)
+    {
+      return d2l3(x);
+    }
+
+    static double simple_quad_lobatto_dxx_4(double x)
+    {
+      return d2l4(x);
+    }
+
+    static double simple_quad_lobatto_dxx_5(double x)
+    {
+      return d2l5(x);
+    }
+
+    static double simple_quad_lobatto_dxx_6(double x)
+    {
+      return d2l6(x);
+    }
+
+    static double simple_quad_lobatto_dxx_7(double x)
+    {
+      return d2l7(x);
+    }
+
+    static double simple_quad_lobatto_dxx_8(double x)
+    {
+      return d2l8(x);
+    }
+
+    static double simple_quad_lobatto_dxx_9(double x)
+    {
+      return d2l9(x);
+    }
+
+    static double simple_quad_lobatto_dxx_10(double x)
+    {
+      return d2l10(x);
+    }
+
+    static Shapeset::shape_fn_1d_t simple_quad_lobatto[] =
+    {
+      simple_quad_lobatto_0, simple_quad_lobatto_1, simple_quad_lobatto_2, simple_quad_lobatto_3, simple_quad_lobatto_4, simple_quad_lobatto_5,
+      simple_quad_lobatto_6, simple_quad_lobatto_7, simple_quad_lobatto_8, simple_quad_lobatto_9, simple_quad_lobatto_10,
+    };
+
+    static Shapeset::shape_fn_1d_t simple_quad_lobatto_dx[] =
+    {
+      simple_quad_lobatto_dx_0, simple_quad_lobatto_dx_1, simple_quad_lobatto_dx_2, simple_quad_lobatto_dx_3, simple_quad_lobatto_dx_4, simple_quad_lobatto_dx_5,
+      simple_quad_lobatto_dx_6, simple_quad_lobatto_dx_7, simple_quad_lobatto_dx_8, simple_quad_lobatto_dx_9, simple_quad_lobatto_dx_10,
+    };
+
+    static Shapeset::shape_fn_1d_t simple_quad_lobatto_dxx[] =
+    {
+      simple_quad_lobatto_dxx_0, simple_quad_lobatto_dxx_1, simple_quad_lobatto_dxx_2, simple_quad_lobatto_dxx_3, simple_quad_lobatto_dxx_4, simple_quad_lobatto_dxx_5,
+      simple_quad_lobatto_dxx_6, simple_quad_lobatto_dxx_7, simple_quad_lobatto_dxx_8, simple_quad_lobatto_dxx_9, simple_quad_lobatto_dxx_10,
+    };
+
+    Shapeset::shape_fn_1d_t* simple_quad_tensor_fn_table[3] = { simple_quad_lobatto, simple_quad_lobatto_dx, simple_quad_lobatto_dxx };
+
+    int simple_quad_tensor_x[] =
+    {
+       0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,
+       1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,
+       2,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3,
+       3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  4,  4,  4,  4,  4,
+       4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  6,
+       6,  6,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,  7,  7,  7,  7,
+       7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8,  8,  8,  8,  8,
+       8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 10,
+    };
+
+    int simple_quad_tensor_y[] =
+    {
+       0,  1,  2,  3,  3,  4,  5,  5,  6,  7,  7,  8,  9,  9, 10,  0,
+       1,  2,  3,  3,  4,  5,  5,  6,  7,  7,  8,  9,  9, 10,  0,  1,
+       2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  0,  1,  1,  2,  3,  4,
+       5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+      10,  0,  0,  1,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,
+       2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  0,  1,  1,  2,  3,  4,
+       5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+      10,  0,  0,  1,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,
+       2,  3,  4,  5,  6,  7,  8,  9, 10,
+    };
+
+    double simple_quad_tensor_coef[] =
+    {
+       1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0, -1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, -1.0, -1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0, -1.0, -1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0, -1.0, -1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0, -1.0, -1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,
+       1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,  1.0,
+    };
+
     static int qb_2_2[] = { 32, };
     static int qb_2_3[] = { 32, 33, };
     static int qb_2_4[] = { 32, 33, 34, };
@@ -3827,6 +3827,217 @@ namespace Hermes
     Shapeset::shape_fn_t* leg_quad_shape_fn_table_dxy[1] = { leg_quad_fn_dxy };
     Shapeset::shape_fn_t* leg_quad_shape_fn_table_dyy[1] = { leg_quad_fn_dyy };
 
+    //// tensor-product form of the quad shape functions ///////////////////////////////////////////////
+
+    static double leg_quad_legendre_0(double x)
+    {
+      return Legendre0(x);
+    }
+
+    static double leg_quad_legendre_1(double x)
+    {
+      return Legendre1(x);
+    }
+
+    static double leg_quad_legendre_2(double x)
+    {
+      return Legendre2(x);
+    }
+
+    static double leg_quad_legendre_3(double x)
+    {
+      return Legendre3(x);
+    }
+
+    static double leg_quad_legendre_4(double x)
+    {
+      return Legendre4(x);
+    }
+
+    static double leg_quad_legendre_5(double x)
+    {
+      return Legendre5(x);
+    }
+
+    static double leg_quad_legendre_6(double x)
+    {
+      return Legendre6(x);
+    }
+
+    static double leg_quad_legendre_7(double x)
+    {
+      return Legendre7(x);
+    }
+
+    static double leg_quad_legendre_8(double x)
+    {
+      return Legendre8(x);
+    }
+
+    static double leg_quad_legendre_9(double x)
+    {
+      return Legendre9(x);
+    }
+
+    static double leg_quad_legendre_10(double x)
+    {
+      return Legendre10(x);
+    }
+
+    static double leg_quad_legendre_dx_0(double x)
+    {
+      return Legendre0x(x);
+    }
+
+    static double leg_quad_legendre_dx_1(double x)
+    {
+      return Legendre1x(x);
+    }
+
+    static double leg_quad_legendre_dx_2(double x)
+    {
+      return Legendre2x(x);
+    }
+
+    static double leg_quad_legendre_dx_3(double x)
+    {
+      return Legendre3x(x);
+    }
+
+    static double leg_quad_legendre_dx_4(double x)
+    {
+      return Legendre4x(x);
+    }
+
+    static double leg_quad_legendre_dx_5(double x)
+    {
+      return Legendre5x(x);
+    }
+
+    static double leg_quad_legendre_dx_6(double x)
+    {
+      return Legendre6x(x);
+    }
+
+    static double leg_quad_legendre_dx_7(double x)
+    {
+      return Legendre7x(x);
+    }
+
+    static double leg_quad_legendre_dx_8(double x)
+    {
+      return Legendre8x(x);
+    }
+
+    static double leg_quad_legendre_dx_9(double x)
+    {
+      return Legendre9x(x);
+    }
+
+    static double leg_quad_legendre_dx_10(double x)
+    {
+      return Legendre10x(x);
+    }
+
+    static double leg_quad_legendre_dxx_0(double x)
+    {
+      return Legendre0xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_1(double x)
+    {
+      return Legendre1xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_2(double x)
+    {
+      return Legendre2xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_3(double x)
+    {
+      return Legendre3xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_4(double x)
+    {
+      return Legendre4xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_5(double x)
+    {
+      return Legendre5xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_6(double x)
+    {
+      return Legendre6xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_7(double x)
+    {
+      return Legendre7xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_8(double x)
+    {
+      return Legendre8xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_9(double x)
+    {
+      return Legendre9xx(x);
+    }
+
+    static double leg_quad_legendre_dxx_10(double x)
+    {
+      return Legendre10xx(x);
+    }
+
+    static Shapeset::shape_fn_1d_t leg_quad_legendre[] =
+    {
+      leg_quad_legendre_0, leg_quad_legendre_1, leg_quad_legendre_2, leg_quad_legendre_3, leg_quad_legendre_4, leg_quad_legendre_5,
+      leg_quad_legendre_6, leg_quad_legendre_7, leg_quad_legendre_8, leg_quad_legendre_9, leg_quad_legendre_10,
+    };
+
+    static Shapeset::shape_fn_1d_t leg_quad_legendre_dx[] =
+    {
+      leg_quad_legendre_dx_0, leg_quad_legendre_dx_1, leg_quad_legendre_dx_2, leg_quad_legendre_dx_3, leg_quad_legendre_dx_4, leg_quad_legendre_dx_5,
+      leg_quad_legendre_dx_6, leg_quad_legendre_dx_7, leg_quad_legendre_dx_8, leg_quad_legendre_dx_9, leg_quad_legendre_dx_10,
+    };
+
+    static Shapeset::shape_fn_1d_t leg_quad_legendre_dxx[] =
+    {
+      leg_quad_legendre_dxx_0, leg_quad_legendre_dxx_1, leg_quad_legendre_dxx_2, leg_quad_legendre_dxx_3, leg_quad_legendre_dxx_4, leg_quad_legendre_dxx_5,
+      leg_quad_legendre_dxx_6, leg_quad_legendre_dxx_7, leg_quad_legendre_dxx_8, leg_quad_legendre_dxx_9, leg_quad_legendre_dxx_10,
+    };
+
+    static Shapeset::shape_fn_1d_t* leg_quad_tensor_fn_table[3] = { leg_quad_legendre, leg_quad_legendre_dx, leg_quad_legendre_dxx };
+
+    static int leg_quad_tensor_x[] =
+    {
+       0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,
+       1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+       2,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,
+       4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+       5,  5,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,
+       7,  7,  7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8,  8,  8,
+       8,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10,
+      10, 10, 10, 10, 10, 10, 10, 10, 10,
+    };
+
+    static int leg_quad_tensor_y[] =
+    {
+       0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,
+       5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
+      10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,  2,  3,
+       4,  5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,
+       9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,  2,
+       3,  4,  5,  6,  7,  8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,
+       8,  9, 10,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10,  0,  1,
+       2,  3,  4,  5,  6,  7,  8,  9, 10,
+    };
+
     static int qb_0_0[] = { 0, };
     static int qb_0_1[] = { 0, 1, };
     static int qb_0_2[] = { 0, 1, 2, };
@@ -5596,6 +5807,10 @@ namespace Hermes
       bubble_count = leg_bubble_count;
       index_to_order = leg_index_to_order;
 
+      tensor_fn_table = leg_quad_tensor_fn_table;
+      tensor_x = leg_quad_tensor_x;
+      tensor_y = leg_quad_tensor_y;
+
       ref_vert[0][0][0] = -1.0;
       ref_vert[0][0][1] = -1.0;
       ref_vert[0][1][0] =  1.0;
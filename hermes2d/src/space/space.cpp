@@ -26,6 +26,8 @@
 #endif
 
 #include <iostream>
+#include <map>
+#include <algorithm>
 #include "exceptions.h"
 
 namespace Hermes
@@ -50,6 +52,10 @@ namespace Hermes
       this->seq = g_space_seq;
       this->was_assigned = false;
       this->ndof = 0;
+      this->incremental_dofs = false;
+      this->dof_ordering = HERMES_DOF_ORDERING_NATURAL;
+      this->assigned_first_dof = this->assigned_stride = this->assigned_ndof = 0;
+      this->assignment_seq = this->prev_assignment_seq = -1;
 
       if(essential_bcs != NULL)
         for(typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
@@ -548,6 +554,19 @@ namespace Hermes
             copy_orders_recurrent(e->sons[i], order);
     }
 
+    template<typename Scalar>
+    int Space<Scalar>::get_copied_order(Element* e, int o, int inc) const
+    {
+      if (o < 0)
+        error("Source space has an uninitialized order (element id = %d)", e->id);
+
+      int mo = shapeset->get_max_order();
+      int lower_limit = (get_type() == HERMES_L2_SPACE || get_type() == HERMES_HCURL_SPACE) ? 0 : 1; // L2 and Hcurl may use zero orders.
+      int ho = std::max(lower_limit, std::min(H2D_GET_H_ORDER(o) + inc, mo));
+      int vo = std::max(lower_limit, std::min(H2D_GET_V_ORDER(o) + inc, mo));
+      return e->is_triangle() ? ho : H2D_MAKE_QUAD_ORDER(ho, vo);
+    }
+
     template<typename Scalar>
     void Space<Scalar>::copy_orders(const Space<Scalar>* space, int inc)
     {
@@ -556,15 +575,7 @@ namespace Hermes
       resize_tables();
       for_all_active_elements(e, space->get_mesh())
       {
-        int o = space->get_element_order(e->id);
-        if (o < 0)
-          error("Source space has an uninitialized order (element id = %d)", e->id);
-
-        int mo = shapeset->get_max_order();
-        int lower_limit = (get_type() == HERMES_L2_SPACE || get_type() == HERMES_HCURL_SPACE) ? 0 : 1; // L2 and Hcurl may use zero orders.
-        int ho = std::max(lower_limit, std::min(H2D_GET_H_ORDER(o) + inc, mo));
-        int vo = std::max(lower_limit, std::min(H2D_GET_V_ORDER(o) + inc, mo));
-        o = e->is_triangle() ? ho : H2D_MAKE_QUAD_ORDER(ho, vo);
+        int o = get_copied_order(e, space->get_element_order(e->id), inc);
 
         copy_orders_recurrent(mesh->get_element(e->id), o);
         if(space->edata[e->id].changed_in_last_adaptation)
@@ -587,6 +598,48 @@ namespace Hermes
       this->assign_dofs();
     }
 
+    template<typename Scalar>
+    bool Space<Scalar>::update_copied_orders(const Space<Scalar>* space, int inc)
+    {
+      _F_;
+      bool changed = false;
+      Element* e;
+      for_all_active_elements(e, space->get_mesh())
+      {
+        int o = get_copied_order(e, space->get_element_order(e->id), inc);
+
+        // the first active descendant tells the current order of the subtree
+        Element* fine = mesh->get_element(e->id);
+        Element* first = fine;
+        while (!first->active)
+        {
+          int i = 0;
+          while (first->sons[i] == NULL)
+            i++;
+          first = first->sons[i];
+        }
+
+        bool elem_changed = (edata[first->id].order != o);
+        if (elem_changed)
+        {
+          copy_orders_recurrent(fine, o);
+          changed = true;
+        }
+
+        // mark the subtree
+        if (fine->active)
+          edata[fine->id].changed_in_last_adaptation = elem_changed;
+        else
+          for (unsigned int i = 0; i < 4; i++)
+            if (fine->sons[i] != NULL && fine->sons[i]->active)
+              edata[fine->sons[i]->id].changed_in_last_adaptation = elem_changed;
+      }
+
+      if (changed)
+        seq = g_space_seq++;
+      return changed;
+    }
+
     template<typename Scalar>
     int Space<Scalar>::get_edge_order(Element* e, int edge) const
     {
@@ -718,6 +771,17 @@ namespace Hermes
       assign_edge_dofs();
       assign_bubble_dofs();
 
+      if (dof_ordering == HERMES_DOF_ORDERING_RCM)
+        order_dofs_rcm();
+      else
+        dof_permutation.clear();
+
+      std::vector<AssignedDofs> node_dofs, elem_dofs;
+      std::vector<int> step_map;
+      bool incremental = incremental_dofs && renumber_dofs_incrementally(node_dofs, elem_dofs, step_map);
+      if (incremental)
+        dof_permutation.clear();
+
       free_bc_data();
       update_essential_bc_values();
       update_constraints();
@@ -727,9 +791,627 @@ namespace Hermes
       was_assigned = true;
       this->ndof = (next_dof - first_dof) / stride;
 
+      if (incremental_dofs)
+        update_touched_dofs(incremental, node_dofs, elem_dofs, step_map);
+
       return this->ndof;
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::set_incremental_dofs(bool incremental)
+    {
+      _F_;
+      this->incremental_dofs = incremental;
+      assigned_node_dofs.clear();
+      assigned_elem_dofs.clear();
+      prev_dofs.clear();
+      touched_dofs.clear();
+      assigned_first_dof = assigned_stride = assigned_ndof = 0;
+      assignment_seq = prev_assignment_seq = -1;
+      if (incremental && was_assigned)
+        assign_dofs(first_dof, stride);
+    }
+
+    template<typename Scalar>
+    const Hermes::vector<int>& Space<Scalar>::get_touched_dofs() const
+    {
+      if (!incremental_dofs)
+        error("The incremental assignment of DOFs is not turned on, see Space::set_incremental_dofs().");
+      return touched_dofs;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::transfer_coefficients(const Scalar* prev_coeff_vec, Scalar* coeff_vec) const
+    {
+      _F_;
+      if (!incremental_dofs)
+        error("The incremental assignment of DOFs is not turned on, see Space::set_incremental_dofs().");
+      for (int i = 0; i < ndof; i++)
+        coeff_vec[first_dof + i * stride] = (prev_dofs[i] >= 0) ? prev_coeff_vec[prev_dofs[i]] : (Scalar) 0;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::set_dof_ordering(DofOrdering ordering)
+    {
+      _F_;
+      this->dof_ordering = ordering;
+      if (was_assigned)
+      {
+        assign_dofs(first_dof, stride);
+        // The numbers of the DOFs changed.
+        seq = g_space_seq++;
+      }
+    }
+
+    template<typename Scalar>
+    DofOrdering Space<Scalar>::get_dof_ordering() const
+    {
+      return dof_ordering;
+    }
+
+    template<typename Scalar>
+    const std::vector<int>& Space<Scalar>::get_dof_permutation() const
+    {
+      return dof_permutation;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::get_dof_blocks(Hermes::vector<Space<Scalar>*> spaces, std::vector<std::vector<int> >& blocks, bool element_blocks)
+    {
+      _F_;
+      blocks.clear();
+      AsmList<Scalar> al;
+      Element* e;
+      for (unsigned int s = 0; s < spaces.size(); s++)
+      {
+        // The elements whose assembly lists contain each DOF, in the order of the elements.
+        std::map<int, std::vector<int> > support;
+        for_all_active_elements(e, spaces[s]->get_mesh())
+        {
+          spaces[s]->get_element_assembly_list(e, &al);
+          for (unsigned int i = 0; i < al.cnt; i++)
+          {
+            if (al.dof[i] < 0)
+              continue;
+            std::vector<int>& elems = support[al.dof[i]];
+            if (elems.empty() || elems.back() != e->id)
+              elems.push_back(e->id);
+          }
+        }
+
+        std::map<std::vector<int>, int> block_index;
+        for (std::map<int, std::vector<int> >::iterator it = support.begin(); it != support.end(); it++)
+        {
+          std::vector<int> key;
+          if (element_blocks)
+            key.push_back(it->second.front());
+          else
+          {
+            key = it->second;
+            std::sort(key.begin(), key.end());
+          }
+          std::map<std::vector<int>, int>::iterator b = block_index.find(key);
+          if (b == block_index.end())
+          {
+            b = block_index.insert(std::pair<std::vector<int>, int>(key, blocks.size())).first;
+            blocks.push_back(std::vector<int>());
+          }
+          blocks[b->second].push_back(it->first);
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::get_order_hierarchy(Hermes::vector<Space<Scalar>*> spaces, std::vector<std::vector<int> >& levels)
+    {
+      _F_;
+      levels.clear();
+      for (unsigned int s = 0; s < spaces.size(); s++)
+        if (spaces[s]->get_type() != HERMES_H1_SPACE)
+          error("The order hierarchy is available only for H1 spaces.");
+
+      Hermes::vector<Space<Scalar>*> finer = spaces;
+      AsmList<Scalar> finer_al, coarser_al;
+      Element* e;
+      while (true)
+      {
+        // The coarsest level has the order 1 on all elements.
+        bool coarsest = true;
+        for (unsigned int s = 0; s < finer.size() && coarsest; s++)
+          for_all_active_elements(e, finer[s]->get_mesh())
+          {
+            int o = finer[s]->get_element_order(e->id);
+            if (std::max(H2D_GET_H_ORDER(o), H2D_GET_V_ORDER(o)) > 1)
+            {
+              coarsest = false;
+              break;
+            }
+          }
+        if (coarsest)
+          break;
+
+        Hermes::vector<Space<Scalar>*> coarser;
+        for (unsigned int s = 0; s < finer.size(); s++)
+          coarser.push_back(finer[s]->dup(finer[s]->get_mesh(), -1));
+        int ndof = Space<Scalar>::assign_dofs(coarser);
+
+        // A basis function of the coarser level is the basis function of the finer level with the same shape
+        // function on an element where it is not constrained, i.e. its shape function has a single entry in
+        // the assembly list (with the same coefficient).
+        std::vector<int> finer_dofs(ndof, -1);
+        for (unsigned int s = 0; s < coarser.size(); s++)
+          for_all_active_elements(e, coarser[s]->get_mesh())
+          {
+            finer[s]->get_element_assembly_list(e, &finer_al);
+            coarser[s]->get_element_assembly_list(e, &coarser_al);
+            std::map<int, int> finer_entry, coarser_entry;
+            for (unsigned int i = 0; i < finer_al.cnt; i++)
+              finer_entry[finer_al.idx[i]] = finer_entry.count(finer_al.idx[i]) ? -1 : i;
+            for (unsigned int i = 0; i < coarser_al.cnt; i++)
+              coarser_entry[coarser_al.idx[i]] = coarser_entry.count(coarser_al.idx[i]) ? -1 : i;
+
+            for (std::map<int, int>::iterator it = coarser_entry.begin(); it != coarser_entry.end(); it++)
+            {
+              int i = it->second;
+              if (i < 0 || coarser_al.dof[i] < 0 || finer_dofs[coarser_al.dof[i]] >= 0)
+                continue;
+              std::map<int, int>::iterator fit = finer_entry.find(it->first);
+              if (fit == finer_entry.end() || fit->second < 0)
+                continue;
+              int j = fit->second;
+              if (finer_al.dof[j] >= 0 && std::abs(finer_al.coef[j] - coarser_al.coef[i]) <= 1e-12 * std::abs(finer_al.coef[j]))
+                finer_dofs[coarser_al.dof[i]] = finer_al.dof[j];
+            }
+          }
+
+        for (int i = 0; i < ndof; i++)
+          if (finer_dofs[i] < 0)
+            error("The DOF %d of the order hierarchy is not a DOF of the finer level, the shapeset has to be hierarchical.", i);
+        levels.push_back(finer_dofs);
+
+        if (levels.size() > 1)
+          for (unsigned int s = 0; s < finer.size(); s++)
+            delete finer[s];
+        finer = coarser;
+      }
+
+      if (!levels.empty())
+        for (unsigned int s = 0; s < finer.size(); s++)
+          delete finer[s];
+    }
+
+    /// Breadth-first search of the graph (adj_start, adj) from the vertex root, marks the visited vertices by stamp
+    /// and stores them in the order of the search. Returns the number of levels, last_level is the index
+    /// in visited of the first vertex of the last level.
+    static int bfs_levels(const std::vector<int>& adj_start, const std::vector<int>& adj, int root,
+      std::vector<int>& mark, int stamp, std::vector<int>& visited, int& last_level)
+    {
+      visited.clear();
+      visited.push_back(root);
+      mark[root] = stamp;
+      int levels = 0;
+      unsigned int begin = 0;
+      while (begin < visited.size())
+      {
+        unsigned int end = visited.size();
+        last_level = begin;
+        levels++;
+        for (unsigned int i = begin; i < end; i++)
+          for (int k = adj_start[visited[i]]; k < adj_start[visited[i] + 1]; k++)
+            if (mark[adj[k]] != stamp)
+            {
+              mark[adj[k]] = stamp;
+              visited.push_back(adj[k]);
+            }
+        begin = end;
+      }
+      return levels;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::order_dofs_rcm()
+    {
+      _F_;
+      int num = (next_dof - first_dof) / stride;
+
+      // The blocks of consecutive DOFs: of the nodes and of the bubbles of the elements.
+      std::vector<int> node_block(mesh->get_max_node_id(), -1), elem_block(mesh->get_max_element_id(), -1);
+      std::vector<int> block_dof, block_n;
+      int total = 0;
+      Node* nd;
+      for_all_nodes(nd, mesh)
+      {
+        int n = nd->type ? ndata[nd->id].n : 1;
+        if (ndata[nd->id].dof >= 0 && n > 0)
+        {
+          node_block[nd->id] = block_dof.size();
+          block_dof.push_back((ndata[nd->id].dof - first_dof) / stride);
+          block_n.push_back(n);
+          total += n;
+        }
+      }
+      Element* e;
+      for_all_active_elements(e, mesh)
+        if (edata[e->id].n > 0)
+        {
+          elem_block[e->id] = block_dof.size();
+          block_dof.push_back((edata[e->id].bdof - first_dof) / stride);
+          block_n.push_back(edata[e->id].n);
+          total += edata[e->id].n;
+        }
+      int nb = block_dof.size();
+      dof_permutation.clear();
+      if (total != num)
+      {
+        warn("The DOFs of the space could not be reordered.");
+        return;
+      }
+
+      // The blocks of each element, including the bubbles of the neighbors (they are coupled in DG).
+      std::vector<int> elem_start(1, 0), elem_blocks;
+      for_all_active_elements(e, mesh)
+      {
+        for (unsigned int i = 0; i < e->get_num_surf(); i++)
+        {
+          if (node_block[e->vn[i]->id] >= 0)
+            elem_blocks.push_back(node_block[e->vn[i]->id]);
+          if (node_block[e->en[i]->id] >= 0)
+            elem_blocks.push_back(node_block[e->en[i]->id]);
+          for (int k = 0; k < 2; k++)
+          {
+            Element* neighbor = e->en[i]->elem[k];
+            if (neighbor != NULL && neighbor != e && neighbor->active && elem_block[neighbor->id] >= 0)
+              elem_blocks.push_back(elem_block[neighbor->id]);
+          }
+        }
+        if (elem_block[e->id] >= 0)
+          elem_blocks.push_back(elem_block[e->id]);
+        elem_start.push_back(elem_blocks.size());
+      }
+
+      // The adjacency graph of the blocks.
+      std::vector<int> adj_start(nb + 1, 0);
+      for (unsigned int i = 0; i + 1 < elem_start.size(); i++)
+        for (int k = elem_start[i]; k < elem_start[i + 1]; k++)
+          adj_start[elem_blocks[k] + 1] += elem_start[i + 1] - elem_start[i] - 1;
+      for (int b = 0; b < nb; b++)
+        adj_start[b + 1] += adj_start[b];
+      std::vector<int> adj(adj_start[nb]), adj_end(adj_start.begin(), adj_start.end() - 1);
+      for (unsigned int i = 0; i + 1 < elem_start.size(); i++)
+        for (int k = elem_start[i]; k < elem_start[i + 1]; k++)
+          for (int l = elem_start[i]; l < elem_start[i + 1]; l++)
+            if (elem_blocks[l] != elem_blocks[k])
+              adj[adj_end[elem_blocks[k]]++] = elem_blocks[l];
+      int cnt = 0;
+      for (int b = 0; b < nb; b++)
+      {
+        std::sort(adj.begin() + adj_start[b], adj.begin() + adj_end[b]);
+        int start = cnt;
+        for (int k = adj_start[b]; k < adj_end[b]; k++)
+          if (cnt == start || adj[cnt - 1] != adj[k])
+            adj[cnt++] = adj[k];
+        adj_start[b] = start;
+      }
+      adj_start[nb] = cnt;
+
+      // Cuthill-McKee ordering of each connected component, starting from a pseudo-peripheral block
+      // (George and Liu), the neighbors are visited by increasing degree.
+      std::vector<int> mark(nb, -1), order, visited, neighbors;
+      std::vector<std::pair<int, int> > by_degree;
+      order.reserve(nb);
+      int stamp = 0;
+      for (int b = 0; b < nb; b++)
+      {
+        if (mark[b] == -2)
+          continue;
+        int root = b, last_level;
+        int levels = bfs_levels(adj_start, adj, root, mark, stamp++, visited, last_level);
+        while (true)
+        {
+          int candidate = visited[last_level];
+          for (unsigned int i = last_level; i < visited.size(); i++)
+            if (adj_start[visited[i] + 1] - adj_start[visited[i]] < adj_start[candidate + 1] - adj_start[candidate])
+              candidate = visited[i];
+          int candidate_levels = bfs_levels(adj_start, adj, candidate, mark, stamp++, visited, last_level);
+          if (candidate_levels <= levels)
+            break;
+          root = candidate;
+          levels = candidate_levels;
+        }
+
+        unsigned int begin = order.size();
+        order.push_back(root);
+        mark[root] = -2;
+        for (unsigned int i = begin; i < order.size(); i++)
+        {
+          by_degree.clear();
+          for (int k = adj_start[order[i]]; k < adj_start[order[i] + 1]; k++)
+            if (mark[adj[k]] != -2)
+            {
+              mark[adj[k]] = -2;
+              by_degree.push_back(std::pair<int, int>(adj_start[adj[k] + 1] - adj_start[adj[k]], adj[k]));
+            }
+          std::sort(by_degree.begin(), by_degree.end());
+          for (unsigned int k = 0; k < by_degree.size(); k++)
+            order.push_back(by_degree[k].second);
+        }
+      }
+
+      // Number the blocks in the reverse order.
+      dof_permutation.assign(num, -1);
+      std::vector<int> new_dof(nb);
+      int next = 0;
+      for (int i = nb - 1; i >= 0; i--)
+      {
+        int b = order[i];
+        new_dof[b] = next;
+        for (int j = 0; j < block_n[b]; j++)
+          dof_permutation[block_dof[b] + j] = next + j;
+        next += block_n[b];
+      }
+      for_all_nodes(nd, mesh)
+        if (node_block[nd->id] >= 0)
+          ndata[nd->id].dof = first_dof + new_dof[node_block[nd->id]] * stride;
+      for_all_active_elements(e, mesh)
+        if (elem_block[e->id] >= 0)
+          edata[e->id].bdof = first_dof + new_dof[elem_block[e->id]] * stride;
+    }
+
+    template<typename Scalar>
+    bool Space<Scalar>::renumber_dofs_incrementally(std::vector<AssignedDofs>& node_dofs, std::vector<AssignedDofs>& elem_dofs, std::vector<int>& step_map)
+    {
+      _F_;
+      int num = (next_dof - first_dof) / stride;
+      AssignedDofs empty;
+      empty.key[0] = empty.key[1] = empty.key[2] = -1;
+      empty.dof = -1;
+      empty.n = 0;
+      empty.hash = 0;
+
+      // DOFs of the nodes and elements, as assigned by assign_*_dofs().
+      node_dofs.assign(mesh->get_max_node_id(), empty);
+      Node* nd;
+      for_all_nodes(nd, mesh)
+      {
+        AssignedDofs* ad = &node_dofs[nd->id];
+        ad->key[0] = nd->type;
+        ad->key[1] = nd->p1;
+        ad->key[2] = nd->p2;
+        int n = nd->type ? ndata[nd->id].n : 1;
+        if (ndata[nd->id].dof >= 0 && n > 0)
+        {
+          ad->dof = (ndata[nd->id].dof - first_dof) / stride;
+          ad->n = n;
+        }
+      }
+      elem_dofs.assign(mesh->get_max_element_id(), empty);
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        AssignedDofs* ad = &elem_dofs[e->id];
+        ad->key[0] = e->get_nvert();
+        ad->key[1] = e->vn[0]->id;
+        ad->key[2] = e->vn[1]->id;
+        if (edata[e->id].n > 0)
+        {
+          ad->dof = (edata[e->id].bdof - first_dof) / stride;
+          ad->n = edata[e->id].n;
+        }
+      }
+      step_map.assign(num, -1);
+      if (assigned_stride != stride)
+        return false;
+
+      // Keep the DOFs of the nodes and elements which had the same number of DOFs before.
+      std::vector<AssignedDofs*> blocks;
+      std::vector<int> prev_first;
+      std::vector<bool> used(assigned_ndof, false);
+      int total = 0;
+      for (int k = 0; k < 2; k++)
+      {
+        std::vector<AssignedDofs>& current = k ? elem_dofs : node_dofs;
+        std::vector<AssignedDofs>& assigned = k ? assigned_elem_dofs : assigned_node_dofs;
+        for (unsigned int i = 0; i < current.size(); i++)
+        {
+          AssignedDofs* ad = &current[i];
+          if (ad->n == 0)
+            continue;
+          total += ad->n;
+          int prev = -1;
+          if (i < assigned.size() && assigned[i].n == ad->n && assigned[i].key[0] == ad->key[0]
+            && assigned[i].key[1] == ad->key[1] && assigned[i].key[2] == ad->key[2])
+          {
+            prev = assigned[i].dof;
+            for (int j = 0; j < ad->n; j++)
+              used[prev + j] = true;
+          }
+          blocks.push_back(ad);
+          prev_first.push_back(prev);
+        }
+      }
+      if (total != num)
+        return false;
+      for (unsigned int b = 0; b < blocks.size(); b++)
+        blocks[b]->dof = prev_first[b];
+
+      // The kept DOFs behind the new number of DOFs have to be moved.
+      std::vector<int> owner(num, -1);
+      std::vector<std::pair<int, int> > moved;
+      for (unsigned int b = 0; b < blocks.size(); b++)
+        if (blocks[b]->dof >= 0 && blocks[b]->dof + blocks[b]->n <= num)
+          for (int j = 0; j < blocks[b]->n; j++)
+            owner[blocks[b]->dof + j] = b;
+        else
+          moved.push_back(std::pair<int, int>(-blocks[b]->n, b));
+      std::sort(moved.begin(), moved.end());
+
+      // Gaps (by size) below the free space at the end.
+      int tail = num;
+      while (tail > 0 && owner[tail - 1] < 0)
+        tail--;
+      std::multimap<int, int> gaps;
+      for (int i = 0; i < tail; i++)
+        if (owner[i] < 0)
+        {
+          int start = i;
+          while (owner[i] < 0)
+            i++;
+          gaps.insert(std::pair<int, int>(i - start, start));
+        }
+
+      // The moved and the new DOFs are put into the gaps (the largest ones first, each into the smallest
+      // gap it fits in). The ones that do not fit are put at the end. If there is not enough space
+      // there, the last DOFs are moved into the gaps (or to the end) too.
+      std::vector<int> pending;
+      int pending_size = 0;
+      unsigned int next = 0;
+      while (next < moved.size() || num - tail < pending_size)
+      {
+        int b;
+        if (next < moved.size())
+          b = moved[next++].second;
+        else
+        {
+          // Release the last DOFs before the end, together with the gap before them.
+          b = owner[tail - 1];
+          for (int j = 0; j < blocks[b]->n; j++)
+            owner[blocks[b]->dof + j] = -1;
+          tail = blocks[b]->dof;
+          if (tail > 0 && owner[tail - 1] < 0)
+          {
+            int start = tail;
+            while (start > 0 && owner[start - 1] < 0)
+              start--;
+            std::pair<std::multimap<int, int>::iterator, std::multimap<int, int>::iterator> range = gaps.equal_range(tail - start);
+            for (std::multimap<int, int>::iterator it = range.first; it != range.second; it++)
+              if (it->second == start)
+              {
+                gaps.erase(it);
+                break;
+              }
+            tail = start;
+          }
+        }
+
+        std::multimap<int, int>::iterator it = gaps.lower_bound(blocks[b]->n);
+        if (it == gaps.end())
+        {
+          pending.push_back(b);
+          pending_size += blocks[b]->n;
+          continue;
+        }
+        blocks[b]->dof = it->second;
+        for (int j = 0; j < blocks[b]->n; j++)
+          owner[it->second + j] = b;
+        if (it->first > blocks[b]->n)
+          gaps.insert(std::pair<int, int>(it->first - blocks[b]->n, it->second + blocks[b]->n));
+        gaps.erase(it);
+      }
+      for (unsigned int i = 0; i < pending.size(); i++)
+      {
+        blocks[pending[i]]->dof = tail;
+        tail += blocks[pending[i]]->n;
+      }
+
+      for (unsigned int b = 0; b < blocks.size(); b++)
+        if (prev_first[b] >= 0)
+          for (int j = 0; j < blocks[b]->n; j++)
+            step_map[blocks[b]->dof + j] = prev_first[b] + j;
+
+      // Store the new numbers.
+      for_all_nodes(nd, mesh)
+        if (node_dofs[nd->id].n > 0)
+          ndata[nd->id].dof = first_dof + node_dofs[nd->id].dof * stride;
+      for_all_active_elements(e, mesh)
+        if (elem_dofs[e->id].n > 0)
+          edata[e->id].bdof = first_dof + elem_dofs[e->id].dof * stride;
+      return true;
+    }
+
+    static unsigned int hash_bytes(unsigned int hash, const void* data, size_t size)
+    {
+      // FNV-1a.
+      const unsigned char* bytes = (const unsigned char*) data;
+      for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+      return hash;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::update_touched_dofs(bool incremental, std::vector<AssignedDofs>& node_dofs, std::vector<AssignedDofs>& elem_dofs, const std::vector<int>& step_map)
+    {
+      _F_;
+      // An element whose assembly list changed touches all its DOFs, the DOFs of the unchanged
+      // elements have the same basis functions (and therefore the same matrix entries) as before.
+      std::vector<bool> touched(ndof, !incremental);
+      AsmList<Scalar> al;
+      Element* e;
+      for_all_active_elements(e, mesh)
+      {
+        get_element_assembly_list(e, &al);
+        unsigned int hash = 2166136261u;
+        for (unsigned int i = 0; i < al.cnt; i++)
+          if (al.dof[i] >= 0)
+          {
+            hash = hash_bytes(hash, &al.idx[i], sizeof(int));
+            hash = hash_bytes(hash, &al.dof[i], sizeof(int));
+            hash = hash_bytes(hash, &al.coef[i], sizeof(Scalar));
+          }
+        AssignedDofs* ad = &elem_dofs[e->id];
+        ad->hash = hash;
+
+        if (incremental)
+        {
+          bool changed = true;
+          if ((unsigned int) e->id < assigned_elem_dofs.size())
+          {
+            AssignedDofs* prev = &assigned_elem_dofs[e->id];
+            changed = prev->hash != hash || prev->key[0] != ad->key[0] || prev->key[1] != ad->key[1] || prev->key[2] != ad->key[2];
+          }
+          if (changed)
+            for (unsigned int i = 0; i < al.cnt; i++)
+              if (al.dof[i] >= 0)
+                touched[(al.dof[i] - first_dof) / stride] = true;
+        }
+      }
+
+      // If the space did not change since the last assignment, the touched DOFs and the previous
+      // DOFs are still related to the assignment before that one.
+      bool repeated = incremental && seq == assignment_seq;
+      std::vector<int> new_prev_dofs(ndof, -1);
+      for (int i = 0; i < ndof; i++)
+        if (step_map[i] >= 0)
+          new_prev_dofs[i] = repeated ? prev_dofs[step_map[i]] : assigned_first_dof + step_map[i] * stride;
+      if (repeated)
+      {
+        std::vector<int> inverse_map(assigned_ndof, -1);
+        for (int i = 0; i < ndof; i++)
+          if (step_map[i] >= 0)
+            inverse_map[step_map[i]] = i;
+        for (unsigned int i = 0; i < touched_dofs.size(); i++)
+        {
+          int prev = inverse_map[(touched_dofs[i] - assigned_first_dof) / stride];
+          if (prev >= 0)
+            touched[prev] = true;
+        }
+      }
+      else
+        prev_assignment_seq = incremental ? assignment_seq : -1;
+      assignment_seq = seq;
+      prev_dofs.swap(new_prev_dofs);
+
+      touched_dofs.clear();
+      for (int i = 0; i < ndof; i++)
+        if (touched[i])
+          touched_dofs.push_back(first_dof + i * stride);
+
+      assigned_node_dofs.swap(node_dofs);
+      assigned_elem_dofs.swap(elem_dofs);
+      assigned_first_dof = first_dof;
+      assigned_stride = stride;
+      assigned_ndof = ndof;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::reset_dof_assignment()
     {
@@ -987,7 +1669,58 @@ namespace Hermes
       return;
     }
 
+    template<typename Scalar>
+    RefinedSpaceBuilder<Scalar>::RefinedSpaceBuilder(Space<Scalar>* coarse, int order_increase, int refinement_type)
+      : coarse(coarse), order_increase(order_increase), refinement_type(refinement_type), ref_mesh(NULL), ref_space(NULL), coarse_mesh_seq(0)
+    {
+      _F_;
+      if (coarse == NULL) throw Hermes::Exceptions::NullException(1);
+    }
+
+    template<typename Scalar>
+    RefinedSpaceBuilder<Scalar>::~RefinedSpaceBuilder()
+    {
+      _F_;
+      delete ref_space;
+      delete ref_mesh;
+    }
+
+    template<typename Scalar>
+    Space<Scalar>* RefinedSpaceBuilder<Scalar>::get_refined_space()
+    {
+      _F_;
+      Mesh* coarse_mesh = coarse->get_mesh();
+      if (ref_space == NULL)
+      {
+        ref_mesh = new Mesh;
+        ref_mesh->copy(coarse_mesh);
+        ref_mesh->refine_all_elements(refinement_type);
+        ref_space = coarse->dup(ref_mesh, order_increase);
+      }
+      else if (coarse_mesh->get_seq() != coarse_mesh_seq)
+      {
+        // The coarse mesh changed, rebuild the reference mesh and distribute the orders.
+        ref_mesh->copy(coarse_mesh);
+        ref_mesh->refine_all_elements(refinement_type);
+
+        ref_space->resize_tables();
+        for (int i = 0; i < ref_space->esize; i++)
+        {
+          ref_space->edata[i].order = -1;
+          ref_space->edata[i].changed_in_last_adaptation = false;
+        }
+        ref_space->copy_orders(coarse, order_increase);
+      }
+      else if (ref_space->update_copied_orders(coarse, order_increase))
+        ref_space->assign_dofs();
+
+      coarse_mesh_seq = coarse_mesh->get_seq();
+      return ref_space;
+    }
+
     template class HERMES_API Space<double>;
     template class HERMES_API Space<std::complex<double> >;
+    template class HERMES_API RefinedSpaceBuilder<double>;
+    template class HERMES_API RefinedSpaceBuilder<std::complex<double> >;
   }
 }
@@ -56,6 +56,8 @@ namespace Hermes
     {
       areas.push_back(area);
       stage_time = 0.0;
+      order_memoization = true;
+      load_case = 0;
     }
 
     template<typename Scalar>
@@ -65,6 +67,8 @@ namespace Hermes
     {
       this->areas = areas;
       stage_time = 0.0;
+      order_memoization = true;
+      load_case = 0;
     }
 
     template<typename Scalar>
@@ -79,6 +83,18 @@ namespace Hermes
       return stage_time;
     }
 
+    template<typename Scalar>
+    void Form<Scalar>::set_order_memoization(bool order_memoization)
+    {
+      this->order_memoization = order_memoization;
+    }
+
+    template<typename Scalar>
+    bool Form<Scalar>::get_order_memoization() const
+    {
+      return order_memoization;
+    }
+
     template<typename Scalar>
     MatrixFormVol<Scalar>::MatrixFormVol(unsigned int i, unsigned int j,
       std::string area, SymFlag sym, Hermes::vector<MeshFunction<Scalar>*> ext, double scaling_factor, int u_ext_offset) :
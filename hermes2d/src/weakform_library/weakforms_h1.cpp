@@ -72,6 +72,16 @@ namespace Hermes
         Geom<double> *e, ExtData<Scalar> *ext) const
       {
         Scalar result = 0;
+        if (coeff->is_constant()) {
+          // Constant coefficient, the integral is evaluated by the vectorized kernels.
+          Scalar const_coeff = coeff->value(e->x[0], e->y[0]);
+          if (gt == HERMES_PLANAR)
+            return const_coeff * int_u_v<double, Scalar>(n, wt, u, v);
+          else if (gt == HERMES_AXISYM_X)
+            return const_coeff * int_y_u_v<double, Scalar>(n, wt, u, v, e);
+          else
+            return const_coeff * int_x_u_v<double, Scalar>(n, wt, u, v, e);
+        }
         if (gt == HERMES_PLANAR) {
           for (int i = 0; i < n; i++) {
             result += wt[i] * coeff->value(e->x[i], e->y[i]) * u->val[i] * v->val[i];
@@ -157,6 +167,16 @@ namespace Hermes
         Func<double> *v, Geom<double> *e, ExtData<Scalar> *ext) const
       {
         Scalar result = 0;
+        if (coeff->is_constant()) {
+          // Constant coefficient (its derivative is zero), the integral is evaluated by the vectorized kernels.
+          Scalar const_coeff = coeff->value(Scalar(0.0));
+          if (gt == HERMES_PLANAR)
+            return const_coeff * int_grad_u_grad_v<double, Scalar>(n, wt, u, v);
+          else if (gt == HERMES_AXISYM_X)
+            return const_coeff * int_y_grad_u_grad_v<double, Scalar>(n, wt, u, v, e);
+          else
+            return const_coeff * int_x_grad_u_grad_v<double, Scalar>(n, wt, u, v, e);
+        }
         if (gt == HERMES_PLANAR) {
           for (int i = 0; i < n; i++) {
             result += wt[i] * (coeff->derivative(u_ext[idx_j]->val[i]) * u->val[i] *
@@ -420,6 +440,16 @@ namespace Hermes
         Geom<double> *e, ExtData<Scalar> *ext) const
       {
         Scalar result = 0;
+        if (coeff->is_constant()) {
+          // Constant coefficient, the integral is evaluated by the vectorized kernels.
+          Scalar const_coeff = coeff->value(e->x[0], e->y[0]);
+          if (gt == HERMES_PLANAR)
+            return const_coeff * int_u_ext_v<double, Scalar>(n, wt, u_ext[idx_i], v);
+          else if (gt == HERMES_AXISYM_X)
+            return const_coeff * int_y_u_ext_v<double, Scalar>(n, wt, u_ext[idx_i], v, e);
+          else
+            return const_coeff * int_x_u_ext_v<double, Scalar>(n, wt, u_ext[idx_i], v, e);
+        }
         if (gt == HERMES_PLANAR) {
           for (int i = 0; i < n; i++) {
             result += wt[i] * coeff->value(e->x[i], e->y[i]) * u_ext[idx_i]->val[i] * v->val[i];
@@ -503,6 +533,16 @@ namespace Hermes
         Geom<double> *e, ExtData<Scalar> *ext) const
       {
         Scalar result = 0;
+        if (coeff->is_constant()) {
+          // Constant coefficient, the integral is evaluated by the vectorized kernels.
+          Scalar const_coeff = coeff->value(Scalar(0.0));
+          if (gt == HERMES_PLANAR)
+            return const_coeff * int_grad_u_ext_grad_v<double, Scalar>(n, wt, u_ext[idx_i], v);
+          else if (gt == HERMES_AXISYM_X)
+            return const_coeff * int_y_grad_u_ext_grad_v<double, Scalar>(n, wt, u_ext[idx_i], v, e);
+          else
+            return const_coeff * int_x_grad_u_ext_grad_v<double, Scalar>(n, wt, u_ext[idx_i], v, e);
+        }
         if (gt == HERMES_PLANAR) {
           for (int i = 0; i < n; i++) {
             result += wt[i] * coeff->value(u_ext[idx_i]->val[i])
@@ -0,0 +1,119 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a test of the threaded error calculation (Adapt::set_num_threads()). The errors of a
+// system of two components on differently refined meshes, with an error form coupling the
+// components, are calculated serially and by 2, 3 and 4 threads, for all combinations of the
+// absolute and relative total and element errors. The coarse and the reference solutions are given
+// by coefficient vectors, no problem is solved. The test fails if the total errors, the errors of
+// the components (calc_err_est(), calc_err_exact()) or the errors of the elements are not bitwise
+// identical to the serial ones.
+
+const int INIT_REF_NUM = 2;                       // Number of initial uniform refinements of the meshes.
+const int P_INIT = 2;                             // Polynomial degree of the first space.
+const int MAX_THREADS = 4;                        // Maximum number of threads of the error calculation.
+
+/// Sets sln to the function in the space given by the coefficient vector sin(a * i) / (1 + 0.01 i).
+void init_solution(Space<double>* space, double a, Solution<double>* sln)
+{
+  int ndof = space->get_num_dofs();
+  double* coeff_vec = new double[ndof];
+  for (int i = 0; i < ndof; i++)
+    coeff_vec[i] = std::sin(a * i) / (1.0 + 0.01 * i);
+  Solution<double>::vector_to_solution(coeff_vec, space, sln);
+  delete [] coeff_vec;
+}
+
+/// Calculates the errors by num_threads threads, returns false if they differ from the serial ones.
+bool compare(Hermes::vector<Space<double>*> spaces, Hermes::vector<Solution<double>*> slns,
+  Hermes::vector<Solution<double>*> ref_slns, unsigned int error_flags, int num_threads)
+{
+  Adapt<double>::MatrixFormVolError coupling(0, 1, HERMES_L2_NORM);
+
+  Adapt<double> adaptivity(spaces);
+  adaptivity.set_error_form(0, 1, &coupling);
+  Hermes::vector<double> component_errors;
+  double err_est = adaptivity.calc_err_est(slns, ref_slns, &component_errors, true, error_flags);
+  Hermes::vector<double> component_errors_exact;
+  double err_exact = adaptivity.calc_err_exact(slns, ref_slns, &component_errors_exact, false, error_flags);
+
+  Adapt<double> adaptivity_threaded(spaces);
+  adaptivity_threaded.set_error_form(0, 1, &coupling);
+  adaptivity_threaded.set_num_threads(num_threads);
+  Hermes::vector<double> component_errors_threaded;
+  double err_est_threaded = adaptivity_threaded.calc_err_est(slns, ref_slns, &component_errors_threaded, true, error_flags);
+  Hermes::vector<double> component_errors_exact_threaded;
+  double err_exact_threaded = adaptivity_threaded.calc_err_exact(slns, ref_slns, &component_errors_exact_threaded, false, error_flags);
+
+  info("Flags %#x, %d threads: err_est %g, err_exact %g.", error_flags, num_threads, err_est, err_exact);
+  if (err_est != err_est_threaded || err_exact != err_exact_threaded)
+    return false;
+  for (unsigned int i = 0; i < spaces.size(); i++)
+    if (component_errors[i] != component_errors_threaded[i] || component_errors_exact[i] != component_errors_exact_threaded[i])
+      return false;
+  for (unsigned int i = 0; i < spaces.size(); i++)
+  {
+    Element* e;
+    for_all_active_elements(e, spaces[i]->get_mesh())
+      if (adaptivity.get_element_error_squared(i, e->id) != adaptivity_threaded.get_element_error_squared(i, e->id))
+        return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh_u, mesh_v;
+  MeshReaderH2D mloader;
+  mloader.load("square_quad.mesh", &mesh_u);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh_u.refine_all_elements();
+  mesh_v.copy(&mesh_u);
+  mesh_u.refine_towards_vertex(0, 2);
+  mesh_v.refine_towards_vertex(2, 3);
+
+  H1Space<double> space_u(&mesh_u, P_INIT);
+  H1Space<double> space_v(&mesh_v, P_INIT + 1);
+  Hermes::vector<Space<double>*> spaces(&space_u, &space_v);
+
+  Space<double>* ref_space_u = Space<double>::construct_refined_space(&space_u);
+  Space<double>* ref_space_v = Space<double>::construct_refined_space(&space_v);
+
+  Solution<double> sln_u, sln_v, ref_sln_u, ref_sln_v;
+  init_solution(&space_u, 0.7, &sln_u);
+  init_solution(&space_v, 1.1, &sln_v);
+  init_solution(ref_space_u, 1.3, &ref_sln_u);
+  init_solution(ref_space_v, 0.9, &ref_sln_v);
+  Hermes::vector<Solution<double>*> slns(&sln_u, &sln_v);
+  Hermes::vector<Solution<double>*> ref_slns(&ref_sln_u, &ref_sln_v);
+
+  const int num_flags = 4;
+  unsigned int error_flags[num_flags] = {
+    HERMES_TOTAL_ERROR_REL | HERMES_ELEMENT_ERROR_REL, HERMES_TOTAL_ERROR_ABS | HERMES_ELEMENT_ERROR_ABS,
+    HERMES_TOTAL_ERROR_REL | HERMES_ELEMENT_ERROR_ABS, HERMES_TOTAL_ERROR_ABS | HERMES_ELEMENT_ERROR_REL };
+
+  bool success = true;
+  for (int i = 0; i < num_flags; i++)
+    for (int num_threads = 2; num_threads <= MAX_THREADS; num_threads++)
+      if (!compare(spaces, slns, ref_slns, error_flags[i], num_threads))
+        success = false;
+
+  delete ref_space_u->get_mesh();
+  delete ref_space_u;
+  delete ref_space_v->get_mesh();
+  delete ref_space_v;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
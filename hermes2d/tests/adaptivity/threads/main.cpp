@@ -0,0 +1,125 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::RefinementSelectors;
+
+// This is a test of the threaded adaptivity (Adapt::set_num_threads()). Two copies of a coarse
+// space are adapted with respect to the same reference solution, one serially and one by
+// NUM_THREADS threads, in NUM_STEPS steps. The coarse and the reference solutions are given by
+// coefficient vectors, no problem is solved. The test fails if the total errors (calc_err_est(),
+// calc_err_exact()) or the errors of the elements are not bitwise identical, or if the two
+// adaptivities do not give the same refinements of the elements and the same polynomial orders.
+
+const int INIT_REF_NUM = 2;                       // Number of initial uniform refinements of the mesh.
+const int P_INIT = 2;                             // Initial polynomial degree of the spaces.
+const int NUM_STEPS = 3;                          // Number of adaptivity steps.
+const int NUM_THREADS = 4;                        // Number of threads of the threaded adaptivity.
+const double THRESHOLD = 0.3;                     // Parameter of the adaptive strategy.
+const int STRATEGY = 0;                           // Adaptive strategy.
+const CandList CAND_LIST = H2D_HP_ANISO;          // Candidates of the refinements.
+const double CONV_EXP = 1.0;                      // Parameter of the selection of the candidates.
+
+/// Returns false if the meshes or the orders of the elements in the spaces differ.
+bool compare(Space<double>* space, Space<double>* space_threaded)
+{
+  Mesh* mesh = space->get_mesh();
+  Mesh* mesh_threaded = space_threaded->get_mesh();
+  if (mesh->get_max_element_id() != mesh_threaded->get_max_element_id()
+    || mesh->get_num_active_elements() != mesh_threaded->get_num_active_elements())
+    return false;
+  for (int id = 0; id < mesh->get_max_element_id(); id++)
+  {
+    Element* e = mesh->get_element(id);
+    Element* f = mesh_threaded->get_element(id);
+    if (e->used != f->used)
+      return false;
+    if (!e->used)
+      continue;
+    if (e->active != f->active)
+      return false;
+    if (e->active && space->get_element_order(id) != space_threaded->get_element_order(id))
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh, mesh_threaded;
+  MeshReaderH2D mloader;
+  mloader.load("square_quad.mesh", &mesh);
+  mloader.load("square_quad.mesh", &mesh_threaded);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+  {
+    mesh.refine_all_elements();
+    mesh_threaded.refine_all_elements();
+  }
+
+  H1Space<double> space(&mesh, P_INIT);
+  H1Space<double> space_threaded(&mesh_threaded, P_INIT);
+
+  H1ProjBasedSelector<double> selector(CAND_LIST, CONV_EXP, H2DRS_DEFAULT_ORDER);
+
+  bool success = true;
+  for (int step = 0; step < NUM_STEPS && success; step++)
+  {
+    // Reference solution.
+    Space<double>* ref_space = Space<double>::construct_refined_space(&space);
+    int ndof_ref = ref_space->get_num_dofs();
+    double* ref_vec = new double[ndof_ref];
+    for (int i = 0; i < ndof_ref; i++)
+      ref_vec[i] = std::sin(1.3 * i) / (1.0 + 0.01 * i);
+    Solution<double> ref_sln;
+    Solution<double>::vector_to_solution(ref_vec, ref_space, &ref_sln);
+
+    // Coarse solutions (the same on both spaces).
+    int ndof = space.get_num_dofs();
+    double* coarse_vec = new double[ndof];
+    for (int i = 0; i < ndof; i++)
+      coarse_vec[i] = 0.5 * std::cos((double) i);
+    Solution<double> sln, sln_threaded;
+    Solution<double>::vector_to_solution(coarse_vec, &space, &sln);
+    Solution<double>::vector_to_solution(coarse_vec, &space_threaded, &sln_threaded);
+
+    Adapt<double> adaptivity(&space);
+    double err_exact = adaptivity.calc_err_exact(&sln, &ref_sln, false);
+    double err_est = adaptivity.calc_err_est(&sln, &ref_sln);
+
+    Adapt<double> adaptivity_threaded(&space_threaded);
+    adaptivity_threaded.set_num_threads(NUM_THREADS);
+    double err_exact_threaded = adaptivity_threaded.calc_err_exact(&sln_threaded, &ref_sln, false);
+    double err_est_threaded = adaptivity_threaded.calc_err_est(&sln_threaded, &ref_sln);
+
+    info("Step %d: %d elements, ndof %d, err_est %g, err_exact %g.", step, mesh.get_num_active_elements(),
+      space.get_num_dofs(), err_est, err_exact);
+    if (err_est != err_est_threaded || err_exact != err_exact_threaded)
+      success = false;
+    Element* e;
+    for_all_active_elements(e, &mesh)
+      if (adaptivity.get_element_error_squared(0, e->id) != adaptivity_threaded.get_element_error_squared(0, e->id))
+        success = false;
+
+    adaptivity.adapt(&selector, THRESHOLD, STRATEGY);
+    adaptivity_threaded.adapt(&selector, THRESHOLD, STRATEGY);
+    if (!compare(&space, &space_threaded))
+      success = false;
+
+    delete [] ref_vec;
+    delete [] coarse_vec;
+    delete ref_space->get_mesh();
+    delete ref_space;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -1,10 +1,319 @@
 #define HERMES_REPORT_ALL
 #include "hermes2d.h"
 
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
 // This is a test of assembling in Hermes2D.
+// The threaded assembling and the assembling without the memoization of the integration
+// orders have to produce exactly the same matrix and right-hand side as the serial one,
+// the threaded assembling with the element coloring the same up to round-off (on a curved
+// mesh with triangles, quads and hanging nodes, with previous iteration solutions and
+// an external function). The batched assembling of three load cases (serial and threaded)
+// has to produce exactly the same vectors as the assembling of each load case alone, and
+// the matrix-free application of the matrix (serial, threaded and colored) the same product
+// as the assembled matrix up to round-off.
+
+class CustomMatrixFormVol : public MatrixFormVol<double>
+{
+public:
+  CustomMatrixFormVol() : MatrixFormVol<double>(0, 0) {};
+
+  template<typename Real, typename Scalar>
+  Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u,
+    Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (1.0 + u_ext[0]->val[i] * u_ext[0]->val[i]) * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i])
+      + wt[i] * e->x[i] * u->val[i] * v->val[i];
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u,
+    Func<double> *v, Geom<double> *e, ExtData<double> *ext) const
+  {
+    return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
+    Geom<Hermes::Ord> *e, ExtData<Hermes::Ord> *ext) const
+  {
+    return matrix_form<Hermes::Ord, Hermes::Ord>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  MatrixFormVol<double>* clone()
+  {
+    return new CustomMatrixFormVol(*this);
+  }
+};
+
+class CustomVectorFormVol : public VectorFormVol<double>
+{
+public:
+  CustomVectorFormVol(MeshFunction<double>* ext_fn) : VectorFormVol<double>(0)
+  {
+    this->ext.push_back(ext_fn);
+  };
+
+  template<typename Real, typename Scalar>
+  Scalar vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v,
+    Geom<Real> *e, ExtData<Scalar> *ext) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (u_ext[0]->dx[i] * v->dx[i] + u_ext[0]->dy[i] * v->dy[i] - ext->fn[0]->val[i] * v->val[i]);
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v,
+    Geom<double> *e, ExtData<double> *ext) const
+  {
+    return vector_form<double, double>(n, wt, u_ext, v, e, ext);
+  }
+
+  Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *v,
+    Geom<Hermes::Ord> *e, ExtData<Hermes::Ord> *ext) const
+  {
+    return vector_form<Hermes::Ord, Hermes::Ord>(n, wt, u_ext, v, e, ext);
+  }
+
+  VectorFormVol<double>* clone()
+  {
+    return new CustomVectorFormVol(*this);
+  }
+};
+
+class CustomWeakForm : public WeakForm<double>
+{
+public:
+  CustomWeakForm(MeshFunction<double>* ext_fn) : WeakForm<double>(1)
+  {
+    add_matrix_form(new CustomMatrixFormVol());
+    add_vector_form(new CustomVectorFormVol(ext_fn));
+    add_matrix_form_surf(new WeakFormsH1::DefaultMatrixFormSurf<double>(0, 0, "Outer", new Hermes2DFunction<double>(3.0)));
+    add_vector_form_surf(new WeakFormsH1::DefaultVectorFormSurf<double>(0, "Left", new Hermes2DFunction<double>(-2.0)));
+
+    // Load cases assembled only by the batched assembling.
+    VectorFormVol<double>* load_vol = new WeakFormsH1::DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(5.0));
+    load_vol->load_case = 1;
+    add_vector_form(load_vol);
+    VectorFormSurf<double>* load_surf = new WeakFormsH1::DefaultVectorFormSurf<double>(0, "Outer", new Hermes2DFunction<double>(-4.0));
+    load_surf->load_case = 2;
+    add_vector_form_surf(load_surf);
+  }
+
+  void set_order_memoization(bool order_memoization)
+  {
+    for (unsigned int i = 0; i < get_mfvol().size(); i++)
+      get_mfvol()[i]->set_order_memoization(order_memoization);
+    for (unsigned int i = 0; i < get_mfsurf().size(); i++)
+      get_mfsurf()[i]->set_order_memoization(order_memoization);
+    for (unsigned int i = 0; i < get_vfvol().size(); i++)
+      get_vfvol()[i]->set_order_memoization(order_memoization);
+    for (unsigned int i = 0; i < get_vfsurf().size(); i++)
+      get_vfsurf()[i]->set_order_memoization(order_memoization);
+  }
+};
 
 int main(int argc, char* argv[])
 {
-  return 0;
-}
+  // Load and refine the mesh, some elements more to get hanging nodes.
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", &mesh);
+  mesh.refine_all_elements();
+  mesh.refine_all_elements();
+  mesh.refine_element_id(mesh.get_max_element_id() - 1);
+  mesh.refine_element_id(mesh.get_max_element_id() - 10);
 
+  // Space.
+  DefaultEssentialBCConst<double> bc("Inner", 1.0);
+  EssentialBCs<double> bcs(&bc);
+  H1Space<double> space(&mesh, &bcs, 3);
+  int ndof = space.get_num_dofs();
+
+  // Previous iteration coefficients and the external function.
+  double* coeff_vec = new double[ndof];
+  double* ext_vec = new double[ndof];
+  for (int i = 0; i < ndof; i++)
+  {
+    coeff_vec[i] = std::sin((double) i);
+    ext_vec[i] = std::cos((double) i);
+  }
+  Solution<double> ext_sln;
+  Solution<double>::vector_to_solution(ext_vec, &space, &ext_sln);
+
+  CustomWeakForm wf(&ext_sln);
+
+  // Serial assembling.
+  DiscreteProblem<double> dp_serial(&wf, &space);
+  SparseMatrix<double>* matrix_serial = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs_serial = create_vector<double>(SOLVER_UMFPACK);
+  for (int i = 0; i < 2; i++)
+    dp_serial.assemble(coeff_vec, matrix_serial, rhs_serial);
+
+  // Threaded assembling.
+  DiscreteProblem<double> dp_threaded(&wf, &space);
+  dp_threaded.set_num_threads(4);
+  SparseMatrix<double>* matrix_threaded = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs_threaded = create_vector<double>(SOLVER_UMFPACK);
+  for (int i = 0; i < 2; i++)
+    dp_threaded.assemble(coeff_vec, matrix_threaded, rhs_threaded);
+
+  // Threaded assembling using the element coloring.
+  DiscreteProblem<double> dp_colored(&wf, &space);
+  dp_colored.set_num_threads(4);
+  dp_colored.set_element_coloring(true);
+  SparseMatrix<double>* matrix_colored = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs_colored = create_vector<double>(SOLVER_UMFPACK);
+  for (int i = 0; i < 2; i++)
+    dp_colored.assemble(coeff_vec, matrix_colored, rhs_colored);
+
+  // Serial assembling without the memoization of the integration orders.
+  wf.set_order_memoization(false);
+  DiscreteProblem<double> dp_no_memo(&wf, &space);
+  SparseMatrix<double>* matrix_no_memo = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs_no_memo = create_vector<double>(SOLVER_UMFPACK);
+  dp_no_memo.assemble(coeff_vec, matrix_no_memo, rhs_no_memo);
+
+  // Batched assembling of the three load cases, and the load cases 1 and 2 alone.
+  Hermes::vector<Vector<double>*> rhs_batched, rhs_batched_threaded;
+  for (int i = 0; i < 3; i++)
+  {
+    rhs_batched.push_back(create_vector<double>(SOLVER_UMFPACK));
+    rhs_batched_threaded.push_back(create_vector<double>(SOLVER_UMFPACK));
+  }
+  DiscreteProblem<double> dp_batched(&wf, &space);
+  SparseMatrix<double>* matrix_batched = create_matrix<double>(SOLVER_UMFPACK);
+  dp_batched.assemble(coeff_vec, matrix_batched, rhs_batched);
+  dp_threaded.assemble(coeff_vec, NULL, rhs_batched_threaded);
+
+  WeakForm<double> wf_load_vol(1);
+  wf_load_vol.add_vector_form(new WeakFormsH1::DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(5.0)));
+  DiscreteProblem<double> dp_load_vol(&wf_load_vol, &space);
+  Vector<double>* rhs_load_vol = create_vector<double>(SOLVER_UMFPACK);
+  dp_load_vol.assemble(coeff_vec, rhs_load_vol);
+
+  WeakForm<double> wf_load_surf(1);
+  wf_load_surf.add_vector_form_surf(new WeakFormsH1::DefaultVectorFormSurf<double>(0, "Outer", new Hermes2DFunction<double>(-4.0)));
+  DiscreteProblem<double> dp_load_surf(&wf_load_surf, &space);
+  Vector<double>* rhs_load_surf = create_vector<double>(SOLVER_UMFPACK);
+  dp_load_surf.assemble(coeff_vec, rhs_load_surf);
+
+  // Matrix-free products with the assembled matrix.
+  double* x = new double[ndof];
+  double* y_assembled = new double[ndof];
+  double* y_serial = new double[ndof];
+  double* y_threaded = new double[ndof];
+  double* y_colored = new double[ndof];
+  for (int i = 0; i < ndof; i++)
+    x[i] = 1.0 + std::sin(3.0 * i);
+  dp_serial.apply(coeff_vec, x, y_serial);
+  dp_threaded.apply(coeff_vec, x, y_threaded);
+  dp_colored.apply(coeff_vec, x, y_colored);
+
+  // The results of the threaded assembling (and of the one without the memoization) have to be bitwise identical,
+  // the colored assembling sums the contributions in a different order.
+  bool success = true;
+  for (int i = 0; i < ndof; i++)
+  {
+    for (int j = 0; j < ndof; j++)
+    {
+      if (matrix_serial->get(i, j) != matrix_threaded->get(i, j))
+        success = false;
+      if (matrix_serial->get(i, j) != matrix_no_memo->get(i, j))
+        success = false;
+      if (std::abs(matrix_serial->get(i, j) - matrix_colored->get(i, j)) > 1e-12 * (1.0 + std::abs(matrix_serial->get(i, j))))
+        success = false;
+      if (matrix_serial->get(i, j) != matrix_batched->get(i, j))
+        success = false;
+    }
+    if (rhs_serial->get(i) != rhs_threaded->get(i))
+      success = false;
+    if (rhs_serial->get(i) != rhs_no_memo->get(i))
+      success = false;
+    if (std::abs(rhs_serial->get(i) - rhs_colored->get(i)) > 1e-12 * (1.0 + std::abs(rhs_serial->get(i))))
+      success = false;
+    if (rhs_serial->get(i) != rhs_batched[0]->get(i) || rhs_load_vol->get(i) != rhs_batched[1]->get(i)
+      || rhs_load_surf->get(i) != rhs_batched[2]->get(i))
+      success = false;
+    for (int j = 0; j < 3; j++)
+      if (rhs_batched[j]->get(i) != rhs_batched_threaded[j]->get(i))
+        success = false;
+
+    y_assembled[i] = 0.0;
+    double y_norm = 0.0;
+    for (int j = 0; j < ndof; j++)
+    {
+      y_assembled[i] += matrix_serial->get(i, j) * x[j];
+      y_norm += std::abs(matrix_serial->get(i, j) * x[j]);
+    }
+    if (std::abs(y_serial[i] - y_assembled[i]) > 1e-12 * (1.0 + y_norm)
+      || std::abs(y_threaded[i] - y_assembled[i]) > 1e-12 * (1.0 + y_norm)
+      || std::abs(y_colored[i] - y_assembled[i]) > 1e-12 * (1.0 + y_norm))
+      success = false;
+  }
+
+  // Matrix-free solve of A x' = A x by full GMRES with the operator, x' has to be x.
+  DiscreteProblemOperator<double> op(&dp_serial, coeff_vec);
+  KrylovVector<double> rhs_krylov;
+  rhs_krylov.alloc(ndof);
+  for (int i = 0; i < ndof; i++)
+    rhs_krylov.set(i, y_assembled[i]);
+  KrylovSolver<double> krylov(&op, &rhs_krylov);
+  krylov.set_restart(ndof);
+  krylov.set_max_iters(ndof);
+  krylov.set_tolerance(1e-12);
+  if (!krylov.solve())
+    success = false;
+  double x_norm = 0.0, x_error = 0.0;
+  for (int i = 0; i < ndof; i++)
+  {
+    x_norm += x[i] * x[i];
+    x_error += (krylov.get_sln_vector()[i] - x[i]) * (krylov.get_sln_vector()[i] - x[i]);
+  }
+  if (std::sqrt(x_error) > 1e-6 * std::sqrt(x_norm))
+    success = false;
+  info("Matrix-free GMRES: %d iterations.", krylov.get_num_iters());
+
+  // The temporaries of the form evaluations have to come from the arenas.
+  if (dp_serial.get_arena_peak_size() == 0 || dp_threaded.get_arena_peak_size() == 0)
+    success = false;
+  info("Peak arena use: %d bytes.", (int) dp_serial.get_arena_peak_size());
+
+  delete matrix_serial;
+  delete rhs_serial;
+  delete matrix_threaded;
+  delete rhs_threaded;
+  delete matrix_colored;
+  delete rhs_colored;
+  delete matrix_no_memo;
+  delete rhs_no_memo;
+  delete matrix_batched;
+  for (int i = 0; i < 3; i++)
+  {
+    delete rhs_batched[i];
+    delete rhs_batched_threaded[i];
+  }
+  delete rhs_load_vol;
+  delete rhs_load_surf;
+  delete [] x;
+  delete [] y_assembled;
+  delete [] y_serial;
+  delete [] y_threaded;
+  delete [] y_colored;
+  delete [] coeff_vec;
+  delete [] ext_vec;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
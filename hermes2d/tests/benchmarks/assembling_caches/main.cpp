@@ -0,0 +1,217 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a micro-benchmark of the caches of precalculated shapeset values used in assembling
+// (DiscreteProblem::get_fn()). On a triangular mesh with perturbed vertices, so that every element
+// has its own (constant) jacobian, the lookups done during one assembling are timed in the hashed
+// caches and in the std::map based caches used before. The test fails if the two caches do not
+// give the same values. The number of refinements can be given on the command line
+// (8 gives 131072 elements).
+
+const int INIT_REF_NUM = 5;           // 2 * 4^5 = 2048 elements.
+const double PERTURBATION = 0.2;      // Displacement of the inner vertices relative to the element size.
+const int NUM_SHAPES = 10;            // Number of shape functions on an element (p = 3 triangles).
+const int ORDER = 7;                  // Integration order.
+const int SHAPESET_ID = 0;            // Id of H1Shapeset.
+
+class CachesBenchmark : public DiscreteProblem<double>
+{
+public:
+  typedef AssemblingCaches::KeyConst KeyConst;
+  typedef AssemblingCaches::KeyNonConst KeyNonConst;
+  typedef AssemblingCaches::FnCache<KeyConst> FnCacheConst;
+  typedef AssemblingCaches::FnCache<KeyNonConst> FnCacheNonConst;
+
+  /// Comparison of the keys of the std::map based caches.
+  struct CompareConst
+  {
+    bool operator()(const KeyConst& a, const KeyConst& b) const
+    {
+      for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        {
+          if (a.inv_ref_map[i][j] < b.inv_ref_map[i][j]) return true;
+          if (a.inv_ref_map[i][j] > b.inv_ref_map[i][j]) return false;
+        }
+      return CompareNonConst()(KeyNonConst(a.index, a.order, a.sub_idx, a.shapeset_type),
+        KeyNonConst(b.index, b.order, b.sub_idx, b.shapeset_type));
+    }
+  };
+
+  struct CompareNonConst
+  {
+    bool operator()(const KeyNonConst& a, const KeyNonConst& b) const
+    {
+      if (a.index != b.index) return a.index < b.index;
+      if (a.order != b.order) return a.order < b.order;
+      if (a.sub_idx != b.sub_idx) return a.sub_idx < b.sub_idx;
+      return a.shapeset_type < b.shapeset_type;
+    }
+  };
+};
+
+typedef CachesBenchmark::KeyConst KeyConst;
+typedef CachesBenchmark::KeyNonConst KeyNonConst;
+
+struct InvRefMap
+{
+  double2x2 m;
+};
+
+/// Values stored in the caches (only the pointers are looked up here).
+class BenchmarkFunc : public Func<double>
+{
+public:
+  BenchmarkFunc() : Func<double>(1, 1) {};
+};
+
+int main(int argc, char* argv[])
+{
+  int init_ref_num = (argc > 1) ? atoi(argv[1]) : INIT_REF_NUM;
+
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square_tri.mesh", &mesh);
+  for (int i = 0; i < init_ref_num; i++)
+    mesh.refine_all_elements();
+  info("Number of elements: %d.", mesh.get_num_active_elements());
+
+  // Pseudo-random displacements of the vertices inside the square (0, pi)^2.
+  double h = M_PI / (1 << init_ref_num);
+  srand(1);
+  Node* n;
+  for_all_vertex_nodes(n, &mesh)
+  {
+    if (n->x < 1e-12 || n->x > M_PI - 1e-12 || n->y < 1e-12 || n->y > M_PI - 1e-12)
+      continue;
+    n->x += PERTURBATION * h * (2.0 * rand() / RAND_MAX - 1.0);
+    n->y += PERTURBATION * h * (2.0 * rand() / RAND_MAX - 1.0);
+  }
+
+  // Inverse reference maps of the elements (the jacobians are constant on the triangles).
+  std::vector<InvRefMap> inv_ref_maps;
+  Element* e;
+  for_all_active_elements(e, &mesh)
+  {
+    double jac[2][2] =
+    {
+      { (e->vn[1]->x - e->vn[0]->x) / 2.0, (e->vn[2]->x - e->vn[0]->x) / 2.0 },
+      { (e->vn[1]->y - e->vn[0]->y) / 2.0, (e->vn[2]->y - e->vn[0]->y) / 2.0 }
+    };
+    double det = jac[0][0] * jac[1][1] - jac[0][1] * jac[1][0];
+    InvRefMap inv_ref_map;
+    inv_ref_map.m[0][0] = jac[1][1] / det;
+    inv_ref_map.m[0][1] = -jac[0][1] / det;
+    inv_ref_map.m[1][0] = -jac[1][0] / det;
+    inv_ref_map.m[1][1] = jac[0][0] / det;
+    inv_ref_maps.push_back(inv_ref_map);
+  }
+  int num_elements = inv_ref_maps.size();
+  info("Number of lookups: %d.", 2 * NUM_SHAPES * NUM_SHAPES * num_elements);
+
+  bool success = true;
+  TimePeriod timer;
+
+  // Constant jacobians: the caches are kept during the whole assembling,
+  // the values for test and basis functions are looked up for every pair.
+  std::map<KeyConst, Func<double>*, CachesBenchmark::CompareConst> map_const;
+  timer.tick();
+  for (int el = 0; el < num_elements; el++)
+    for (int i = 0; i < NUM_SHAPES; i++)
+      for (int j = 0; j < NUM_SHAPES; j++)
+        for (int k = 0; k < 2; k++)
+        {
+          KeyConst key(256 - (k == 0 ? i : j), ORDER, 0, SHAPESET_ID, &inv_ref_maps[el].m);
+          if (map_const.find(key) == map_const.end())
+            map_const[key] = new BenchmarkFunc();
+        }
+  timer.tick();
+  double time_map_const = timer.last();
+
+  CachesBenchmark::FnCacheConst cache_const;
+  timer.tick();
+  for (int el = 0; el < num_elements; el++)
+    for (int i = 0; i < NUM_SHAPES; i++)
+      for (int j = 0; j < NUM_SHAPES; j++)
+        for (int k = 0; k < 2; k++)
+        {
+          KeyConst key(256 - (k == 0 ? i : j), ORDER, 0, SHAPESET_ID, &inv_ref_maps[el].m);
+          if (cache_const.get(key) == NULL)
+            cache_const.add(key, new BenchmarkFunc());
+        }
+  timer.tick();
+  double time_hash_const = timer.last();
+
+  // Both caches have to contain the same keys.
+  if (map_const.size() != cache_const.get_size())
+    success = false;
+  for (std::map<KeyConst, Func<double>*, CachesBenchmark::CompareConst>::iterator it = map_const.begin(); it != map_const.end(); it++)
+  {
+    if (cache_const.get(it->first) == NULL)
+      success = false;
+    delete it->second;
+  }
+
+  // Non-constant jacobians: the caches are cleared for every element.
+  std::map<KeyNonConst, Func<double>*, CachesBenchmark::CompareNonConst> map_non_const;
+  timer.tick();
+  for (int el = 0; el < num_elements; el++)
+  {
+    for (std::map<KeyNonConst, Func<double>*, CachesBenchmark::CompareNonConst>::iterator it = map_non_const.begin(); it != map_non_const.end(); it++)
+      delete it->second;
+    map_non_const.clear();
+    for (int i = 0; i < NUM_SHAPES; i++)
+      for (int j = 0; j < NUM_SHAPES; j++)
+        for (int k = 0; k < 2; k++)
+        {
+          KeyNonConst key(256 - (k == 0 ? i : j), ORDER, 0, SHAPESET_ID);
+          if (map_non_const.find(key) == map_non_const.end())
+            map_non_const[key] = new BenchmarkFunc();
+        }
+  }
+  timer.tick();
+  double time_map_non_const = timer.last();
+
+  CachesBenchmark::FnCacheNonConst cache_non_const;
+  timer.tick();
+  for (int el = 0; el < num_elements; el++)
+  {
+    cache_non_const.clear();
+    for (int i = 0; i < NUM_SHAPES; i++)
+      for (int j = 0; j < NUM_SHAPES; j++)
+        for (int k = 0; k < 2; k++)
+        {
+          KeyNonConst key(256 - (k == 0 ? i : j), ORDER, 0, SHAPESET_ID);
+          if (cache_non_const.get(key) == NULL)
+            cache_non_const.add(key, new BenchmarkFunc());
+        }
+  }
+  timer.tick();
+  double time_hash_non_const = timer.last();
+
+  if (map_non_const.size() != cache_non_const.get_size())
+    success = false;
+  for (std::map<KeyNonConst, Func<double>*, CachesBenchmark::CompareNonConst>::iterator it = map_non_const.begin(); it != map_non_const.end(); it++)
+  {
+    if (cache_non_const.get(it->first) == NULL)
+      success = false;
+    delete it->second;
+  }
+
+  info("Constant jacobians:     std::map %g s, hashed cache %g s.", time_map_const, time_hash_const);
+  info("Non-constant jacobians: std::map %g s, hashed cache %g s.", time_map_non_const, time_hash_non_const);
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
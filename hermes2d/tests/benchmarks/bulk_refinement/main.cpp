@@ -0,0 +1,159 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a benchmark of the bulk uniform refinement (Mesh::refine_all_elements()). Two copies of
+// a mesh are refined uniformly NUM_LEVELS times, one by refine_all_elements(), the other one element
+// by element (as refine_all_elements() did before), and the times are reported. The meshes are then
+// unrefined and refined again (reusing the released node ids), refined towards a vertex and refined
+// uniformly once more (with hanging nodes, where the bulk refinement is not used). The test fails if
+// the meshes (the elements and nodes with their id numbers) differ after any of the steps, or if
+// a lookup of an edge node gives a different node. The number of uniform refinements can be given
+// on the command line.
+
+const int NUM_LEVELS = 5;             // Number of uniform refinements.
+const int CORNER_REF_NUM = 3;         // Number of refinements towards a vertex.
+
+/// Gives access to the (protected) lookups of the nodes.
+class BenchmarkMesh : public Mesh
+{
+public:
+  /// Looks up the edge nodes of all active elements, returns false if a lookup gives a different node.
+  bool lookup_edge_nodes()
+  {
+    bool success = true;
+    Element* e;
+    for_all_active_elements(e, this)
+      for (unsigned int i = 0; i < e->get_num_surf(); i++)
+        if (peek_edge_node(e->vn[i]->id, e->vn[(i + 1) % e->get_num_surf()]->id) != e->en[i])
+          success = false;
+    return success;
+  }
+};
+
+/// Criterion of the serial refinement (refine_by_criterion()): refine all elements.
+int refine_all(Element* e)
+{
+  return 0;
+}
+
+/// Returns the id of the element, -1 for NULL.
+int get_id(Element* e)
+{
+  return (e == NULL) ? -1 : e->id;
+}
+
+/// Returns false if the elements or the nodes of the meshes differ.
+bool compare(BenchmarkMesh* mesh, BenchmarkMesh* mesh_serial)
+{
+  if (mesh->get_max_element_id() != mesh_serial->get_max_element_id()
+    || mesh->get_num_active_elements() != mesh_serial->get_num_active_elements()
+    || mesh->get_max_node_id() != mesh_serial->get_max_node_id()
+    || mesh->get_num_nodes() != mesh_serial->get_num_nodes())
+    return false;
+
+  for (int id = 0; id < mesh->get_max_element_id(); id++)
+  {
+    Element* e = mesh->get_element_fast(id), *f = mesh_serial->get_element_fast(id);
+    if (e->used != f->used)
+      return false;
+    if (!e->used)
+      continue;
+    if (e->active != f->active || e->get_nvert() != f->get_nvert() || e->marker != f->marker || get_id(e->parent) != get_id(f->parent))
+      return false;
+    for (unsigned int i = 0; i < e->get_nvert(); i++)
+      if (e->vn[i]->id != f->vn[i]->id)
+        return false;
+    for (unsigned int i = 0; i < 4; i++)
+      if (e->active ? (i < e->get_nvert() && e->en[i]->id != f->en[i]->id) : get_id(e->sons[i]) != get_id(f->sons[i]))
+        return false;
+  }
+
+  for (int id = 0; id < mesh->get_max_node_id(); id++)
+  {
+    Node* n = mesh->get_node(id), *m = mesh_serial->get_node(id);
+    if (n->used != m->used)
+      return false;
+    if (!n->used)
+      continue;
+    if (n->type != m->type || n->ref != m->ref || n->bnd != m->bnd || n->p1 != m->p1 || n->p2 != m->p2)
+      return false;
+    if (n->type == HERMES_TYPE_VERTEX ? (n->x != m->x || n->y != m->y)
+      : (n->marker != m->marker || get_id(n->elem[0]) != get_id(m->elem[0]) || get_id(n->elem[1]) != get_id(m->elem[1])))
+      return false;
+  }
+
+  return mesh->lookup_edge_nodes() && mesh_serial->lookup_edge_nodes();
+}
+
+/// Runs the benchmark on the mesh, returns false if the bulk and the serial refinement give different meshes.
+bool run(const char* mesh_file, int num_levels)
+{
+  BenchmarkMesh mesh, mesh_serial;
+  MeshReaderH2D mloader;
+  mloader.load(mesh_file, &mesh);
+  mloader.load(mesh_file, &mesh_serial);
+
+  bool success = true;
+  TimePeriod timer;
+  for (int level = 1; level <= num_levels; level++)
+  {
+    timer.tick();
+    mesh.refine_all_elements();
+    timer.tick();
+    double time_bulk = timer.last();
+    timer.tick();
+    mesh_serial.refine_by_criterion(refine_all, 1);
+    timer.tick();
+    if (!compare(&mesh, &mesh_serial))
+      success = false;
+    info("%s, level %d: %d elements, %d nodes, refinement %g s (bulk), %g s (serial).", mesh_file, level,
+      mesh.get_num_active_elements(), mesh.get_num_nodes(), time_bulk, timer.last());
+  }
+
+  // Released node ids reused.
+  mesh.unrefine_all_elements();
+  mesh_serial.unrefine_all_elements();
+  mesh.refine_all_elements();
+  mesh_serial.refine_by_criterion(refine_all, 1);
+  if (!compare(&mesh, &mesh_serial))
+    success = false;
+
+  // Hanging nodes.
+  mesh.refine_towards_vertex(0, CORNER_REF_NUM);
+  mesh_serial.refine_towards_vertex(0, CORNER_REF_NUM);
+  if (!compare(&mesh, &mesh_serial))
+    success = false;
+  mesh.refine_all_elements();
+  mesh_serial.refine_by_criterion(refine_all, 1);
+  if (!compare(&mesh, &mesh_serial))
+    success = false;
+
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  int num_levels = (argc > 1) ? atoi(argv[1]) : NUM_LEVELS;
+
+  bool success = true;
+  if (!run("../square.mesh", num_levels))
+    success = false;
+  if (!run("../square_tri.mesh", num_levels))
+    success = false;
+  if (!run("../mixed.mesh", num_levels))
+    success = false;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
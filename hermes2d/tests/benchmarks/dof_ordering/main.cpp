@@ -0,0 +1,200 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the reverse Cuthill-McKee ordering of DOFs (Space::set_dof_ordering()).
+// On the meshes of the tests (refined uniformly and towards a vertex, to have hanging nodes),
+// a reaction-diffusion problem is assembled and solved in a space of the order P_INIT with the
+// natural and with the RCM ordering of the DOFs. The bandwidth, the profile and the fill-in of the
+// matrices and the times of the solution are reported. The test fails if
+// - the assembly lists of the elements do not follow the permutation of the DOFs,
+// - the solutions (as Solutions) differ by more than the rounding errors.
+
+const int P_INIT = 3;                 // Polynomial degree of the spaces.
+const double TOLERANCE = 1e-10;       // Relative tolerance of the solutions.
+
+/// Bilinear form of -Laplace u + u.
+class CustomMatrixFormVol : public MatrixFormVol<double>
+{
+public:
+  CustomMatrixFormVol() : MatrixFormVol<double>(0, 0, HERMES_ANY, HERMES_SYM) {};
+
+  template<typename Real, typename Scalar>
+  Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u,
+    Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i] + u->val[i] * v->val[i]);
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u,
+    Func<double> *v, Geom<double> *e, ExtData<double> *ext) const
+  {
+    return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
+    Geom<Hermes::Ord> *e, ExtData<Hermes::Ord> *ext) const
+  {
+    return matrix_form<Hermes::Ord, Hermes::Ord>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  MatrixFormVol<double>* clone()
+  {
+    return new CustomMatrixFormVol(*this);
+  }
+};
+
+/// Weak form of -Laplace u + u = 1.
+class CustomWeakForm : public WeakForm<double>
+{
+public:
+  CustomWeakForm() : WeakForm<double>(1)
+  {
+    add_matrix_form(new CustomMatrixFormVol);
+    add_vector_form(new DefaultVectorFormVol<double>(0));
+  }
+};
+
+/// Gives access to the (protected) sparse structure.
+class BenchmarkMatrix : public UMFPackMatrix<double>
+{
+public:
+  /// Largest distance of a nonzero from the diagonal.
+  int get_bandwidth()
+  {
+    int bandwidth = 0;
+    for (unsigned int j = 0; j < get_size(); j++)
+      for (int k = get_Ap()[j]; k < get_Ap()[j + 1]; k++)
+        bandwidth = std::max(bandwidth, std::abs(get_Ai()[k] - (int) j));
+    return bandwidth;
+  }
+
+  /// Sum of the distances of the first nonzeros of the columns from the diagonal (the fill-in of a skyline factorization).
+  long get_profile()
+  {
+    long profile = 0;
+    for (unsigned int j = 0; j < get_size(); j++)
+      if (get_Ap()[j] < get_Ap()[j + 1])
+        profile += std::max((int) j - get_Ai()[get_Ap()[j]], 0);
+    return profile;
+  }
+};
+
+/// Returns the pairs of the shape functions and DOFs of the assembly list of the element.
+std::vector<std::pair<int, int> > get_list(Space<double>* space, Element* e)
+{
+  AsmList<double> al;
+  space->get_element_assembly_list(e, &al);
+  std::vector<std::pair<int, int> > list;
+  for (unsigned int i = 0; i < al.get_cnt(); i++)
+    list.push_back(std::pair<int, int>(al.get_idx()[i], al.get_dof()[i]));
+  return list;
+}
+
+/// Assembles and solves the problem, returns the coefficient vector.
+double* solve(Space<double>* space, WeakForm<double>* wf, const char* name, const char* ordering)
+{
+  DiscreteProblem<double> dp(wf, space);
+  BenchmarkMatrix matrix;
+  UMFPackVector<double> rhs;
+  dp.assemble(&matrix, &rhs);
+
+  TimePeriod timer;
+  timer.tick();
+  UMFPackLinearSolver<double> solver(&matrix, &rhs);
+  if (!solver.solve())
+    error("Matrix solver failed.");
+  timer.tick();
+
+  info("%s, %s ordering: ndof %d, bandwidth %d, profile %ld, fill-in %g, solved in %g s.", name, ordering,
+    space->get_num_dofs(), matrix.get_bandwidth(), matrix.get_profile(), ((SparseMatrix<double>*) &matrix)->get_fill_in(), timer.last());
+
+  double* coeff_vec = new double[space->get_num_dofs()];
+  memcpy(coeff_vec, solver.get_sln_vector(), space->get_num_dofs() * sizeof(double));
+  return coeff_vec;
+}
+
+/// Runs the benchmark on the mesh, returns false if the orderings give different results.
+bool run(const char* mesh_file, const char* bdy_marker, int init_ref_num, int corner_ref_num)
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load(mesh_file, &mesh);
+  for (int i = 0; i < init_ref_num; i++)
+    mesh.refine_all_elements();
+  mesh.refine_towards_vertex(0, corner_ref_num);
+
+  CustomWeakForm wf;
+  DefaultEssentialBCConst<double> bc_essential(bdy_marker, 1.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  H1Space<double> space_natural(&mesh, &bcs, P_INIT);
+  H1Space<double> space_rcm(&mesh, &bcs, P_INIT);
+  space_rcm.set_dof_ordering(HERMES_DOF_ORDERING_RCM);
+
+  // The assembly lists follow the permutation (the constrained DOFs may come in a different order).
+  bool success = space_natural.get_num_dofs() == space_rcm.get_num_dofs()
+    && (int) space_rcm.get_dof_permutation().size() == space_rcm.get_num_dofs();
+  const std::vector<int>& permutation = space_rcm.get_dof_permutation();
+  Element* e;
+  for_all_active_elements(e, &mesh)
+  {
+    std::vector<std::pair<int, int> > list_natural = get_list(&space_natural, e), list_rcm = get_list(&space_rcm, e);
+    if (!success || list_natural.size() != list_rcm.size())
+      return false;
+    for (unsigned int i = 0; i < list_natural.size(); i++)
+      if (list_natural[i].second >= 0)
+        list_natural[i].second = permutation[list_natural[i].second];
+    std::sort(list_natural.begin(), list_natural.end());
+    std::sort(list_rcm.begin(), list_rcm.end());
+    if (list_natural != list_rcm)
+      success = false;
+  }
+
+  double* coeff_natural = solve(&space_natural, &wf, mesh_file, "natural");
+  double* coeff_rcm = solve(&space_rcm, &wf, mesh_file, "RCM");
+
+  // The solutions are the same.
+  Solution<double> sln_natural, sln_rcm;
+  Solution<double>::vector_to_solution(coeff_natural, &space_natural, &sln_natural);
+  Solution<double>::vector_to_solution(coeff_rcm, &space_rcm, &sln_rcm);
+  for_all_active_elements(e, &mesh)
+    for (int k = 0; k < 3; k++)
+    {
+      double xi = (k - 1) * 0.3, value = sln_natural.get_ref_value(e, xi, xi);
+      if (std::abs(value - sln_rcm.get_ref_value(e, xi, xi)) > TOLERANCE * (1.0 + std::abs(value)))
+        success = false;
+    }
+
+  delete [] coeff_natural;
+  delete [] coeff_rcm;
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  bool success = true;
+  if (!run("../square.mesh", "1", 5, 4))
+    success = false;
+  if (!run("../square_tri.mesh", "Bdy", 5, 4))
+    success = false;
+  if (!run("../domain.mesh", "Outer", 4, 4))
+    success = false;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,166 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the renumbering of elements along the Hilbert curve (Mesh::reorder_elements()).
+// A mesh is refined uniformly, then in NUM_ROUNDS rounds a pseudo-random selection of its elements
+// is refined (so that the ids of neighboring elements are scattered, as after adaptivity). On this mesh
+// and on its reordered copy, a reaction-diffusion problem is assembled and solved, and the solution
+// is evaluated on all elements and integrated (Traverse). The test fails if the solutions on the two
+// meshes differ by more than the rounding errors.
+
+const int INIT_REF_NUM = 5;           // Number of initial uniform refinements of the mesh.
+const int NUM_ROUNDS = 4;             // Number of rounds of the pseudo-random refinements.
+const int P_INIT = 2;                 // Polynomial degree of the spaces.
+const int NUM_EVALUATIONS = 5;        // Number of evaluations of the solution on all elements that are timed.
+const double TOLERANCE = 1e-10;       // Relative tolerance of the results.
+
+/// Bilinear form of -Laplace u + u.
+class CustomMatrixFormVol : public MatrixFormVol<double>
+{
+public:
+  CustomMatrixFormVol() : MatrixFormVol<double>(0, 0, HERMES_ANY, HERMES_SYM) {};
+
+  template<typename Real, typename Scalar>
+  Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u,
+    Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i] + u->val[i] * v->val[i]);
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u,
+    Func<double> *v, Geom<double> *e, ExtData<double> *ext) const
+  {
+    return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[], Func<Hermes::Ord> *u, Func<Hermes::Ord> *v,
+    Geom<Hermes::Ord> *e, ExtData<Hermes::Ord> *ext) const
+  {
+    return matrix_form<Hermes::Ord, Hermes::Ord>(n, wt, u_ext, u, v, e, ext);
+  }
+
+  MatrixFormVol<double>* clone()
+  {
+    return new CustomMatrixFormVol(*this);
+  }
+};
+
+/// Weak form of -Laplace u + u = 1.
+class CustomWeakForm : public WeakForm<double>
+{
+public:
+  CustomWeakForm() : WeakForm<double>(1)
+  {
+    add_matrix_form(new CustomMatrixFormVol);
+    add_vector_form(new DefaultVectorFormVol<double>(0));
+  }
+};
+
+/// Assembles and solves the problem on the mesh, evaluates the solution. Returns its norm and the sum of its values.
+void run(Mesh* mesh, const char* name, double& norm, double& sum)
+{
+  CustomWeakForm wf;
+  DefaultEssentialBCConst<double> bc_essential("1", 1.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space(mesh, &bcs, P_INIT);
+
+  TimePeriod timer;
+  timer.tick();
+  DiscreteProblem<double> dp(&wf, &space);
+  UMFPackMatrix<double> matrix;
+  UMFPackVector<double> rhs;
+  dp.assemble(&matrix, &rhs);
+  timer.tick();
+  double time_assembling = timer.last();
+
+  UMFPackLinearSolver<double> solver(&matrix, &rhs);
+  if (!solver.solve())
+    error("Matrix solver failed.");
+  Solution<double> sln;
+  Solution<double>::vector_to_solution(solver.get_sln_vector(), &space, &sln);
+
+  // Values of the solution at the integration points of all elements.
+  timer.tick();
+  sum = 0.0;
+  for (int r = 0; r < NUM_EVALUATIONS; r++)
+  {
+    Element* e;
+    for_all_active_elements(e, mesh)
+    {
+      sln.set_active_element(e);
+      int order = 2 * P_INIT;
+      sln.set_quad_order(order, H2D_FN_VAL | H2D_FN_DX | H2D_FN_DY);
+      double* values = sln.get_fn_values();
+      int np = sln.get_quad_2d()->get_num_points(order);
+      for (int i = 0; i < np; i++)
+        sum += values[i];
+    }
+  }
+  timer.tick();
+  double time_evaluation = timer.last();
+
+  timer.tick();
+  norm = Global<double>::calc_norm(&sln, HERMES_H1_NORM);
+  timer.tick();
+  double time_norm = timer.last();
+
+  info("%s: %d elements, ndof %d, assembling %g s, evaluation %g s, norm %g s.", name,
+    mesh->get_num_active_elements(), space.get_num_dofs(), time_assembling, time_evaluation, time_norm);
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  // Refine every third element (pseudo-randomly selected) in each round.
+  unsigned int random = 12345;
+  for (int round = 0; round < NUM_ROUNDS; round++)
+  {
+    std::vector<int> ids;
+    Element* e;
+    for_all_active_elements(e, &mesh)
+    {
+      random = random * 1103515245 + 12345;
+      if ((random >> 16) % 3 == 0)
+        ids.push_back(e->id);
+    }
+    for (unsigned int i = 0; i < ids.size(); i++)
+      mesh.refine_element_id(ids[i]);
+  }
+
+  Mesh mesh_reordered;
+  mesh_reordered.copy(&mesh);
+  TimePeriod timer;
+  timer.tick();
+  mesh_reordered.reorder_elements();
+  timer.tick();
+  info("Reordering of %d elements: %g s.", mesh_reordered.get_num_elements(), timer.last());
+
+  double norm, sum, norm_reordered, sum_reordered;
+  run(&mesh, "Original mesh", norm, sum);
+  run(&mesh_reordered, "Reordered mesh", norm_reordered, sum_reordered);
+
+  bool success = std::abs(norm - norm_reordered) <= TOLERANCE * norm
+    && std::abs(sum - sum_reordered) <= TOLERANCE * std::abs(sum);
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,208 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the incremental assignment of DOFs (Space::set_incremental_dofs()) and
+// of the update of the matrix sparse structure. A space is adapted in NUM_STEPS steps (without
+// solving anything): every other step refines some of its elements, the other steps increase orders
+// of some elements. In every step, the sparse structure is updated by a DiscreteProblem used in
+// all steps, and created from scratch for a copy of the space numbered as before. The test fails if
+// - the assembly list of an element without touched DOFs changed,
+// - the updated sparse structure differs from the one created from scratch,
+// - the coefficients of the untouched DOFs are not kept by Space::transfer_coefficients().
+
+const int INIT_REF_NUM = 6;           // Number of initial uniform refinements of the mesh.
+const int P_INIT = 2;                 // Initial polynomial degree of the space.
+const int NUM_STEPS = 20;             // Number of adaptivity steps.
+const int NUM_CHANGED = 16;           // Number of elements changed in an adaptivity step.
+const int P_MAX = 8;                  // Maximum polynomial degree.
+
+/// Gives access to the (protected) setting of element orders without assigning DOFs.
+class BenchmarkSpace : public H1Space<double>
+{
+public:
+  BenchmarkSpace(Mesh* mesh, EssentialBCs<double>* bcs, int p_init) : H1Space<double>(mesh, bcs, p_init) {}
+
+  /// Refines the element, the sons inherit its order.
+  void refine_element(Element* e)
+  {
+    int o = get_element_order(e->id);
+    mesh->refine_element_id(e->id);
+    for (int j = 0; j < 4; j++)
+      set_element_order_internal(e->sons[j]->id, o);
+  }
+
+  /// Increases the order of the element by one.
+  void increase_order(Element* e)
+  {
+    int o = std::min(H2D_GET_H_ORDER(get_element_order(e->id)) + 1, P_MAX);
+    set_element_order_internal(e->id, H2D_MAKE_QUAD_ORDER(o, o));
+  }
+};
+
+/// Returns the DOFs of the assembly list of the element.
+std::vector<int> get_dofs(Space<double>* space, Element* e)
+{
+  AsmList<double> al;
+  space->get_element_assembly_list(e, &al);
+  std::vector<int> dofs;
+  for (unsigned int i = 0; i < al.get_cnt(); i++)
+  {
+    dofs.push_back(al.get_idx()[i]);
+    dofs.push_back(al.get_dof()[i]);
+  }
+  return dofs;
+}
+
+/// Gives access to the (protected) creation of the sparse structure.
+class BenchmarkDiscreteProblem : public DiscreteProblem<double>
+{
+public:
+  BenchmarkDiscreteProblem(const WeakForm<double>* wf, const Space<double>* space) : DiscreteProblem<double>(wf, space) {}
+
+  void create_structure(SparseMatrix<double>* mat)
+  {
+    create_sparse_structure(mat);
+  }
+};
+
+/// Gives access to the (protected) sparse structure.
+class BenchmarkMatrix : public UMFPackMatrix<double>
+{
+public:
+  /// Returns false if the matrices have different sparse structures.
+  bool same_structure(BenchmarkMatrix* other)
+  {
+    if (get_size() != other->get_size() || get_nnz() != other->get_nnz())
+      return false;
+    return memcmp(get_Ap(), other->get_Ap(), (get_size() + 1) * sizeof(int)) == 0
+      && memcmp(get_Ai(), other->get_Ai(), get_nnz() * sizeof(int)) == 0;
+  }
+
+  unsigned int get_num_nonzeros() const
+  {
+    return get_nnz();
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("1", 1.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  BenchmarkSpace space(&mesh, &bcs, P_INIT);
+  space.set_incremental_dofs();
+
+  Hermes1DFunction<double> lambda(1.0);
+  Hermes2DFunction<double> f(1.0);
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, &lambda, &f);
+
+  // The DiscreteProblem updating the sparse structure.
+  BenchmarkDiscreteProblem dp(&wf, &space);
+  BenchmarkMatrix matrix;
+  dp.create_structure(&matrix);
+
+  bool success = true;
+  double time_scratch = 0.0, time_update = 0.0;
+  TimePeriod timer;
+  for (int step = 1; step <= NUM_STEPS; step++)
+  {
+    // DOFs before the step.
+    std::map<int, std::vector<int> > prev_dofs;
+    Element* e;
+    for_all_active_elements(e, &mesh)
+      prev_dofs[e->id] = get_dofs(&space, e);
+    int prev_ndof = space.get_num_dofs();
+    double* prev_coeff_vec = new double[prev_ndof];
+    for (int i = 0; i < prev_ndof; i++)
+      prev_coeff_vec[i] = std::sin(1.0 + i);
+
+    // Adapt the space.
+    std::vector<Element*> elements;
+    for_all_active_elements(e, &mesh)
+      elements.push_back(e);
+    for (int i = 0; i < NUM_CHANGED; i++)
+    {
+      e = elements[(step * 7919 + i * 104729) % elements.size()];
+      if (step % 2)
+        space.increase_order(e);
+      else if (e->active)
+        space.refine_element(e);
+    }
+    space.assign_dofs();
+    int ndof = space.get_num_dofs();
+
+    std::vector<bool> touched(ndof, false);
+    const Hermes::vector<int>& touched_dofs = space.get_touched_dofs();
+    for (unsigned int i = 0; i < touched_dofs.size(); i++)
+      touched[touched_dofs[i]] = true;
+
+    // Elements without touched DOFs have to have the same assembly lists as before.
+    for_all_active_elements(e, &mesh)
+    {
+      std::vector<int> dofs = get_dofs(&space, e);
+      bool has_touched = false;
+      for (unsigned int i = 1; i < dofs.size(); i += 2)
+        if (dofs[i] >= 0 && touched[dofs[i]])
+          has_touched = true;
+      if (!has_touched && (prev_dofs.find(e->id) == prev_dofs.end() || prev_dofs[e->id] != dofs))
+        success = false;
+    }
+
+    // Coefficients of the untouched DOFs are kept.
+    double* coeff_vec = new double[ndof];
+    space.transfer_coefficients(prev_coeff_vec, coeff_vec);
+    for (int i = 0; i < ndof; i++)
+      if (!touched[i] && coeff_vec[i] != prev_coeff_vec[i])
+        success = false;
+    delete [] coeff_vec;
+    delete [] prev_coeff_vec;
+
+    // Sparse structure from scratch (the copy of the space is numbered as before).
+    Space<double>* space_copy = space.dup(&mesh);
+    BenchmarkDiscreteProblem dp_scratch(&wf, space_copy);
+    BenchmarkMatrix matrix_scratch;
+    timer.tick();
+    dp_scratch.create_structure(&matrix_scratch);
+    timer.tick();
+    double time_scratch_step = timer.last();
+
+    // Updated sparse structure.
+    dp.create_structure(&matrix);
+    timer.tick();
+    double time_update_step = timer.last();
+
+    // The updated structure has to match the structure created from scratch.
+    BenchmarkDiscreteProblem dp_check(&wf, &space);
+    BenchmarkMatrix matrix_check;
+    dp_check.create_structure(&matrix_check);
+    if (!matrix.same_structure(&matrix_check) || space_copy->get_num_dofs() != ndof || matrix_scratch.get_num_nonzeros() != matrix.get_num_nonzeros())
+      success = false;
+
+    info("Step %d, ndof %d, touched %d: from scratch %g s, updated %g s.", step, ndof, (int) touched_dofs.size(),
+      time_scratch_step, time_update_step);
+    time_scratch += time_scratch_step;
+    time_update += time_update_step;
+    delete space_copy;
+  }
+  info("Total: from scratch %g s, updated %g s.", time_scratch, time_update);
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,146 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a micro-benchmark of the vectorized integrals of the weak forms (integrals/h1.h). For
+// the integration orders of quads 2..24, the integrals int_u_v, int_grad_u_grad_v (real) and
+// int_u_ext_v, int_grad_u_ext_grad_v (complex) are timed against the scalar loops used before.
+// The test fails if the results differ by more than the rounding errors.
+
+const int MIN_ORDER = 2;              // Lowest integration order.
+const int MAX_ORDER = 24;             // Highest integration order.
+const int NUM_PAIRS = 20000;          // Number of integrals per order (pairs of basis and test functions).
+const double TOLERANCE = 1e-12;       // Relative tolerance of the results.
+
+/// Values of a function at the integration points.
+template<typename Scalar>
+class BenchmarkFunc : public Func<Scalar>
+{
+public:
+  BenchmarkFunc(int n, int seed) : Func<Scalar>(n, 1)
+  {
+    this->val = new Scalar[n];
+    this->dx = new Scalar[n];
+    this->dy = new Scalar[n];
+    for (int i = 0; i < n; i++)
+    {
+      this->val[i] = value(seed, i, 0);
+      this->dx[i] = value(seed, i, 1);
+      this->dy[i] = value(seed, i, 2);
+    }
+  }
+  ~BenchmarkFunc()
+  {
+    delete [] this->val;
+    delete [] this->dx;
+    delete [] this->dy;
+  }
+  static Scalar value(int seed, int i, int k);
+};
+
+template<>
+double BenchmarkFunc<double>::value(int seed, int i, int k)
+{
+  return std::sin(1.0 + seed + 0.37 * i + 1.3 * k);
+}
+
+template<>
+std::complex<double> BenchmarkFunc<std::complex<double> >::value(int seed, int i, int k)
+{
+  return std::complex<double>(std::sin(1.0 + seed + 0.37 * i + 1.3 * k), std::cos(2.0 + seed + 0.11 * i + 0.7 * k));
+}
+
+/// Returns false if the results are not the same up to the rounding errors (scale is the sum of the absolute values).
+template<typename Scalar>
+bool compare(Scalar a, Scalar b, double scale)
+{
+  return std::abs(a - b) <= TOLERANCE * (1.0 + scale);
+}
+
+int main(int argc, char* argv[])
+{
+  info("Width of the vector registers: %d doubles.", H2D_SIMD_WIDTH);
+  bool success = true;
+  TimePeriod timer;
+  for (int order = MIN_ORDER; order <= MAX_ORDER; order += 2)
+  {
+    g_quad_2d_std.set_mode(HERMES_MODE_QUAD);
+    int n = g_quad_2d_std.get_num_points(order);
+    double3* pt = g_quad_2d_std.get_points(order);
+    double* wt = new double[n];
+    for (int i = 0; i < n; i++)
+      wt[i] = pt[i][2];
+
+    BenchmarkFunc<double> u(n, 0), v(n, 1);
+    BenchmarkFunc<std::complex<double> > u_ext(n, 2);
+
+    // Real integrals.
+    double scalar_result = 0.0, scale = 0.0;
+    timer.tick();
+    for (int pair = 0; pair < NUM_PAIRS; pair++)
+      for (int i = 0; i < n; i++)
+        scalar_result += wt[i] * u.val[i] * v.val[i] + wt[i] * (u.dx[i] * v.dx[i] + u.dy[i] * v.dy[i]);
+    timer.tick();
+    double time_scalar = timer.last();
+    double reference = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+      reference += wt[i] * u.val[i] * v.val[i] + wt[i] * (u.dx[i] * v.dx[i] + u.dy[i] * v.dy[i]);
+      scale += std::abs(wt[i]) * (std::abs(u.val[i] * v.val[i]) + std::abs(u.dx[i] * v.dx[i]) + std::abs(u.dy[i] * v.dy[i]));
+    }
+
+    double simd_result = 0.0;
+    timer.tick();
+    for (int pair = 0; pair < NUM_PAIRS; pair++)
+      simd_result += int_u_v<double, double>(n, wt, &u, &v) + int_grad_u_grad_v<double, double>(n, wt, &u, &v);
+    timer.tick();
+    double time_simd = timer.last();
+    if (!compare(reference, int_u_v<double, double>(n, wt, &u, &v) + int_grad_u_grad_v<double, double>(n, wt, &u, &v), scale))
+      success = false;
+
+    // Complex integrals (residual forms).
+    std::complex<double> scalar_complex = 0.0;
+    timer.tick();
+    for (int pair = 0; pair < NUM_PAIRS; pair++)
+      for (int i = 0; i < n; i++)
+        scalar_complex += wt[i] * u_ext.val[i] * v.val[i] + wt[i] * (u_ext.dx[i] * v.dx[i] + u_ext.dy[i] * v.dy[i]);
+    timer.tick();
+    double time_scalar_complex = timer.last();
+    std::complex<double> reference_complex = 0.0;
+    scale = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+      reference_complex += wt[i] * u_ext.val[i] * v.val[i] + wt[i] * (u_ext.dx[i] * v.dx[i] + u_ext.dy[i] * v.dy[i]);
+      scale += std::abs(wt[i]) * (std::abs(u_ext.val[i] * v.val[i]) + std::abs(u_ext.dx[i] * v.dx[i]) + std::abs(u_ext.dy[i] * v.dy[i]));
+    }
+
+    std::complex<double> simd_complex = 0.0;
+    timer.tick();
+    for (int pair = 0; pair < NUM_PAIRS; pair++)
+      simd_complex += int_u_ext_v<double, std::complex<double> >(n, wt, &u_ext, &v)
+        + int_grad_u_ext_grad_v<double, std::complex<double> >(n, wt, &u_ext, &v);
+    timer.tick();
+    double time_simd_complex = timer.last();
+    if (!compare(reference_complex, int_u_ext_v<double, std::complex<double> >(n, wt, &u_ext, &v)
+      + int_grad_u_ext_grad_v<double, std::complex<double> >(n, wt, &u_ext, &v), scale))
+      success = false;
+
+    info("Order %d, %d points: real %g s / %g s (vectorized), complex %g s / %g s (vectorized).", order, n,
+      time_scalar, time_simd, time_scalar_complex, time_simd_complex);
+    info("(Sums of the timed integrals: %g, %g, %g, %g.)", scalar_result, simd_result, std::abs(scalar_complex), std::abs(simd_complex));
+    delete [] wt;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
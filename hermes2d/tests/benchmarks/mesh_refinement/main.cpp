@@ -0,0 +1,91 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a benchmark of the node hash tables of the mesh (HashTable). A mesh of one square is refined
+// uniformly up to MAX_LEVEL times (4^MAX_LEVEL elements). In every level, the refinement and the lookups
+// of the edge nodes of all active elements are timed. Finally, the last level is unrefined and refined
+// again (removing and adding the nodes). The test fails if the number of nodes does not match the grid,
+// or if a lookup returns a different node than the one of the element. The number of uniform refinements
+// can be given on the command line (the hash tables are measured at 11 levels, about 4.2M elements and
+// several GB of memory).
+
+const int MAX_LEVEL = 7;              // Number of uniform refinements.
+
+/// Gives access to the (protected) lookups of the nodes.
+class BenchmarkMesh : public Mesh
+{
+public:
+  /// Looks up the edge nodes of all active elements, returns false if a lookup gives a different node.
+  bool lookup_edge_nodes()
+  {
+    bool success = true;
+    Element* e;
+    for_all_active_elements(e, this)
+      for (unsigned int i = 0; i < e->get_num_surf(); i++)
+        if (peek_edge_node(e->vn[i]->id, e->vn[(i + 1) % e->get_num_surf()]->id) != e->en[i])
+          success = false;
+    return success;
+  }
+};
+
+/// Returns false if the number of nodes does not match the uniform grid of the level.
+bool check_nodes(Mesh* mesh, int level)
+{
+  long n = 1L << level;
+  return mesh->get_num_active_elements() == n * n && mesh->get_num_nodes() == (n + 1) * (n + 1) + 2 * n * (n + 1);
+}
+
+int main(int argc, char* argv[])
+{
+  int max_level = (argc > 1) ? atoi(argv[1]) : MAX_LEVEL;
+
+  BenchmarkMesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+
+  bool success = true;
+  TimePeriod timer;
+  for (int level = 1; level <= max_level; level++)
+  {
+    timer.tick();
+    mesh.refine_all_elements();
+    timer.tick();
+    double time_refinement = timer.last();
+    if (!check_nodes(&mesh, level))
+      success = false;
+
+    timer.tick();
+    if (!mesh.lookup_edge_nodes())
+      success = false;
+    timer.tick();
+    info("Level %d: %d elements, %d nodes, refinement %g s, lookups of the edge nodes %g s.", level,
+      mesh.get_num_active_elements(), mesh.get_num_nodes(), time_refinement, timer.last());
+  }
+
+  timer.tick();
+  mesh.unrefine_all_elements();
+  timer.tick();
+  double time_unrefinement = timer.last();
+  if (!check_nodes(&mesh, max_level - 1) || !mesh.lookup_edge_nodes())
+    success = false;
+  timer.tick();
+  mesh.refine_all_elements();
+  timer.tick();
+  if (!check_nodes(&mesh, max_level) || !mesh.lookup_edge_nodes())
+    success = false;
+  info("Unrefinement of the last level %g s, refinement again %g s.", time_unrefinement, timer.last());
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,134 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+using namespace Hermes::Preconditioners;
+
+// This is a benchmark of the native preconditioners of the Krylov solvers (precond_native.h).
+// The Poisson equation -Laplace u = 1 is solved by GMRES (SOLVER_KRYLOV) without a preconditioner,
+// with the block Jacobi preconditioner by the blocks of Space::get_dof_blocks(), with ILU(0), ILUT
+// and SSOR. The test fails if any of the solvers does not converge or if its solution differs from
+// the solution by UMFPack by more than the tolerance of the solvers allows.
+
+const int INIT_REF_NUM = 4;           // Number of initial uniform refinements of the mesh.
+const int P_INIT = 4;                 // Polynomial degree of the space.
+const double KRYLOV_TOL = 1e-10;      // Relative residual of the Krylov solvers.
+const int KRYLOV_MAX_ITER = 5000;     // Maximum allowed number of iterations.
+const double TOLERANCE = 1e-6;        // Relative tolerance of the results.
+
+/// Solves the system by GMRES with the preconditioner pc (none if NULL), returns the solution
+/// vector (to be deleted by the caller), or NULL if the solver did not converge. The forms are
+/// evaluated at coeff_vec.
+double* run(DiscreteProblem<double>* dp, double* coeff_vec, int ndof, Precond<double>* pc, const char* name)
+{
+  CSRMatrix<double> matrix;
+  KrylovVector<double> rhs;
+  // The structure of the previous matrix is kept by dp, the new one has to be allocated.
+  dp->invalidate_matrix();
+  dp->assemble(coeff_vec, &matrix, &rhs);
+
+  KrylovSolver<double> solver(&matrix, &rhs);
+  solver.set_solver("gmres");
+  solver.set_tolerance(KRYLOV_TOL);
+  solver.set_max_iters(KRYLOV_MAX_ITER);
+  if (pc != NULL)
+    solver.set_precond(pc);
+
+  Hermes::TimePeriod cpu_time;
+  bool converged = solver.solve();
+  cpu_time.tick();
+  info("%s: %d iterations, %g s.", name, solver.get_num_iters(), cpu_time.last());
+  if (!converged)
+    return NULL;
+
+  double* sln_vector = new double[ndof];
+  memcpy(sln_vector, solver.get_sln_vector(), ndof * sizeof(double));
+  return sln_vector;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, new Hermes1DFunction<double>(1.0), new Hermes2DFunction<double>(-1.0));
+  DefaultEssentialBCConst<double> bc_essential("1", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space(&mesh, &bcs, P_INIT);
+  int ndof = space.get_num_dofs();
+  info("ndof: %d.", ndof);
+
+  DiscreteProblem<double> dp(&wf, &space);
+
+  // The forms of DefaultWeakFormPoisson are evaluated at the previous Newton iterate, the system
+  // is linear, so zero is used.
+  double* coeff_vec = new double[ndof];
+  memset(coeff_vec, 0, ndof * sizeof(double));
+
+  // Reference solution.
+  SparseMatrix<double>* matrix = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs = create_vector<double>(SOLVER_UMFPACK);
+  LinearSolver<double>* direct = create_linear_solver<double>(SOLVER_UMFPACK, matrix, rhs);
+  dp.assemble(coeff_vec, matrix, rhs);
+  if (!direct->solve())
+    error("UMFPack failed.");
+  double* sln_direct = new double[ndof];
+  memcpy(sln_direct, direct->get_sln_vector(), ndof * sizeof(double));
+  delete direct;
+  delete matrix;
+  delete rhs;
+
+  Hermes::vector<Space<double>*> spaces;
+  spaces.push_back(&space);
+  std::vector<std::vector<int> > node_blocks, element_blocks;
+  Space<double>::get_dof_blocks(spaces, node_blocks);
+  Space<double>::get_dof_blocks(spaces, element_blocks, true);
+  info("%d node blocks, %d element blocks.", (int) node_blocks.size(), (int) element_blocks.size());
+
+  BlockJacobiPrecond<double> node_block_jacobi(node_blocks);
+  BlockJacobiPrecond<double> element_block_jacobi(element_blocks);
+  IluPrecond<double> ilu0;
+  IluPrecond<double> ilut(1e-4, 20);
+  SsorPrecond<double> ssor(1.2);
+
+  const int num_runs = 6;
+  Precond<double>* preconds[num_runs] = { NULL, &node_block_jacobi, &element_block_jacobi, &ilu0, &ilut, &ssor };
+  const char* names[num_runs] = { "No preconditioner", "Block Jacobi (nodes)", "Block Jacobi (elements)", "ILU(0)", "ILUT", "SSOR" };
+
+  double max = 0.0;
+  for (int i = 0; i < ndof; i++)
+    max = std::max(max, std::abs(sln_direct[i]));
+  bool success = true;
+  for (int run_i = 0; run_i < num_runs; run_i++)
+  {
+    double* sln_krylov = run(&dp, coeff_vec, ndof, preconds[run_i], names[run_i]);
+    if (sln_krylov == NULL)
+    {
+      success = false;
+      continue;
+    }
+    for (int i = 0; i < ndof; i++)
+      if (std::abs(sln_krylov[i] - sln_direct[i]) > TOLERANCE * max)
+        success = false;
+    delete [] sln_krylov;
+  }
+
+  delete [] sln_direct;
+  delete [] coeff_vec;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,108 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the assembling of the residual and the jacobian in one traversal in the
+// Newton's method (NewtonSolver::set_fused_assembling(), NewtonSolver::set_speculative_jacobian()).
+// A nonlinear heat problem -div(lambda(u) grad u) = 1 with lambda(u) = 1 + u^2 is solved by the
+// Newton's method with the residual and the jacobian assembled separately, assembled together in
+// the first iteration and assembled together in every iteration. The test fails if the solutions
+// differ by more than the rounding errors.
+
+const int INIT_REF_NUM = 5;           // Number of initial uniform refinements of the mesh.
+const int P_INIT = 3;                 // Polynomial degree of the space.
+const double NEWTON_TOL = 1e-10;      // Stopping criterion of the Newton's method.
+const int NEWTON_MAX_ITER = 20;       // Maximum allowed number of Newton iterations.
+const double TOLERANCE = 1e-10;       // Relative tolerance of the results.
+
+/// Thermal conductivity lambda(u) = 1 + u^2.
+class CustomLambda : public Hermes1DFunction<double>
+{
+public:
+  CustomLambda() : Hermes1DFunction<double>() {};
+
+  virtual double value(double u) const { return 1.0 + u * u; }
+  virtual Ord value(Ord u) const { return Ord(1) + u * u; }
+  virtual double derivative(double u) const { return 2.0 * u; }
+  virtual Ord derivative(Ord u) const { return Ord(2) * u; }
+};
+
+/// Weak form of -div(lambda(u) grad u) = 1.
+class CustomWeakForm : public WeakForm<double>
+{
+public:
+  CustomWeakForm(Hermes1DFunction<double>* lambda) : WeakForm<double>(1)
+  {
+    add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0, HERMES_ANY, lambda));
+    add_vector_form(new DefaultResidualDiffusion<double>(0, HERMES_ANY, lambda));
+    add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(-1.0)));
+  }
+};
+
+/// Solves the problem in the spaces of dp, returns the solution vector (to be deleted by the caller).
+double* run(DiscreteProblem<double>* dp, Hermes::vector<const Space<double>*> spaces, bool fused_assembling,
+  bool speculative_jacobian, const char* name)
+{
+  int ndof = Space<double>::get_num_dofs(spaces);
+  NewtonSolver<double> newton(dp, SOLVER_UMFPACK);
+  newton.set_verbose_output(false);
+  newton.set_fused_assembling(fused_assembling);
+  newton.set_speculative_jacobian(speculative_jacobian);
+  newton.solve(NULL, NEWTON_TOL, NEWTON_MAX_ITER);
+  info("%s: assembling %g s, solving %g s.", name, newton.get_assemble_time(), newton.get_solve_time());
+
+  double* sln_vector = new double[ndof];
+  memcpy(sln_vector, newton.get_sln_vector(), ndof * sizeof(double));
+  return sln_vector;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  CustomLambda lambda;
+  CustomWeakForm wf(&lambda);
+  DefaultEssentialBCConst<double> bc_essential("1", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space(&mesh, &bcs, P_INIT);
+  int ndof = space.get_num_dofs();
+  info("ndof: %d.", ndof);
+
+  Hermes::vector<const Space<double>*> spaces;
+  spaces.push_back(&space);
+  DiscreteProblem<double> dp(&wf, spaces);
+  double* sln_separate = run(&dp, spaces, false, false, "Separate assembling");
+  double* sln_fused = run(&dp, spaces, true, false, "Fused assembling in the first iteration");
+  double* sln_speculative = run(&dp, spaces, true, true, "Fused assembling in every iteration");
+
+  double max = 0.0;
+  for (int i = 0; i < ndof; i++)
+    max = std::max(max, std::abs(sln_separate[i]));
+  bool success = true;
+  for (int i = 0; i < ndof; i++)
+    if (std::abs(sln_fused[i] - sln_separate[i]) > TOLERANCE * max
+      || std::abs(sln_speculative[i] - sln_separate[i]) > TOLERANCE * max)
+      success = false;
+
+  delete [] sln_separate;
+  delete [] sln_fused;
+  delete [] sln_speculative;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
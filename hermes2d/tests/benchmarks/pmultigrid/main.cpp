@@ -0,0 +1,121 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+using namespace Hermes::Preconditioners;
+
+// This is a benchmark of the p-multigrid (PMultigridPrecond, PMultigridSolver) with the levels given
+// by Space::get_order_hierarchy(). The Poisson equation -Laplace u = 1 is solved in a space of a high
+// polynomial degree by UMFPack, by CG preconditioned by the p-multigrid and by the p-multigrid solver.
+// The test fails if any of the iterative solvers does not converge or if its solution differs from
+// the solution by UMFPack by more than the tolerance of the solvers allows.
+
+const int INIT_REF_NUM = 3;           // Number of initial uniform refinements of the mesh.
+const int P_INIT = 8;                 // Polynomial degree of the space.
+const double TOL = 1e-10;             // Relative residual of the iterative solvers.
+const int MAX_ITER = 500;             // Maximum allowed number of iterations.
+const double TOLERANCE = 1e-6;        // Relative tolerance of the results.
+
+/// Returns true if the solution differs from the reference solution at most by the tolerance.
+bool compare(double* sln, double* sln_ref, int ndof)
+{
+  double max = 0.0;
+  for (int i = 0; i < ndof; i++)
+    max = std::max(max, std::abs(sln_ref[i]));
+  for (int i = 0; i < ndof; i++)
+    if (std::abs(sln[i] - sln_ref[i]) > TOLERANCE * max)
+      return false;
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, new Hermes1DFunction<double>(1.0), new Hermes2DFunction<double>(-1.0));
+  DefaultEssentialBCConst<double> bc_essential("1", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space(&mesh, &bcs, P_INIT);
+  int ndof = space.get_num_dofs();
+  info("ndof: %d.", ndof);
+
+  DiscreteProblem<double> dp(&wf, &space);
+
+  // The forms of DefaultWeakFormPoisson are evaluated at the previous Newton iterate, the system
+  // is linear, so zero is used.
+  double* coeff_vec = new double[ndof];
+  memset(coeff_vec, 0, ndof * sizeof(double));
+
+  // Reference solution.
+  SparseMatrix<double>* matrix = create_matrix<double>(SOLVER_UMFPACK);
+  Vector<double>* rhs = create_vector<double>(SOLVER_UMFPACK);
+  LinearSolver<double>* direct = create_linear_solver<double>(SOLVER_UMFPACK, matrix, rhs);
+  dp.assemble(coeff_vec, matrix, rhs);
+  if (!direct->solve())
+    error("UMFPack failed.");
+  info("UMFPack: %g s.", direct->get_time());
+  double* sln_direct = new double[ndof];
+  memcpy(sln_direct, direct->get_sln_vector(), ndof * sizeof(double));
+  delete direct;
+  delete matrix;
+  delete rhs;
+
+  Hermes::TimePeriod cpu_time;
+  Hermes::vector<Space<double>*> spaces;
+  spaces.push_back(&space);
+  std::vector<std::vector<int> > levels;
+  Space<double>::get_order_hierarchy(spaces, levels);
+  cpu_time.tick();
+  info("%d levels, the coarsest one with %d DOFs: %g s.", (int) levels.size() + 1, (int) levels.back().size(), cpu_time.last());
+
+  CSRMatrix<double> krylov_matrix;
+  KrylovVector<double> krylov_rhs;
+  // The structure of the UMFPack matrix is kept by dp, the CSR one has to be allocated.
+  dp.invalidate_matrix();
+  dp.assemble(coeff_vec, &krylov_matrix, &krylov_rhs);
+
+  bool success = true;
+
+  // CG preconditioned by the p-multigrid.
+  PMultigridPrecond<double> multigrid(levels);
+  KrylovSolver<double> cg(&krylov_matrix, &krylov_rhs);
+  cg.set_solver("cg");
+  cg.set_precond(&multigrid);
+  cg.set_tolerance(TOL);
+  cg.set_max_iters(MAX_ITER);
+  if (cg.solve())
+    success = compare(cg.get_sln_vector(), sln_direct, ndof) && success;
+  else
+    success = false;
+  info("CG with the p-multigrid: %d iterations, %g s.", cg.get_num_iters(), cg.get_time());
+
+  // The p-multigrid solver.
+  PMultigridSolver<double> pmg(&krylov_matrix, &krylov_rhs, levels);
+  pmg.set_tolerance(TOL);
+  pmg.set_max_iters(MAX_ITER);
+  if (pmg.solve())
+    success = compare(pmg.get_sln_vector(), sln_direct, ndof) && success;
+  else
+    success = false;
+  info("p-multigrid solver: %d iterations, %g s.", pmg.get_num_iters(), pmg.get_time());
+
+  delete [] sln_direct;
+  delete [] coeff_vec;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
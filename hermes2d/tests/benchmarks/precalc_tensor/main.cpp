@@ -0,0 +1,155 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a micro-benchmark of the sum-factorized evaluation of the shape functions on quads
+// (Shapeset::get_tensor_values(), used by PrecalcShapeset and Solution). For p = 2..10, the
+// values, x- and y-derivatives of all shape functions of H1Shapeset and L2Shapeset of the order p
+// are evaluated at the points of the integration rule of the order 2p, pointwise (as before)
+// and sum-factorized. The test fails if the values are not exactly the same, or if the tables
+// of a Solution on quads do not match its values evaluated at single points.
+
+const int P_MIN = 2;                  // Lowest polynomial degree.
+const int P_MAX = 10;                 // Highest polynomial degree.
+const int NUM_REPEATS = 20;           // Number of evaluations of the tables that are timed.
+const double SLN_TOLERANCE = 1e-12;   // Relative tolerance of the values of the Solution.
+
+/// Gives access to the (protected) evaluation of the shape functions.
+template<typename ShapesetType>
+class TensorBenchmark : public ShapesetType
+{
+public:
+  TensorBenchmark() { this->set_mode(HERMES_MODE_QUAD); }
+
+  /// Times the evaluation of the tables of the shape functions of the space on the element e (of the order p),
+  /// returns false if the results differ.
+  bool run(const char* name, Space<double>* space, Element* e, int p)
+  {
+    AsmList<double> al;
+    space->get_element_assembly_list(e, &al);
+    std::vector<int> indices;
+    for (unsigned int l = 0; l < al.get_cnt(); l++)
+      if (this->is_tensor_fn(al.get_idx()[l]))
+        indices.push_back(al.get_idx()[l]);
+
+    // Points of the tensor-product rule.
+    int order = std::min(2 * p, g_quad_2d_std.get_max_order());
+    int np_1d = g_quad_2d_std.get_tensor_num_points(order);
+    int np = g_quad_2d_std.get_num_points(order);
+    double3* pt = g_quad_2d_std.get_points(order);
+    double* x_1d = new double[np_1d];
+    double* y_1d = new double[np_1d];
+    for (int i = 0; i < np_1d; i++)
+    {
+      x_1d[i] = pt[i * np_1d][0];
+      y_1d[i] = pt[i][1];
+    }
+
+    int size = 3 * indices.size() * np;
+    double* values_direct = new double[size];
+    double* values_tensor = new double[size];
+
+    TimePeriod timer;
+    timer.tick();
+    for (int r = 0; r < NUM_REPEATS; r++)
+    {
+      double* values = values_direct;
+      for (int k = 0; k < 3; k++)
+        for (unsigned int l = 0; l < indices.size(); l++, values += np)
+          for (int i = 0; i < np; i++)
+            values[i] = this->get_value(k, indices[l], pt[i][0], pt[i][1], 0);
+    }
+    timer.tick();
+    double time_direct = timer.last();
+
+    timer.tick();
+    for (int r = 0; r < NUM_REPEATS; r++)
+    {
+      double* values = values_tensor;
+      for (int k = 0; k < 3; k++)
+        for (unsigned int l = 0; l < indices.size(); l++, values += np)
+          this->get_tensor_values(k, indices[l], np_1d, x_1d, np_1d, y_1d, values);
+    }
+    timer.tick();
+    double time_tensor = timer.last();
+
+    bool success = (indices.size() == al.get_cnt()) && (np == np_1d * np_1d) && memcmp(values_direct, values_tensor, size * sizeof(double)) == 0;
+    info("%s, p = %d: %d functions, %d points, pointwise %g s, sum-factorized %g s.", name, p,
+      (int) indices.size(), np, time_direct, time_tensor);
+
+    delete [] values_direct;
+    delete [] values_tensor;
+    delete [] x_1d;
+    delete [] y_1d;
+    return success;
+  }
+};
+
+/// Compares the values of a Solution of the order p on quads with its values at single points.
+bool check_solution(Mesh* mesh, int p)
+{
+  H1Space<double> space(mesh, p);
+  int ndof = space.get_num_dofs();
+  double* coeff_vec = new double[ndof];
+  for (int i = 0; i < ndof; i++)
+    coeff_vec[i] = std::sin(1.0 + i);
+  Solution<double> sln;
+  Solution<double>::vector_to_solution(coeff_vec, &space, &sln);
+
+  bool success = true;
+  int order = std::min(2 * p, g_quad_2d_std.get_max_order());
+  int np = g_quad_2d_std.get_num_points(order);
+  double3* pt = g_quad_2d_std.get_points(order);
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    sln.set_active_element(e);
+    sln.set_quad_order(order, H2D_FN_VAL);
+    double* values = sln.get_fn_values();
+    for (int i = 0; i < np; i++)
+    {
+      double value = sln.get_ref_value(e, pt[i][0], pt[i][1], 0, 0);
+      if (std::abs(values[i] - value) > SLN_TOLERANCE * (1.0 + std::abs(value)))
+        success = false;
+    }
+  }
+  delete [] coeff_vec;
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+
+  g_quad_2d_std.set_mode(HERMES_MODE_QUAD);
+  TensorBenchmark<H1Shapeset> h1_shapeset;
+  TensorBenchmark<L2Shapeset> l2_shapeset;
+
+  bool success = true;
+  for (int p = P_MIN; p <= P_MAX; p++)
+  {
+    H1Space<double> h1_space(&mesh, p);
+    L2Space<double> l2_space(&mesh, p);
+    if (!h1_shapeset.run("H1Shapeset", &h1_space, mesh.get_element(0), p))
+      success = false;
+    if (!l2_shapeset.run("L2Shapeset", &l2_space, mesh.get_element(0), p))
+      success = false;
+    if (!check_solution(&mesh, p))
+      success = false;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
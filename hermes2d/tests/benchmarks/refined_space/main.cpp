@@ -0,0 +1,133 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// This is a benchmark of the construction of the reference spaces in an adaptivity loop. A coarse
+// space is adapted in NUM_STEPS steps (without solving anything): every other step refines some of
+// its elements, the other steps increase orders of some elements. In every step, the reference space
+// is constructed by Space::construct_refined_space() (from scratch) and by RefinedSpaceBuilder (which
+// reuses the reference space of the previous step). The test fails if the reference spaces differ.
+
+const int INIT_REF_NUM = 5;           // Number of initial uniform refinements of the coarse mesh.
+const int P_INIT = 2;                 // Initial polynomial degree of the coarse space.
+const int NUM_STEPS = 20;             // Number of adaptivity steps.
+const int NUM_CHANGED = 16;           // Number of elements changed in an adaptivity step.
+const int P_MAX = 8;                  // Maximum polynomial degree of the coarse space.
+
+/// Gives access to the (protected) setting of element orders without assigning DOFs.
+class BenchmarkSpace : public H1Space<double>
+{
+public:
+  BenchmarkSpace(Mesh* mesh, EssentialBCs<double>* bcs, int p_init) : H1Space<double>(mesh, bcs, p_init) {}
+
+  /// Refines the element, the sons inherit its order.
+  void refine_element(Element* e)
+  {
+    int o = get_element_order(e->id);
+    mesh->refine_element_id(e->id);
+    for (int j = 0; j < 4; j++)
+      set_element_order_internal(e->sons[j]->id, o);
+  }
+
+  /// Increases the order of the element by one.
+  void increase_order(Element* e)
+  {
+    int o = std::min(H2D_GET_H_ORDER(get_element_order(e->id)) + 1, P_MAX);
+    set_element_order_internal(e->id, H2D_MAKE_QUAD_ORDER(o, o));
+  }
+};
+
+/// Returns false if the spaces have different DOFs.
+bool compare(Space<double>* space, Space<double>* other)
+{
+  if (space->get_num_dofs() != other->get_num_dofs())
+    return false;
+
+  AsmList<double> al, other_al;
+  Element* e;
+  for_all_active_elements(e, space->get_mesh())
+  {
+    Element* other_e = other->get_mesh()->get_element(e->id);
+    if (!other_e->active)
+      return false;
+    space->get_element_assembly_list(e, &al);
+    other->get_element_assembly_list(other_e, &other_al);
+    if (al.get_cnt() != other_al.get_cnt())
+      return false;
+    for (unsigned int i = 0; i < al.get_cnt(); i++)
+      if (al.get_idx()[i] != other_al.get_idx()[i] || al.get_dof()[i] != other_al.get_dof()[i])
+        return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("1", 1.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  BenchmarkSpace space(&mesh, &bcs, P_INIT);
+  RefinedSpaceBuilder<double> builder(&space);
+
+  bool success = true;
+  double time_construct = 0.0, time_builder = 0.0;
+  TimePeriod timer;
+  for (int step = 0; step < NUM_STEPS; step++)
+  {
+    // Adapt the coarse space.
+    if (step > 0)
+    {
+      std::vector<Element*> elements;
+      Element* e;
+      for_all_active_elements(e, &mesh)
+        elements.push_back(e);
+      for (int i = 0; i < NUM_CHANGED; i++)
+      {
+        e = elements[(step * 7919 + i * 104729) % elements.size()];
+        if (step % 2)
+          space.increase_order(e);
+        else if (e->active)
+          space.refine_element(e);
+      }
+      space.assign_dofs();
+    }
+
+    timer.tick();
+    Space<double>* ref_space = Space<double>::construct_refined_space(&space);
+    timer.tick();
+    double time_construct_step = timer.last();
+
+    Space<double>* ref_space_builder = builder.get_refined_space();
+    timer.tick();
+    double time_builder_step = timer.last();
+
+    if (!compare(ref_space, ref_space_builder))
+      success = false;
+    info("Step %d, ndof_fine %d: construct_refined_space %g s, RefinedSpaceBuilder %g s.", step,
+      ref_space->get_num_dofs(), time_construct_step, time_builder_step);
+    time_construct += time_construct_step;
+    time_builder += time_builder_step;
+
+    delete ref_space->get_mesh();
+    delete ref_space;
+  }
+  info("Total: construct_refined_space %g s, RefinedSpaceBuilder %g s.", time_construct, time_builder);
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
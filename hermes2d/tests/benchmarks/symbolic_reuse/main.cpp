@@ -0,0 +1,96 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the reuse of the symbolic factorization by the structure fingerprint
+// of the matrix (SparseMatrix::get_structure_fingerprint()). A sequence of problems
+// -div(k grad u) = 1 with changing k is assembled by new DiscreteProblems to the same matrix,
+// as in time stepping, and solved by two UMFPack solvers, one of them factorizing from scratch
+// every time. Then the polynomial degree of the space is raised, so that the structure changes.
+// The test fails if the solutions differ or if the symbolic factorization is not skipped exactly
+// for the problems with the structure of the previous one.
+
+const int INIT_REF_NUM = 4;           // Number of initial uniform refinements of the mesh.
+const int P_INIT = 4;                 // Polynomial degree of the space.
+const int NUM_STEPS = 10;             // Number of problems with the same structure.
+const double TOLERANCE = 1e-10;       // Relative tolerance of the results.
+
+/// Assembles the problem with the coefficient k, solves it by both solvers and compares the solutions.
+bool step(Space<double>* space, double k, UMFPackMatrix<double>* matrix, UMFPackVector<double>* rhs,
+  UMFPackLinearSolver<double>* reuse, UMFPackLinearSolver<double>* scratch, double& time_reuse, double& time_scratch)
+{
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, new Hermes1DFunction<double>(k), new Hermes2DFunction<double>(-1.0));
+  DiscreteProblem<double> dp(&wf, space);
+  // The forms are evaluated at the previous Newton iterate, the problem is linear, so zero is used.
+  int ndof = space->get_num_dofs();
+  double* coeff_vec = new double[ndof];
+  memset(coeff_vec, 0, ndof * sizeof(double));
+  dp.assemble(coeff_vec, matrix, rhs);
+  delete [] coeff_vec;
+
+  if (!reuse->solve() || !scratch->solve())
+    return false;
+  time_reuse += reuse->get_time();
+  time_scratch += scratch->get_time();
+
+  double max = 0.0;
+  for (int i = 0; i < ndof; i++)
+    max = std::max(max, std::abs(scratch->get_sln_vector()[i]));
+  for (int i = 0; i < ndof; i++)
+    if (std::abs(reuse->get_sln_vector()[i] - scratch->get_sln_vector()[i]) > TOLERANCE * max)
+      return false;
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh.refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("1", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space(&mesh, &bcs, P_INIT);
+  info("ndof: %d.", space.get_num_dofs());
+
+  UMFPackMatrix<double> matrix;
+  UMFPackVector<double> rhs;
+  UMFPackLinearSolver<double> reuse(&matrix, &rhs);
+  UMFPackLinearSolver<double> scratch(&matrix, &rhs);
+  scratch.set_structure_reuse_detection(false);
+
+  bool success = true;
+  double time_reuse = 0.0, time_scratch = 0.0;
+  for (int i = 0; i < NUM_STEPS; i++)
+    success = step(&space, 1.0 + 0.1 * i, &matrix, &rhs, &reuse, &scratch, time_reuse, time_scratch) && success;
+  info("Same structure: %d symbolic factorizations skipped.", reuse.get_num_skipped_symbolic_factorizations());
+  if (reuse.get_num_skipped_symbolic_factorizations() != NUM_STEPS - 1)
+    success = false;
+
+  // The structure changes, the first factorization has to be done from scratch.
+  space.set_uniform_order(P_INIT + 1);
+  info("ndof: %d.", space.get_num_dofs());
+  for (int i = 0; i < 2; i++)
+    success = step(&space, 2.0 + 0.1 * i, &matrix, &rhs, &reuse, &scratch, time_reuse, time_scratch) && success;
+  info("Changed structure: %d symbolic factorizations skipped.", reuse.get_num_skipped_symbolic_factorizations());
+  if (reuse.get_num_skipped_symbolic_factorizations() != NUM_STEPS)
+    success = false;
+
+  info("Solving with the reuse: %g s, from scratch: %g s.", time_reuse, time_scratch);
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -0,0 +1,168 @@
+#define HERMES_REPORT_INFO
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// This is a benchmark of the recorded traversals of the union of meshes (TraversePlan). A coupled
+// problem with three components is defined on three differently refined meshes (so that the union
+// mesh differs from each of them) and assembled NUM_ASSEMBLINGS times, with the traversal of the
+// meshes recorded in the first assembling and reused in the following ones, and with the meshes
+// traversed in every assembling. The recorded traversal is used both by the serial and by the
+// threaded assembling. The test fails if the matrices or the right-hand sides differ.
+
+const int INIT_REF_NUM = 4;           // Number of initial uniform refinements of the meshes.
+const int P_INIT = 2;                 // Polynomial degree of the spaces.
+const int NUM_ASSEMBLINGS = 10;       // Number of assemblings that are timed.
+const int NUM_THREADS = 4;            // Number of threads of the threaded assembling.
+const double TOLERANCE = 1e-12;       // Relative tolerance of the results.
+const int NUM_COMPONENTS = 3;
+
+/// Weak form coupling all components, with a surface form on the boundary.
+class CustomWeakForm : public WeakForm<double>
+{
+public:
+  CustomWeakForm() : WeakForm<double>(NUM_COMPONENTS)
+  {
+    for (int i = 0; i < NUM_COMPONENTS; i++)
+    {
+      add_matrix_form(new DefaultJacobianDiffusion<double>(i, i));
+      for (int j = 0; j < NUM_COMPONENTS; j++)
+        if (i != j)
+          add_matrix_form(new DefaultMatrixFormVol<double>(i, j, HERMES_ANY, new Hermes2DFunction<double>(0.1)));
+      add_vector_form(new DefaultVectorFormVol<double>(i));
+      add_vector_form_surf(new DefaultVectorFormSurf<double>(i));
+    }
+  }
+};
+
+/// Gives access to the (protected) values of the matrix.
+class BenchmarkMatrix : public UMFPackMatrix<double>
+{
+public:
+  /// Returns false if the matrices differ.
+  bool same_values(BenchmarkMatrix& other)
+  {
+    if (get_size() != other.get_size() || get_nnz() != other.get_nnz())
+      return false;
+    double max = 0.0;
+    for (unsigned int i = 0; i < get_nnz(); i++)
+      max = std::max(max, std::abs(get_Ax()[i]));
+    for (unsigned int i = 0; i < get_nnz(); i++)
+      if (std::abs(get_Ax()[i] - other.get_Ax()[i]) > TOLERANCE * max)
+        return false;
+    return true;
+  }
+};
+
+/// Assembles the problem NUM_ASSEMBLINGS times at the coefficient vector coeff_vec, returns the
+/// time of one assembling.
+double run(DiscreteProblem<double>& dp, double* coeff_vec, BenchmarkMatrix& matrix, UMFPackVector<double>& rhs,
+  const char* name)
+{
+  TimePeriod timer;
+  timer.tick();
+  for (int i = 0; i < NUM_ASSEMBLINGS; i++)
+    dp.assemble(coeff_vec, &matrix, &rhs);
+  timer.tick();
+  double time = timer.last() / NUM_ASSEMBLINGS;
+  info("%s: %g s per assembling.", name, time);
+  return time;
+}
+
+/// Returns false if the matrices or the right-hand sides differ.
+bool compare(BenchmarkMatrix& matrix, Vector<double>& rhs, BenchmarkMatrix& other_matrix, Vector<double>& other_rhs)
+{
+  if (!matrix.same_values(other_matrix) || rhs.length() != other_rhs.length())
+    return false;
+  double max = 0.0;
+  for (unsigned int i = 0; i < rhs.length(); i++)
+    max = std::max(max, std::abs(rhs.get(i)));
+  for (unsigned int i = 0; i < rhs.length(); i++)
+    if (std::abs(rhs.get(i) - other_rhs.get(i)) > TOLERANCE * max)
+      return false;
+  return true;
+}
+
+/// Returns a zero coefficient vector of the length ndof (to be deleted by the caller).
+double* zero_coeff_vec(int ndof)
+{
+  double* coeff_vec = new double[ndof];
+  memset(coeff_vec, 0, ndof * sizeof(double));
+  return coeff_vec;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh[NUM_COMPONENTS];
+  MeshReaderH2D mloader;
+  mloader.load("../square.mesh", &mesh[0]);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh[0].refine_all_elements();
+  for (int i = 1; i < NUM_COMPONENTS; i++)
+    mesh[i].copy(&mesh[0]);
+  mesh[0].refine_towards_vertex(0, 4);
+  mesh[1].refine_towards_vertex(2, 4);
+  mesh[2].refine_towards_boundary("1", 2);
+
+  CustomWeakForm wf;
+  DefaultEssentialBCConst<double> bc_essential("1", 1.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  H1Space<double> space_0(&mesh[0], &bcs, P_INIT);
+  H1Space<double> space_1(&mesh[1], P_INIT);
+  H1Space<double> space_2(&mesh[2], P_INIT + 1);
+  Hermes::vector<const Space<double>*> spaces(&space_0, &space_1, &space_2);
+  info("ndof: %d.", Space<double>::get_num_dofs(spaces));
+
+  // The Jacobian forms are evaluated at the previous Newton iterate, zero is used.
+  double* coeff_vec = zero_coeff_vec(Space<double>::get_num_dofs(spaces));
+
+  DiscreteProblem<double> dp_traverse(&wf, spaces);
+  dp_traverse.set_reuse_traversal(false);
+  BenchmarkMatrix matrix_traverse;
+  UMFPackVector<double> rhs_traverse;
+  run(dp_traverse, coeff_vec, matrix_traverse, rhs_traverse, "Traversal in every assembling");
+
+  DiscreteProblem<double> dp_plan(&wf, spaces);
+  BenchmarkMatrix matrix_plan;
+  UMFPackVector<double> rhs_plan;
+  run(dp_plan, coeff_vec, matrix_plan, rhs_plan, "Recorded traversal");
+
+  DiscreteProblem<double> dp_threaded(&wf, spaces);
+  dp_threaded.set_num_threads(NUM_THREADS);
+  BenchmarkMatrix matrix_threaded;
+  UMFPackVector<double> rhs_threaded;
+  run(dp_threaded, coeff_vec, matrix_threaded, rhs_threaded, "Recorded traversal, threads");
+
+  bool success = compare(matrix_traverse, rhs_traverse, matrix_plan, rhs_plan)
+    && compare(matrix_traverse, rhs_traverse, matrix_threaded, rhs_threaded);
+
+  // The traversal has to be recorded again after the meshes change.
+  Element* e;
+  for_all_active_elements(e, &mesh[1])
+  {
+    mesh[1].refine_element_id(e->id);
+    break;
+  }
+  space_1.set_uniform_order(P_INIT);
+  // The discrete problem offsets the DOFs of the spaces, each of them is numbered from zero.
+  space_1.assign_dofs();
+  delete [] coeff_vec;
+  coeff_vec = zero_coeff_vec(Space<double>::get_num_dofs(spaces));
+  run(dp_traverse, coeff_vec, matrix_traverse, rhs_traverse, "Refined, traversal in every assembling");
+  run(dp_plan, coeff_vec, matrix_plan, rhs_plan, "Refined, recorded traversal");
+  success = success && compare(matrix_traverse, rhs_traverse, matrix_plan, rhs_plan);
+  delete [] coeff_vec;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return TEST_SUCCESS;
+  }
+  else
+  {
+    printf("Failure!\n");
+    return TEST_FAILURE;
+  }
+}
@@ -99,6 +99,15 @@ namespace Hermes
         this->append_only = append_only;
       }
 
+      /// Allocates in advance the pages for the items with id numbers up to size - 1,
+      /// so that the following calls of add() do not allocate memory. The id numbers
+      /// assigned by add() stay the same.
+      void reserve(int size)
+      {
+        while ((int) pages.size() << HERMES_PAGE_BITS < size)
+          pages.push_back(new TYPE[HERMES_PAGE_SIZE]);
+      }
+
       /// Wrapper function for Hermes::vector::add() for compatibility purposes.
       int add(TYPE item)
       {
@@ -116,7 +125,7 @@ namespace Hermes
         TYPE* item;
         if (unused.empty() || append_only)
         {
-          if (!(size & HERMES_PAGE_MASK))
+          if ((size >> HERMES_PAGE_BITS) == (int) pages.size())
           {
             TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
             pages.push_back(new_page);
@@ -260,7 +269,8 @@ namespace Hermes
       /// This is a special-purpose function used to create empty element slots.
       void skip_slot()
       {
-        if (!(size & HERMES_PAGE_MASK))
+        // The page may have been allocated by reserve() already.
+        if ((size >> HERMES_PAGE_BITS) == (int) pages.size())
         {
           TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
           pages.push_back(new_page);
@@ -57,6 +57,7 @@
 #include "hermes_logging.h"
 #include "hermes_function.h"
 #include "common_time_period.h"
+#include "memory_arena.h"
 #include "compat.h"
 #include "callstack.h"
 #include "error.h"
@@ -149,16 +150,18 @@ namespace Hermes
     SOLVER_MUMPS,
     SOLVER_SUPERLU,
     SOLVER_AMESOS,
-    SOLVER_AZTECOO
+    SOLVER_AZTECOO,
+    SOLVER_KRYLOV
   };
 
-  const std::string MatrixSolverNames[6] = {
+  const std::string MatrixSolverNames[7] = {
     "UMFPACK",
     "PETSc",
     "MUMPS",
     "SuperLU",
     "Trilinos/Amesos",
-    "Trilinos/AztecOO"
+    "Trilinos/AztecOO",
+    "Krylov"
   };
 
   struct HERMES_API SplineCoeff
@@ -30,7 +30,10 @@
 #include "solvers/petsc_solver.h"
 #include "solvers/umfpack_solver.h"
 #include "solvers/superlu_solver.h"
+#include "solvers/krylov_solver.h"
 #include "solvers/precond.h"
 #include "solvers/precond_ifpack.h"
 #include "solvers/precond_ml.h"
+#include "solvers/precond_native.h"
+#include "solvers/pmultigrid_solver.h"
 #include "solvers/eigensolver.h"
@@ -438,7 +438,34 @@ namespace Hermes
         return 0;
       }
 
+      /// True if add() can be called concurrently for disjoint sets of rows and columns,
+      /// i.e. add() does not change the sparse structure of the matrix.
+      virtual bool is_concurrent_add_supported() const { return false; }
+
+      /// Fingerprint of the sparse structure, a hash of the structure arrays and of the sequence
+      /// number given by set_structure_seq(). Direct solvers compare it with the fingerprint
+      /// of the last symbolic factorization to find out whether it can be reused.
+      /// @return the fingerprint, 0 if the matrix type does not provide it
+      unsigned long long get_structure_fingerprint();
+
+      /// Set the sequence number of the structure (DiscreteProblem uses the sequence numbers
+      /// of its spaces), it becomes a part of the fingerprint.
+      void set_structure_seq(int seq);
+
     protected:
+      /// Hash of the structure arrays, 0 if the matrix type does not provide it.
+      virtual unsigned long long compute_structure_hash() { return 0; }
+      /// Has to be called whenever the structure arrays change (alloc(), free(), create()).
+      void invalidate_structure_fingerprint();
+      /// Adds n bytes of data to the FNV-1a hash (a new hash by default).
+      static unsigned long long hash_bytes(const void* data, size_t n, unsigned long long hash = 14695981039346656037ULL);
+
+      /// The cached fingerprint.
+      unsigned long long structure_fingerprint;
+      bool structure_fingerprint_valid;
+      /// The sequence number given by set_structure_seq().
+      int structure_seq;
+
       /// Size of page (max number of indices stored in one page).
       static const int PAGE_SIZE = 62;
 
@@ -524,6 +551,9 @@ namespace Hermes
       /// @param[in] y   - values
       virtual void add(unsigned int n, unsigned int *idx, Scalar *y) = 0;
 
+      /// True if add() can be called concurrently for disjoint sets of indices.
+      virtual bool is_concurrent_add_supported() const { return false; }
+
       /// Get vector length.
       unsigned int length() const {return this->size;}
 
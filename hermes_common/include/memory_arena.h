@@ -0,0 +1,168 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file memory_arena.h
+    \brief File containing the class MemoryArena, a bump allocator of short-lived temporaries.
+*/
+#ifndef __HERMES_COMMON_MEMORY_ARENA_H
+#define __HERMES_COMMON_MEMORY_ARENA_H
+
+#include <vector>
+#include <new>
+#include <stddef.h>
+#include "compat.h"
+
+namespace Hermes
+{
+  /// A bump allocator of short-lived temporaries.
+  /** Memory is handed out from large chunks and is never released one piece at a time,
+  *  all of it is released at once by reset(). After a reset the chunks are merged into one
+  *  that is large enough for the peak use so far, so that an arena that is reset in a loop
+  *  stops allocating from the heap after the first few iterations.
+  *
+  *  Every thread may have a current arena (set_current()). The functions allocate_current()
+  *  and new_array() use the current arena of the calling thread if there is one and the heap
+  *  otherwise. Every block records where it was taken from, so free_current() and delete_array()
+  *  may be called whatever arena is current then; they release heap blocks and leave arena
+  *  blocks to reset(). The memory obtained while an arena was current has to be freed (or
+  *  forgotten) before the arena is reset.
+  *
+  *  An instance of the arena should not be used across threads. The class is not thread-safe. */
+  class HERMES_API MemoryArena
+  {
+  public:
+    /// Constructor.
+    /** \param[in] chunk_size Size of the first chunk (in bytes). */
+    MemoryArena(size_t chunk_size = 64 * 1024);
+
+    /// Destructor, releases all chunks.
+    ~MemoryArena();
+
+    /// Returns a block of (at least) size bytes, aligned to 16 bytes.
+    void* allocate(size_t size);
+
+    /// Returns true if ptr points into the memory of this arena.
+    bool contains(const void* ptr) const;
+
+    /// Releases all memory obtained from the arena.
+    void reset();
+
+    /// Returns the number of bytes currently obtained from the arena.
+    size_t get_size() const;
+
+    /// Returns the maximum number of bytes obtained from the arena at one time (since its construction).
+    size_t get_peak_size() const;
+
+    /// Returns the current arena of the calling thread (NULL if there is none).
+    static MemoryArena* get_current();
+
+    /// Sets the current arena of the calling thread, NULL stops using arenas.
+    /** \return The previous current arena of the calling thread. */
+    static MemoryArena* set_current(MemoryArena* arena);
+
+    /// Returns size bytes from the current arena of the calling thread, or from the heap.
+    static void* allocate_current(size_t size);
+
+    /// Frees the memory obtained by allocate_current().
+    static void free_current(void* ptr);
+
+    /// Allocates an array of n values of T, from the current arena of the calling thread, or from the heap.
+    template<typename T>
+    static T* new_array(int n)
+    {
+      T* array = static_cast<T*>(allocate_block(n * sizeof(T), n));
+      for (int i = 0; i < n; i++)
+        new (array + i) T();
+      return array;
+    }
+
+    /// Frees an array obtained by new_array(), the destructors of its values are run.
+    template<typename T>
+    static void delete_array(T* array)
+    {
+      if (array == NULL)
+        return;
+      size_t n = get_block_count(array);
+      for (size_t i = 0; i < n; i++)
+        array[i].~T();
+      free_block(array);
+    }
+
+  protected:
+    /// A piece of memory the blocks are taken from.
+    struct Chunk
+    {
+      char* data;
+      size_t size;
+    };
+
+    /// Adds a chunk that can hold at least size bytes.
+    void add_chunk(size_t size);
+
+    /// Header stored in front of the blocks of allocate_current() and new_array().
+    struct BlockHeader
+    {
+      MemoryArena* arena;  ///< The arena the block was taken from, NULL for the heap.
+      size_t count;        ///< Number of the values of new_array() in the block.
+    };
+
+    /// Returns size bytes after a header recording the owning arena and count.
+    static void* allocate_block(size_t size, size_t count);
+
+    /// Returns the count recorded in the header of the block.
+    static size_t get_block_count(void* ptr);
+
+    /// Releases the block if it was taken from the heap.
+    static void free_block(void* ptr);
+
+    std::vector<Chunk> chunks;
+    size_t chunk_size;   ///< Size of the next chunk.
+    size_t chunk_used;   ///< Number of bytes used in the last chunk.
+    size_t size;         ///< Number of bytes obtained from the arena.
+    size_t peak_size;    ///< Maximum of size.
+    size_t total_size;   ///< Sum of the sizes of all chunks.
+
+  private:
+    MemoryArena(const MemoryArena&);
+    MemoryArena& operator=(const MemoryArena&);
+  };
+
+  /// Makes an arena the current arena of the calling thread for the lifetime of the instance.
+  /** The destructor restores the previous current arena (also when an exception is thrown)
+  *  and, if requested, resets the arena. */
+  class HERMES_API MemoryArenaScope
+  {
+  public:
+    /// Constructor.
+    /** \param[in] arena The arena to make current, NULL stops using arenas in the scope.
+    *  \param[in] reset_on_exit Reset the arena after the previous current arena is restored. */
+    MemoryArenaScope(MemoryArena* arena, bool reset_on_exit = false);
+
+    /// Destructor, restores the previous current arena.
+    ~MemoryArenaScope();
+
+  private:
+    MemoryArena* arena;
+    MemoryArena* previous_arena;
+    bool reset_on_exit;
+
+    MemoryArenaScope(const MemoryArenaScope&);
+    MemoryArenaScope& operator=(const MemoryArenaScope&);
+  };
+}
+#endif
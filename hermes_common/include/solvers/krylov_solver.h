@@ -0,0 +1,269 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file krylov_solver.h
+\brief Native Krylov subspace solvers (CG, BiCGStab, GMRES) working with the CSR matrix format.
+*/
+#ifndef __HERMES_COMMON_KRYLOV_SOLVER_H_
+#define __HERMES_COMMON_KRYLOV_SOLVER_H_
+#include "config.h"
+#include "linear_solver.h"
+#include "matrix.h"
+#include "exceptions.h"
+
+using namespace Hermes::Algebra;
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    template <typename Scalar> class HERMES_API KrylovSolver;
+  }
+
+  namespace Algebra
+  {
+    using namespace Hermes::Solvers;
+
+    /// \brief General CSR Matrix class.
+    ///
+    /// The matrix is stored by rows, so that the product with a vector can be computed
+    /// by multiple threads, each of them writing its own rows of the result.
+    /// Requires OpenMP (WITH_OPENMP) for the threaded product.
+    template <typename Scalar>
+    class HERMES_API CSRMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      CSRMatrix();
+      /// \brief Constructor with specific size
+      /// @param[in] size size of matrix (number of rows and columns)
+      CSRMatrix(unsigned int size);
+      virtual ~CSRMatrix();
+
+      /// Creates matrix in CSR format using size, nnz, and the three arrays (the arrays are copied).
+      /// @param[in] size size of matrix (num of rows and columns)
+      /// @param[in] nnz number of nonzero values
+      /// @param[in] ap index to ap/ax, where each row starts (size is matrix size + 1)
+      /// @param[in] ai column indices
+      /// @param[in] ax values
+      void create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax);
+
+      /// Creates matrix from the arrays of a matrix in CSC format (e.g. CSCMatrix::get_Ap() etc.).
+      /// A symmetric matrix in CSC format is the same matrix in CSR format, then the arrays are
+      /// shared, not copied (they must not be freed before this matrix, and changes of the values
+      /// are seen by both matrices). Otherwise the matrix is transposed into new arrays.
+      /// @param[in] symmetric the matrix is symmetric (the values, not only the structure)
+      void create_from_csc(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax, bool symmetric = false);
+
+      /// Number of threads computing the product with a vector (1 by default).
+      void set_num_threads(int num_threads);
+
+      virtual void alloc();
+      virtual void free();
+      virtual Scalar get(unsigned int m, unsigned int n);
+      virtual void zero();
+      virtual void add(unsigned int m, unsigned int n, Scalar v);
+      virtual void add_to_diagonal(Scalar v);
+      virtual void add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols);
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+      virtual unsigned int get_matrix_size() const;
+      virtual unsigned int get_nnz() const;
+      virtual double get_fill_in() const;
+      virtual bool is_concurrent_add_supported() const;
+      virtual int get_num_row_entries(unsigned int row);
+
+      /// Applies the matrix to vector_in and saves result to vector_out (row by row, in parallel).
+      virtual void multiply_with_vector(Scalar* vector_in, Scalar* vector_out);
+      /// Multiplies matrix with a Scalar.
+      virtual void multiply_with_Scalar(Scalar value);
+
+      /// @return pointer to #Ap
+      int *get_Ap();
+      /// @return pointer to #Ai
+      int *get_Ai();
+      /// @return pointer to #Ax
+      Scalar *get_Ax();
+
+    protected:
+      /// Matrix entries (row-wise).
+      Scalar *Ax;
+      /// Column indices of values in Ax.
+      int *Ai;
+      /// Index to Ax/Ai, where each row starts.
+      int *Ap;
+      /// Number of non-zero entries ( =  Ap[size]).
+      unsigned int nnz;
+      /// The arrays are shared with a CSC matrix (create_from_csc()) and are not deleted.
+      bool shared_arrays;
+      /// Number of threads computing the product with a vector.
+      int num_threads;
+
+      /// Position of the entry (m, n) in Ax, -1 if it is not in the structure.
+      int find_entry(unsigned int m, unsigned int n) const;
+
+      template <typename T> friend class Hermes::Solvers::KrylovSolver;
+      template<typename T> friend SparseMatrix<T>*  create_matrix(Hermes::MatrixSolverType matrix_solver_type);
+    };
+
+    /// \brief Class representing the vector for the native Krylov solvers.
+    template <typename Scalar>
+    class HERMES_API KrylovVector : public Vector<Scalar>
+    {
+    public:
+      KrylovVector();
+      /// Constructor of vector with specific size.
+      /// @param[in] size size of vector
+      KrylovVector(unsigned int size);
+      virtual ~KrylovVector();
+
+      virtual void alloc(unsigned int ndofs);
+      virtual void free();
+      virtual Scalar get(unsigned int idx);
+      virtual void extract(Scalar *v) const;
+      virtual void zero();
+      virtual void change_sign();
+      virtual void set(unsigned int idx, Scalar y);
+      virtual void add(unsigned int idx, Scalar y);
+      virtual void add(unsigned int n, unsigned int *idx, Scalar *y);
+      virtual void add_vector(Vector<Scalar>* vec);
+      virtual void add_vector(Scalar* vec);
+      virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+      virtual bool is_concurrent_add_supported() const;
+
+      /// @return pointer to array with vector data
+      /// \sa #v
+      Scalar *get_c_array();
+
+    protected:
+      Scalar *v;
+      template <typename T> friend class Hermes::Solvers::KrylovSolver;
+    };
+  }
+
+  namespace Solvers
+  {
+    /// \brief A linear operator y = A x that is not stored as a matrix (matrix-free solves).
+    ///
+    /// It is solved by the KrylovSolver, e.g. the matrix of a DiscreteProblem applied by
+    /// DiscreteProblem::apply().
+    template <typename Scalar>
+    class KrylovOperator
+    {
+    public:
+      virtual ~KrylovOperator() {};
+
+      /// Returns the number of rows (and columns) of the operator.
+      virtual unsigned int get_size() = 0;
+
+      /// Computes y = A x.
+      virtual void apply(const Scalar* x, Scalar* y) = 0;
+    };
+
+    /// \brief Native Krylov subspace solvers.
+    ///
+    /// Conjugate gradients (for symmetric/hermitian positive definite matrices), BiCGStab and
+    /// restarted GMRES, without external libraries. The system is solved to the relative
+    /// residual norm given by set_tolerance(), starting from the zero vector. BiCGStab and GMRES
+    /// are preconditioned from the right, CG by a symmetric preconditioner (Jacobi, SSOR).
+    ///
+    /// @ingroup solvers
+    template <typename Scalar>
+    class HERMES_API KrylovSolver : public IterSolver<Scalar>
+    {
+    public:
+      /// Constructor of the Krylov solver.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      KrylovSolver(CSRMatrix<Scalar> *m, KrylovVector<Scalar> *rhs);
+      /// Constructor of the matrix-free Krylov solver. The preconditioners given by name
+      /// need a matrix, a preconditioner set by set_precond(Precond<Scalar>*) is applied
+      /// as it is (it is not created from the operator).
+      /// @param[in] op pointer to the operator
+      /// @param[in] rhs pointer to right hand side vector
+      KrylovSolver(KrylovOperator<Scalar> *op, KrylovVector<Scalar> *rhs);
+      virtual ~KrylovSolver();
+
+      /// Set the type of the solver
+      /// @param[in] solver - name of the solver [ gmres | cg | bicgstab ] (gmres by default)
+      void set_solver(const char *solver);
+
+      /// Set the number of iterations after which GMRES is restarted (30 by default).
+      void set_restart(int restart);
+
+      /// Set the number of threads computing the products of the matrix with vectors (1 by default).
+      /// Not used by the matrix-free solver.
+      void set_num_threads(int num_threads);
+
+      /// Set preconditioner.
+      /// @param[in] name - name of the preconditioner [ none | jacobi | ilu | ilut | ssor ]
+      virtual void set_precond(const char *name);
+      /// Set preconditioner, it has to implement Precond::apply() (see precond_native.h).
+      /// It is not deleted by the solver.
+      virtual void set_precond(Precond<Scalar> *pc);
+
+      virtual bool solve();
+      virtual int get_matrix_size();
+      virtual int get_num_iters();
+      virtual double get_residual();
+
+    protected:
+      /// Krylov methods.
+      enum Method
+      {
+        KRYLOV_CG,
+        KRYLOV_BICGSTAB,
+        KRYLOV_GMRES
+      };
+
+      /// Conjugate gradients.
+      bool solve_cg(Scalar* b, Scalar* x);
+      /// BiCGStab.
+      bool solve_bicgstab(Scalar* b, Scalar* x);
+      /// Restarted GMRES.
+      bool solve_gmres(Scalar* b, Scalar* x);
+
+      /// z = M^{-1} r by the preconditioner, z = r without it.
+      void precondition(Scalar* r, Scalar* z);
+
+      /// y = A x by the matrix or by the operator.
+      void multiply(Scalar* x, Scalar* y);
+
+      /// Matrix to solve (NULL for the matrix-free solver).
+      CSRMatrix<Scalar> *m;
+      /// Operator to solve (NULL if there is a matrix).
+      KrylovOperator<Scalar> *op;
+      /// Right hand side vector.
+      KrylovVector<Scalar> *rhs;
+
+      Method method;
+      int restart;
+
+      /// Preconditioner (NULL for none).
+      Precond<Scalar> *pc;
+      /// The preconditioner was created by set_precond(const char*) and is deleted by the solver.
+      bool own_pc;
+
+      /// Number of iterations of the last solve().
+      int num_iters;
+      /// Relative residual norm reached by the last solve().
+      double residual;
+
+      template<typename T> friend LinearSolver<T>* create_linear_solver(Hermes::MatrixSolverType matrix_solver_type, Matrix<T>* matrix, Vector<T>* rhs);
+    };
+  }
+}
+#endif
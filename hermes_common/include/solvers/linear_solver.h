@@ -74,6 +74,13 @@ namespace Hermes
     /// <b>Typical scenario:</b>
     /// When \c rhsonly was set to \c true for the assembly phase,
     /// \c HERMES_REUSE_FACTORIZATION_COMPLETELY should be set for the following solution phase.
+    ///
+    /// <b>Automatic reuse:</b>
+    /// UMFPack, SuperLU and MUMPS compare the structure fingerprint of the matrix
+    /// (SparseMatrix::get_structure_fingerprint()) with the one of the last symbolic factorization.
+    /// If it matches, \c HERMES_FACTORIZE_FROM_SCRATCH is performed as \c HERMES_REUSE_MATRIX_REORDERING,
+    /// if it does not, any scheme is performed as \c HERMES_FACTORIZE_FROM_SCRATCH
+    /// (see DirectSolver::set_structure_reuse_detection()).
     enum FactorizationScheme
     {
       HERMES_FACTORIZE_FROM_SCRATCH,              ///< Perform new factorization, don't reuse
@@ -138,12 +145,31 @@ namespace Hermes
     {
     public:
       DirectSolver(unsigned int factorization_scheme = HERMES_FACTORIZE_FROM_SCRATCH)
-        : LinearSolver<Scalar>(), factorization_scheme(factorization_scheme) {};
+        : LinearSolver<Scalar>(), factorization_scheme(factorization_scheme), structure_reuse_detection(true),
+        symbolic_fingerprint(0), num_skipped_symbolic_factorizations(0) {};
+
+      /// Enable or disable the automatic reuse of the symbolic factorization for matrices
+      /// with the same structure fingerprint (enabled by default).
+      void set_structure_reuse_detection(bool enable);
+
+      /// Number of the factorizations which reused the symbolic factorization (the reordering)
+      /// of a previous one.
+      int get_num_skipped_symbolic_factorizations() const;
 
     protected:
       virtual void set_factorization_scheme(FactorizationScheme reuse_scheme);
 
+      /// The factorization scheme to be performed, see FactorizationScheme.
+      /// @param[in] m the matrix to be factorized
+      /// @param[in] has_factorization the solver keeps the data of a previous factorization
+      unsigned int get_effective_factorization_scheme(SparseMatrix<Scalar>* m, bool has_factorization);
+
       unsigned int factorization_scheme;
+
+      bool structure_reuse_detection;
+      /// Structure fingerprint of the matrix of the last symbolic factorization.
+      unsigned long long symbolic_fingerprint;
+      int num_skipped_symbolic_factorizations;
     };
 
     /// \brief  Abstract class for defining interface for iterative solvers.
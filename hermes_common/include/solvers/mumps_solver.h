@@ -122,6 +122,8 @@ namespace Hermes
       typename mumps_type<Scalar>::mumps_Scalar *Ax; ///< Matrix entries (column-wise).
       int *Ai;          ///< Row indices of values in Ax.
       unsigned int *Ap;          ///< Index to Ax/Ai, where each column starts.
+      /// Hash of the size, Ap and Ai.
+      virtual unsigned long long compute_structure_hash();
 
       friend class Solvers::MumpsSolver<Scalar>;
     };
@@ -51,13 +51,13 @@ namespace Hermes
       /// Sets the attribute verbose_output to the paramater passed.
       void set_verbose_output(bool verbose_output_to_set);
 
-      /// Set the name of the iterative method employed by AztecOO (ignored
-      /// by the other solvers).
+      /// Set the name of the iterative method employed by AztecOO or by the
+      /// native Krylov solvers (ignored by the other solvers).
       /// \param[in] preconditioner_name See the attribute preconditioner.
       void set_iterative_method(const char* iterative_method_name);
 
-      /// Set the name of the preconditioner employed by AztecOO (ignored by
-      /// the other solvers).
+      /// Set the name of the preconditioner employed by AztecOO or by the
+      /// native Krylov solvers (ignored by the other solvers).
       /// \param[in] preconditioner_name See the attribute preconditioner.
       void set_preconditioner(const char* preconditioner_name);
 
@@ -74,7 +74,7 @@ namespace Hermes
 
       /// Linear solver to use, choices:
       /// SOLVER_AMESOS, SOLVER_AZTECOO, SOLVER_MUMPS,
-      /// SOLVER_PETSC, SOLVER_SUPERLU, SOLVER_UMFPACK.
+      /// SOLVER_PETSC, SOLVER_SUPERLU, SOLVER_UMFPACK, SOLVER_KRYLOV.
       /// Default: SOLVER_UMFPACK.
       Hermes::MatrixSolverType matrix_solver_type;
 
@@ -87,7 +87,8 @@ namespace Hermes
 
       /// Name of the iterative method employed by AztecOO (ignored
       /// by the other solvers).
-      /// Possibilities: gmres, cg, cgs, tfqmr, bicgstab.
+      /// Possibilities: gmres, cg, cgs, tfqmr, bicgstab (gmres, cg, bicgstab
+      /// for the native Krylov solvers).
       char* iterative_method;
 
       /// Name of the preconditioner employed by AztecOO (ignored by
@@ -0,0 +1,172 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file pmultigrid_solver.h
+\brief p-multigrid solver and preconditioner working with the CSR matrix format.
+*/
+#ifndef __HERMES_COMMON_PMULTIGRID_SOLVER_H_
+#define __HERMES_COMMON_PMULTIGRID_SOLVER_H_
+
+#include "precond_native.h"
+#include "krylov_solver.h"
+#include <vector>
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    /// \brief p-multigrid preconditioner.
+    ///
+    /// With a hierarchical shapeset the basis functions of a space with lower polynomial orders
+    /// are basis functions of the original space, so the DOFs of every coarser level are a subset
+    /// of the DOFs of the finer level (Space::get_order_hierarchy() in Hermes2D gives the levels
+    /// down to the order 1). The prolongation is then the injection of the DOFs, the restriction
+    /// its transpose and the Galerkin coarse operators P^T A P are submatrices of the finer ones.
+    ///
+    /// apply() performs one V-cycle with the zero initial guess: smoothing (SSOR by default, see
+    /// set_smoother()) on all levels but the coarsest one, where the system is solved by a direct
+    /// solver factorized once in compute() (see set_coarse_solver()). Without a direct solver in
+    /// the build the coarsest level is solved by the native Krylov solver (SOLVER_KRYLOV). With a
+    /// symmetric smoother and the same number of pre- and post-smoothing steps the preconditioner
+    /// is symmetric, so it can be used by CG.
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API PMultigridPrecond : public NativePrecond<Scalar>
+    {
+    public:
+      PMultigridPrecond();
+      /// @param[in] levels for every level but the finest one (from the finer to the coarser levels)
+      /// the DOF of the finer level of each its DOF
+      PMultigridPrecond(const std::vector<std::vector<int> >& levels);
+      virtual ~PMultigridPrecond();
+
+      /// Sets the levels, for every level but the finest one (from the finer to the coarser levels)
+      /// the DOF of the finer level of each its DOF.
+      void set_levels(const std::vector<std::vector<int> >& levels);
+
+      /// Set the smoother.
+      /// @param[in] name - name of the smoother [ ssor | jacobi ] (ssor by default, jacobi is damped by 2/3)
+      void set_smoother(const char *name);
+
+      /// Set the number of smoothing steps before and after the coarse grid correction (2 and 2 by default).
+      void set_smoothing_steps(int pre_smoothing_steps, int post_smoothing_steps);
+
+      /// Set the solver of the coarsest level. By default the first of UMFPack, SuperLU and MUMPS
+      /// Hermes was built with, SOLVER_KRYLOV (ILU(0) preconditioned GMRES) if there is none.
+      void set_coarse_solver(Hermes::MatrixSolverType coarse_solver_type);
+
+      /// Number of the levels including the finest one.
+      int get_num_levels() const;
+
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      virtual void compute_internal();
+      virtual void free_internal();
+
+      /// Smoothers.
+      enum Smoother
+      {
+        SMOOTHER_SSOR,
+        SMOOTHER_JACOBI
+      };
+
+      /// Computes the Galerkin operator of the level from the matrix of the finer level.
+      CSRMatrix<Scalar>* restrict_matrix(int level);
+      /// Creates the smoother of the level.
+      NativePrecond<Scalar>* create_smoother(int level);
+      /// Sets up the direct solver of the coarsest level.
+      void create_coarse_solver();
+
+      /// The V-cycle on the level, improves x.
+      void cycle(int level, Scalar* b, Scalar* x);
+      /// Steps of the smoother on the level, improve x.
+      void smooth(int level, Scalar* b, Scalar* x, int steps);
+      /// r = b - A x on the level.
+      void compute_residual(int level, Scalar* b, Scalar* x, Scalar* r);
+
+      /// The levels given by set_levels().
+      std::vector<std::vector<int> > levels;
+
+      Smoother smoother_type;
+      int pre_smoothing_steps, post_smoothing_steps;
+      Hermes::MatrixSolverType coarse_solver_type;
+
+      /// The matrices of the levels, the first one is the matrix of the preconditioner.
+      std::vector<CSRMatrix<Scalar>*> matrices;
+      /// The smoothers of the levels but the coarsest one.
+      std::vector<NativePrecond<Scalar>*> smoothers;
+      /// Work vectors of the levels (right hand side, solution, residual, correction).
+      std::vector<std::vector<Scalar> > level_b, level_x, level_r, level_z;
+
+      /// The direct solver of the coarsest level.
+      SparseMatrix<Scalar>* coarse_matrix;
+      Vector<Scalar>* coarse_rhs;
+      LinearSolver<Scalar>* coarse_solver;
+    };
+  }
+
+  namespace Solvers
+  {
+    /// \brief p-multigrid solver.
+    ///
+    /// Repeats the V-cycles of PMultigridPrecond until the relative residual norm given by
+    /// set_tolerance() is reached, starting from the zero vector. As a preconditioner of CG
+    /// or GMRES (KrylovSolver::set_precond()) the p-multigrid is usually more robust.
+    ///
+    /// @ingroup solvers
+    template <typename Scalar>
+    class HERMES_API PMultigridSolver : public IterSolver<Scalar>
+    {
+    public:
+      /// Constructor of the p-multigrid solver.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      /// @param[in] levels the levels, see PMultigridPrecond::set_levels()
+      PMultigridSolver(CSRMatrix<Scalar> *m, KrylovVector<Scalar> *rhs, const std::vector<std::vector<int> >& levels);
+      virtual ~PMultigridSolver();
+
+      /// The multigrid cycle, to set the smoother etc.
+      Hermes::Preconditioners::PMultigridPrecond<Scalar>* get_multigrid();
+
+      /// The multigrid is the preconditioner, other preconditioners are not used.
+      virtual void set_precond(const char *name);
+      virtual void set_precond(Precond<Scalar> *pc);
+
+      virtual bool solve();
+      virtual int get_matrix_size();
+      virtual int get_num_iters();
+      virtual double get_residual();
+
+    protected:
+      /// Matrix to solve.
+      CSRMatrix<Scalar> *m;
+      /// Right hand side vector.
+      KrylovVector<Scalar> *rhs;
+
+      Hermes::Preconditioners::PMultigridPrecond<Scalar> multigrid;
+
+      /// Number of iterations of the last solve().
+      int num_iters;
+      /// Relative residual norm reached by the last solve().
+      double residual;
+    };
+  }
+}
+#endif
@@ -26,6 +26,7 @@
 // solver libraries via config.h.
 
 #include "matrix.h"
+#include "exceptions.h"
 
 #ifdef HAVE_EPETRA
 #include <Epetra_Operator.h>
@@ -50,10 +51,22 @@ namespace Hermes
 #endif
     {
     public:
+      virtual ~Precond() {};
+
       virtual void create(Matrix<Scalar> *mat) = 0;
       virtual void destroy() = 0;
       virtual void compute() = 0;
 
+      /// Applies the preconditioner to a vector, z = M^{-1} r. This is the library-neutral
+      /// interface used by the native solvers, the preconditioners of the external libraries
+      /// are applied by them (see get_obj()).
+      /// @param[in] r the vector to precondition
+      /// @param[out] z the preconditioned vector
+      virtual void apply(Scalar* r, Scalar* z)
+      {
+        throw Hermes::Exceptions::Exception("The preconditioner can only be applied by its library.");
+      }
+
 #ifdef HAVE_EPETRA
       virtual Epetra_Operator *get_obj() = 0;
 
@@ -0,0 +1,211 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file precond_native.h
+\brief Native algebraic preconditioners (Jacobi, block Jacobi, ILU, SSOR) working with the CSR matrix format.
+*/
+#ifndef __HERMES_COMMON_PRECOND_NATIVE_H_
+#define __HERMES_COMMON_PRECOND_NATIVE_H_
+
+#include "precond.h"
+#include "krylov_solver.h"
+#include <vector>
+
+#ifdef HAVE_EPETRA
+#include <Epetra_SerialComm.h>
+#include <Epetra_Map.h>
+#include <Epetra_MultiVector.h>
+#endif
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    /// \brief Base class of the preconditioners that need no external library.
+    ///
+    /// The preconditioners work with CSRMatrix (SOLVER_KRYLOV). A CSCMatrix (SOLVER_UMFPACK)
+    /// is accepted as well, it is converted in every compute(). They are applied by apply(),
+    /// and with Epetra they are also Epetra operators, so that AztecOO can use them (real only).
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API NativePrecond : public Precond<Scalar>
+    {
+    public:
+      NativePrecond();
+      virtual ~NativePrecond();
+
+      /// Sets the matrix, the preconditioner is computed from its current values by compute().
+      virtual void create(Matrix<Scalar> *mat);
+      virtual void destroy();
+      virtual void compute();
+
+      virtual void apply(Scalar* r, Scalar* z) = 0;
+
+#ifdef HAVE_EPETRA
+      virtual Epetra_Operator *get_obj() { return this; }
+
+      // Epetra_Operator interface
+      virtual int ApplyInverse(const Epetra_MultiVector &r, Epetra_MultiVector &z) const;
+      virtual const Epetra_Comm &Comm() const { return comm; }
+      virtual const Epetra_Map &OperatorDomainMap() const { return *map; }
+      virtual const Epetra_Map &OperatorRangeMap() const { return *map; }
+#endif
+
+    protected:
+      /// Computes the preconditioner from the matrix a.
+      virtual void compute_internal() = 0;
+      /// Frees the data of the preconditioner.
+      virtual void free_internal() = 0;
+
+      /// The matrix passed to create().
+      Matrix<Scalar> *mat;
+      /// The matrix in the CSR format (mat itself or its copy).
+      CSRMatrix<Scalar> *a;
+      /// The matrix a is a copy of mat owned by the preconditioner.
+      bool own_a;
+      /// Size of the matrix.
+      int size;
+
+#ifdef HAVE_EPETRA
+      Epetra_SerialComm comm;
+      Epetra_Map *map;
+#endif
+    };
+
+    /// \brief Jacobi (diagonal) preconditioner.
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API JacobiPrecond : public NativePrecond<Scalar>
+    {
+    public:
+      JacobiPrecond();
+      virtual ~JacobiPrecond();
+
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      virtual void compute_internal();
+      virtual void free_internal();
+
+      /// Inverse of the diagonal.
+      Scalar *inv_diag;
+    };
+
+    /// \brief Block Jacobi preconditioner.
+    ///
+    /// The diagonal blocks of the matrix are given by sets of DOFs (e.g. by Space::get_dof_blocks()
+    /// in Hermes2D) and are factorized by the dense LU decomposition. The DOFs not in any block
+    /// form blocks of their own. Without blocks this is the Jacobi preconditioner.
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API BlockJacobiPrecond : public NativePrecond<Scalar>
+    {
+    public:
+      BlockJacobiPrecond();
+      /// @param[in] blocks the DOFs of the blocks, every DOF can be in one block at most
+      BlockJacobiPrecond(const std::vector<std::vector<int> >& blocks);
+      virtual ~BlockJacobiPrecond();
+
+      /// Sets the DOFs of the blocks, every DOF can be in one block at most.
+      void set_blocks(const std::vector<std::vector<int> >& blocks);
+
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      virtual void compute_internal();
+      virtual void free_internal();
+
+      /// The DOFs of the blocks given by set_blocks().
+      std::vector<std::vector<int> > blocks;
+
+      /// The DOFs of the blocks in the preconditioner (all DOFs, block by block), the start of every block in dofs.
+      std::vector<int> dofs, block_start;
+      /// The LU factors of the blocks stored row by row one after another, the start of every block in lu.
+      std::vector<Scalar> lu;
+      std::vector<int> lu_start;
+      /// Pivots of the LU factorization.
+      std::vector<int> pivots;
+    };
+
+    /// \brief Incomplete LU factorization.
+    ///
+    /// ILU(0) keeps the sparsity structure of the matrix. ILUT (the dual threshold variant) drops
+    /// the entries smaller than drop_tolerance times the norm of the row, and keeps at most fill
+    /// largest entries in every row of L and U (and the diagonal).
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API IluPrecond : public NativePrecond<Scalar>
+    {
+    public:
+      /// ILU(0).
+      IluPrecond();
+      /// ILUT.
+      /// @param[in] drop_tolerance relative drop tolerance of the entries
+      /// @param[in] fill number of the entries kept in every row of L and U
+      IluPrecond(double drop_tolerance, int fill);
+      virtual ~IluPrecond();
+
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      virtual void compute_internal();
+      virtual void free_internal();
+
+      void compute_ilu0();
+      void compute_ilut();
+
+      bool threshold;
+      double drop_tolerance;
+      int fill;
+
+      /// The factors, L (without the unit diagonal) and U, in the CSR format with sorted columns.
+      std::vector<int> Lp, Li, Up, Ui;
+      std::vector<Scalar> Lx, Ux;
+    };
+
+    /// \brief Symmetric successive over-relaxation.
+    ///
+    /// M = omega / (2 - omega) (D / omega + L) (D / omega)^{-1} (D / omega + U), where D, L, U
+    /// are the diagonal, the strictly lower and the strictly upper part of the matrix.
+    ///
+    /// @ingroup preconds
+    template <typename Scalar>
+    class HERMES_API SsorPrecond : public NativePrecond<Scalar>
+    {
+    public:
+      /// @param[in] omega relaxation parameter from (0, 2)
+      SsorPrecond(double omega = 1.0);
+      virtual ~SsorPrecond();
+
+      virtual void apply(Scalar* r, Scalar* z);
+
+    protected:
+      virtual void compute_internal();
+      virtual void free_internal();
+
+      double omega;
+      /// Position of the diagonal entry of every row in the matrix.
+      int *diag_pos;
+    };
+  }
+}
+#endif
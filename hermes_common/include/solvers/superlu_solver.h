@@ -152,6 +152,8 @@ namespace Hermes
       unsigned int *Ap;
       /// Number of non-zero entries ( =  Ap[size]).
       unsigned int nnz;
+      /// Hash of the size, Ap and Ai.
+      virtual unsigned long long compute_structure_hash();
 
       friend class Solvers::SuperLUSolver<Scalar>;
     };
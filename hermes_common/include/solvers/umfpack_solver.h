@@ -37,6 +37,11 @@ namespace Hermes
     template <typename Scalar> class HERMES_API UMFPackIterator;
   }
 
+  namespace Preconditioners
+  {
+    template <typename Scalar> class HERMES_API NativePrecond;
+  }
+
   namespace Algebra
   {
     using namespace Hermes::Solvers;
@@ -54,6 +59,15 @@ namespace Hermes
       /// @param[in] ai row indices
       /// @param[in] ax values
       void create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax);
+
+      /// Use the scatter map in add(m, n, mat, rows, cols) (on by default).
+      /// The positions in Ax of the added blocks are stored during the first assembling
+      /// and reused when the same blocks are added in the same order again after zero()
+      /// or finish(), e.g. in Newton's iterations or time steps. Every reused position is
+      /// checked to belong to the row and column of the entry, so blocks added in another
+      /// order are added correctly (by the search) and the rest of the map is rebuilt.
+      /// @param[in] use_scatter_map if false, the map is not used and freed
+      void set_scatter_map(bool use_scatter_map);
     protected:
       CSCMatrix();
       /// \brief Constructor with specific size
@@ -65,6 +79,8 @@ namespace Hermes
       virtual void free();
       virtual Scalar get(unsigned int m, unsigned int n);
       virtual void zero();
+      /// Ends the assembling, the next blocks are added from the beginning of the scatter map.
+      virtual void finish();
       virtual void add(unsigned int m, unsigned int n, Scalar v);
       virtual void add_to_diagonal(Scalar v);
       /// Add matrix.
@@ -85,6 +101,7 @@ namespace Hermes
       virtual unsigned int get_matrix_size() const;
       virtual unsigned int get_nnz() const;
       virtual double get_fill_in() const;
+      virtual bool is_concurrent_add_supported() const;
 
       // Applies the matrix to vector_in and saves result to vector_out.
       void multiply_with_vector(Scalar* vector_in, Scalar* vector_out);
@@ -113,8 +130,20 @@ namespace Hermes
       int *Ap;
       /// Number of non-zero entries ( =  Ap[size]).
       unsigned int nnz;
+      /// Scatter map: positions in Ax of the entries added by add(m, n, mat, rows, cols)
+      /// since the last zero(), in the order of adding (-1 for zero values not in the structure).
+      Hermes::vector<int> scatter_map;
+      /// Current position in the scatter map.
+      unsigned int scatter_pos;
+      /// Use the scatter map.
+      bool use_scatter_map;
+      /// Position of the entry (m, n) in Ax, -1 if it is not in the structure.
+      int find_entry(unsigned int m, unsigned int n) const;
+      /// Hash of the size, Ap and Ai.
+      virtual unsigned long long compute_structure_hash();
       template <typename T> friend class Hermes::Solvers::UMFPackLinearSolver;
       template <typename T> friend class Hermes::Solvers::UMFPackIterator;
+      template <typename T> friend class Hermes::Preconditioners::NativePrecond;
       template<typename T> friend SparseMatrix<T>*  create_matrix(Hermes::MatrixSolverType matrix_solver_type);
     };
 
@@ -150,6 +179,7 @@ namespace Hermes
       virtual void add_vector(Vector<Scalar>* vec);
       virtual void add_vector(Scalar* vec);
       virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+      virtual bool is_concurrent_add_supported() const;
 
       /// @return pointer to array with vector data
       /// \sa #v
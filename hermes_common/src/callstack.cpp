@@ -23,6 +23,9 @@
 #include "third_party_codes/trilinos-teuchos/Teuchos_stacktrace.hpp"
 #include <signal.h>
 #include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /// Definition of the global CallStack instance.
 CallStack callstack;
@@ -33,6 +36,12 @@ CallStackObj::CallStackObj(int ln, const char *func, const char *file)
   this->func = func;
   this->file = file;
 
+#ifdef _OPENMP
+  // the call stack is kept for the master thread only
+  if (omp_get_thread_num() != 0)
+    return;
+#endif
+
   // add this object to the call stack
   if (callstack.size < callstack.max_size)
   {
@@ -43,6 +52,11 @@ CallStackObj::CallStackObj(int ln, const char *func, const char *file)
 
 CallStackObj::~CallStackObj()
 {
+#ifdef _OPENMP
+  if (omp_get_thread_num() != 0)
+    return;
+#endif
+
   // remove the object only if it is on the top of the call stack
   if (callstack.size > 0 && callstack.stack[callstack.size - 1] == this)
   {
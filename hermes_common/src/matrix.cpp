@@ -32,6 +32,7 @@
 #include "solvers/mumps_solver.h"
 #include "solvers/newton_solver_nox.h"
 #include "solvers/aztecoo_solver.h"
+#include "solvers/krylov_solver.h"
 #include "qsort.h"
 
 void Hermes::Algebra::DenseMatrixOperations::ludcmp(double **a, int n, int *indx, double *d)
@@ -119,6 +120,9 @@ Hermes::Algebra::SparseMatrix<Scalar>::SparseMatrix()
   _F_;
   this->size = 0;
   pages = NULL;
+  structure_fingerprint = 0;
+  structure_fingerprint_valid = false;
+  structure_seq = 0;
 
   row_storage = false;
   col_storage = false;
@@ -130,6 +134,9 @@ Hermes::Algebra::SparseMatrix<Scalar>::SparseMatrix(unsigned int size)
   _F_;
   this->size = size;
   pages = NULL;
+  structure_fingerprint = 0;
+  structure_fingerprint_valid = false;
+  structure_seq = 0;
 
   row_storage = false;
   col_storage = false;
@@ -209,6 +216,55 @@ int Hermes::Algebra::SparseMatrix<Scalar>::get_num_indices()
   return total;
 }
 
+template<typename Scalar>
+unsigned long long Hermes::Algebra::SparseMatrix<Scalar>::get_structure_fingerprint()
+{
+  _F_;
+  if (!structure_fingerprint_valid)
+  {
+    structure_fingerprint = compute_structure_hash();
+    if (structure_fingerprint != 0)
+    {
+      structure_fingerprint = hash_bytes(&structure_seq, sizeof(int), structure_fingerprint);
+      // 0 is reserved for "unknown".
+      if (structure_fingerprint == 0)
+        structure_fingerprint = 1;
+    }
+    structure_fingerprint_valid = true;
+  }
+  return structure_fingerprint;
+}
+
+template<typename Scalar>
+void Hermes::Algebra::SparseMatrix<Scalar>::set_structure_seq(int seq)
+{
+  _F_;
+  if (seq != structure_seq)
+  {
+    structure_seq = seq;
+    structure_fingerprint_valid = false;
+  }
+}
+
+template<typename Scalar>
+void Hermes::Algebra::SparseMatrix<Scalar>::invalidate_structure_fingerprint()
+{
+  _F_;
+  structure_fingerprint_valid = false;
+}
+
+template<typename Scalar>
+unsigned long long Hermes::Algebra::SparseMatrix<Scalar>::hash_bytes(const void* data, size_t n, unsigned long long hash)
+{
+  const unsigned char* bytes = (const unsigned char*) data;
+  for (size_t i = 0; i < n; i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
 template<typename Scalar>
 SparseMatrix<Scalar>* Hermes::Algebra::create_matrix(Hermes::MatrixSolverType matrix_solver_type)
 {
@@ -269,6 +325,11 @@ SparseMatrix<Scalar>* Hermes::Algebra::create_matrix(Hermes::MatrixSolverType ma
 #endif
       break;
     }
+  case Hermes::SOLVER_KRYLOV:
+    {
+      return new CSRMatrix<Scalar>;
+      break;
+    }
   default:
     error("Unknown matrix solver requested.");
   }
@@ -335,6 +396,11 @@ Vector<Scalar>* Hermes::Algebra::create_vector(Hermes::MatrixSolverType matrix_s
 #endif
       break;
     }
+  case Hermes::SOLVER_KRYLOV:
+    {
+      return new KrylovVector<Scalar>;
+      break;
+    }
   default:
     error("Unknown matrix solver requested.");
   }
@@ -0,0 +1,174 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file memory_arena.cpp
+    \brief File containing the class MemoryArena, a bump allocator of short-lived temporaries.
+*/
+#include "memory_arena.h"
+
+namespace Hermes
+{
+  /// Alignment of the blocks.
+  static const size_t ARENA_ALIGNMENT = 16;
+
+  /// Size of the header of the blocks of allocate_current() and new_array(), keeps them aligned.
+  static const size_t BLOCK_HEADER_SIZE = 16;
+
+  /// The current arena of the thread.
+  static MemoryArena* current_arena = NULL;
+#ifdef _OPENMP
+#pragma omp threadprivate(current_arena)
+#endif
+
+  MemoryArena::MemoryArena(size_t chunk_size) : chunk_size(chunk_size), chunk_used(0), size(0), peak_size(0), total_size(0)
+  {
+  }
+
+  MemoryArena::~MemoryArena()
+  {
+    for (unsigned int i = 0; i < chunks.size(); i++)
+      delete [] chunks[i].data;
+  }
+
+  void MemoryArena::add_chunk(size_t size)
+  {
+    while (chunk_size < size)
+      chunk_size *= 2;
+    Chunk chunk;
+    chunk.data = new char[chunk_size];
+    chunk.size = chunk_size;
+    chunks.push_back(chunk);
+    chunk_used = 0;
+    total_size += chunk_size;
+    // Every new chunk is twice as big as the last one.
+    chunk_size *= 2;
+  }
+
+  void* MemoryArena::allocate(size_t size)
+  {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+    if (size == 0)
+      size = ARENA_ALIGNMENT;
+    if (chunks.empty() || chunk_used + size > chunks.back().size)
+      add_chunk(size);
+
+    // new[] returns memory aligned for any fundamental type, the offsets are multiples of the alignment.
+    void* block = chunks.back().data + chunk_used;
+    chunk_used += size;
+    this->size += size;
+    if (this->size > peak_size)
+      peak_size = this->size;
+    return block;
+  }
+
+  bool MemoryArena::contains(const void* ptr) const
+  {
+    const char* p = static_cast<const char*>(ptr);
+    for (unsigned int i = 0; i < chunks.size(); i++)
+      if (p >= chunks[i].data && p < chunks[i].data + chunks[i].size)
+        return true;
+    return false;
+  }
+
+  void MemoryArena::reset()
+  {
+    // Merge the chunks into one, the next cycle will most likely need the same amount of memory.
+    if (chunks.size() > 1)
+    {
+      for (unsigned int i = 0; i < chunks.size(); i++)
+        delete [] chunks[i].data;
+      chunks.clear();
+      chunk_size = total_size;
+      total_size = 0;
+      add_chunk(chunk_size);
+    }
+    chunk_used = 0;
+    size = 0;
+  }
+
+  size_t MemoryArena::get_size() const
+  {
+    return size;
+  }
+
+  size_t MemoryArena::get_peak_size() const
+  {
+    return peak_size;
+  }
+
+  MemoryArena* MemoryArena::get_current()
+  {
+    return current_arena;
+  }
+
+  MemoryArena* MemoryArena::set_current(MemoryArena* arena)
+  {
+    MemoryArena* previous_arena = current_arena;
+    current_arena = arena;
+    return previous_arena;
+  }
+
+  void* MemoryArena::allocate_block(size_t size, size_t count)
+  {
+    char* block;
+    if (current_arena == NULL)
+      block = static_cast<char*>(::operator new(BLOCK_HEADER_SIZE + size));
+    else
+      block = static_cast<char*>(current_arena->allocate(BLOCK_HEADER_SIZE + size));
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(block);
+    header->arena = current_arena;
+    header->count = count;
+    return block + BLOCK_HEADER_SIZE;
+  }
+
+  size_t MemoryArena::get_block_count(void* ptr)
+  {
+    return reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - BLOCK_HEADER_SIZE)->count;
+  }
+
+  void MemoryArena::free_block(void* ptr)
+  {
+    char* block = static_cast<char*>(ptr) - BLOCK_HEADER_SIZE;
+    // The memory of an arena is released by reset().
+    if (reinterpret_cast<BlockHeader*>(block)->arena == NULL)
+      ::operator delete(block);
+  }
+
+  void* MemoryArena::allocate_current(size_t size)
+  {
+    return allocate_block(size, 0);
+  }
+
+  void MemoryArena::free_current(void* ptr)
+  {
+    if (ptr != NULL)
+      free_block(ptr);
+  }
+
+  MemoryArenaScope::MemoryArenaScope(MemoryArena* arena, bool reset_on_exit) : arena(arena), reset_on_exit(reset_on_exit)
+  {
+    previous_arena = MemoryArena::set_current(arena);
+  }
+
+  MemoryArenaScope::~MemoryArenaScope()
+  {
+    MemoryArena::set_current(previous_arena);
+    if (reset_on_exit && arena != NULL)
+      arena->reset();
+  }
+}
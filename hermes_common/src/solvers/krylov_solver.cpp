@@ -0,0 +1,1034 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file krylov_solver.cpp
+\brief Native Krylov subspace solvers (CG, BiCGStab, GMRES) working with the CSR matrix format.
+*/
+#include "config.h"
+#include "krylov_solver.h"
+#include "precond_native.h"
+#include "common_time_period.h"
+#include "error.h"
+#include "callstack.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace Hermes::Error;
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    /// Position of idx in the sorted array Ai of the length Alen, -1 if it is not there.
+    static int find_index(int *Ai, int Alen, int idx)
+    {
+      int lo = 0, hi = Alen - 1;
+      while (lo <= hi)
+      {
+        int mid = (lo + hi) >> 1;
+        if (idx < Ai[mid]) hi = mid - 1;
+        else if (idx > Ai[mid]) lo = mid + 1;
+        else return mid;
+      }
+      return -1;
+    }
+
+    /// Transposes the matrix (size, Ap, Ai, Ax) in a compressed format (CSC or CSR) into the
+    /// arrays Tp, Ti, Tx (Ax and Tx may be NULL). The indices in Ti come out sorted.
+    template<typename Scalar>
+    static void transpose_compressed(unsigned int size, int* Ap, int* Ai, Scalar* Ax, int* Tp, int* Ti, Scalar* Tx)
+    {
+      memset(Tp, 0, (size + 1) * sizeof(int));
+      for (int k = 0; k < Ap[size]; k++)
+        Tp[Ai[k] + 1]++;
+      for (unsigned int i = 0; i < size; i++)
+        Tp[i + 1] += Tp[i];
+
+      int* pos = new int[size];
+      memcpy(pos, Tp, size * sizeof(int));
+      for (unsigned int j = 0; j < size; j++)
+        for (int k = Ap[j]; k < Ap[j + 1]; k++)
+        {
+          int p = pos[Ai[k]]++;
+          Ti[p] = j;
+          if (Tx != NULL)
+            Tx[p] = Ax[k];
+        }
+      delete [] pos;
+    }
+
+    template<typename Scalar>
+    CSRMatrix<Scalar>::CSRMatrix()
+    {
+      _F_;
+      this->size = 0; nnz = 0;
+      Ap = NULL;
+      Ai = NULL;
+      Ax = NULL;
+      shared_arrays = false;
+      num_threads = 1;
+    }
+
+    template<typename Scalar>
+    CSRMatrix<Scalar>::CSRMatrix(unsigned int size)
+    {
+      _F_;
+      this->size = size; nnz = 0;
+      Ap = NULL;
+      Ai = NULL;
+      Ax = NULL;
+      shared_arrays = false;
+      num_threads = 1;
+      this->alloc();
+    }
+
+    template<typename Scalar>
+    CSRMatrix<Scalar>::~CSRMatrix()
+    {
+      _F_;
+      free();
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::alloc()
+    {
+      _F_;
+      assert(this->pages != NULL);
+
+      // The pages hold the row indices of the columns, sort them by columns first.
+      int* Cp = new int [this->size + 1];
+      MEM_CHECK(Cp);
+      int cisize = this->get_num_indices();
+      int* Ci = new int [cisize];
+      MEM_CHECK(Ci);
+
+      unsigned int i;
+      int pos = 0;
+      for (i = 0; i < this->size; i++)
+      {
+        Cp[i] = pos;
+        pos += this->sort_and_store_indices(this->pages[i], Ci + pos, Ci + cisize);
+      }
+      Cp[i] = pos;
+
+      delete [] this->pages;
+      this->pages = NULL;
+
+      // Then transpose the structure into rows.
+      nnz = Cp[this->size];
+      Ap = new int [this->size + 1];
+      MEM_CHECK(Ap);
+      Ai = new int [nnz];
+      MEM_CHECK(Ai);
+      transpose_compressed<Scalar>(this->size, Cp, Ci, NULL, Ap, Ai, NULL);
+      delete [] Cp;
+      delete [] Ci;
+
+      Ax = new Scalar [nnz];
+      MEM_CHECK(Ax);
+      memset(Ax, 0, sizeof(Scalar) * nnz);
+      shared_arrays = false;
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::free()
+    {
+      _F_;
+      nnz = 0;
+      if (!shared_arrays)
+      {
+        if (Ap != NULL) delete [] Ap;
+        if (Ai != NULL) delete [] Ai;
+        if (Ax != NULL) delete [] Ax;
+      }
+      Ap = NULL;
+      Ai = NULL;
+      Ax = NULL;
+      shared_arrays = false;
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax)
+    {
+      _F_;
+      free();
+      this->size = size;
+      this->nnz = nnz;
+
+      this->Ap = new int[this->size + 1]; assert(this->Ap != NULL);
+      this->Ai = new int[nnz];    assert(this->Ai != NULL);
+      this->Ax = new Scalar[nnz]; assert(this->Ax != NULL);
+
+      memcpy(this->Ap, ap, (this->size + 1) * sizeof(int));
+      memcpy(this->Ai, ai, nnz * sizeof(int));
+      memcpy(this->Ax, ax, nnz * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::create_from_csc(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax, bool symmetric)
+    {
+      _F_;
+      free();
+      this->size = size;
+      this->nnz = nnz;
+
+      if (symmetric)
+      {
+        // The columns of a symmetric matrix are its rows.
+        this->Ap = ap;
+        this->Ai = ai;
+        this->Ax = ax;
+        shared_arrays = true;
+        return;
+      }
+
+      this->Ap = new int[this->size + 1]; assert(this->Ap != NULL);
+      this->Ai = new int[nnz];    assert(this->Ai != NULL);
+      this->Ax = new Scalar[nnz]; assert(this->Ax != NULL);
+      transpose_compressed<Scalar>(size, ap, ai, ax, this->Ap, this->Ai, this->Ax);
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::set_num_threads(int num_threads)
+    {
+      _F_;
+      if(num_threads < 1)
+        error("The number of threads has to be positive.");
+#ifndef _OPENMP
+      if(num_threads > 1)
+      {
+        warning("Hermes was built without OpenMP, the matrix-vector product will be serial.");
+        num_threads = 1;
+      }
+#endif
+      this->num_threads = num_threads;
+    }
+
+    template<typename Scalar>
+    Scalar CSRMatrix<Scalar>::get(unsigned int m, unsigned int n)
+    {
+      _F_;
+      int pos = find_entry(m, n);
+      return pos < 0 ? Scalar(0.0) : Ax[pos];
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::zero()
+    {
+      _F_;
+      memset(Ax, 0, sizeof(Scalar) * nnz);
+    }
+
+    template<typename Scalar>
+    int CSRMatrix<Scalar>::find_entry(unsigned int m, unsigned int n) const
+    {
+      if (Ap[m + 1] == Ap[m])
+        return -1;
+      int pos = find_index(Ai + Ap[m], Ap[m + 1] - Ap[m], n);
+      return pos < 0 ? -1 : Ap[m] + pos;
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
+    {
+      _F_;
+      if (v != 0.0)   // ignore zero values.
+      {
+        int pos = find_entry(m, n);
+        // Make sure we are adding to an existing non-zero entry.
+        if (pos < 0)
+        {
+          info("CSRMatrix<Scalar>::add(): i = %d, j = %d.", m, n);
+          error("Sparse matrix entry not found");
+        }
+        Ax[pos] += v;
+      }
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::add_to_diagonal(Scalar v)
+    {
+      for (unsigned int i = 0; i < this->size; i++)
+        add(i, i, v);
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
+    {
+      _F_;
+      for (unsigned int i = 0; i < m; i++)       // rows
+        for (unsigned int j = 0; j < n; j++)     // cols
+          if(rows[i] >= 0 && cols[j] >= 0) // not Dir. dofs.
+            add(rows[i], cols[j], mat[i][j]);
+    }
+
+    template<typename Scalar>
+    bool CSRMatrix<Scalar>::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+    {
+      _F_;
+      switch (fmt)
+      {
+      case DF_MATLAB_SPARSE:
+        fprintf(file, "%% Size: %dx%d\n%% Nonzeros: %d\ntemp = zeros(%d, 3);\ntemp = [\n",
+          this->size, this->size, nnz, nnz);
+        for (unsigned int i = 0; i < this->size; i++)
+          for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          {
+            fprintf(file, "%d %d ", i + 1, Ai[k] + 1);
+            Hermes::Helpers::fprint_num(file, Ax[k]);
+            fprintf(file, "\n");
+          }
+        fprintf(file, "];\n%s = spconvert(temp);\n", var_name);
+        return true;
+
+      case DF_HERMES_BIN:
+        {
+          hermes_fwrite("HERMESX\001", 1, 8, file);
+          int ssize = sizeof(Scalar);
+          hermes_fwrite(&ssize, sizeof(int), 1, file);
+          hermes_fwrite(&this->size, sizeof(int), 1, file);
+          hermes_fwrite(&nnz, sizeof(int), 1, file);
+          hermes_fwrite(Ap, sizeof(int), this->size + 1, file);
+          hermes_fwrite(Ai, sizeof(int), nnz, file);
+          hermes_fwrite(Ax, sizeof(Scalar), nnz, file);
+          return true;
+        }
+
+      default:
+        return false;
+      }
+    }
+
+    template<typename Scalar>
+    unsigned int CSRMatrix<Scalar>::get_matrix_size() const
+    {
+      return this->size;
+    }
+
+    template<typename Scalar>
+    unsigned int CSRMatrix<Scalar>::get_nnz() const
+    {
+      return this->nnz;
+    }
+
+    template<typename Scalar>
+    double CSRMatrix<Scalar>::get_fill_in() const
+    {
+      _F_;
+      return nnz / (double) (this->size * this->size);
+    }
+
+    template<typename Scalar>
+    bool CSRMatrix<Scalar>::is_concurrent_add_supported() const
+    {
+      return true;
+    }
+
+    template<typename Scalar>
+    int CSRMatrix<Scalar>::get_num_row_entries(unsigned int row)
+    {
+      return Ap[row + 1] - Ap[row];
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar* vector_out)
+    {
+      int n = this->size;
+      // Every thread writes its own rows of vector_out.
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+      for (int i = 0; i < n; i++)
+      {
+        Scalar sum = 0.0;
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          sum += Ax[k] * vector_in[Ai[k]];
+        vector_out[i] = sum;
+      }
+    }
+
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::multiply_with_Scalar(Scalar value)
+    {
+      for (unsigned int i = 0; i < this->nnz; i++) Ax[i] *= value;
+    }
+
+    template<typename Scalar>
+    int *CSRMatrix<Scalar>::get_Ap()
+    {
+      return this->Ap;
+    }
+
+    template<typename Scalar>
+    int *CSRMatrix<Scalar>::get_Ai()
+    {
+      return this->Ai;
+    }
+
+    template<typename Scalar>
+    Scalar *CSRMatrix<Scalar>::get_Ax()
+    {
+      return this->Ax;
+    }
+
+    template<typename Scalar>
+    KrylovVector<Scalar>::KrylovVector()
+    {
+      _F_;
+      v = NULL;
+      this->size = 0;
+    }
+
+    template<typename Scalar>
+    KrylovVector<Scalar>::KrylovVector(unsigned int size)
+    {
+      _F_;
+      v = NULL;
+      this->size = size;
+      this->alloc(size);
+    }
+
+    template<typename Scalar>
+    KrylovVector<Scalar>::~KrylovVector()
+    {
+      _F_;
+      free();
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::alloc(unsigned int n)
+    {
+      _F_;
+      free();
+      this->size = n;
+      v = new Scalar [n];
+      MEM_CHECK(v);
+      this->zero();
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::zero()
+    {
+      _F_;
+      memset(v, 0, this->size * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::change_sign()
+    {
+      _F_;
+      for (unsigned int i = 0; i < this->size; i++) v[i] *= -1.;
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::free()
+    {
+      _F_;
+      delete [] v;
+      v = NULL;
+      this->size = 0;
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::set(unsigned int idx, Scalar y)
+    {
+      _F_;
+      v[idx] = y;
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::add(unsigned int idx, Scalar y)
+    {
+      _F_;
+      v[idx] += y;
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::add(unsigned int n, unsigned int *idx, Scalar *y)
+    {
+      _F_;
+      for (unsigned int i = 0; i < n; i++)
+        v[idx[i]] += y[i];
+    }
+
+    template<typename Scalar>
+    Scalar KrylovVector<Scalar>::get(unsigned int idx)
+    {
+      return v[idx];
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::extract(Scalar *v) const
+    {
+      memcpy(v, this->v, this->size * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::add_vector(Vector<Scalar>* vec)
+    {
+      assert(this->length() == vec->length());
+      for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec->get(i);
+    }
+
+    template<typename Scalar>
+    void KrylovVector<Scalar>::add_vector(Scalar* vec)
+    {
+      for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec[i];
+    }
+
+    template<typename Scalar>
+    bool KrylovVector<Scalar>::is_concurrent_add_supported() const
+    {
+      return true;
+    }
+
+    template<typename Scalar>
+    Scalar *KrylovVector<Scalar>::get_c_array()
+    {
+      return this->v;
+    }
+
+    template<typename Scalar>
+    bool KrylovVector<Scalar>::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+    {
+      _F_;
+      switch (fmt)
+      {
+      case DF_MATLAB_SPARSE:
+        fprintf(file, "%% Size: %dx1\n%s = [\n", this->size, var_name);
+        for (unsigned int i = 0; i < this->size; i++)
+        {
+          Hermes::Helpers::fprint_num(file, v[i]);
+          fprintf(file, "\n");
+        }
+        fprintf(file, " ];\n");
+        return true;
+
+      case DF_HERMES_BIN:
+        {
+          hermes_fwrite("HERMESR\001", 1, 8, file);
+          int ssize = sizeof(Scalar);
+          hermes_fwrite(&ssize, sizeof(int), 1, file);
+          hermes_fwrite(&this->size, sizeof(int), 1, file);
+          hermes_fwrite(v, sizeof(Scalar), this->size, file);
+          return true;
+        }
+
+      case DF_PLAIN_ASCII:
+        {
+          fprintf(file, "\n");
+          for (unsigned int i = 0; i < this->size; i++)
+          {
+            Hermes::Helpers::fprint_num(file, v[i]);
+            fprintf(file, "\n");
+          }
+          return true;
+        }
+
+      default:
+        return false;
+      }
+    }
+
+    template class HERMES_API CSRMatrix<double>;
+    template class HERMES_API CSRMatrix<std::complex<double> >;
+    template class HERMES_API KrylovVector<double>;
+    template class HERMES_API KrylovVector<std::complex<double> >;
+  }
+
+  namespace Solvers
+  {
+    /// Complex conjugate (identity for real numbers).
+    static inline double conjugate(double x) { return x; }
+    static inline std::complex<double> conjugate(std::complex<double> x) { return std::conj(x); }
+
+    /// Inner product (x, y) = sum conj(x_i) * y_i.
+    template<typename Scalar>
+    static Scalar dot(int n, Scalar* x, Scalar* y)
+    {
+      Scalar sum = 0.0;
+      for (int i = 0; i < n; i++)
+        sum += conjugate(x[i]) * y[i];
+      return sum;
+    }
+
+    /// Euclidean norm.
+    template<typename Scalar>
+    static double norm(int n, Scalar* x)
+    {
+      double sum = 0.0;
+      for (int i = 0; i < n; i++)
+        sum += std::abs(x[i]) * std::abs(x[i]);
+      return sqrt(sum);
+    }
+
+    /// y = y + a * x.
+    template<typename Scalar>
+    static void axpy(int n, Scalar a, Scalar* x, Scalar* y)
+    {
+      for (int i = 0; i < n; i++)
+        y[i] += a * x[i];
+    }
+
+    template<typename Scalar>
+    KrylovSolver<Scalar>::KrylovSolver(CSRMatrix<Scalar> *m, KrylovVector<Scalar> *rhs)
+      : IterSolver<Scalar>(), m(m), op(NULL), rhs(rhs), method(KRYLOV_GMRES), restart(30), pc(NULL), own_pc(false), num_iters(0), residual(0.0)
+    {
+      _F_;
+      this->precond_yes = false;
+    }
+
+    template<typename Scalar>
+    KrylovSolver<Scalar>::KrylovSolver(KrylovOperator<Scalar> *op, KrylovVector<Scalar> *rhs)
+      : IterSolver<Scalar>(), m(NULL), op(op), rhs(rhs), method(KRYLOV_GMRES), restart(30), pc(NULL), own_pc(false), num_iters(0), residual(0.0)
+    {
+      _F_;
+      this->precond_yes = false;
+    }
+
+    template<typename Scalar>
+    KrylovSolver<Scalar>::~KrylovSolver()
+    {
+      _F_;
+      if (own_pc)
+        delete pc;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_solver(const char *name)
+    {
+      _F_;
+      if (name != NULL && strcasecmp(name, "cg") == 0) method = KRYLOV_CG;
+      else if (name != NULL && strcasecmp(name, "bicgstab") == 0) method = KRYLOV_BICGSTAB;
+      else
+      {
+        if (name != NULL && strcasecmp(name, "gmres") != 0)
+          warning("Unknown Krylov method '%s', using GMRES.", name);
+        method = KRYLOV_GMRES;
+      }
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_restart(int restart)
+    {
+      _F_;
+      if (restart < 1)
+        error("The GMRES restart has to be positive.");
+      this->restart = restart;
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_num_threads(int num_threads)
+    {
+      _F_;
+      if (m != NULL)
+        m->set_num_threads(num_threads);
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_precond(const char *name)
+    {
+      _F_;
+      if (own_pc)
+        delete pc;
+      pc = NULL;
+      own_pc = false;
+
+      if (name == NULL || strcasecmp(name, "none") == 0) pc = NULL;
+      else if (strcasecmp(name, "jacobi") == 0) pc = new JacobiPrecond<Scalar>;
+      else if (strcasecmp(name, "ilu") == 0) pc = new IluPrecond<Scalar>;
+      else if (strcasecmp(name, "ilut") == 0) pc = new IluPrecond<Scalar>(1e-4, 20);
+      else if (strcasecmp(name, "ssor") == 0) pc = new SsorPrecond<Scalar>;
+      else
+        warning("Unknown preconditioner '%s', using none.", name);
+
+      own_pc = (pc != NULL);
+      this->precond_yes = (pc != NULL);
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::set_precond(Precond<Scalar> *pc)
+    {
+      _F_;
+      if (own_pc)
+        delete this->pc;
+      this->pc = pc;
+      own_pc = false;
+      this->precond_yes = (pc != NULL);
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::precondition(Scalar* r, Scalar* z)
+    {
+      if (pc != NULL)
+        pc->apply(r, z);
+      else
+        memcpy(z, r, get_matrix_size() * sizeof(Scalar));
+    }
+
+    template<typename Scalar>
+    void KrylovSolver<Scalar>::multiply(Scalar* x, Scalar* y)
+    {
+      if (m != NULL)
+        m->multiply_with_vector(x, y);
+      else
+        op->apply(x, y);
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::get_matrix_size()
+    {
+      return (m != NULL) ? m->get_size() : op->get_size();
+    }
+
+    template<typename Scalar>
+    int KrylovSolver<Scalar>::get_num_iters()
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double KrylovSolver<Scalar>::get_residual()
+    {
+      return residual;
+    }
+
+    template<typename Scalar>
+    bool KrylovSolver<Scalar>::solve()
+    {
+      _F_;
+      assert(m != NULL || op != NULL);
+      assert(rhs != NULL);
+      assert((unsigned int) get_matrix_size() == rhs->length());
+
+      Hermes::TimePeriod tmr;
+
+      int n = get_matrix_size();
+      if(this->sln)
+        delete [] this->sln;
+      this->sln = new Scalar[n];
+      MEM_CHECK(this->sln);
+      memset(this->sln, 0, n * sizeof(Scalar));
+
+      if (pc != NULL && m != NULL)
+      {
+        pc->create(m);
+        pc->compute();
+      }
+      else if (own_pc)
+        error("The preconditioners given by name need a matrix.");
+
+      num_iters = 0;
+      residual = 0.0;
+      bool converged;
+      if (norm(n, rhs->v) == 0.0)
+        converged = true;
+      else if (method == KRYLOV_CG)
+        converged = solve_cg(rhs->v, this->sln);
+      else if (method == KRYLOV_BICGSTAB)
+        converged = solve_bicgstab(rhs->v, this->sln);
+      else
+        converged = solve_gmres(rhs->v, this->sln);
+
+      tmr.tick();
+      this->time = tmr.accumulated();
+
+      if (!converged)
+        warning("Krylov solver did not converge in %d iterations, relative residual norm %g.", num_iters, residual);
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool KrylovSolver<Scalar>::solve_cg(Scalar* b, Scalar* x)
+    {
+      _F_;
+      int n = get_matrix_size();
+      double b_norm = norm(n, b);
+      Scalar* r = new Scalar[n];
+      Scalar* z = new Scalar[n];
+      Scalar* p = new Scalar[n];
+      Scalar* q = new Scalar[n];
+
+      // x = 0, r = b, p = z = M^{-1} r.
+      memcpy(r, b, n * sizeof(Scalar));
+      precondition(r, z);
+      memcpy(p, z, n * sizeof(Scalar));
+      Scalar rz = dot(n, r, z);
+      residual = 1.0;
+
+      bool converged = false;
+      while (num_iters < this->max_iters)
+      {
+        multiply(p, q);
+        Scalar pq = dot(n, p, q);
+        if (pq == 0.0)
+          break;
+        Scalar alpha = rz / pq;
+        axpy(n, alpha, p, x);
+        axpy(n, -alpha, q, r);
+        num_iters++;
+
+        residual = norm(n, r) / b_norm;
+        if (residual < this->tolerance)
+        {
+          converged = true;
+          break;
+        }
+
+        precondition(r, z);
+        Scalar rz_new = dot(n, r, z);
+        Scalar beta = rz_new / rz;
+        for (int i = 0; i < n; i++)
+          p[i] = z[i] + beta * p[i];
+        rz = rz_new;
+      }
+
+      delete [] r;
+      delete [] z;
+      delete [] p;
+      delete [] q;
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool KrylovSolver<Scalar>::solve_bicgstab(Scalar* b, Scalar* x)
+    {
+      _F_;
+      int n = get_matrix_size();
+      double b_norm = norm(n, b);
+      Scalar* r = new Scalar[n];
+      Scalar* r0 = new Scalar[n];
+      Scalar* p = new Scalar[n];
+      Scalar* p_hat = new Scalar[n];
+      Scalar* v = new Scalar[n];
+      Scalar* s = new Scalar[n];
+      Scalar* s_hat = new Scalar[n];
+      Scalar* t = new Scalar[n];
+
+      // x = 0, r = r0 = b. The preconditioner is applied from the right.
+      memcpy(r, b, n * sizeof(Scalar));
+      memcpy(r0, b, n * sizeof(Scalar));
+      memset(p, 0, n * sizeof(Scalar));
+      memset(v, 0, n * sizeof(Scalar));
+      Scalar rho = 1.0, alpha = 1.0, omega = 1.0;
+      residual = 1.0;
+
+      bool converged = false;
+      while (num_iters < this->max_iters)
+      {
+        Scalar rho_new = dot(n, r0, r);
+        if (rho_new == 0.0)
+          break;
+        Scalar beta = (rho_new / rho) * (alpha / omega);
+        for (int i = 0; i < n; i++)
+          p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+        precondition(p, p_hat);
+        multiply(p_hat, v);
+        Scalar r0v = dot(n, r0, v);
+        if (r0v == 0.0)
+          break;
+        alpha = rho_new / r0v;
+        for (int i = 0; i < n; i++)
+          s[i] = r[i] - alpha * v[i];
+        num_iters++;
+
+        residual = norm(n, s) / b_norm;
+        if (residual < this->tolerance)
+        {
+          axpy(n, alpha, p_hat, x);
+          converged = true;
+          break;
+        }
+
+        precondition(s, s_hat);
+        multiply(s_hat, t);
+        Scalar tt = dot(n, t, t);
+        if (tt == 0.0)
+          break;
+        omega = dot(n, t, s) / tt;
+        for (int i = 0; i < n; i++)
+        {
+          x[i] += alpha * p_hat[i] + omega * s_hat[i];
+          r[i] = s[i] - omega * t[i];
+        }
+
+        residual = norm(n, r) / b_norm;
+        if (residual < this->tolerance)
+        {
+          converged = true;
+          break;
+        }
+        if (omega == 0.0)
+          break;
+        rho = rho_new;
+      }
+
+      delete [] r;
+      delete [] r0;
+      delete [] p;
+      delete [] p_hat;
+      delete [] v;
+      delete [] s;
+      delete [] s_hat;
+      delete [] t;
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool KrylovSolver<Scalar>::solve_gmres(Scalar* b, Scalar* x)
+    {
+      _F_;
+      int n = get_matrix_size();
+      double b_norm = norm(n, b);
+
+      // Krylov basis (restart + 1 vectors), Hessenberg matrix, Givens rotations.
+      // The preconditioner is applied from the right, so that the residual is the true one.
+      Scalar* V = new Scalar[(size_t) n * (restart + 1)];
+      Scalar** H = DenseMatrixOperations::new_matrix<Scalar>(restart + 1, restart);
+      double* c = new double[restart];
+      Scalar* s = new Scalar[restart];
+      Scalar* g = new Scalar[restart + 1];
+      Scalar* r = new Scalar[n];
+      Scalar* z = new Scalar[n];
+
+      bool converged = false;
+      bool breakdown = false;
+      while (!converged && !breakdown && num_iters < this->max_iters)
+      {
+        // r = b - A x.
+        multiply(x, r);
+        for (int i = 0; i < n; i++)
+          r[i] = b[i] - r[i];
+        double beta = norm(n, r);
+        residual = beta / b_norm;
+        if (residual < this->tolerance)
+        {
+          converged = true;
+          break;
+        }
+
+        for (int i = 0; i < n; i++)
+          V[i] = r[i] / beta;
+        memset(g, 0, (restart + 1) * sizeof(Scalar));
+        g[0] = beta;
+
+        int j;
+        for (j = 0; j < restart && num_iters < this->max_iters; j++)
+        {
+          Scalar* w = V + (size_t) (j + 1) * n;
+          precondition(V + (size_t) j * n, z);
+          multiply(z, w);
+          num_iters++;
+
+          // Modified Gram-Schmidt.
+          for (int i = 0; i <= j; i++)
+          {
+            H[i][j] = dot(n, V + (size_t) i * n, w);
+            axpy(n, -H[i][j], V + (size_t) i * n, w);
+          }
+          double h = norm(n, w);
+          H[j + 1][j] = h;
+          if (h != 0.0)
+            for (int i = 0; i < n; i++)
+              w[i] /= h;
+
+          // Apply the previous rotations to the new column.
+          for (int i = 0; i < j; i++)
+          {
+            Scalar temp = c[i] * H[i][j] + s[i] * H[i + 1][j];
+            H[i + 1][j] = -conjugate(s[i]) * H[i][j] + c[i] * H[i + 1][j];
+            H[i][j] = temp;
+          }
+
+          // The rotation eliminating H[j + 1][j].
+          double a_abs = std::abs(H[j][j]);
+          double d = sqrt(a_abs * a_abs + h * h);
+          if (d == 0.0)
+          {
+            breakdown = true;
+            break;
+          }
+          if (a_abs == 0.0)
+          {
+            c[j] = 0.0;
+            s[j] = 1.0;
+          }
+          else
+          {
+            c[j] = a_abs / d;
+            s[j] = (H[j][j] / a_abs) * h / d;
+          }
+          H[j][j] = c[j] * H[j][j] + s[j] * H[j + 1][j];
+          H[j + 1][j] = 0.0;
+          g[j + 1] = -conjugate(s[j]) * g[j];
+          g[j] = c[j] * g[j];
+
+          residual = std::abs(g[j + 1]) / b_norm;
+          if (residual < this->tolerance)
+          {
+            converged = true;
+            j++;
+            break;
+          }
+          // Lucky breakdown, the solution is in the current subspace.
+          if (h == 0.0)
+          {
+            breakdown = true;
+            j++;
+            break;
+          }
+        }
+
+        // Solve the upper triangular system H y = g (in place of g) and update x += M^{-1} V y.
+        for (int i = j - 1; i >= 0; i--)
+        {
+          for (int k = i + 1; k < j; k++)
+            g[i] -= H[i][k] * g[k];
+          g[i] /= H[i][i];
+        }
+        memset(r, 0, n * sizeof(Scalar));
+        for (int i = 0; i < j; i++)
+          axpy(n, g[i], V + (size_t) i * n, r);
+        precondition(r, z);
+        axpy(n, Scalar(1.0), z, x);
+      }
+
+      // A breakdown with the exact solution in the subspace.
+      if (breakdown && !converged)
+      {
+        multiply(x, r);
+        for (int i = 0; i < n; i++)
+          r[i] = b[i] - r[i];
+        residual = norm(n, r) / b_norm;
+        converged = residual < this->tolerance;
+      }
+
+      delete [] V;
+      delete [] H;
+      delete [] c;
+      delete [] s;
+      delete [] g;
+      delete [] r;
+      delete [] z;
+      return converged;
+    }
+
+    template class HERMES_API KrylovSolver<double>;
+    template class HERMES_API KrylovSolver<std::complex<double> >;
+  }
+}
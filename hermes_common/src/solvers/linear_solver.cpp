@@ -27,6 +27,7 @@
 #include "mumps_solver.h"
 #include "newton_solver_nox.h"
 #include "aztecoo_solver.h"
+#include "krylov_solver.h"
 
 using namespace Hermes::Algebra;
 
@@ -146,6 +147,13 @@ namespace Hermes
 #endif
           break;
         }
+      case Hermes::SOLVER_KRYLOV:
+        {
+          info("Using Krylov.");
+          if (rhs != NULL) return new KrylovSolver<Scalar>(static_cast<CSRMatrix<Scalar>*>(matrix), static_cast<KrylovVector<Scalar>*>(rhs));
+          else return new KrylovSolver<Scalar>(static_cast<CSRMatrix<Scalar>*>(matrix), static_cast<KrylovVector<Scalar>*>(rhs_dummy));
+          break;
+        }
       default:
         error("Unknown matrix solver requested.");
       }
@@ -158,6 +166,47 @@ namespace Hermes
       factorization_scheme = reuse_scheme;
     }
 
+    template<typename Scalar>
+    void DirectSolver<Scalar>::set_structure_reuse_detection(bool enable)
+    {
+      structure_reuse_detection = enable;
+    }
+
+    template<typename Scalar>
+    int DirectSolver<Scalar>::get_num_skipped_symbolic_factorizations() const
+    {
+      return num_skipped_symbolic_factorizations;
+    }
+
+    template<typename Scalar>
+    unsigned int DirectSolver<Scalar>::get_effective_factorization_scheme(SparseMatrix<Scalar>* m, bool has_factorization)
+    {
+      _F_;
+      unsigned int eff_fact_scheme = factorization_scheme;
+      // Perform both factorization phases for the first time.
+      if (!has_factorization)
+        eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
+      else if (structure_reuse_detection)
+      {
+        unsigned long long fingerprint = m->get_structure_fingerprint();
+        // 0 means that the matrix does not know its structure, then the scheme is kept.
+        if (fingerprint != 0)
+        {
+          if (fingerprint != symbolic_fingerprint)
+            eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
+          else if (eff_fact_scheme == HERMES_FACTORIZE_FROM_SCRATCH)
+            eff_fact_scheme = HERMES_REUSE_MATRIX_REORDERING;
+        }
+      }
+
+      if (eff_fact_scheme == HERMES_FACTORIZE_FROM_SCRATCH)
+        symbolic_fingerprint = m->get_structure_fingerprint();
+      else
+        num_skipped_symbolic_factorizations++;
+
+      return eff_fact_scheme;
+    }
+
     template<typename Scalar>
     void IterSolver<Scalar>::set_tolerance(double tol)
     {
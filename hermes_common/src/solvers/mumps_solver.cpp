@@ -119,6 +119,7 @@ namespace Hermes
       this->pages = NULL;
 
       nnz = Ap[this->size];
+      this->invalidate_structure_fingerprint();
 
       Ax = new typename mumps_type<Scalar>::mumps_Scalar[nnz];
       memset(Ax, 0, sizeof(Scalar) * nnz);
@@ -137,6 +138,7 @@ namespace Hermes
     {
       _F_;
       nnz = 0;
+      this->invalidate_structure_fingerprint();
       delete[] Ap; Ap = NULL;
       delete[] Ai; Ai = NULL;
       delete[] Ax; Ax = NULL;
@@ -144,6 +146,17 @@ namespace Hermes
       delete[] jcn; jcn = NULL;
     }
 
+    template<typename Scalar>
+    unsigned long long MumpsMatrix<Scalar>::compute_structure_hash()
+    {
+      _F_;
+      if (Ap == NULL || Ai == NULL)
+        return 0;
+      unsigned long long hash = this->hash_bytes(&this->size, sizeof(unsigned int));
+      hash = this->hash_bytes(Ap, (this->size + 1) * sizeof(Ap[0]), hash);
+      return this->hash_bytes(Ai, nnz * sizeof(int), hash);
+    }
+
     inline double mumps_to_Scalar(double x)
     {
       return x;
@@ -424,6 +437,7 @@ namespace Hermes
         this->Ai[i] = ai[i];
         irn[i] = ai[i];
       }
+      this->invalidate_structure_fingerprint();
     }
     // Duplicates a matrix (including allocation).
     template<typename Scalar>
@@ -765,11 +779,23 @@ namespace Hermes
       _F_;
       // When called for the first time, all three phases (analysis, factorization,
       // solution) must be performed.
-      int eff_fact_scheme = this->factorization_scheme;
-      if (!inited)
-        if( this->factorization_scheme == HERMES_REUSE_MATRIX_REORDERING ||
-          this->factorization_scheme == HERMES_REUSE_FACTORIZATION_COMPLETELY )
-          eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
+      int eff_fact_scheme = this->get_effective_factorization_scheme(m, inited);
+      // The analysis with scaling is performed by the case HERMES_REUSE_MATRIX_REORDERING_AND_SCALING.
+      if (eff_fact_scheme == HERMES_FACTORIZE_FROM_SCRATCH && this->factorization_scheme == HERMES_REUSE_MATRIX_REORDERING_AND_SCALING)
+      {
+        param.INFOG(33) = -999;
+        eff_fact_scheme = HERMES_REUSE_MATRIX_REORDERING_AND_SCALING;
+      }
+
+      // The arrays of the matrix may have been reallocated with the same structure.
+      if (inited)
+      {
+        param.n = m->size;
+        param.nz = m->nnz;
+        param.irn = m->irn;
+        param.jcn = m->jcn;
+        param.a = m->Ax;
+      }
 
       switch (eff_fact_scheme)
       {
@@ -72,9 +72,9 @@ namespace Hermes
     template<typename Scalar>
     void NonlinearSolver<Scalar>::set_iterative_method(const char* iterative_method_name)
     {
-      if(this->matrix_solver_type != SOLVER_AZTECOO)
+      if(this->matrix_solver_type != SOLVER_AZTECOO && this->matrix_solver_type != SOLVER_KRYLOV)
       {
-        warning("Trying to set iterative method for a different solver than AztecOO.");
+        warning("Trying to set iterative method for a different solver than AztecOO or Krylov.");
         return;
       }
       else
@@ -86,9 +86,9 @@ namespace Hermes
     template<typename Scalar>
     void NonlinearSolver<Scalar>::set_preconditioner(const char* preconditioner_name)
     {
-      if(this->matrix_solver_type != SOLVER_AZTECOO)
+      if(this->matrix_solver_type != SOLVER_AZTECOO && this->matrix_solver_type != SOLVER_KRYLOV)
       {
-        warning("Trying to set iterative method for a different solver than AztecOO.");
+        warning("Trying to set iterative method for a different solver than AztecOO or Krylov.");
         return;
       }
       else
@@ -0,0 +1,474 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file pmultigrid_solver.cpp
+\brief p-multigrid solver and preconditioner working with the CSR matrix format.
+*/
+#include "config.h"
+#include "pmultigrid_solver.h"
+#include "common_time_period.h"
+#include "error.h"
+#include "callstack.h"
+#include <algorithm>
+
+using namespace Hermes::Error;
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    /// Orders the entries of a row by the columns.
+    template<typename Scalar>
+    static bool smaller_column(const std::pair<int, Scalar>& a, const std::pair<int, Scalar>& b)
+    {
+      return a.first < b.first;
+    }
+
+    /// The first of UMFPack, SuperLU and MUMPS Hermes was built with, the native Krylov solver if none.
+    static Hermes::MatrixSolverType default_coarse_solver()
+    {
+#if defined(WITH_UMFPACK)
+      return SOLVER_UMFPACK;
+#elif defined(WITH_SUPERLU)
+      return SOLVER_SUPERLU;
+#elif defined(WITH_MUMPS)
+      return SOLVER_MUMPS;
+#else
+      return SOLVER_KRYLOV;
+#endif
+    }
+
+    template<typename Scalar>
+    PMultigridPrecond<Scalar>::PMultigridPrecond() : NativePrecond<Scalar>(), smoother_type(SMOOTHER_SSOR),
+      pre_smoothing_steps(2), post_smoothing_steps(2), coarse_solver_type(default_coarse_solver()),
+      coarse_matrix(NULL), coarse_rhs(NULL), coarse_solver(NULL)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    PMultigridPrecond<Scalar>::PMultigridPrecond(const std::vector<std::vector<int> >& levels) : NativePrecond<Scalar>(),
+      levels(levels), smoother_type(SMOOTHER_SSOR), pre_smoothing_steps(2), post_smoothing_steps(2),
+      coarse_solver_type(default_coarse_solver()), coarse_matrix(NULL), coarse_rhs(NULL), coarse_solver(NULL)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    PMultigridPrecond<Scalar>::~PMultigridPrecond()
+    {
+      _F_;
+      free_internal();
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::set_levels(const std::vector<std::vector<int> >& levels)
+    {
+      _F_;
+      this->levels = levels;
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::set_smoother(const char *name)
+    {
+      _F_;
+      if (name != NULL && strcasecmp(name, "jacobi") == 0) smoother_type = SMOOTHER_JACOBI;
+      else
+      {
+        if (name != NULL && strcasecmp(name, "ssor") != 0)
+          warning("Unknown smoother '%s', using SSOR.", name);
+        smoother_type = SMOOTHER_SSOR;
+      }
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::set_smoothing_steps(int pre_smoothing_steps, int post_smoothing_steps)
+    {
+      _F_;
+      if (pre_smoothing_steps < 0 || post_smoothing_steps < 0)
+        error("The number of smoothing steps cannot be negative.");
+      this->pre_smoothing_steps = pre_smoothing_steps;
+      this->post_smoothing_steps = post_smoothing_steps;
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::set_coarse_solver(Hermes::MatrixSolverType coarse_solver_type)
+    {
+      _F_;
+      this->coarse_solver_type = coarse_solver_type;
+    }
+
+    template<typename Scalar>
+    int PMultigridPrecond<Scalar>::get_num_levels() const
+    {
+      return levels.size() + 1;
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::compute_internal()
+    {
+      _F_;
+      int num_levels = get_num_levels();
+      for (unsigned int l = 0; l < levels.size(); l++)
+      {
+        int finer_size = (l == 0) ? this->size : levels[l - 1].size();
+        for (unsigned int i = 0; i < levels[l].size(); i++)
+          if (levels[l][i] < 0 || levels[l][i] >= finer_size)
+            error("The DOF %d of the multigrid level %d is not a DOF of the finer level.", i, l + 1);
+      }
+
+      level_b.resize(num_levels);
+      level_x.resize(num_levels);
+      level_r.resize(num_levels);
+      level_z.resize(num_levels);
+      matrices.push_back(this->a);
+      for (int l = 0; l < num_levels; l++)
+      {
+        if (l > 0)
+          matrices.push_back(restrict_matrix(l));
+        int n = matrices[l]->get_size();
+        level_b[l].resize(n);
+        level_x[l].resize(n);
+        level_r[l].resize(n);
+        level_z[l].resize(n);
+
+        if (l < num_levels - 1)
+          smoothers.push_back(create_smoother(l));
+      }
+
+      create_coarse_solver();
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::free_internal()
+    {
+      _F_;
+      // The first matrix is the matrix of the preconditioner.
+      for (unsigned int l = 1; l < matrices.size(); l++)
+        delete matrices[l];
+      matrices.clear();
+      for (unsigned int l = 0; l < smoothers.size(); l++)
+        delete smoothers[l];
+      smoothers.clear();
+      level_b.clear();
+      level_x.clear();
+      level_r.clear();
+      level_z.clear();
+
+      delete coarse_solver;
+      delete coarse_matrix;
+      delete coarse_rhs;
+      coarse_solver = NULL;
+      coarse_matrix = NULL;
+      coarse_rhs = NULL;
+    }
+
+    template<typename Scalar>
+    CSRMatrix<Scalar>* PMultigridPrecond<Scalar>::restrict_matrix(int level)
+    {
+      _F_;
+      const std::vector<int>& finer_dofs = levels[level - 1];
+      CSRMatrix<Scalar>* finer = matrices[level - 1];
+      int n = finer_dofs.size();
+      int* fine_Ap = finer->get_Ap();
+      int* fine_Ai = finer->get_Ai();
+      Scalar* fine_Ax = finer->get_Ax();
+
+      // The DOF of this level of every DOF of the finer level (-1 if there is none).
+      std::vector<int> coarse_dofs(finer->get_size(), -1);
+      for (int i = 0; i < n; i++)
+        coarse_dofs[finer_dofs[i]] = i;
+
+      // P^T A P is the submatrix of the rows and columns of the DOFs of this level.
+      std::vector<int> Ap(n + 1), Ai;
+      std::vector<Scalar> Ax;
+      std::vector<std::pair<int, Scalar> > row;
+      Ap[0] = 0;
+      for (int i = 0; i < n; i++)
+      {
+        row.clear();
+        for (int k = fine_Ap[finer_dofs[i]]; k < fine_Ap[finer_dofs[i] + 1]; k++)
+          if (coarse_dofs[fine_Ai[k]] >= 0)
+            row.push_back(std::pair<int, Scalar>(coarse_dofs[fine_Ai[k]], fine_Ax[k]));
+        std::sort(row.begin(), row.end(), smaller_column<Scalar>);
+        for (unsigned int k = 0; k < row.size(); k++)
+        {
+          Ai.push_back(row[k].first);
+          Ax.push_back(row[k].second);
+        }
+        Ap[i + 1] = Ai.size();
+      }
+
+      CSRMatrix<Scalar>* matrix = new CSRMatrix<Scalar>;
+      if (n > 0)
+        matrix->create(n, Ai.size(), &Ap[0], Ai.empty() ? NULL : &Ai[0], Ax.empty() ? NULL : &Ax[0]);
+      return matrix;
+    }
+
+    template<typename Scalar>
+    NativePrecond<Scalar>* PMultigridPrecond<Scalar>::create_smoother(int level)
+    {
+      _F_;
+      NativePrecond<Scalar>* smoother;
+      if (smoother_type == SMOOTHER_JACOBI)
+        smoother = new JacobiPrecond<Scalar>;
+      else
+        smoother = new SsorPrecond<Scalar>;
+      smoother->create(matrices[level]);
+      smoother->compute();
+      return smoother;
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::create_coarse_solver()
+    {
+      _F_;
+      CSRMatrix<Scalar>* coarsest = matrices.back();
+      int n = coarsest->get_size();
+      // E.g. all DOFs of the order 1 are Dirichlet DOFs.
+      if (n == 0)
+        return;
+      int* Ap = coarsest->get_Ap();
+      int* Ai = coarsest->get_Ai();
+      Scalar* Ax = coarsest->get_Ax();
+
+      coarse_matrix = create_matrix<Scalar>(coarse_solver_type);
+      coarse_rhs = create_vector<Scalar>(coarse_solver_type);
+      coarse_matrix->prealloc(n);
+      for (int i = 0; i < n; i++)
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          coarse_matrix->pre_add_ij(i, Ai[k]);
+      coarse_matrix->alloc();
+      for (int i = 0; i < n; i++)
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          coarse_matrix->add(i, Ai[k], Ax[k]);
+      coarse_matrix->finish();
+      coarse_rhs->alloc(n);
+
+      coarse_solver = create_linear_solver<Scalar>(coarse_solver_type, coarse_matrix, coarse_rhs);
+      if (coarse_solver_type == SOLVER_KRYLOV)
+      {
+        // Not a direct solver, the coarse level is solved by ILU(0) preconditioned GMRES to a tolerance
+        // tight enough for the preconditioner to stay linear.
+        KrylovSolver<Scalar>* krylov = static_cast<KrylovSolver<Scalar>*>(coarse_solver);
+        krylov->set_tolerance(1e-12);
+        krylov->set_precond("ilu");
+      }
+      else
+        // The matrix is factorized by the first solve and the factorization is reused in all cycles.
+        coarse_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      memset(z, 0, this->size * sizeof(Scalar));
+      cycle(0, r, z);
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::cycle(int level, Scalar* b, Scalar* x)
+    {
+      int n = matrices[level]->get_size();
+      if (n == 0)
+        return;
+      if (level == get_num_levels() - 1)
+      {
+        coarse_rhs->zero();
+        for (int i = 0; i < n; i++)
+          coarse_rhs->set(i, b[i]);
+        coarse_rhs->finish();
+        if (!coarse_solver->solve())
+          error("The coarse level of the p-multigrid could not be solved.");
+        Scalar* sln = coarse_solver->get_sln_vector();
+        for (int i = 0; i < n; i++)
+          x[i] += sln[i];
+        return;
+      }
+
+      smooth(level, b, x, pre_smoothing_steps);
+
+      // Restriction of the residual to the coarser level, correction and its prolongation.
+      Scalar* r = &level_r[level][0];
+      compute_residual(level, b, x, r);
+      const std::vector<int>& finer_dofs = levels[level];
+      int coarse_n = finer_dofs.size();
+      Scalar* coarse_b = &level_b[level + 1][0];
+      Scalar* coarse_x = &level_x[level + 1][0];
+      for (int i = 0; i < coarse_n; i++)
+      {
+        coarse_b[i] = r[finer_dofs[i]];
+        coarse_x[i] = 0.0;
+      }
+      cycle(level + 1, coarse_b, coarse_x);
+      for (int i = 0; i < coarse_n; i++)
+        x[finer_dofs[i]] += coarse_x[i];
+
+      smooth(level, b, x, post_smoothing_steps);
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::smooth(int level, Scalar* b, Scalar* x, int steps)
+    {
+      int n = matrices[level]->get_size();
+      Scalar* r = &level_r[level][0];
+      Scalar* z = &level_z[level][0];
+      // The Jacobi smoother is damped to smooth the oscillatory errors.
+      double damping = (smoother_type == SMOOTHER_JACOBI) ? 2.0 / 3.0 : 1.0;
+      for (int step = 0; step < steps; step++)
+      {
+        compute_residual(level, b, x, r);
+        smoothers[level]->apply(r, z);
+        for (int i = 0; i < n; i++)
+          x[i] += damping * z[i];
+      }
+    }
+
+    template<typename Scalar>
+    void PMultigridPrecond<Scalar>::compute_residual(int level, Scalar* b, Scalar* x, Scalar* r)
+    {
+      int n = matrices[level]->get_size();
+      matrices[level]->multiply_with_vector(x, r);
+      for (int i = 0; i < n; i++)
+        r[i] = b[i] - r[i];
+    }
+
+    template class HERMES_API PMultigridPrecond<double>;
+    template class HERMES_API PMultigridPrecond<std::complex<double> >;
+  }
+
+  namespace Solvers
+  {
+    /// Euclidean norm.
+    template<typename Scalar>
+    static double norm(int n, Scalar* x)
+    {
+      double sum = 0.0;
+      for (int i = 0; i < n; i++)
+        sum += std::abs(x[i]) * std::abs(x[i]);
+      return sqrt(sum);
+    }
+
+    template<typename Scalar>
+    PMultigridSolver<Scalar>::PMultigridSolver(CSRMatrix<Scalar> *m, KrylovVector<Scalar> *rhs, const std::vector<std::vector<int> >& levels)
+      : IterSolver<Scalar>(), m(m), rhs(rhs), multigrid(levels), num_iters(0), residual(0.0)
+    {
+      _F_;
+      this->precond_yes = true;
+    }
+
+    template<typename Scalar>
+    PMultigridSolver<Scalar>::~PMultigridSolver()
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    Hermes::Preconditioners::PMultigridPrecond<Scalar>* PMultigridSolver<Scalar>::get_multigrid()
+    {
+      return &multigrid;
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_precond(const char *name)
+    {
+      _F_;
+      warning("The p-multigrid solver uses no other preconditioner than the multigrid cycle.");
+    }
+
+    template<typename Scalar>
+    void PMultigridSolver<Scalar>::set_precond(Precond<Scalar> *pc)
+    {
+      _F_;
+      warning("The p-multigrid solver uses no other preconditioner than the multigrid cycle.");
+    }
+
+    template<typename Scalar>
+    int PMultigridSolver<Scalar>::get_matrix_size()
+    {
+      return m->get_size();
+    }
+
+    template<typename Scalar>
+    int PMultigridSolver<Scalar>::get_num_iters()
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    double PMultigridSolver<Scalar>::get_residual()
+    {
+      return residual;
+    }
+
+    template<typename Scalar>
+    bool PMultigridSolver<Scalar>::solve()
+    {
+      _F_;
+      assert(m != NULL);
+      assert(rhs != NULL);
+      assert(m->get_size() == rhs->length());
+
+      Hermes::TimePeriod tmr;
+
+      int n = m->get_size();
+      if(this->sln)
+        delete [] this->sln;
+      this->sln = new Scalar[n];
+      MEM_CHECK(this->sln);
+      memset(this->sln, 0, n * sizeof(Scalar));
+
+      multigrid.create(m);
+      multigrid.compute();
+
+      Scalar* b = rhs->get_c_array();
+      Scalar* r = new Scalar[n];
+      Scalar* z = new Scalar[n];
+      double b_norm = norm(n, b);
+
+      // x = 0, r = b; x += MG(r), r = b - A x.
+      num_iters = 0;
+      residual = (b_norm == 0.0) ? 0.0 : 1.0;
+      memcpy(r, b, n * sizeof(Scalar));
+      while (residual > this->tolerance && num_iters < this->max_iters)
+      {
+        multigrid.apply(r, z);
+        for (int i = 0; i < n; i++)
+          this->sln[i] += z[i];
+        m->multiply_with_vector(this->sln, r);
+        for (int i = 0; i < n; i++)
+          r[i] = b[i] - r[i];
+        residual = norm(n, r) / b_norm;
+        num_iters++;
+      }
+      delete [] r;
+      delete [] z;
+
+      tmr.tick();
+      this->time = tmr.accumulated();
+
+      bool converged = (residual <= this->tolerance);
+      if (!converged)
+        warning("p-multigrid solver did not converge in %d iterations, relative residual norm %g.", num_iters, residual);
+      return converged;
+    }
+
+    template class HERMES_API PMultigridSolver<double>;
+    template class HERMES_API PMultigridSolver<std::complex<double> >;
+  }
+}
@@ -0,0 +1,671 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file precond_native.cpp
+\brief Native algebraic preconditioners (Jacobi, block Jacobi, ILU, SSOR) working with the CSR matrix format.
+*/
+#include "config.h"
+#include "precond_native.h"
+#include "umfpack_solver.h"
+#include "error.h"
+#include "callstack.h"
+#include <set>
+#include <algorithm>
+
+using namespace Hermes::Error;
+
+namespace Hermes
+{
+  namespace Preconditioners
+  {
+    template<typename Scalar>
+    NativePrecond<Scalar>::NativePrecond() : mat(NULL), a(NULL), own_a(false), size(0)
+    {
+      _F_;
+#ifdef HAVE_EPETRA
+      map = NULL;
+#endif
+    }
+
+    template<typename Scalar>
+    NativePrecond<Scalar>::~NativePrecond()
+    {
+      _F_;
+      if (own_a)
+        delete a;
+#ifdef HAVE_EPETRA
+      delete map;
+#endif
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::create(Matrix<Scalar> *mat)
+    {
+      _F_;
+      destroy();
+      this->mat = mat;
+      size = mat->get_size();
+
+      a = dynamic_cast<CSRMatrix<Scalar>*>(mat);
+#ifdef WITH_UMFPACK
+      // A CSC matrix is converted in compute().
+      if (a == NULL && dynamic_cast<CSCMatrix<Scalar>*>(mat) != NULL)
+      {
+        a = new CSRMatrix<Scalar>;
+        own_a = true;
+      }
+#endif
+      if (a == NULL)
+        error("The native preconditioners need a CSRMatrix (or a CSCMatrix).");
+
+#ifdef HAVE_EPETRA
+      map = new Epetra_Map(size, 0, comm);
+#endif
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::destroy()
+    {
+      _F_;
+      free_internal();
+      if (own_a)
+        delete a;
+      a = NULL;
+      own_a = false;
+      mat = NULL;
+#ifdef HAVE_EPETRA
+      delete map;
+      map = NULL;
+#endif
+    }
+
+    template<typename Scalar>
+    void NativePrecond<Scalar>::compute()
+    {
+      _F_;
+      if (a == NULL)
+        error("The matrix of the preconditioner was not set by create().");
+#ifdef WITH_UMFPACK
+      if (own_a)
+      {
+        CSCMatrix<Scalar>* csc = static_cast<CSCMatrix<Scalar>*>(mat);
+        a->create_from_csc(csc->get_size(), csc->get_nnz(), csc->get_Ap(), csc->get_Ai(), csc->get_Ax());
+      }
+#endif
+      free_internal();
+      compute_internal();
+    }
+
+#ifdef HAVE_EPETRA
+    template<typename Scalar>
+    int NativePrecond<Scalar>::ApplyInverse(const Epetra_MultiVector &r, Epetra_MultiVector &z) const
+    {
+      error("The native preconditioners can be used by AztecOO only for real matrices.");
+      return -1;
+    }
+
+    template<>
+    int NativePrecond<double>::ApplyInverse(const Epetra_MultiVector &r, Epetra_MultiVector &z) const
+    {
+      // r and z may be the same vector.
+      double* temp = new double[size];
+      for (int k = 0; k < r.NumVectors(); k++)
+      {
+        memcpy(temp, r[k], size * sizeof(double));
+        const_cast<NativePrecond<double>*>(this)->apply(temp, z[k]);
+      }
+      delete [] temp;
+      return 0;
+    }
+#endif
+
+    template<typename Scalar>
+    JacobiPrecond<Scalar>::JacobiPrecond() : NativePrecond<Scalar>(), inv_diag(NULL)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    JacobiPrecond<Scalar>::~JacobiPrecond()
+    {
+      _F_;
+      free_internal();
+    }
+
+    template<typename Scalar>
+    void JacobiPrecond<Scalar>::compute_internal()
+    {
+      _F_;
+      inv_diag = new Scalar[this->size];
+      MEM_CHECK(inv_diag);
+      for (int i = 0; i < this->size; i++)
+      {
+        Scalar d = this->a->get(i, i);
+        if (d == 0.0)
+          error("Zero diagonal entry in the row %d, the Jacobi preconditioner can not be used.", i);
+        inv_diag[i] = 1.0 / d;
+      }
+    }
+
+    template<typename Scalar>
+    void JacobiPrecond<Scalar>::free_internal()
+    {
+      _F_;
+      delete [] inv_diag;
+      inv_diag = NULL;
+    }
+
+    template<typename Scalar>
+    void JacobiPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      for (int i = 0; i < this->size; i++)
+        z[i] = inv_diag[i] * r[i];
+    }
+
+    template<typename Scalar>
+    BlockJacobiPrecond<Scalar>::BlockJacobiPrecond() : NativePrecond<Scalar>()
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    BlockJacobiPrecond<Scalar>::BlockJacobiPrecond(const std::vector<std::vector<int> >& blocks) : NativePrecond<Scalar>(), blocks(blocks)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    BlockJacobiPrecond<Scalar>::~BlockJacobiPrecond()
+    {
+      _F_;
+      free_internal();
+    }
+
+    template<typename Scalar>
+    void BlockJacobiPrecond<Scalar>::set_blocks(const std::vector<std::vector<int> >& blocks)
+    {
+      _F_;
+      this->blocks = blocks;
+    }
+
+    template<typename Scalar>
+    void BlockJacobiPrecond<Scalar>::compute_internal()
+    {
+      _F_;
+      int n = this->size;
+
+      // Local index of every DOF in its block.
+      std::vector<int> local(n, -1);
+      dofs.reserve(n);
+      block_start.push_back(0);
+      for (unsigned int b = 0; b < blocks.size(); b++)
+      {
+        for (unsigned int k = 0; k < blocks[b].size(); k++)
+        {
+          int dof = blocks[b][k];
+          if (dof < 0 || dof >= n)
+            continue;
+          if (local[dof] >= 0)
+            error("The DOF %d is in more than one block of the block Jacobi preconditioner.", dof);
+          local[dof] = dofs.size() - block_start.back();
+          dofs.push_back(dof);
+        }
+        if ((int) dofs.size() > block_start.back())
+          block_start.push_back(dofs.size());
+      }
+      for (int dof = 0; dof < n; dof++)
+        if (local[dof] < 0)
+        {
+          local[dof] = 0;
+          dofs.push_back(dof);
+          block_start.push_back(dofs.size());
+        }
+
+      int num_blocks = block_start.size() - 1;
+      lu_start.resize(num_blocks + 1);
+      lu_start[0] = 0;
+      for (int b = 0; b < num_blocks; b++)
+      {
+        int bs = block_start[b + 1] - block_start[b];
+        lu_start[b + 1] = lu_start[b] + bs * bs;
+      }
+      lu.assign(lu_start[num_blocks], Scalar(0.0));
+      pivots.resize(n);
+
+      // The block of every DOF.
+      std::vector<int> block_of(n);
+      for (int b = 0; b < num_blocks; b++)
+        for (int k = block_start[b]; k < block_start[b + 1]; k++)
+          block_of[dofs[k]] = b;
+
+      int* Ap = this->a->get_Ap();
+      int* Ai = this->a->get_Ai();
+      Scalar* Ax = this->a->get_Ax();
+      for (int b = 0; b < num_blocks; b++)
+      {
+        int bs = block_start[b + 1] - block_start[b];
+        Scalar* m = &lu[lu_start[b]];
+        int* piv = &pivots[block_start[b]];
+
+        // Extract the block.
+        for (int k = 0; k < bs; k++)
+        {
+          int row = dofs[block_start[b] + k];
+          for (int p = Ap[row]; p < Ap[row + 1]; p++)
+            if (block_of[Ai[p]] == b)
+              m[k * bs + local[Ai[p]]] = Ax[p];
+        }
+
+        // LU decomposition with partial pivoting.
+        for (int k = 0; k < bs; k++)
+        {
+          int pk = k;
+          for (int i = k + 1; i < bs; i++)
+            if (std::abs(m[i * bs + k]) > std::abs(m[pk * bs + k]))
+              pk = i;
+          piv[k] = pk;
+          if (m[pk * bs + k] == 0.0)
+            error("Singular block in the block Jacobi preconditioner.");
+          if (pk != k)
+            for (int j = 0; j < bs; j++)
+              std::swap(m[k * bs + j], m[pk * bs + j]);
+          for (int i = k + 1; i < bs; i++)
+          {
+            Scalar l = (m[i * bs + k] /= m[k * bs + k]);
+            for (int j = k + 1; j < bs; j++)
+              m[i * bs + j] -= l * m[k * bs + j];
+          }
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void BlockJacobiPrecond<Scalar>::free_internal()
+    {
+      _F_;
+      dofs.clear();
+      block_start.clear();
+      lu.clear();
+      lu_start.clear();
+      pivots.clear();
+    }
+
+    template<typename Scalar>
+    void BlockJacobiPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      int num_blocks = (int) block_start.size() - 1;
+      std::vector<Scalar> y;
+      for (int b = 0; b < num_blocks; b++)
+      {
+        int bs = block_start[b + 1] - block_start[b];
+        const int* block_dofs = &dofs[block_start[b]];
+        const int* piv = &pivots[block_start[b]];
+        const Scalar* m = &lu[lu_start[b]];
+
+        y.resize(bs);
+        for (int k = 0; k < bs; k++)
+          y[k] = r[block_dofs[k]];
+        for (int k = 0; k < bs; k++)
+          if (piv[k] != k)
+            std::swap(y[k], y[piv[k]]);
+        for (int i = 1; i < bs; i++)
+          for (int j = 0; j < i; j++)
+            y[i] -= m[i * bs + j] * y[j];
+        for (int i = bs - 1; i >= 0; i--)
+        {
+          for (int j = i + 1; j < bs; j++)
+            y[i] -= m[i * bs + j] * y[j];
+          y[i] /= m[i * bs + i];
+        }
+        for (int k = 0; k < bs; k++)
+          z[block_dofs[k]] = y[k];
+      }
+    }
+
+    template<typename Scalar>
+    IluPrecond<Scalar>::IluPrecond() : NativePrecond<Scalar>(), threshold(false), drop_tolerance(0.0), fill(0)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    IluPrecond<Scalar>::IluPrecond(double drop_tolerance, int fill) : NativePrecond<Scalar>(), threshold(true), drop_tolerance(drop_tolerance), fill(fill)
+    {
+      _F_;
+    }
+
+    template<typename Scalar>
+    IluPrecond<Scalar>::~IluPrecond()
+    {
+      _F_;
+      free_internal();
+    }
+
+    template<typename Scalar>
+    void IluPrecond<Scalar>::compute_internal()
+    {
+      _F_;
+      if (threshold)
+        compute_ilut();
+      else
+        compute_ilu0();
+    }
+
+    template<typename Scalar>
+    void IluPrecond<Scalar>::compute_ilu0()
+    {
+      _F_;
+      int n = this->size;
+      int* Ap = this->a->get_Ap();
+      int* Ai = this->a->get_Ai();
+      Scalar* Ax = this->a->get_Ax();
+
+      // The factors in the structure of the matrix.
+      std::vector<Scalar> w(Ax, Ax + Ap[n]);
+      std::vector<int> diag(n, -1);
+      std::vector<int> pos(n, -1);
+      for (int i = 0; i < n; i++)
+      {
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+          pos[Ai[p]] = p;
+
+        for (int p = Ap[i]; p < Ap[i + 1] && Ai[p] < i; p++)
+        {
+          int k = Ai[p];
+          w[p] /= w[diag[k]];
+          for (int q = diag[k] + 1; q < Ap[k + 1]; q++)
+            if (pos[Ai[q]] >= 0)
+              w[pos[Ai[q]]] -= w[p] * w[q];
+        }
+
+        if (pos[i] < 0 || w[pos[i]] == 0.0)
+          error("Zero pivot in the row %d of ILU(0).", i);
+        diag[i] = pos[i];
+
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+          pos[Ai[p]] = -1;
+      }
+
+      Lp.assign(1, 0);
+      Up.assign(1, 0);
+      for (int i = 0; i < n; i++)
+      {
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+        {
+          if (Ai[p] < i)
+          {
+            Li.push_back(Ai[p]);
+            Lx.push_back(w[p]);
+          }
+          else
+          {
+            Ui.push_back(Ai[p]);
+            Ux.push_back(w[p]);
+          }
+        }
+        Lp.push_back(Li.size());
+        Up.push_back(Ui.size());
+      }
+    }
+
+    /// Compares the entries (column, value) of a row by the absolute value, the largest first.
+    template<typename Scalar>
+    static bool larger_entry(const std::pair<int, Scalar>& a, const std::pair<int, Scalar>& b)
+    {
+      return std::abs(a.second) > std::abs(b.second);
+    }
+
+    /// Compares the entries (column, value) of a row by the column.
+    template<typename Scalar>
+    static bool smaller_column(const std::pair<int, Scalar>& a, const std::pair<int, Scalar>& b)
+    {
+      return a.first < b.first;
+    }
+
+    template<typename Scalar>
+    void IluPrecond<Scalar>::compute_ilut()
+    {
+      _F_;
+      int n = this->size;
+      int* Ap = this->a->get_Ap();
+      int* Ai = this->a->get_Ai();
+      Scalar* Ax = this->a->get_Ax();
+
+      // The working row (dense), the columns of its nonzero entries.
+      std::vector<Scalar> w(n, Scalar(0.0));
+      std::vector<bool> nonzero(n, false);
+      std::set<int> lower;
+      std::vector<int> upper;
+      std::vector<std::pair<int, Scalar> > l_row, u_row;
+
+      Lp.assign(1, 0);
+      Up.assign(1, 0);
+      for (int i = 0; i < n; i++)
+      {
+        double row_norm = 0.0;
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+        {
+          int j = Ai[p];
+          w[j] = Ax[p];
+          nonzero[j] = true;
+          if (j < i)
+            lower.insert(j);
+          else
+            upper.push_back(j);
+          row_norm += std::abs(Ax[p]) * std::abs(Ax[p]);
+        }
+        if (!nonzero[i])
+        {
+          nonzero[i] = true;
+          upper.push_back(i);
+        }
+        double tau = drop_tolerance * sqrt(row_norm);
+
+        // Elimination by the previous rows, in the order of the columns.
+        l_row.clear();
+        while (!lower.empty())
+        {
+          int k = *lower.begin();
+          lower.erase(lower.begin());
+          Scalar l = w[k] / Ux[Up[k]];
+          w[k] = 0.0;
+          nonzero[k] = false;
+          if (std::abs(l) < tau)
+            continue;
+          l_row.push_back(std::pair<int, Scalar>(k, l));
+          for (int q = Up[k] + 1; q < Up[k + 1]; q++)
+          {
+            int j = Ui[q];
+            if (!nonzero[j])
+            {
+              nonzero[j] = true;
+              if (j < i)
+                lower.insert(j);
+              else
+                upper.push_back(j);
+            }
+            w[j] -= l * Ux[q];
+          }
+        }
+
+        // The diagonal entry is always kept.
+        Scalar d = w[i];
+        if (d == 0.0)
+          d = tau > 0.0 ? tau : 1.0;
+        u_row.clear();
+        for (unsigned int k = 0; k < upper.size(); k++)
+        {
+          int j = upper[k];
+          if (j != i && std::abs(w[j]) >= tau)
+            u_row.push_back(std::pair<int, Scalar>(j, w[j]));
+          w[j] = 0.0;
+          nonzero[j] = false;
+        }
+        upper.clear();
+
+        // Keep the largest entries.
+        if ((int) l_row.size() > fill)
+        {
+          std::partial_sort(l_row.begin(), l_row.begin() + fill, l_row.end(), larger_entry<Scalar>);
+          l_row.resize(fill);
+        }
+        if ((int) u_row.size() > fill)
+        {
+          std::partial_sort(u_row.begin(), u_row.begin() + fill, u_row.end(), larger_entry<Scalar>);
+          u_row.resize(fill);
+        }
+        std::sort(l_row.begin(), l_row.end(), smaller_column<Scalar>);
+        std::sort(u_row.begin(), u_row.end(), smaller_column<Scalar>);
+
+        for (unsigned int k = 0; k < l_row.size(); k++)
+        {
+          Li.push_back(l_row[k].first);
+          Lx.push_back(l_row[k].second);
+        }
+        Ui.push_back(i);
+        Ux.push_back(d);
+        for (unsigned int k = 0; k < u_row.size(); k++)
+        {
+          Ui.push_back(u_row[k].first);
+          Ux.push_back(u_row[k].second);
+        }
+        Lp.push_back(Li.size());
+        Up.push_back(Ui.size());
+      }
+    }
+
+    template<typename Scalar>
+    void IluPrecond<Scalar>::free_internal()
+    {
+      _F_;
+      Lp.clear();
+      Li.clear();
+      Lx.clear();
+      Up.clear();
+      Ui.clear();
+      Ux.clear();
+    }
+
+    template<typename Scalar>
+    void IluPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      int n = this->size;
+      // L y = r (unit diagonal).
+      for (int i = 0; i < n; i++)
+      {
+        Scalar sum = r[i];
+        for (int p = Lp[i]; p < Lp[i + 1]; p++)
+          sum -= Lx[p] * z[Li[p]];
+        z[i] = sum;
+      }
+      // U z = y (the diagonal is the first entry of every row).
+      for (int i = n - 1; i >= 0; i--)
+      {
+        Scalar sum = z[i];
+        for (int p = Up[i] + 1; p < Up[i + 1]; p++)
+          sum -= Ux[p] * z[Ui[p]];
+        z[i] = sum / Ux[Up[i]];
+      }
+    }
+
+    template<typename Scalar>
+    SsorPrecond<Scalar>::SsorPrecond(double omega) : NativePrecond<Scalar>(), omega(omega), diag_pos(NULL)
+    {
+      _F_;
+      if (omega <= 0.0 || omega >= 2.0)
+        error("The relaxation parameter of SSOR has to be in (0, 2).");
+    }
+
+    template<typename Scalar>
+    SsorPrecond<Scalar>::~SsorPrecond()
+    {
+      _F_;
+      free_internal();
+    }
+
+    template<typename Scalar>
+    void SsorPrecond<Scalar>::compute_internal()
+    {
+      _F_;
+      int n = this->size;
+      int* Ap = this->a->get_Ap();
+      int* Ai = this->a->get_Ai();
+      Scalar* Ax = this->a->get_Ax();
+      diag_pos = new int[n];
+      MEM_CHECK(diag_pos);
+      for (int i = 0; i < n; i++)
+      {
+        diag_pos[i] = -1;
+        for (int p = Ap[i]; p < Ap[i + 1]; p++)
+          if (Ai[p] == i)
+            diag_pos[i] = p;
+        if (diag_pos[i] < 0 || Ax[diag_pos[i]] == 0.0)
+          error("Zero diagonal entry in the row %d, SSOR can not be used.", i);
+      }
+    }
+
+    template<typename Scalar>
+    void SsorPrecond<Scalar>::free_internal()
+    {
+      _F_;
+      delete [] diag_pos;
+      diag_pos = NULL;
+    }
+
+    template<typename Scalar>
+    void SsorPrecond<Scalar>::apply(Scalar* r, Scalar* z)
+    {
+      int n = this->size;
+      int* Ap = this->a->get_Ap();
+      int* Ai = this->a->get_Ai();
+      Scalar* Ax = this->a->get_Ax();
+      double c = (2.0 - omega) / omega;
+
+      // (D / omega + L) y = c r, z = (D / omega) y.
+      for (int i = 0; i < n; i++)
+      {
+        Scalar sum = c * r[i];
+        for (int p = Ap[i]; p < diag_pos[i]; p++)
+          sum -= Ax[p] * z[Ai[p]];
+        z[i] = sum / (Ax[diag_pos[i]] / omega);
+      }
+      for (int i = 0; i < n; i++)
+        z[i] *= Ax[diag_pos[i]] / omega;
+
+      // (D / omega + U) z = (D / omega) y.
+      for (int i = n - 1; i >= 0; i--)
+      {
+        Scalar sum = z[i];
+        for (int p = diag_pos[i] + 1; p < Ap[i + 1]; p++)
+          sum -= Ax[p] * z[Ai[p]];
+        z[i] = sum / (Ax[diag_pos[i]] / omega);
+      }
+    }
+
+    template class HERMES_API NativePrecond<double>;
+    template class HERMES_API NativePrecond<std::complex<double> >;
+    template class HERMES_API JacobiPrecond<double>;
+    template class HERMES_API JacobiPrecond<std::complex<double> >;
+    template class HERMES_API BlockJacobiPrecond<double>;
+    template class HERMES_API BlockJacobiPrecond<std::complex<double> >;
+    template class HERMES_API IluPrecond<double>;
+    template class HERMES_API IluPrecond<std::complex<double> >;
+    template class HERMES_API SsorPrecond<double>;
+    template class HERMES_API SsorPrecond<std::complex<double> >;
+  }
+}
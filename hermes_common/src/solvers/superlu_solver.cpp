@@ -160,6 +160,7 @@ namespace Hermes
       this->pages = NULL;
 
       nnz = Ap[this->size];
+      this->invalidate_structure_fingerprint();
 
       Ax = new Scalar [nnz];
       memset(Ax, 0, sizeof(Scalar) * nnz);
@@ -170,11 +171,23 @@ namespace Hermes
     {
       _F_;
       nnz = 0;
+      this->invalidate_structure_fingerprint();
       delete [] Ap; Ap = NULL;
       delete [] Ai; Ai = NULL;
       delete [] Ax; Ax = NULL;
     }
 
+    template<typename Scalar>
+    unsigned long long SuperLUMatrix<Scalar>::compute_structure_hash()
+    {
+      _F_;
+      if (Ap == NULL || Ai == NULL)
+        return 0;
+      unsigned long long hash = this->hash_bytes(&this->size, sizeof(unsigned int));
+      hash = this->hash_bytes(Ap, (this->size + 1) * sizeof(Ap[0]), hash);
+      return this->hash_bytes(Ai, nnz * sizeof(int), hash);
+    }
+
     template<typename Scalar>
     Scalar SuperLUMatrix<Scalar>::get(unsigned int m, unsigned int n)
     {
@@ -388,6 +401,7 @@ namespace Hermes
         this->Ax[i] = ax[i];
         this->Ai[i] = ai[i];
       }
+      this->invalidate_structure_fingerprint();
     }
     // Duplicates a matrix (including allocation).
 
@@ -723,7 +737,11 @@ namespace Hermes
       // keep the (possibly rescaled) matrix from the last factorization, otherwise recreate it
       // from the master SuperLUMatrix<Scalar> pointed to by this->m (this also applies to the case when
       // A does not yet exist).
-      if (!has_A || this->factorization_scheme != HERMES_REUSE_FACTORIZATION_COMPLETELY)
+#ifdef SLU_MT
+      if (!has_A || options.fact != FACTORED)
+#else
+      if (!has_A || options.Fact != FACTORED)
+#endif
       {
         if (A_changed)
           free_matrix();
@@ -861,20 +879,16 @@ namespace Hermes
     bool SuperLUSolver<Scalar>::setup_factorization()
     {
       _F_;
+      // Always factorize from scratch for the first time.
+      int eff_fact_scheme = this->get_effective_factorization_scheme(m, inited);
+
       unsigned int A_size = A.nrow < 0 ? 0 : A.nrow;
-      if (has_A && this->factorization_scheme != HERMES_FACTORIZE_FROM_SCRATCH && A_size != m->size)
+      if (has_A && eff_fact_scheme != HERMES_FACTORIZE_FROM_SCRATCH && A_size != m->size)
       {
         warning("You cannot reuse factorization structures for factorizing matrices of different sizes.");
         return false;
       }
 
-      // Always factorize from scratch for the first time.
-      int eff_fact_scheme;
-      if (!inited)
-        eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
-      else
-        eff_fact_scheme = this->factorization_scheme;
-
       // Prepare factorization structures. In case of a particular reuse scheme, comments are given
       // to clarify which arguments will be reused and which will be reset by the dgssvx (zgssvx) routine.
       // It was determined empirically by running the dlinsolx2 example from SuperLU, setting options.Fact
@@ -932,6 +946,8 @@ namespace Hermes
         // L, U matrices may be reused without reallocating.
         // SLU_DESTROY_L(&L);
         // SLU_DESTROY_U(&U);
+        // The values of the matrix have to be copied again.
+        A_changed = true;
         break;
       case HERMES_REUSE_MATRIX_REORDERING_AND_SCALING:
         // needed from previous:      etree, perm_c, perm_r, L, U
@@ -944,6 +960,7 @@ namespace Hermes
 #else
         options.Fact = SamePattern_SameRowPerm;
 #endif
+        A_changed = true;
         break;
       case HERMES_REUSE_FACTORIZATION_COMPLETELY:
         // needed from previous:      perm_c, perm_r, equed, L, U
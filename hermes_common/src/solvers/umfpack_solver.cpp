@@ -25,6 +25,9 @@
 #include "trace.h"
 #include "error.h"
 #include "callstack.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 extern "C"
 {
@@ -73,6 +76,8 @@ namespace Hermes
       Ap = NULL;
       Ai = NULL;
       Ax = NULL;
+      scatter_pos = 0;
+      use_scatter_map = true;
     }
 
     template<typename Scalar>
@@ -80,6 +85,8 @@ namespace Hermes
     {
       _F_;
       this->size = size;
+      scatter_pos = 0;
+      use_scatter_map = true;
       this->alloc();
     }
 
@@ -137,10 +144,14 @@ namespace Hermes
       this->pages = NULL;
 
       nnz = Ap[this->size];
+      this->invalidate_structure_fingerprint();
 
       Ax = new Scalar [nnz];
       MEM_CHECK(Ax);
       memset(Ax, 0, sizeof(Scalar) * nnz);
+
+      scatter_map.clear();
+      scatter_pos = 0;
     }
 
     template<typename Scalar>
@@ -148,9 +159,23 @@ namespace Hermes
     {
       _F_;
       nnz = 0;
+      this->invalidate_structure_fingerprint();
       if (Ap != NULL) {delete [] Ap; Ap = NULL;}
       if (Ai != NULL) {delete [] Ai; Ai = NULL;}
       if (Ax != NULL) {delete [] Ax; Ax = NULL;}
+      scatter_map.clear();
+      scatter_pos = 0;
+    }
+
+    template<typename Scalar>
+    unsigned long long CSCMatrix<Scalar>::compute_structure_hash()
+    {
+      _F_;
+      if (Ap == NULL || Ai == NULL)
+        return 0;
+      unsigned long long hash = this->hash_bytes(&this->size, sizeof(unsigned int));
+      hash = this->hash_bytes(Ap, (this->size + 1) * sizeof(Ap[0]), hash);
+      return this->hash_bytes(Ai, nnz * sizeof(int), hash);
     }
 
     template<typename Scalar>
@@ -171,6 +196,36 @@ namespace Hermes
     {
       _F_;
       memset(Ax, 0, sizeof(Scalar) * nnz);
+      // A new assembling starts, the blocks will be added again from the beginning of the scatter map.
+      scatter_pos = 0;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::finish()
+    {
+      _F_;
+      // Adding the same blocks again without zero() (e.g. a second right-hand side of the
+      // same matrix) must not append them to the map.
+      scatter_pos = 0;
+    }
+
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::set_scatter_map(bool use_scatter_map)
+    {
+      _F_;
+      this->use_scatter_map = use_scatter_map;
+      if (!use_scatter_map)
+        Hermes::vector<int>().swap(scatter_map);
+      scatter_pos = 0;
+    }
+
+    template<typename Scalar>
+    int CSCMatrix<Scalar>::find_entry(unsigned int m, unsigned int n) const
+    {
+      if (Ap[n + 1] == Ap[n])
+        return -1;
+      int pos = find_position(Ai + Ap[n], Ap[n + 1] - Ap[n], m);
+      return pos < 0 ? -1 : Ap[n] + pos;
     }
 
     template<typename Scalar>
@@ -301,10 +356,62 @@ namespace Hermes
     void CSCMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar **mat, int *rows, int *cols)
     {
       _F_;
+      bool scatter = use_scatter_map;
+#ifdef _OPENMP
+      // Concurrent adds (colored assembling) can not share the position in the map.
+      if (omp_in_parallel())
+        scatter = false;
+#endif
+      if (!scatter)
+      {
+        for (unsigned int i = 0; i < m; i++)       // rows
+          for (unsigned int j = 0; j < n; j++)     // cols
+            if(rows[i] >= 0 && cols[j] >= 0) // not Dir. dofs.
+              add(rows[i], cols[j], mat[i][j]);
+        return;
+      }
+
       for (unsigned int i = 0; i < m; i++)       // rows
+      {
+        if (rows[i] < 0) // Dir. dof.
+          continue;
         for (unsigned int j = 0; j < n; j++)     // cols
-          if(rows[i] >= 0 && cols[j] >= 0) // not Dir. dofs.
-            add(rows[i], cols[j], mat[i][j]);
+        {
+          if (cols[j] < 0) // Dir. dof.
+            continue;
+          Scalar v = mat[i][j];
+          int pos;
+          if (scatter_pos < scatter_map.size())
+          {
+            // Check that the stored position really belongs to (rows[i], cols[j]).
+            pos = scatter_map[scatter_pos];
+            if (pos < 0 ? v != 0.0 : (pos < Ap[cols[j]] || pos >= Ap[cols[j] + 1] || Ai[pos] != rows[i]))
+            {
+              // The blocks are added differently than before, the rest of the map is rebuilt.
+              scatter_map.resize(scatter_pos);
+              pos = find_entry(rows[i], cols[j]);
+              scatter_map.push_back(pos);
+            }
+          }
+          else
+          {
+            pos = find_entry(rows[i], cols[j]);
+            scatter_map.push_back(pos);
+          }
+          scatter_pos++;
+
+          if (v != 0.0)   // ignore zero values.
+          {
+            // Make sure we are adding to an existing non-zero entry.
+            if (pos < 0)
+            {
+              info("CSCMatrix<Scalar>::add(): i = %d, j = %d.", rows[i], cols[j]);
+              error("Sparse matrix entry not found");
+            }
+            Ax[pos] += v;
+          }
+        }
+      }
     }
 
     double inline real(double x)
@@ -552,6 +659,12 @@ namespace Hermes
       return nnz / (double) (this->size * this->size);
     }
 
+    template<typename Scalar>
+    bool CSCMatrix<Scalar>::is_concurrent_add_supported() const
+    {
+      return true;
+    }
+
     template<typename Scalar>
     void CSCMatrix<Scalar>::create(unsigned int size, unsigned int nnz, int* ap, int* ai, Scalar* ax)
     {
@@ -567,6 +680,9 @@ namespace Hermes
         this->Ax[i] = ax[i];
         this->Ai[i] = ai[i];
       }
+      this->invalidate_structure_fingerprint();
+      scatter_map.clear();
+      scatter_pos = 0;
     }
 
     template<typename Scalar>
@@ -701,6 +817,12 @@ namespace Hermes
       for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec[i];
     }
 
+    template<typename Scalar>
+    bool UMFPackVector<Scalar>::is_concurrent_add_supported() const
+    {
+      return true;
+    }
+
     template<typename Scalar>
     Scalar *UMFPackVector<Scalar>::get_c_array()
     {
@@ -888,12 +1010,7 @@ namespace Hermes
     bool UMFPackLinearSolver<double>::setup_factorization()
     {
       _F_;
-      // Perform both factorization phases for the first time.
-      int eff_fact_scheme;
-      if (factorization_scheme != HERMES_FACTORIZE_FROM_SCRATCH && symbolic == NULL && numeric == NULL)
-        eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
-      else
-        eff_fact_scheme = factorization_scheme;
+      int eff_fact_scheme = this->get_effective_factorization_scheme(m, symbolic != NULL && numeric != NULL);
 
       int status;
       switch(eff_fact_scheme)
@@ -951,12 +1068,7 @@ namespace Hermes
     bool UMFPackLinearSolver<std::complex<double> >::setup_factorization()
     {
       _F_;
-      // Perform both factorization phases for the first time.
-      int eff_fact_scheme;
-      if (factorization_scheme != HERMES_FACTORIZE_FROM_SCRATCH && symbolic == NULL && numeric == NULL)
-        eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
-      else
-        eff_fact_scheme = factorization_scheme;
+      int eff_fact_scheme = this->get_effective_factorization_scheme(m, symbolic != NULL && numeric != NULL);
 
       int status;
       switch(eff_fact_scheme)
@@ -214,18 +214,44 @@ void build_matrix_block(int n, std::map<unsigned int, MatrixEntry> &ar_mat, std:
     rhs->finish();
 }
 
-// Test code.
-void solve(LinearSolver<std::complex<double> > &solver, int n) {
-  if (solver.solve()) {
-    std::complex<double> *sln = solver.get_sln_vector();
+// Builds the compressed sparse columns of the matrix, the entries of every column sorted by rows.
+void build_csc(int n, std::map<unsigned int, MatrixEntry> &ar_mat, int *&ap, int *&ai, std::complex<double> *&ax)
+{
+    std::map<std::pair<int, int>, std::complex<double> > columns;
+    for (std::map<unsigned int, MatrixEntry>::iterator it = ar_mat.begin(); it != ar_mat.end(); it++) {
+      MatrixEntry &me = it->second;
+      columns[std::pair<int, int>(me.n, me.m)] += me.value;
+    }
+
+    ap = new int[n + 1];
+    ai = new int[columns.size()];
+    ax = new std::complex<double>[columns.size()];
+    memset(ap, 0, (n + 1) * sizeof(int));
+    int pos = 0;
+    for (std::map<std::pair<int, int>, std::complex<double> >::iterator it = columns.begin(); it != columns.end(); it++) {
+      ap[it->first.first + 1]++;
+      ai[pos] = it->first.second;
+      ax[pos++] = it->second;
+    }
     for (int i = 0; i < n; i++)
-      if(sln[i].imag() < 0.0)
-        std::cout << std::endl << sln[i].real() << sln[i].imag();
-      else
-        std::cout << std::endl << sln[i].real() << ' + ' << sln[i].imag();
-  }
-  else
+      ap[i + 1] += ap[i];
+}
+
+// Test code.
+// Returns a copy of the solution (the solution vector is deleted with the solver), NULL if the solver failed.
+std::complex<double>* solve(LinearSolver<std::complex<double> > &solver, int n) {
+  if (!solver.solve()) {
     printf("Unable to solve.\n");
+    return NULL;
+  }
+  std::complex<double> *sln = new std::complex<double>[n];
+  memcpy(sln, solver.get_sln_vector(), n * sizeof(std::complex<double>));
+  for (int i = 0; i < n; i++)
+    if(sln[i].imag() < 0.0)
+      std::cout << std::endl << sln[i].real() << sln[i].imag();
+    else
+      std::cout << std::endl << sln[i].real() << ' + ' << sln[i].imag();
+  return sln;
 }
 
 int main(int argc, char *argv[]) {
@@ -248,7 +274,7 @@ int main(int argc, char *argv[]) {
   if (read_matrix_and_rhs((char*)"in/linsys-cplx-4", n, nnz, ar_mat, ar_rhs, cplx_2_real) != TEST_SUCCESS)
     error("Failed to read the matrix and rhs.");
 
-  std::complex<double>* sln;
+  std::complex<double>* sln = NULL;
 
   if (strcasecmp(argv[1], "petsc") == 0) {
 #ifdef WITH_PETSC
@@ -257,8 +283,7 @@ int main(int argc, char *argv[]) {
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     PetscLinearSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "petsc-block") == 0) {
@@ -268,8 +293,7 @@ sln = solver.get_sln_vector();
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     PetscLinearSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "umfpack") == 0) {
@@ -279,8 +303,7 @@ sln = solver.get_sln_vector();
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     UMFPackLinearSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "umfpack-block") == 0) {
@@ -290,10 +313,135 @@ sln = solver.get_sln_vector();
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     UMFPackLinearSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
+  else if (strcasecmp(argv[1], "krylov") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-block") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-jacobi") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    JacobiPrecond<std::complex<double> > pc;
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ilu") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    IluPrecond<std::complex<double> > pc;
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ilut") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    IluPrecond<std::complex<double> > pc(1e-4, 20);
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ssor") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    SsorPrecond<std::complex<double> > pc;
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-block-jacobi") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    // The DOFs 0, 1 and the rest.
+    std::vector<std::vector<int> > blocks(2);
+    for (int i = 0; i < n; i++)
+      blocks[i < 2 ? 0 : 1].push_back(i);
+    BlockJacobiPrecond<std::complex<double> > pc(blocks);
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-bicgstab") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_solver("bicgstab");
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-restart") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    // Restarted before the Krylov space spans the whole space.
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_restart(n - 2);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+    info("Iterations: %d.", solver.get_num_iters());
+  }
+  else if (strcasecmp(argv[1], "krylov-threads") == 0) {
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_num_threads(4);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-csc") == 0 || strcasecmp(argv[1], "krylov-csc-symmetric") == 0) {
+    // The matrix is replaced by its compressed columns, a symmetric matrix shares them.
+    int *ap, *ai;
+    std::complex<double> *ax;
+    build_csc(n, ar_mat, ap, ai, ax);
+    CSRMatrix<std::complex<double> > mat;
+    KrylovVector<std::complex<double> > rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+    mat.create_from_csc(n, ap[n], ap, ai, ax, strcasecmp(argv[1], "krylov-csc-symmetric") == 0);
+
+    KrylovSolver<std::complex<double> > solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+    delete [] ap;
+    delete [] ai;
+    delete [] ax;
+  }
   else if (strcasecmp(argv[1], "aztecoo") == 0) {
 #ifdef WITH_TRILINOS
     EpetraMatrix<std::complex<double> > mat;
@@ -301,8 +449,7 @@ sln = solver.get_sln_vector();
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     AztecOOSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "aztecoo-block") == 0) {
@@ -312,8 +459,7 @@ sln = solver.get_sln_vector();
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     AztecOOSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "amesos") == 0) {
@@ -324,8 +470,7 @@ sln = solver.get_sln_vector();
 
     if (AmesosSolver<std::complex<double> >::is_available("Klu")) {
       AmesosSolver<std::complex<double> > solver("Klu", &mat, &rhs);
-      solve(solver, n);
-sln = solver.get_sln_vector();
+      sln = solve(solver, n);
     }
 #endif
   }
@@ -337,8 +482,7 @@ sln = solver.get_sln_vector();
 
     if (AmesosSolver<std::complex<double> >::is_available("Klu")) {
       AmesosSolver<std::complex<double> > solver("Klu", &mat, &rhs);
-      solve(solver, n);
-sln = solver.get_sln_vector();
+      sln = solve(solver, n);
     }
 #endif
   }
@@ -349,8 +493,7 @@ sln = solver.get_sln_vector();
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     MumpsSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "mumps-block") == 0) {
@@ -360,16 +503,16 @@ sln = solver.get_sln_vector();
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     MumpsSolver<std::complex<double> > solver(&mat, &rhs);
-    solve(solver, n);
-sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else
     ret = TEST_FAILURE;
 
-std::cout << sln[0] << sln[1] << sln[2];
-
-  if (std::abs(sln[0] - std::complex<double>(0.800000, -0.600000)) > 1E-6 || std::abs(sln[1] - std::complex<double>(0.470588, -0.882353)) > 1E-6 || std::abs(sln[2] - std::complex<double>(0.486486, -0.918919)) > 1E-6)
+  // No solution if the solver is unknown or not available, or if it failed.
+  if (sln == NULL)
+    ret = TEST_FAILURE;
+  else if (std::abs(sln[0] - std::complex<double>(0.800000, -0.600000)) > 1E-6 || std::abs(sln[1] - std::complex<double>(0.470588, -0.882353)) > 1E-6 || std::abs(sln[2] - std::complex<double>(0.486486, -0.918919)) > 1E-6)
     ret = TEST_FAILURE;
   else
     ret = TEST_SUCCESS;
@@ -379,4 +522,7 @@ std::cout << sln[0] << sln[1] << sln[2];
     printf("Failure!\n");
   else
     printf("Success!\n");
+
+  delete [] sln;
+  return ret;
 }
@@ -252,10 +252,39 @@ void build_matrix_block(int n, std::map<unsigned int, MatrixEntry> &ar_mat, std:
     rhs->finish();
 }
 
+// Builds the compressed sparse columns of the matrix, the entries of every column sorted by rows.
+void build_csc(int n, std::map<unsigned int, MatrixEntry> &ar_mat, int *&ap, int *&ai, double *&ax)
+{
+    std::map<std::pair<int, int>, double> columns;
+    for (std::map<unsigned int, MatrixEntry>::iterator it = ar_mat.begin(); it != ar_mat.end(); it++) {
+      MatrixEntry &me = it->second;
+      columns[std::pair<int, int>(me.n, me.m)] += me.value;
+    }
+
+    ap = new int[n + 1];
+    ai = new int[columns.size()];
+    ax = new double[columns.size()];
+    memset(ap, 0, (n + 1) * sizeof(int));
+    int pos = 0;
+    for (std::map<std::pair<int, int>, double>::iterator it = columns.begin(); it != columns.end(); it++) {
+      ap[it->first.first + 1]++;
+      ai[pos] = it->first.second;
+      ax[pos++] = it->second;
+    }
+    for (int i = 0; i < n; i++)
+      ap[i + 1] += ap[i];
+}
+
 // Test code.
-void solve(LinearSolver<double> &solver, int n) {
-  if (!solver.solve())
+// Returns a copy of the solution (the solution vector is deleted with the solver), NULL if the solver failed.
+double* solve(LinearSolver<double> &solver, int n) {
+  if (!solver.solve()) {
     printf("Unable to solve.\n");
+    return NULL;
+  }
+  double* sln = new double[n];
+  memcpy(sln, solver.get_sln_vector(), n * sizeof(double));
+  return sln;
 }
 
 int main(int argc, char *argv[]) {
@@ -291,7 +320,7 @@ break;
 break;
 }
 
-double* sln;
+double* sln = NULL;
 
   if (strcasecmp(argv[1], "petsc") == 0) {
 #ifdef WITH_PETSC
@@ -300,8 +329,7 @@ double* sln;
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     PetscLinearSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "petsc-block") == 0) {
@@ -311,8 +339,7 @@ double* sln;
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     PetscLinearSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "umfpack") == 0) {
@@ -322,8 +349,7 @@ double* sln;
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     UMFPackLinearSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "umfpack-block") == 0) {
@@ -333,10 +359,135 @@ double* sln;
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     UMFPackLinearSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
+  else if (strcasecmp(argv[1], "krylov") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-block") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-jacobi") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    JacobiPrecond<double> pc;
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ilu") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    IluPrecond<double> pc;
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ilut") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    IluPrecond<double> pc(1e-4, 20);
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-ssor") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    SsorPrecond<double> pc;
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-block-jacobi") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    // The DOFs 0, 1 and the rest, the blocks are regular also where the diagonal has zeros (system 3).
+    std::vector<std::vector<int> > blocks(2);
+    for (int i = 0; i < n; i++)
+      blocks[i < 2 ? 0 : 1].push_back(i);
+    BlockJacobiPrecond<double> pc(blocks);
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    solver.set_precond(&pc);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-cg") == 0 || strcasecmp(argv[1], "krylov-bicgstab") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_solver(argv[1] + strlen("krylov-"));
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-restart") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    // Restarted before the Krylov space spans the whole space.
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_restart(n - 2);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+    info("Iterations: %d.", solver.get_num_iters());
+  }
+  else if (strcasecmp(argv[1], "krylov-threads") == 0) {
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_num_threads(4);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "krylov-csc") == 0 || strcasecmp(argv[1], "krylov-csc-symmetric") == 0) {
+    // The matrix is replaced by its compressed columns, a symmetric matrix shares them.
+    int *ap, *ai;
+    double *ax;
+    build_csc(n, ar_mat, ap, ai, ax);
+    CSRMatrix<double> mat;
+    KrylovVector<double> rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+    mat.create_from_csc(n, ap[n], ap, ai, ax, strcasecmp(argv[1], "krylov-csc-symmetric") == 0);
+
+    KrylovSolver<double> solver(&mat, &rhs);
+    solver.set_tolerance(1e-12);
+    sln = solve(solver, n);
+    delete [] ap;
+    delete [] ai;
+    delete [] ax;
+  }
   else if (strcasecmp(argv[1], "aztecoo") == 0) {
 #ifdef WITH_TRILINOS
     EpetraMatrix<double> mat;
@@ -344,8 +495,7 @@ double* sln;
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     AztecOOSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "aztecoo-block") == 0) {
@@ -355,8 +505,7 @@ double* sln;
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     AztecOOSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "amesos") == 0) {
@@ -367,8 +516,7 @@ double* sln;
 
     if (AmesosSolver<double>::is_available("Klu")) {
       AmesosSolver<double> solver("Klu", &mat, &rhs);
-      solve(solver, n);
-	sln = solver.get_sln_vector();
+      sln = solve(solver, n);
     }
 #endif
   }
@@ -380,8 +528,7 @@ double* sln;
 
     if (AmesosSolver<double>::is_available("Klu")) {
       AmesosSolver<double> solver("Klu", &mat, &rhs);
-      solve(solver, n);
-	sln = solver.get_sln_vector();
+      sln = solve(solver, n);
     }
 #endif
   }
@@ -392,8 +539,7 @@ double* sln;
     build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
 
     MumpsSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else if (strcasecmp(argv[1], "mumps-block") == 0) {
@@ -403,14 +549,16 @@ double* sln;
     build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
 
     MumpsSolver<double> solver(&mat, &rhs);
-    solve(solver, n);
-	sln = solver.get_sln_vector();
+    sln = solve(solver, n);
 #endif
   }
   else
     ret = TEST_FAILURE;
 
-switch(atoi(argv[2]))
+  // No solution if the solver is unknown or not available, or if it failed.
+  if (sln == NULL)
+    ret = TEST_FAILURE;
+  else switch(atoi(argv[2]))
   {
   case 1:
   if (std::abs(sln[0] - 4) > 1E-6 || std::abs(sln[1] - 2) > 1E-6 || std::abs(sln[2] - 3) > 1E-6)
@@ -438,4 +586,6 @@ break;
   else
     printf("Success!\n");
 
+  delete [] sln;
+  return ret;
 }